@@ -3,11 +3,31 @@ CREATE OR REPLACE FUNCTION public.is_cbor(bytea)
 	'pg_cbor.so', 'is_cbor'
 	LANGUAGE c IMMUTABLE LEAKPROOF;
 
+CREATE OR REPLACE FUNCTION public.cbor_is_valid(bytea)
+	RETURNS boolean AS
+	'pg_cbor.so', 'cbor_is_valid'
+	LANGUAGE c IMMUTABLE LEAKPROOF;
+
+CREATE OR REPLACE FUNCTION public.cbor_is_canonical(bytea)
+	RETURNS boolean AS
+	'pg_cbor.so', 'cbor_is_canonical'
+	LANGUAGE c IMMUTABLE LEAKPROOF;
+
+CREATE OR REPLACE FUNCTION public.cbor_canonicalize(bytea)
+	RETURNS bytea AS
+	'pg_cbor.so', 'cbor_canonicalize'
+	LANGUAGE c IMMUTABLE;
+
 CREATE OR REPLACE FUNCTION public.cbor_to_string(bytea)
 	RETURNS text AS
 	'pg_cbor.so', 'cbor_to_string'
 	LANGUAGE c IMMUTABLE LEAKPROOF;
 
+CREATE OR REPLACE FUNCTION public.cbor_to_json(bytea)
+	RETURNS text AS
+	'pg_cbor.so', 'cbor_to_json'
+	LANGUAGE c IMMUTABLE;
+
 CREATE OR REPLACE FUNCTION public.cbor_extract_path(bytea, VARIADIC text[])
 	RETURNS bytea AS
 	'pg_cbor.so', 'cbor_extract_path'
@@ -42,4 +62,866 @@ CREATE OR REPLACE FUNCTION public.cbor_path_as_bool(bytea, VARIADIC text[])
 	RETURNS boolean AS
 	'pg_cbor.so', 'cbor_path_as_bool'
 	LANGUAGE c IMMUTABLE LEAKPROOF;
-	
\ No newline at end of file
+
+CREATE OR REPLACE FUNCTION public.cbor_extract_paths(bytea, text[])
+	RETURNS bytea[] AS
+	'pg_cbor.so', 'cbor_extract_paths'
+	LANGUAGE c IMMUTABLE LEAKPROOF;
+
+CREATE OR REPLACE FUNCTION public.cbor_extract_paths_text(bytea, text[])
+	RETURNS text[] AS
+	'pg_cbor.so', 'cbor_extract_paths_text'
+	LANGUAGE c IMMUTABLE LEAKPROOF;
+
+CREATE OR REPLACE FUNCTION public.cbor_paths_as_text(bytea, text[])
+	RETURNS text[] AS
+	'pg_cbor.so', 'cbor_paths_as_text'
+	LANGUAGE c IMMUTABLE LEAKPROOF;
+
+CREATE OR REPLACE FUNCTION public.cbor_paths_as_bytes(bytea, text[])
+	RETURNS bytea[] AS
+	'pg_cbor.so', 'cbor_paths_as_bytes'
+	LANGUAGE c IMMUTABLE LEAKPROOF;
+
+CREATE OR REPLACE FUNCTION public.cbor_paths_as_int(bytea, text[])
+	RETURNS bigint[] AS
+	'pg_cbor.so', 'cbor_paths_as_int'
+	LANGUAGE c IMMUTABLE LEAKPROOF;
+
+CREATE OR REPLACE FUNCTION public.cbor_paths_as_float(bytea, text[])
+	RETURNS double precision[] AS
+	'pg_cbor.so', 'cbor_paths_as_float'
+	LANGUAGE c IMMUTABLE LEAKPROOF;
+
+CREATE OR REPLACE FUNCTION public.cbor_paths_as_bool(bytea, text[])
+	RETURNS boolean[] AS
+	'pg_cbor.so', 'cbor_paths_as_bool'
+	LANGUAGE c IMMUTABLE LEAKPROOF;
+
+CREATE OR REPLACE FUNCTION public.cbor_each(bytea, OUT key text, OUT value bytea)
+	RETURNS SETOF record AS
+	'pg_cbor.so', 'cbor_each'
+	LANGUAGE c IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION public.cbor_each_text(bytea, OUT key text, OUT value text)
+	RETURNS SETOF record AS
+	'pg_cbor.so', 'cbor_each_text'
+	LANGUAGE c IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION public.cbor_array_elements(bytea)
+	RETURNS SETOF bytea AS
+	'pg_cbor.so', 'cbor_array_elements'
+	LANGUAGE c IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION public.cbor_array_elements_text(bytea)
+	RETURNS SETOF text AS
+	'pg_cbor.so', 'cbor_array_elements_text'
+	LANGUAGE c IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION public.cbor_object_keys(bytea)
+	RETURNS SETOF text AS
+	'pg_cbor.so', 'cbor_object_keys'
+	LANGUAGE c IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION public.cbor_array_length(bytea)
+	RETURNS integer AS
+	'pg_cbor.so', 'cbor_array_length'
+	LANGUAGE c IMMUTABLE STRICT;
+
+CREATE TYPE public.cbor_path;
+
+CREATE OR REPLACE FUNCTION public.cbor_path_in(cstring)
+	RETURNS cbor_path AS
+	'pg_cbor.so', 'cbor_path_in'
+	LANGUAGE c IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION public.cbor_path_out(cbor_path)
+	RETURNS cstring AS
+	'pg_cbor.so', 'cbor_path_out'
+	LANGUAGE c IMMUTABLE STRICT;
+
+CREATE TYPE public.cbor_path (
+	INPUT = cbor_path_in,
+	OUTPUT = cbor_path_out,
+	INTERNALLENGTH = VARIABLE,
+	ALIGNMENT = int4,
+	STORAGE = extended
+);
+
+CREATE OR REPLACE FUNCTION public.cbor_path(text[])
+	RETURNS cbor_path AS
+	'pg_cbor.so', 'cbor_path_from_text_array'
+	LANGUAGE c IMMUTABLE STRICT;
+
+CREATE CAST (text[] AS cbor_path) WITH FUNCTION public.cbor_path(text[]) AS ASSIGNMENT;
+
+CREATE OR REPLACE FUNCTION public.cbor_extract_path(bytea, cbor_path)
+	RETURNS bytea AS
+	'pg_cbor.so', 'cbor_extract_path'
+	LANGUAGE c IMMUTABLE LEAKPROOF;
+
+CREATE OR REPLACE FUNCTION public.cbor_extract_path_text(bytea, cbor_path)
+	RETURNS text AS
+	'pg_cbor.so', 'cbor_extract_path_text'
+	LANGUAGE c IMMUTABLE LEAKPROOF;
+
+CREATE OR REPLACE FUNCTION public.cbor_path_as_text(bytea, cbor_path)
+	RETURNS text AS
+	'pg_cbor.so', 'cbor_path_as_text'
+	LANGUAGE c IMMUTABLE LEAKPROOF;
+
+CREATE OR REPLACE FUNCTION public.cbor_path_as_bytes(bytea, cbor_path)
+	RETURNS bytea AS
+	'pg_cbor.so', 'cbor_path_as_bytes'
+	LANGUAGE c IMMUTABLE LEAKPROOF;
+
+CREATE OR REPLACE FUNCTION public.cbor_path_as_int(bytea, cbor_path)
+	RETURNS bigint AS
+	'pg_cbor.so', 'cbor_path_as_int'
+	LANGUAGE c IMMUTABLE LEAKPROOF;
+
+CREATE OR REPLACE FUNCTION public.cbor_path_as_float(bytea, cbor_path)
+	RETURNS double precision AS
+	'pg_cbor.so', 'cbor_path_as_float'
+	LANGUAGE c IMMUTABLE LEAKPROOF;
+
+CREATE OR REPLACE FUNCTION public.cbor_path_as_bool(bytea, cbor_path)
+	RETURNS boolean AS
+	'pg_cbor.so', 'cbor_path_as_bool'
+	LANGUAGE c IMMUTABLE LEAKPROOF;
+
+CREATE OR REPLACE FUNCTION public.cbor_to_jsonb(bytea)
+	RETURNS jsonb AS
+	'pg_cbor.so', 'cbor_to_jsonb'
+	LANGUAGE c IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION public.jsonb_to_cbor(jsonb)
+	RETURNS bytea AS
+	'pg_cbor.so', 'jsonb_to_cbor'
+	LANGUAGE c IMMUTABLE STRICT;
+
+CREATE CAST (bytea AS jsonb) WITH FUNCTION public.cbor_to_jsonb(bytea);
+CREATE CAST (jsonb AS bytea) WITH FUNCTION public.jsonb_to_cbor(jsonb);
+
+CREATE OR REPLACE FUNCTION public.cbor_exists(bytea, text)
+	RETURNS boolean AS
+	'pg_cbor.so', 'cbor_exists'
+	LANGUAGE c IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION public.cbor_exists_any(bytea, text[])
+	RETURNS boolean AS
+	'pg_cbor.so', 'cbor_exists_any'
+	LANGUAGE c IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION public.cbor_exists_all(bytea, text[])
+	RETURNS boolean AS
+	'pg_cbor.so', 'cbor_exists_all'
+	LANGUAGE c IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION public.cbor_contains(bytea, bytea)
+	RETURNS boolean AS
+	'pg_cbor.so', 'cbor_contains'
+	LANGUAGE c IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION public.cbor_contained(bytea, bytea)
+	RETURNS boolean AS
+	'pg_cbor.so', 'cbor_contained'
+	LANGUAGE c IMMUTABLE STRICT;
+
+CREATE OPERATOR public.? (
+	LEFTARG = bytea,
+	RIGHTARG = text,
+	PROCEDURE = public.cbor_exists,
+	RESTRICT = contsel,
+	JOIN = contjoinsel
+);
+
+CREATE OPERATOR public.?| (
+	LEFTARG = bytea,
+	RIGHTARG = text[],
+	PROCEDURE = public.cbor_exists_any,
+	RESTRICT = contsel,
+	JOIN = contjoinsel
+);
+
+CREATE OPERATOR public.?& (
+	LEFTARG = bytea,
+	RIGHTARG = text[],
+	PROCEDURE = public.cbor_exists_all,
+	RESTRICT = contsel,
+	JOIN = contjoinsel
+);
+
+CREATE OPERATOR public.@> (
+	LEFTARG = bytea,
+	RIGHTARG = bytea,
+	PROCEDURE = public.cbor_contains,
+	COMMUTATOR = '<@',
+	RESTRICT = contsel,
+	JOIN = contjoinsel
+);
+
+CREATE OPERATOR public.<@ (
+	LEFTARG = bytea,
+	RIGHTARG = bytea,
+	PROCEDURE = public.cbor_contained,
+	COMMUTATOR = '@>',
+	RESTRICT = contsel,
+	JOIN = contjoinsel
+);
+
+CREATE TYPE public.cbor;
+
+CREATE OR REPLACE FUNCTION public.cbor_in(cstring, oid, integer)
+	RETURNS cbor AS
+	'pg_cbor.so', 'cbor_in'
+	LANGUAGE c IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION public.cbor_out(cbor)
+	RETURNS cstring AS
+	'pg_cbor.so', 'cbor_out'
+	LANGUAGE c IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION public.cbor_recv(internal, oid, integer)
+	RETURNS cbor AS
+	'pg_cbor.so', 'cbor_recv'
+	LANGUAGE c IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION public.cbor_send(cbor)
+	RETURNS bytea AS
+	'pg_cbor.so', 'cbor_send'
+	LANGUAGE c IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION public.cbor_typmod_in(cstring[])
+	RETURNS integer AS
+	'pg_cbor.so', 'cbor_typmod_in'
+	LANGUAGE c IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION public.cbor_typmod_out(integer)
+	RETURNS cstring AS
+	'pg_cbor.so', 'cbor_typmod_out'
+	LANGUAGE c IMMUTABLE STRICT;
+
+CREATE TYPE public.cbor (
+	INPUT = cbor_in,
+	OUTPUT = cbor_out,
+	RECEIVE = cbor_recv,
+	SEND = cbor_send,
+	TYPMOD_IN = cbor_typmod_in,
+	TYPMOD_OUT = cbor_typmod_out,
+	INTERNALLENGTH = VARIABLE,
+	ALIGNMENT = int4,
+	STORAGE = extended,
+	CATEGORY = 'U'
+);
+
+CREATE OR REPLACE FUNCTION public.cbor(cbor, integer, boolean)
+	RETURNS cbor AS
+	'pg_cbor.so', 'cbor_coerce'
+	LANGUAGE c IMMUTABLE STRICT;
+
+CREATE CAST (cbor AS cbor) WITH FUNCTION public.cbor(cbor, integer, boolean) AS IMPLICIT;
+
+CREATE OR REPLACE FUNCTION public.cbor(bytea)
+	RETURNS cbor AS
+	'pg_cbor.so', 'cbor_from_bytea'
+	LANGUAGE c IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION public.bytea(cbor)
+	RETURNS bytea AS
+	'pg_cbor.so', 'cbor_to_bytea'
+	LANGUAGE c IMMUTABLE STRICT;
+
+CREATE CAST (bytea AS cbor) WITH FUNCTION public.cbor(bytea) AS ASSIGNMENT;
+CREATE CAST (cbor AS bytea) WITH FUNCTION public.bytea(cbor) AS ASSIGNMENT;
+
+CREATE OR REPLACE FUNCTION public.cbor(jsonb)
+	RETURNS cbor AS
+	'pg_cbor.so', 'jsonb_to_cbor'
+	LANGUAGE c IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION public.cbor_to_jsonb(cbor)
+	RETURNS jsonb AS
+	'pg_cbor.so', 'cbor_to_jsonb'
+	LANGUAGE c IMMUTABLE STRICT;
+
+CREATE CAST (jsonb AS cbor) WITH FUNCTION public.cbor(jsonb);
+CREATE CAST (cbor AS jsonb) WITH FUNCTION public.cbor_to_jsonb(cbor);
+
+CREATE OR REPLACE FUNCTION public.cbor_to_string(cbor)
+	RETURNS text AS
+	'pg_cbor.so', 'cbor_to_string'
+	LANGUAGE c IMMUTABLE LEAKPROOF;
+
+CREATE OR REPLACE FUNCTION public.cbor_to_json(cbor)
+	RETURNS text AS
+	'pg_cbor.so', 'cbor_to_json'
+	LANGUAGE c IMMUTABLE;
+
+CREATE OR REPLACE FUNCTION public.cbor_is_valid(cbor)
+	RETURNS boolean AS
+	'pg_cbor.so', 'cbor_is_valid'
+	LANGUAGE c IMMUTABLE LEAKPROOF;
+
+CREATE OR REPLACE FUNCTION public.cbor_is_canonical(cbor)
+	RETURNS boolean AS
+	'pg_cbor.so', 'cbor_is_canonical'
+	LANGUAGE c IMMUTABLE LEAKPROOF;
+
+CREATE OR REPLACE FUNCTION public.cbor_canonicalize(cbor)
+	RETURNS cbor AS
+	'pg_cbor.so', 'cbor_canonicalize'
+	LANGUAGE c IMMUTABLE;
+
+CREATE OR REPLACE FUNCTION public.cbor_extract_path(cbor, VARIADIC text[])
+	RETURNS cbor AS
+	'pg_cbor.so', 'cbor_extract_path'
+	LANGUAGE c IMMUTABLE LEAKPROOF;
+
+CREATE OR REPLACE FUNCTION public.cbor_extract_path_text(cbor, VARIADIC text[])
+	RETURNS text AS
+	'pg_cbor.so', 'cbor_extract_path_text'
+	LANGUAGE c IMMUTABLE LEAKPROOF;
+
+CREATE OR REPLACE FUNCTION public.cbor_path_as_text(cbor, VARIADIC text[])
+	RETURNS text AS
+	'pg_cbor.so', 'cbor_path_as_text'
+	LANGUAGE c IMMUTABLE LEAKPROOF;
+
+CREATE OR REPLACE FUNCTION public.cbor_path_as_bytes(cbor, VARIADIC text[])
+	RETURNS bytea AS
+	'pg_cbor.so', 'cbor_path_as_bytes'
+	LANGUAGE c IMMUTABLE LEAKPROOF;
+
+CREATE OR REPLACE FUNCTION public.cbor_path_as_int(cbor, VARIADIC text[])
+	RETURNS bigint AS
+	'pg_cbor.so', 'cbor_path_as_int'
+	LANGUAGE c IMMUTABLE LEAKPROOF;
+
+CREATE OR REPLACE FUNCTION public.cbor_path_as_float(cbor, VARIADIC text[])
+	RETURNS double precision AS
+	'pg_cbor.so', 'cbor_path_as_float'
+	LANGUAGE c IMMUTABLE LEAKPROOF;
+
+CREATE OR REPLACE FUNCTION public.cbor_path_as_bool(cbor, VARIADIC text[])
+	RETURNS boolean AS
+	'pg_cbor.so', 'cbor_path_as_bool'
+	LANGUAGE c IMMUTABLE LEAKPROOF;
+
+CREATE OR REPLACE FUNCTION public.cbor_extract_paths(cbor, text[])
+	RETURNS cbor[] AS
+	'pg_cbor.so', 'cbor_extract_paths'
+	LANGUAGE c IMMUTABLE LEAKPROOF;
+
+CREATE OR REPLACE FUNCTION public.cbor_extract_paths_text(cbor, text[])
+	RETURNS text[] AS
+	'pg_cbor.so', 'cbor_extract_paths_text'
+	LANGUAGE c IMMUTABLE LEAKPROOF;
+
+CREATE OR REPLACE FUNCTION public.cbor_paths_as_text(cbor, text[])
+	RETURNS text[] AS
+	'pg_cbor.so', 'cbor_paths_as_text'
+	LANGUAGE c IMMUTABLE LEAKPROOF;
+
+CREATE OR REPLACE FUNCTION public.cbor_paths_as_bytes(cbor, text[])
+	RETURNS bytea[] AS
+	'pg_cbor.so', 'cbor_paths_as_bytes'
+	LANGUAGE c IMMUTABLE LEAKPROOF;
+
+CREATE OR REPLACE FUNCTION public.cbor_paths_as_int(cbor, text[])
+	RETURNS bigint[] AS
+	'pg_cbor.so', 'cbor_paths_as_int'
+	LANGUAGE c IMMUTABLE LEAKPROOF;
+
+CREATE OR REPLACE FUNCTION public.cbor_paths_as_float(cbor, text[])
+	RETURNS double precision[] AS
+	'pg_cbor.so', 'cbor_paths_as_float'
+	LANGUAGE c IMMUTABLE LEAKPROOF;
+
+CREATE OR REPLACE FUNCTION public.cbor_paths_as_bool(cbor, text[])
+	RETURNS boolean[] AS
+	'pg_cbor.so', 'cbor_paths_as_bool'
+	LANGUAGE c IMMUTABLE LEAKPROOF;
+
+CREATE OR REPLACE FUNCTION public.cbor_each(cbor, OUT key text, OUT value cbor)
+	RETURNS SETOF record AS
+	'pg_cbor.so', 'cbor_each'
+	LANGUAGE c IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION public.cbor_each_text(cbor, OUT key text, OUT value text)
+	RETURNS SETOF record AS
+	'pg_cbor.so', 'cbor_each_text'
+	LANGUAGE c IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION public.cbor_array_elements(cbor)
+	RETURNS SETOF cbor AS
+	'pg_cbor.so', 'cbor_array_elements'
+	LANGUAGE c IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION public.cbor_array_elements_text(cbor)
+	RETURNS SETOF text AS
+	'pg_cbor.so', 'cbor_array_elements_text'
+	LANGUAGE c IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION public.cbor_object_keys(cbor)
+	RETURNS SETOF text AS
+	'pg_cbor.so', 'cbor_object_keys'
+	LANGUAGE c IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION public.cbor_array_length(cbor)
+	RETURNS integer AS
+	'pg_cbor.so', 'cbor_array_length'
+	LANGUAGE c IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION public.cbor_extract_path(cbor, cbor_path)
+	RETURNS cbor AS
+	'pg_cbor.so', 'cbor_extract_path'
+	LANGUAGE c IMMUTABLE LEAKPROOF;
+
+CREATE OR REPLACE FUNCTION public.cbor_extract_path_text(cbor, cbor_path)
+	RETURNS text AS
+	'pg_cbor.so', 'cbor_extract_path_text'
+	LANGUAGE c IMMUTABLE LEAKPROOF;
+
+CREATE OR REPLACE FUNCTION public.cbor_path_as_text(cbor, cbor_path)
+	RETURNS text AS
+	'pg_cbor.so', 'cbor_path_as_text'
+	LANGUAGE c IMMUTABLE LEAKPROOF;
+
+CREATE OR REPLACE FUNCTION public.cbor_path_as_bytes(cbor, cbor_path)
+	RETURNS bytea AS
+	'pg_cbor.so', 'cbor_path_as_bytes'
+	LANGUAGE c IMMUTABLE LEAKPROOF;
+
+CREATE OR REPLACE FUNCTION public.cbor_path_as_int(cbor, cbor_path)
+	RETURNS bigint AS
+	'pg_cbor.so', 'cbor_path_as_int'
+	LANGUAGE c IMMUTABLE LEAKPROOF;
+
+CREATE OR REPLACE FUNCTION public.cbor_path_as_float(cbor, cbor_path)
+	RETURNS double precision AS
+	'pg_cbor.so', 'cbor_path_as_float'
+	LANGUAGE c IMMUTABLE LEAKPROOF;
+
+CREATE OR REPLACE FUNCTION public.cbor_path_as_bool(cbor, cbor_path)
+	RETURNS boolean AS
+	'pg_cbor.so', 'cbor_path_as_bool'
+	LANGUAGE c IMMUTABLE LEAKPROOF;
+
+CREATE OR REPLACE FUNCTION public.cbor_exists(cbor, text)
+	RETURNS boolean AS
+	'pg_cbor.so', 'cbor_exists'
+	LANGUAGE c IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION public.cbor_exists_any(cbor, text[])
+	RETURNS boolean AS
+	'pg_cbor.so', 'cbor_exists_any'
+	LANGUAGE c IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION public.cbor_exists_all(cbor, text[])
+	RETURNS boolean AS
+	'pg_cbor.so', 'cbor_exists_all'
+	LANGUAGE c IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION public.cbor_contains(cbor, cbor)
+	RETURNS boolean AS
+	'pg_cbor.so', 'cbor_contains'
+	LANGUAGE c IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION public.cbor_contained(cbor, cbor)
+	RETURNS boolean AS
+	'pg_cbor.so', 'cbor_contained'
+	LANGUAGE c IMMUTABLE STRICT;
+
+CREATE OPERATOR public.? (
+	LEFTARG = cbor,
+	RIGHTARG = text,
+	PROCEDURE = public.cbor_exists,
+	RESTRICT = contsel,
+	JOIN = contjoinsel
+);
+
+CREATE OPERATOR public.?| (
+	LEFTARG = cbor,
+	RIGHTARG = text[],
+	PROCEDURE = public.cbor_exists_any,
+	RESTRICT = contsel,
+	JOIN = contjoinsel
+);
+
+CREATE OPERATOR public.?& (
+	LEFTARG = cbor,
+	RIGHTARG = text[],
+	PROCEDURE = public.cbor_exists_all,
+	RESTRICT = contsel,
+	JOIN = contjoinsel
+);
+
+CREATE OPERATOR public.@> (
+	LEFTARG = cbor,
+	RIGHTARG = cbor,
+	PROCEDURE = public.cbor_contains,
+	COMMUTATOR = '<@',
+	RESTRICT = contsel,
+	JOIN = contjoinsel
+);
+
+CREATE OPERATOR public.<@ (
+	LEFTARG = cbor,
+	RIGHTARG = cbor,
+	PROCEDURE = public.cbor_contained,
+	COMMUTATOR = '@>',
+	RESTRICT = contsel,
+	JOIN = contjoinsel
+);
+
+CREATE OR REPLACE FUNCTION public.cbor_object_field(cbor, text)
+	RETURNS cbor AS
+	'pg_cbor.so', 'cbor_extract_path'
+	LANGUAGE c IMMUTABLE LEAKPROOF;
+
+CREATE OR REPLACE FUNCTION public.cbor_array_element(cbor, integer)
+	RETURNS cbor AS
+	'pg_cbor.so', 'cbor_extract_path'
+	LANGUAGE c IMMUTABLE LEAKPROOF;
+
+CREATE OR REPLACE FUNCTION public.cbor_object_field_text(cbor, text)
+	RETURNS text AS
+	'pg_cbor.so', 'cbor_extract_path_text'
+	LANGUAGE c IMMUTABLE LEAKPROOF;
+
+CREATE OR REPLACE FUNCTION public.cbor_array_element_text(cbor, integer)
+	RETURNS text AS
+	'pg_cbor.so', 'cbor_extract_path_text'
+	LANGUAGE c IMMUTABLE LEAKPROOF;
+
+CREATE OR REPLACE FUNCTION public.cbor_extract_path_op(cbor, text[])
+	RETURNS cbor AS
+	'pg_cbor.so', 'cbor_extract_path'
+	LANGUAGE c IMMUTABLE LEAKPROOF;
+
+CREATE OR REPLACE FUNCTION public.cbor_extract_path_text_op(cbor, text[])
+	RETURNS text AS
+	'pg_cbor.so', 'cbor_extract_path_text'
+	LANGUAGE c IMMUTABLE LEAKPROOF;
+
+CREATE OPERATOR public.-> (
+	LEFTARG = cbor,
+	RIGHTARG = text,
+	PROCEDURE = public.cbor_object_field
+);
+
+CREATE OPERATOR public.-> (
+	LEFTARG = cbor,
+	RIGHTARG = integer,
+	PROCEDURE = public.cbor_array_element
+);
+
+CREATE OPERATOR public.->> (
+	LEFTARG = cbor,
+	RIGHTARG = text,
+	PROCEDURE = public.cbor_object_field_text
+);
+
+CREATE OPERATOR public.->> (
+	LEFTARG = cbor,
+	RIGHTARG = integer,
+	PROCEDURE = public.cbor_array_element_text
+);
+
+CREATE OPERATOR public.#> (
+	LEFTARG = cbor,
+	RIGHTARG = text[],
+	PROCEDURE = public.cbor_extract_path_op
+);
+
+CREATE OPERATOR public.#>> (
+	LEFTARG = cbor,
+	RIGHTARG = text[],
+	PROCEDURE = public.cbor_extract_path_text_op
+);
+
+CREATE OR REPLACE FUNCTION public.cbor_path_equals(cbor, text[], cbor)
+	RETURNS boolean AS
+	'pg_cbor.so', 'cbor_path_equals'
+	LANGUAGE c IMMUTABLE STRICT;
+
+-- planner support functions are available since PostgreSQL 12
+DO $$
+BEGIN
+	IF current_setting('server_version_num')::integer >= 120000 THEN
+		CREATE OR REPLACE FUNCTION public.cbor_path_support(internal)
+			RETURNS internal AS
+			'pg_cbor.so', 'cbor_path_support'
+			LANGUAGE c IMMUTABLE STRICT;
+
+		ALTER FUNCTION public.cbor_object_field(cbor, text) SUPPORT public.cbor_path_support;
+		ALTER FUNCTION public.cbor_array_element(cbor, integer) SUPPORT public.cbor_path_support;
+		ALTER FUNCTION public.cbor_object_field_text(cbor, text) SUPPORT public.cbor_path_support;
+		ALTER FUNCTION public.cbor_array_element_text(cbor, integer) SUPPORT public.cbor_path_support;
+		ALTER FUNCTION public.cbor_extract_path_op(cbor, text[]) SUPPORT public.cbor_path_support;
+		ALTER FUNCTION public.cbor_extract_path_text_op(cbor, text[]) SUPPORT public.cbor_path_support;
+		ALTER FUNCTION public.cbor_path_equals(cbor, text[], cbor) SUPPORT public.cbor_path_support;
+	END IF;
+END
+$$;
+
+CREATE OR REPLACE FUNCTION public.cbor_gin_extract_value(cbor, internal, internal)
+	RETURNS internal AS
+	'pg_cbor.so', 'cbor_gin_extract_value'
+	LANGUAGE c IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION public.cbor_gin_extract_query(cbor, internal, int2, internal, internal, internal, internal)
+	RETURNS internal AS
+	'pg_cbor.so', 'cbor_gin_extract_query'
+	LANGUAGE c IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION public.cbor_gin_consistent(internal, int2, cbor, int4, internal, internal, internal, internal)
+	RETURNS boolean AS
+	'pg_cbor.so', 'cbor_gin_consistent'
+	LANGUAGE c IMMUTABLE STRICT;
+
+CREATE OPERATOR CLASS public.cbor_ops
+	DEFAULT FOR TYPE cbor USING gin AS
+	OPERATOR 7 @> (cbor, cbor),
+	OPERATOR 9 ? (cbor, text),
+	OPERATOR 10 ?| (cbor, text[]),
+	OPERATOR 11 ?& (cbor, text[]),
+	FUNCTION 1 byteacmp(bytea, bytea),
+	FUNCTION 2 public.cbor_gin_extract_value(cbor, internal, internal),
+	FUNCTION 3 public.cbor_gin_extract_query(cbor, internal, int2, internal, internal, internal, internal),
+	FUNCTION 4 public.cbor_gin_consistent(internal, int2, cbor, int4, internal, internal, internal, internal),
+	STORAGE bytea;
+
+CREATE OR REPLACE FUNCTION public.cbor_gin_extract_value_path(cbor, internal, internal)
+	RETURNS internal AS
+	'pg_cbor.so', 'cbor_gin_extract_value_path'
+	LANGUAGE c IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION public.cbor_gin_extract_query_path(cbor, internal, int2, internal, internal, internal, internal)
+	RETURNS internal AS
+	'pg_cbor.so', 'cbor_gin_extract_query_path'
+	LANGUAGE c IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION public.cbor_gin_consistent_path(internal, int2, cbor, int4, internal, internal, internal, internal)
+	RETURNS boolean AS
+	'pg_cbor.so', 'cbor_gin_consistent_path'
+	LANGUAGE c IMMUTABLE STRICT;
+
+CREATE OPERATOR CLASS public.cbor_path_ops
+	FOR TYPE cbor USING gin AS
+	OPERATOR 7 @> (cbor, cbor),
+	FUNCTION 1 btint4cmp(int4, int4),
+	FUNCTION 2 public.cbor_gin_extract_value_path(cbor, internal, internal),
+	FUNCTION 3 public.cbor_gin_extract_query_path(cbor, internal, int2, internal, internal, internal, internal),
+	FUNCTION 4 public.cbor_gin_consistent_path(internal, int2, cbor, int4, internal, internal, internal, internal),
+	STORAGE int4;
+
+CREATE OR REPLACE FUNCTION public.cbor_cmp(cbor, cbor)
+	RETURNS integer AS
+	'pg_cbor.so', 'cbor_cmp'
+	LANGUAGE c IMMUTABLE STRICT LEAKPROOF;
+
+CREATE OR REPLACE FUNCTION public.cbor_lt(cbor, cbor)
+	RETURNS boolean AS
+	'pg_cbor.so', 'cbor_lt'
+	LANGUAGE c IMMUTABLE STRICT LEAKPROOF;
+
+CREATE OR REPLACE FUNCTION public.cbor_le(cbor, cbor)
+	RETURNS boolean AS
+	'pg_cbor.so', 'cbor_le'
+	LANGUAGE c IMMUTABLE STRICT LEAKPROOF;
+
+CREATE OR REPLACE FUNCTION public.cbor_eq(cbor, cbor)
+	RETURNS boolean AS
+	'pg_cbor.so', 'cbor_eq'
+	LANGUAGE c IMMUTABLE STRICT LEAKPROOF;
+
+CREATE OR REPLACE FUNCTION public.cbor_ne(cbor, cbor)
+	RETURNS boolean AS
+	'pg_cbor.so', 'cbor_ne'
+	LANGUAGE c IMMUTABLE STRICT LEAKPROOF;
+
+CREATE OR REPLACE FUNCTION public.cbor_ge(cbor, cbor)
+	RETURNS boolean AS
+	'pg_cbor.so', 'cbor_ge'
+	LANGUAGE c IMMUTABLE STRICT LEAKPROOF;
+
+CREATE OR REPLACE FUNCTION public.cbor_gt(cbor, cbor)
+	RETURNS boolean AS
+	'pg_cbor.so', 'cbor_gt'
+	LANGUAGE c IMMUTABLE STRICT LEAKPROOF;
+
+CREATE OR REPLACE FUNCTION public.cbor_sortsupport(internal)
+	RETURNS void AS
+	'pg_cbor.so', 'cbor_sortsupport'
+	LANGUAGE c IMMUTABLE STRICT;
+
+CREATE OPERATOR public.< (
+	LEFTARG = cbor,
+	RIGHTARG = cbor,
+	PROCEDURE = public.cbor_lt,
+	COMMUTATOR = '>',
+	NEGATOR = '>=',
+	RESTRICT = scalarltsel,
+	JOIN = scalarltjoinsel
+);
+
+CREATE OPERATOR public.<= (
+	LEFTARG = cbor,
+	RIGHTARG = cbor,
+	PROCEDURE = public.cbor_le,
+	COMMUTATOR = '>=',
+	NEGATOR = '>',
+	RESTRICT = scalarltsel,
+	JOIN = scalarltjoinsel
+);
+
+CREATE OPERATOR public.= (
+	LEFTARG = cbor,
+	RIGHTARG = cbor,
+	PROCEDURE = public.cbor_eq,
+	COMMUTATOR = '=',
+	NEGATOR = '<>',
+	RESTRICT = eqsel,
+	JOIN = eqjoinsel,
+	MERGES,
+	HASHES
+);
+
+CREATE OPERATOR public.<> (
+	LEFTARG = cbor,
+	RIGHTARG = cbor,
+	PROCEDURE = public.cbor_ne,
+	COMMUTATOR = '<>',
+	NEGATOR = '=',
+	RESTRICT = neqsel,
+	JOIN = neqjoinsel
+);
+
+CREATE OPERATOR public.>= (
+	LEFTARG = cbor,
+	RIGHTARG = cbor,
+	PROCEDURE = public.cbor_ge,
+	COMMUTATOR = '<=',
+	NEGATOR = '<',
+	RESTRICT = scalargtsel,
+	JOIN = scalargtjoinsel
+);
+
+CREATE OPERATOR public.> (
+	LEFTARG = cbor,
+	RIGHTARG = cbor,
+	PROCEDURE = public.cbor_gt,
+	COMMUTATOR = '<',
+	NEGATOR = '<=',
+	RESTRICT = scalargtsel,
+	JOIN = scalargtjoinsel
+);
+
+CREATE OPERATOR CLASS public.cbor_ops
+	DEFAULT FOR TYPE cbor USING btree AS
+	OPERATOR 1 < (cbor, cbor),
+	OPERATOR 2 <= (cbor, cbor),
+	OPERATOR 3 = (cbor, cbor),
+	OPERATOR 4 >= (cbor, cbor),
+	OPERATOR 5 > (cbor, cbor),
+	FUNCTION 1 public.cbor_cmp(cbor, cbor),
+	FUNCTION 2 public.cbor_sortsupport(internal);
+
+CREATE OR REPLACE FUNCTION public.cbor_hash(bytea)
+	RETURNS integer AS
+	'pg_cbor.so', 'cbor_hash'
+	LANGUAGE c IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION public.cbor_hash(cbor)
+	RETURNS integer AS
+	'pg_cbor.so', 'cbor_type_hash'
+	LANGUAGE c IMMUTABLE STRICT;
+
+CREATE OPERATOR CLASS public.cbor_ops
+	DEFAULT FOR TYPE cbor USING hash AS
+	OPERATOR 1 = (cbor, cbor),
+	FUNCTION 1 public.cbor_hash(cbor);
+
+-- extended hash support functions are available since PostgreSQL 11
+DO $$
+BEGIN
+	IF current_setting('server_version_num')::integer >= 110000 THEN
+		CREATE OR REPLACE FUNCTION public.cbor_hash_extended(bytea, int8)
+			RETURNS int8 AS
+			'pg_cbor.so', 'cbor_hash_extended'
+			LANGUAGE c IMMUTABLE STRICT;
+
+		CREATE OR REPLACE FUNCTION public.cbor_hash_extended(cbor, int8)
+			RETURNS int8 AS
+			'pg_cbor.so', 'cbor_type_hash_extended'
+			LANGUAGE c IMMUTABLE STRICT;
+
+		ALTER OPERATOR FAMILY public.cbor_ops USING hash ADD
+			FUNCTION 2 public.cbor_hash_extended(cbor, int8);
+	END IF;
+END
+$$;
+
+CREATE OR REPLACE FUNCTION public.cbor_set(bytea, text[], bytea, create_missing boolean DEFAULT true)
+	RETURNS bytea AS
+	'pg_cbor.so', 'cbor_set'
+	LANGUAGE c IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION public.cbor_insert(bytea, text[], bytea, insert_after boolean DEFAULT false)
+	RETURNS bytea AS
+	'pg_cbor.so', 'cbor_insert'
+	LANGUAGE c IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION public.cbor_delete_path(bytea, text[])
+	RETURNS bytea AS
+	'pg_cbor.so', 'cbor_delete_path'
+	LANGUAGE c IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION public.cbor_set(cbor, text[], cbor, create_missing boolean DEFAULT true)
+	RETURNS cbor AS
+	'pg_cbor.so', 'cbor_set'
+	LANGUAGE c IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION public.cbor_insert(cbor, text[], cbor, insert_after boolean DEFAULT false)
+	RETURNS cbor AS
+	'pg_cbor.so', 'cbor_insert'
+	LANGUAGE c IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION public.cbor_delete_path(cbor, text[])
+	RETURNS cbor AS
+	'pg_cbor.so', 'cbor_delete_path'
+	LANGUAGE c IMMUTABLE STRICT;
+
+CREATE OPERATOR public.#- (
+	LEFTARG = cbor,
+	RIGHTARG = text[],
+	PROCEDURE = public.cbor_delete_path
+);
+
+CREATE OR REPLACE FUNCTION public.cbor_concat(bytea, bytea)
+	RETURNS bytea AS
+	'pg_cbor.so', 'cbor_concat'
+	LANGUAGE c IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION public.cbor_merge_patch(bytea, bytea)
+	RETURNS bytea AS
+	'pg_cbor.so', 'cbor_merge_patch'
+	LANGUAGE c IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION public.cbor_concat(cbor, cbor)
+	RETURNS cbor AS
+	'pg_cbor.so', 'cbor_concat'
+	LANGUAGE c IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION public.cbor_merge_patch(cbor, cbor)
+	RETURNS cbor AS
+	'pg_cbor.so', 'cbor_merge_patch'
+	LANGUAGE c IMMUTABLE STRICT;
+
+CREATE OPERATOR public.|| (
+	LEFTARG = cbor,
+	RIGHTARG = cbor,
+	PROCEDURE = public.cbor_concat
+);
@@ -0,0 +1,5 @@
+-- {"a": 1, "b": null, "c": undefined, "d": "x"}
+SELECT key, value, value IS NULL AS isnull FROM cbor_each_text('\xd9d9f7a46161016162f66163f761646178'::bytea);
+SELECT value, value IS NULL AS isnull FROM cbor_array_elements_text('\xd9d9f78301f66178'::bytea) AS value;
+-- truncated object is not closed at the end of data
+SELECT * FROM cbor_each_text('\xd9d9f7a2616101'::bytea);
@@ -0,0 +1,4 @@
+SELECT '\xd9d9f7820102'::bytea::jsonb;
+SELECT '\xd9d9f782f93e00fb3fd3333333333334'::bytea::jsonb;
+-- truncated array is not closed at the end of data
+SELECT '\xd9d9f78201'::bytea::jsonb;
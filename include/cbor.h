@@ -5,6 +5,11 @@
 #include "cbor_alloc.h"
 #include "cbor_typeinfo.h"
 #include "cbor_iter.h"
+#include "cbor_encoder.h"
+#include "cbor_buffer.h"
+
+// enough for any integer or shortest double representation
+#define CBOR_NUMBER_MAX_SIZE 32
 
 typedef void (*CborWriterPlain) (void *, const char *, int);
 typedef void (*CborWriterFormat) (void *, const char *, ...);
@@ -13,10 +18,138 @@ struct CborWriter {
 	CborWriterPlain plain;
 	CborWriterFormat format;
 	void *ctx;
+	CborBuffer *buffer; // if set, output is written into buffer inline, without callbacks
 };
 
+/** Init writer, that outputs into buffer directly */
+void CborWriterInitBuffer(struct CborWriter *, CborBuffer *);
+
+static inline void CborWriterWrite(const struct CborWriter *writer, const char *data, size_t size) {
+	if (writer->buffer) {
+		CborBufferWrite(writer->buffer, data, size);
+	} else {
+		writer->plain(writer->ctx, data, (int)size);
+	}
+}
+
 bool CborToString(const struct CborWriter *writer, const uint8_t *data, uint32_t size);
 
 bool CborIteratorValueToString(const struct CborWriter *writer, CborIteratorContext *ctx);
 
+/** Write document as JSON (RFC 8949, section 6.1): byte strings as base64url, tags are omitted,
+ * undefined, other simple values and non-finite floats as null, non-string keys as their JSON text.
+ * Returns false if document is malformed or uses container as map key */
+bool CborToJson(const struct CborWriter *writer, const uint8_t *data, uint32_t size);
+
+/** Decimal integer without printf, buffer should be at least CBOR_NUMBER_MAX_SIZE, returns length */
+uint32_t CborFormatUnsigned(char *, uint64_t);
+
+/** Shortest decimal representation, that converts back into the same double, value should be finite */
+uint32_t CborFormatDouble(char *, double);
+
+/* Normalized scalar: type byte, followed by value. Equal scalars have equal normalized form
+ * regardless of encoding (argument width, float width, chunked strings), tags are not included */
+#define CBOR_SCALAR_UNSIGNED 'u' // 8 bytes, big-endian
+#define CBOR_SCALAR_NEGATIVE 'n' // 8 bytes, big-endian, value is -1 - n
+#define CBOR_SCALAR_FLOAT 'f' // 8 bytes, big-endian IEEE double, zero and NaN are canonical
+#define CBOR_SCALAR_BYTES 'b'
+#define CBOR_SCALAR_STRING 's'
+#define CBOR_SCALAR_SIMPLE 'x' // 1 byte, simple value (false, true, null, undefined or other)
+
+/** Append normalized scalar for current item, iterator should be stopped at value (not tag).
+ * Chunked strings are consumed up to their end token. Returns false for containers */
+bool CborIteratorNormalizeScalar(CborIteratorContext *, CborBuffer *);
+
+/** Append normalized scalar for standalone item bytes, leading tags are skipped */
+bool CborNormalizeScalar(const CborData *, CborBuffer *);
+
+/** Structural containment, like jsonb @>: object contains object with subset of its keys,
+ * where every value is contained by value for the same key; array contains array, where every element
+ * is contained by some of its elements; scalars are contained by equal scalars. Tags are ignored.
+ * Both documents are walked in encoded form, keys of wide data objects are looked up with hash index */
+bool CborContains(const uint8_t *data, size_t size, const uint8_t *query, size_t qsize);
+
+/** RFC 7396 merge patch of documents (with or without magic header), result (without magic header) is appended
+ * into buffer. Keys are equal, when their normalized scalars are equal, first of duplicate patch keys is used.
+ * Pairs, that are not changed by patch, are copied by byte ranges, map header is rewritten only when
+ * number of keys is changed. Returns false if document is malformed */
+bool CborMergePatch(CborBuffer *, const uint8_t *target, size_t tsize, const uint8_t *patch, size_t psize);
+
+/** Concatenation, like jsonb ||: arrays are joined, keys of right map replace keys of left map,
+ * other values are added to array as elements. Returns false if document is malformed */
+bool CborConcat(CborBuffer *, const uint8_t *a, size_t asize, const uint8_t *b, size_t bsize);
+
+/** Total order over documents (with or without magic header): simple values < numbers < byte strings
+ * < text strings < arrays < maps. Numbers are compared by value (integer sorts before equal float,
+ * NaN is the largest), strings - bytewise, containers - item by item, shorter first; map pairs are compared
+ * in encoded order. Tags are ignored, equal documents have equal normalized scalars */
+int CborCompare(const uint8_t *a, size_t asize, const uint8_t *b, size_t bsize);
+
+/** Sort key from leading value: CborCompare(a, b) < 0 implies CborCompareKey(a) <= CborCompareKey(b) */
+uint64_t CborCompareKey(const uint8_t *, size_t);
+
+/** Write deterministic encoding (RFC 8949, section 4.2.1) of document into encoder: shortest arguments,
+ * shortest float width, that keeps the value (NaN as f97e00), definite lengths with chunked strings joined,
+ * map pairs sorted bytewise by encoded key. Tags are kept. Returns false if document is malformed or map
+ * has duplicate keys, encoder state is undefined in this case */
+bool CborCanonicalize(CborEncoder *, const uint8_t *data, size_t size);
+
+/** Returns true if document (with or without magic header) is already in form, written by CborCanonicalize.
+ * Single pass without allocations, UTF-8 in text strings is not checked */
+bool CborIsCanonical(const uint8_t *data, size_t size);
+
+/** Hash form: canonical form without tags and with unsigned zero, map pairs with duplicate keys are kept
+ * and ordered by value. Documents, equal by CborCompare, have equal hash form, so its bytes can be hashed
+ * for equality. Map order is not significant for hash form (while CborCompare compares pairs in encoded order),
+ * that only adds collisions. Returns false if document is malformed */
+bool CborCanonicalizeForHash(CborEncoder *, const uint8_t *data, size_t size);
+
+/** Returns true if document is already in hash form, so its bytes can be hashed without copy */
+bool CborIsCanonicalForHash(const uint8_t *data, size_t size);
+
+/** 64-bit hash of hash form with seed. Canonical documents are hashed in single pass without copy
+ * (tags and negative zero are normalized on the fly, unless they are within map keys),
+ * other documents are converted into hash form first. Returns false if document is malformed */
+bool CborHash(const uint8_t *data, size_t size, uint64_t seed, uint64_t *hash);
+
+typedef enum {
+	CborByteEncodingHex,
+	CborByteEncodingBase64, // padded
+	CborByteEncodingBase64Url, // unpadded
+} CborByteEncoding;
+
+// nesting limit for containers with expected conversion tags, deeper tags are ignored
+#define CBOR_ENCODING_SCOPE_MAX 16
+
+/* Tracks expected conversion tags 21/22/23 (RFC 8949, section 3.4.5.2): tag applies
+ * to next item, for containers and chunked strings - to all nested items */
+typedef struct CborByteEncodingScope {
+	CborByteEncoding defaultEncoding;
+	CborByteEncoding pending; // encoding from tag, that applies to next item
+	bool hasPending;
+	uint32_t nscopes;
+	struct {
+		uint32_t depth; // iterator stack size for tagged container
+		CborByteEncoding encoding;
+	} scopes[CBOR_ENCODING_SCOPE_MAX];
+} CborByteEncodingScope;
+
+/** Lowercase hex, output should be at least 2 * size bytes, returns length */
+size_t CborHexEncode(char *, const uint8_t *, size_t);
+
+/** Padded base64, output should be at least (size + 2) / 3 * 4 bytes, returns length */
+size_t CborBase64Encode(char *, const uint8_t *, size_t);
+
+/** Unpadded base64url, output should be at least (size + 2) / 3 * 4 bytes, returns length */
+size_t CborBase64UrlEncode(char *, const uint8_t *, size_t);
+
+/** Max output size for encoding */
+size_t CborByteEncodingSize(CborByteEncoding, size_t);
+size_t CborByteEncode(CborByteEncoding, char *, const uint8_t *, size_t);
+
+void CborByteEncodingScopeInit(CborByteEncodingScope *, CborByteEncoding);
+
+/** Should be called for every token, returns encoding for byte strings of current item */
+CborByteEncoding CborByteEncodingScopeNext(CborByteEncodingScope *, const CborIteratorContext *);
+
 #endif /* INCLUDE_CBOR_H_ */
@@ -0,0 +1,58 @@
+
+#ifndef INCLUDE_CBOR_BUFFER_H_
+#define INCLUDE_CBOR_BUFFER_H_
+
+#include "cbor_alloc.h"
+
+#include <stdint.h>
+#include <string.h>
+
+/* Growable output buffer for text conversions
+ *
+ * Like CborEncoder, buffer can start with `reserved` bytes (like varlena header),
+ * so result can be handed off to caller without copy. Writes are inline,
+ * only growth goes through function call */
+typedef struct CborBuffer {
+	char *data;
+	size_t size; // including reserved prefix
+	size_t capacity;
+	size_t reserved;
+} CborBuffer;
+
+/** Init buffer with `reserved` unused bytes before data and initial capacity for `expected` bytes of output */
+void CborBufferInit(CborBuffer *, size_t reserved, size_t expected);
+void CborBufferFinalize(CborBuffer *);
+
+/** Grow capacity to fit `size` more bytes */
+void CborBufferGrow(CborBuffer *, size_t size);
+
+/** Returns space for at least `size` bytes at the end of buffer, caller should advance `size` by bytes written */
+static inline char *CborBufferReserve(CborBuffer *buf, size_t size) {
+	if (buf->size + size > buf->capacity) {
+		CborBufferGrow(buf, size);
+	}
+	return buf->data + buf->size;
+}
+
+static inline void CborBufferWrite(CborBuffer *buf, const char *data, size_t size) {
+	memcpy(CborBufferReserve(buf, size), data, size);
+	buf->size += size;
+}
+
+static inline void CborBufferWriteChar(CborBuffer *buf, char c) {
+	if (buf->size == buf->capacity) {
+		CborBufferGrow(buf, 1);
+	}
+	buf->data[buf->size ++] = c;
+}
+
+/** Returns data length (without reserved prefix) */
+static inline size_t CborBufferGetSize(const CborBuffer *buf) {
+	return buf->size - buf->reserved;
+}
+
+/** Take ownership of data (including reserved prefix), data should be released with CborFree,
+ * buffer is left empty */
+char *CborBufferRelease(CborBuffer *, size_t *size);
+
+#endif /* INCLUDE_CBOR_BUFFER_H_ */
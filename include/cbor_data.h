@@ -27,6 +27,7 @@ static inline bool CborDataOffset(CborData *data, uint32_t size) {
 		return true;
 	}
 
+	data->ptr += data->size;
 	data->size = 0;
 	return false;
 }
@@ -38,8 +39,35 @@ uint64_t CborDataGetUnsigned64(const CborData *);
 float CborDataGetFloat16(const CborData *);
 float CborDataGetFloat32(const CborData *);
 double CborDataGetFloat64(const CborData *);
+
+/** Half-precision float conversion, encoding rounds to nearest representable value */
+uint16_t CborDataEncodeFloat16(float);
+float CborDataDecodeFloat16(uint16_t);
+
 uint64_t CborDataGetUnsignedValue(const CborData *, uint8_t hint);
 
 uint64_t CborDataReadUnsignedValue(CborData *, uint8_t hint);
 
+/** Skip `count` complete data items (including nested containers, tags and chunked strings)
+ * using only header arithmetic, returns false if data is truncated or malformed */
+bool CborDataSkipItems(CborData *, uint32_t count);
+
+/** Skip items of indefinite-length container until (and including) its break byte */
+bool CborDataSkipUntilBreak(CborData *);
+
+typedef enum CborValidateFlags {
+	CborValidateStrict = 0,
+	CborValidateLegacySimple = 1 << 0, // accept two-byte simple values 24..31, used in RFC 7049 test vectors
+} CborValidateFlags;
+
+/** Check that data (with or without magic header) is single well-formed item:
+ * headers and lengths within bounds, break placement, nesting depth and UTF-8 in text strings */
+bool CborValidate(const uint8_t *, size_t);
+
+/** CborValidate with relaxed checks from CborValidateFlags */
+bool CborValidateWithFlags(const uint8_t *, size_t, uint32_t flags);
+
+/** Check that text is well-formed UTF-8 (RFC 3629), as required for content of text strings */
+bool CborValidateUtf8(const uint8_t *, const uint8_t *end);
+
 #endif /* INCLUDE_CBOR_DATA_H_ */
@@ -0,0 +1,90 @@
+
+#ifndef INCLUDE_CBOR_ENCODER_H_
+#define INCLUDE_CBOR_ENCODER_H_
+
+#include "cbor_data.h"
+#include "cbor_typeinfo.h"
+
+// container length is not known on begin, it will be back-patched by CborEncodeEnd
+#define CBOR_ENCODER_UNKNOWN_COUNT UINT32_MAX
+
+// container is written with undefined length header and closed with break
+#define CBOR_ENCODER_INDEFINITE (UINT32_MAX - 1)
+
+typedef struct CborEncoderFrame {
+	size_t offset; // offset of container header within buffer
+	uint32_t count; // declared number of items (keys and values for maps) or one of special values above
+	uint32_t items; // items written into container (keys and values for maps)
+	uint8_t major;
+} CborEncoderFrame;
+
+/* Growable output buffer for encoded document
+ *
+ * Buffer can start with `reserved` bytes, not used by encoder (like varlena header),
+ * so finished buffer can be handed off to caller without copy.
+ * Integers and lengths are always written with shortest header */
+typedef struct CborEncoder {
+	uint8_t *data;
+	size_t size; // including reserved prefix
+	size_t capacity;
+	size_t reserved;
+
+	size_t stackSize;
+	size_t stackCapacity;
+	CborEncoderFrame *stack;
+
+	bool tagged; // last item was a tag, next item is tag content
+} CborEncoder;
+
+/** Init encoder with `reserved` unused bytes before data, optionally writes magic header */
+void CborEncoderInit(CborEncoder *, size_t reserved, bool header);
+void CborEncoderFinalize(CborEncoder *);
+
+/** Ensure space for `size` more bytes */
+void CborEncoderReserve(CborEncoder *, size_t size);
+
+/** Returns encoded data (without reserved prefix) */
+static inline CborData CborEncoderGetData(const CborEncoder *enc) {
+	CborData ret = { enc->size - enc->reserved, enc->data + enc->reserved };
+	return ret;
+}
+
+/** Returns true if all containers are closed and at least one item was written */
+bool CborEncoderIsComplete(const CborEncoder *);
+
+/** Take ownership of buffer (including reserved prefix), buffer should be released with CborFree,
+ * encoder is left empty. Returns NULL if there are unclosed containers */
+uint8_t *CborEncoderRelease(CborEncoder *, size_t *size);
+
+void CborEncodeUnsigned(CborEncoder *, uint64_t);
+void CborEncodeNegative(CborEncoder *, uint64_t); // encodes -1 - value
+void CborEncodeInteger(CborEncoder *, int64_t);
+
+/** Encode with smallest float width (half, single or double), that represents value exactly */
+void CborEncodeFloat(CborEncoder *, double);
+void CborEncodeDouble(CborEncoder *, double); // always 64-bit
+
+void CborEncodeBool(CborEncoder *, bool);
+void CborEncodeNull(CborEncoder *);
+void CborEncodeUndefined(CborEncoder *);
+void CborEncodeSimple(CborEncoder *, uint8_t);
+
+void CborEncodeBytes(CborEncoder *, const uint8_t *, size_t);
+void CborEncodeString(CborEncoder *, const char *, size_t);
+
+/** Tag applies to next item */
+void CborEncodeTag(CborEncoder *, uint64_t);
+
+/** Begin container with `count` items (pairs for map), CBOR_ENCODER_UNKNOWN_COUNT or CBOR_ENCODER_INDEFINITE */
+void CborEncodeBeginArray(CborEncoder *, uint32_t count);
+void CborEncodeBeginMap(CborEncoder *, uint32_t count);
+
+/** Close current container, returns false if there is no open container,
+ * if number of written items does not match declared count or map has key without value;
+ * encoder state is left unchanged on failure, so missing items can be written before retry */
+bool CborEncodeEnd(CborEncoder *);
+
+/** Append single complete pre-encoded item (without magic header) */
+void CborEncodeRaw(CborEncoder *, const uint8_t *, size_t);
+
+#endif /* INCLUDE_CBOR_ENCODER_H_ */
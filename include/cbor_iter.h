@@ -3,9 +3,16 @@
 #define INCLUDE_CBOR_ITER_H_
 
 #include "cbor_data.h"
+#include "cbor_tape.h"
 
 #define CBOR_STACK_DEFAULT_SIZE 8
 
+// max size of item header: initial byte and 64-bit argument
+#define CBOR_HEADER_MAX_SIZE 9
+
+// encoded key header and first key bytes, compared with one vector operation
+#define CBOR_KEY_PROBE_SIZE 32
+
 typedef enum {
 	CborIteratorTokenDone,
 	CborIteratorTokenKey,
@@ -18,6 +25,7 @@ typedef enum {
 	CborIteratorTokenEndByteStrings,
 	CborIteratorTokenBeginCharStrings,
 	CborIteratorTokenEndCharStrings,
+	CborIteratorTokenNeedData, // feed mode: next chunk is required to continue
 } CborIteratorToken;
 
 typedef enum {
@@ -45,11 +53,32 @@ typedef enum {
 	CborTypeUnknown,
 } CborType;
 
+typedef enum {
+	CborInitialByteFlagContainer = 1 << 0, // array or map
+	CborInitialByteFlagString = 1 << 1, // byte or char string
+	CborInitialByteFlagIndefinite = 1 << 2, // indefinite-length string or container
+	CborInitialByteFlagBreak = 1 << 3, // break for indefinite-length item
+	CborInitialByteFlagTag = 1 << 4, // tag, not counted as container item
+	CborInitialByteFlagInvalid = 1 << 5, // reserved additional info
+} CborInitialByteFlags;
+
+/* Decoded initial byte of data item */
+typedef struct CborInitialByte {
+	uint8_t major; // CborMajorType
+	uint8_t type; // CborType
+	uint8_t length; // length of argument, that follows initial byte
+	uint8_t flags; // CborInitialByteFlags
+} CborInitialByte;
+
+/** Descriptors for every possible initial byte */
+extern const CborInitialByte CborInitialByteTable[256];
+
 struct CborIteratorStackValue {
 	CborStackType type;
 	uint32_t position;
 	uint32_t count;
 	const uint8_t *ptr;
+	uint32_t tape; // tape index of container header, CBOR_TAPE_NOT_FOUND if not known
 };
 
 typedef struct CborIteratorContext {
@@ -58,8 +87,10 @@ typedef struct CborIteratorContext {
 
 	uint8_t type;
 	uint8_t info;
+	CborType itemType; // resolved type of current item
 
 	bool isStreaming;
+	bool malformed; // data is truncated or has invalid item: iteration or skip was stopped, or containers were closed at the end of data
 	CborIteratorToken token;
 	const uint8_t *value;
 
@@ -70,13 +101,49 @@ typedef struct CborIteratorContext {
 	struct CborIteratorStackValue *currentStack;
 	struct CborIteratorStackValue *stackHead;
 
+	bool feed; // data is provided in chunks with CborIteratorFeed
+	bool feedLast; // last chunk was provided
+	bool feedStart; // no items was read from stream yet
+	bool splitPushed; // split string was emitted as Begin/End*Strings
+	uint64_t splitRemaining; // bytes of definite-length string, that was split between chunks
+	CborData stream; // rest of the chunk, while header is decoded from pending buffer
+	uint32_t pendingSize;
+	uint8_t pending[CBOR_HEADER_MAX_SIZE]; // item header, split between chunks
+
+	const CborTape *tape; // optional index for random access
+	uint32_t tapeHint; // expected tape index of item at current position
+
 	struct CborIteratorStackValue *extendedStack; // palloc'ed stack
 	struct CborIteratorStackValue defaultStack[CBOR_STACK_DEFAULT_SIZE]; // preallocated stack
 } CborIteratorContext;
 
+/* Precomputed key for CborIteratorGetKeyProbe: encoded text string header with first key bytes */
+typedef struct CborKeyProbe {
+	const char *key;
+	uint32_t size;
+	uint32_t headerSize; // size of encoded key header
+	uint32_t prefixSize; // bytes used in prefix
+	uint8_t prefix[CBOR_KEY_PROBE_SIZE];
+} CborKeyProbe;
+
 typedef const struct CborData (*CborIteratorPathCallback) (void *);
 
 bool CborIteratorInit(CborIteratorContext *, const uint8_t *, size_t);
+
+/** Init iterator over document with prebuilt tape: array index lookups
+ * and value skipping use tape offsets instead of data scanning */
+bool CborIteratorInitTape(CborIteratorContext *, const CborTape *);
+
+/** Init iterator in feed mode: document is provided chunk by chunk with CborIteratorFeed.
+ * CborIteratorNext returns CborIteratorTokenNeedData at the end of every chunk, definite-length
+ * strings, that cross chunk boundary, are returned as Begin/End*Strings with chunk-sized values.
+ * Only CborIteratorNext and value accessors are supported in this mode */
+void CborIteratorInitStream(CborIteratorContext *);
+
+/** Provide next chunk; data should be valid until CborIteratorNext returns CborIteratorTokenNeedData,
+ * `last` marks end of document */
+void CborIteratorFeed(CborIteratorContext *, const uint8_t *, size_t, bool last);
+
 void CborIteratorFinalize(CborIteratorContext *);
 void CborIteratorReset(CborIteratorContext *);
 
@@ -100,6 +167,18 @@ const uint8_t *CborIteratorGetBytePtr(const CborIteratorContext *);
  */
 const uint8_t *CborIteratorGetCurrentValuePtr(const CborIteratorContext *);
 
+/** Skip the rest of current value (key, value or container, that was just returned by CborIteratorNext)
+ * without emitting tokens. For containers, iterator stops at their end token,
+ * so next CborIteratorNext returns token that follows the value */
+bool CborIteratorSkipValue(CborIteratorContext *);
+
+/** Skip the rest of innermost container (at any position between its items),
+ * iterator stops at its end token */
+bool CborIteratorSkipContainer(CborIteratorContext *);
+
+/** Skip next `count` values within current container without emitting tokens */
+bool CborIteratorSkip(CborIteratorContext *, uint32_t count);
+
 /* read until the end of current value, returns pointer to the next value
  * useful for value extraction
  *
@@ -107,12 +186,30 @@ const uint8_t *CborIteratorGetCurrentValuePtr(const CborIteratorContext *);
  * should be valid CBOR without header */
 const uint8_t *CborIteratorReadCurrentValue(CborIteratorContext *);
 
+/** Init iterator and stop at first token of root value, tags before root value are skipped */
+bool CborIteratorInitRoot(CborIteratorContext *, const uint8_t *, size_t);
+
+/** If iterator is stopped at tag, advance to tagged value, returns current token */
+CborIteratorToken CborIteratorSkipTags(CborIteratorContext *);
+
+/** Read whole container element (with leading tags), iterator should be stopped at its first token
+ * and is left at token, that follows the item. `item` receives item bytes with tags,
+ * `content` - bytes of tagged value only. Returns false at the end of container */
+bool CborIteratorReadElement(CborIteratorContext *, CborData *item, CborData *content);
+
 /** Stop at i-th value in array. Iterator should be stopped at CborIteratorTokenBeginArray */
 bool CborIteratorGetIth(CborIteratorContext *ctx, long int lindex);
 
 /** Stop at value with specific object key. Iterator should be stopped at CborIteratorTokenBeginObject */
 bool CborIteratorGetKey(CborIteratorContext *ctx, const char *, uint32_t);
 
+/** Prepare key for CborIteratorGetKeyProbe, key data should outlive probe */
+void CborKeyProbeInit(CborKeyProbe *, const char *, uint32_t);
+
+/** Same as CborIteratorGetKey, but with prepared key: every key in object is compared
+ *  with encoded probe prefix (using SSE2/AVX2 when available), without key decoding */
+bool CborIteratorGetKeyProbe(CborIteratorContext *ctx, const CborKeyProbe *);
+
 /** Stop iterator at value, defined by path (e.g. { "objKey", "42", "valueKey" })
  *  Generic callback variant: callback mast return CborData { 0, NULL } to stop */
 bool CborIteratorPath(CborIteratorContext *ctx, CborIteratorPathCallback, void *ptr);
@@ -0,0 +1,101 @@
+
+#ifndef INCLUDE_CBOR_PATH_H_
+#define INCLUDE_CBOR_PATH_H_
+
+#include "cbor_iter.h"
+#include "cbor_buffer.h"
+
+#define CBOR_PATH_NONE UINT32_MAX
+
+typedef struct CborPathStep {
+	CborData key; // step text, data should outlive path
+	bool isIndex; // step text is valid array index
+	long int index;
+	CborKeyProbe probe; // prepared key for object lookup
+} CborPathStep;
+
+/* Compiled path: every step is classified and prepared once,
+ * so path can be applied to many documents without reparsing */
+typedef struct CborPath {
+	uint32_t nsteps;
+	CborPathStep *steps;
+} CborPath;
+
+typedef struct CborPathTrieNode {
+	CborData step; // key or array index text, data should outlive trie
+	bool isIndex; // step text is valid array index
+	bool terminal; // at least one path ends at this node
+	bool resolved; // value for terminal node was found
+	bool deferred; // array element can not be resolved in forward pass (aliased index or negative index
+		// within undefined length array), whole subtree is resolved with fallback
+	long int index;
+
+	uint32_t parent;
+	uint32_t child; // first child
+	uint32_t sibling; // next child of parent
+	uint32_t nchildren;
+	uint32_t epoch; // last container visit, when node was matched
+
+	CborData value; // encoded value (without magic header) for resolved terminal node
+} CborPathTrieNode;
+
+/* Multiple paths, merged into trie by common prefixes
+ *
+ * All paths are resolved within single forward pass over document,
+ * shared path prefixes are walked once, unrelated subtrees are skipped */
+typedef struct CborPathTrie {
+	uint32_t nnodes;
+	uint32_t nodesCapacity;
+	CborPathTrieNode *nodes;
+
+	uint32_t npaths;
+	uint32_t pathsCapacity;
+	uint32_t *paths; // terminal node for every path
+
+	uint32_t epoch;
+} CborPathTrie;
+
+/** Parse array index from step text, returns false if step is not an integer within int range */
+bool CborPathParseIndex(const CborData *, long int *);
+
+/** Compile path from steps, step data should outlive path */
+void CborPathInit(CborPath *, const CborData *steps, uint32_t nsteps);
+void CborPathFinalize(CborPath *);
+
+/** Same as CborIteratorPath, but with compiled path */
+bool CborIteratorGetPath(CborIteratorContext *, const CborPath *);
+
+void CborPathTrieInit(CborPathTrie *);
+void CborPathTrieFinalize(CborPathTrie *);
+
+/** Add path into trie, returns path index */
+uint32_t CborPathTrieAdd(CborPathTrie *, const CborData *steps, uint32_t nsteps);
+
+/** Resolve all paths within document, returns false if document is malformed */
+bool CborPathTrieResolve(CborPathTrie *, const uint8_t *, size_t);
+
+/** Returns encoded value (without magic header) for path or NULL if path was not found */
+const CborData *CborPathTrieGetValue(const CborPathTrie *, uint32_t path);
+
+typedef enum CborEditMode {
+	CborEditSet, // replace value, missing last object key or array index is created
+	CborEditReplace, // replace existing value only
+	CborEditInsertBefore, // insert array element before index or new object key
+	CborEditInsertAfter, // insert array element after index or new object key
+	CborEditDelete, // remove array element or object pair
+} CborEditMode;
+
+typedef enum CborEditStatus {
+	CborEditStatusOk,
+	CborEditStatusNotFound, // path does not exist, nothing is written
+	CborEditStatusKeyExists, // insert with existing object key
+	CborEditStatusMalformed, // document is malformed or value is not single complete item
+} CborEditStatus;
+
+/** Edit document (with or without magic header) at path and append result (without magic header) into buffer.
+ * Bytes around edited item are copied as is, only header of its container is rewritten, when count is changed.
+ * Missing array index for CborEditSet and insert positions are clamped to array bounds, negative index
+ * counts from the end. Value should be single complete item without magic header, it's not used for CborEditDelete */
+CborEditStatus CborEditPath(CborBuffer *, const uint8_t *data, size_t size, const CborPath *, CborEditMode, const CborData *value);
+
+#endif /* INCLUDE_CBOR_PATH_H_ */
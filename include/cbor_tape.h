@@ -0,0 +1,52 @@
+
+#ifndef INCLUDE_CBOR_TAPE_H_
+#define INCLUDE_CBOR_TAPE_H_
+
+#include "cbor_data.h"
+
+#define CBOR_TAPE_NOT_FOUND UINT32_MAX
+
+typedef struct CborTapeEntry {
+	uint32_t offset; // offset of item header within data
+	uint32_t end; // offset of first byte after item (including nested items and break)
+	uint32_t next; // tape index of next item after this one and all its nested items
+	uint32_t children; // index of first direct child in children list
+	uint32_t count; // number of direct children (keys and values for maps)
+	uint8_t type; // major type
+	uint8_t info; // additional info
+} CborTapeEntry;
+
+/* Flat index of document, built in one pass over data
+ *
+ * Every item (including tags and chunks of indefinite-length strings) gets an entry
+ * in document order; direct children of every container stored contiguously
+ * in `children` list, so i-th item of container can be found with one lookup */
+typedef struct CborTape {
+	CborData data; // document without magic header
+
+	uint32_t size;
+	uint32_t capacity;
+	CborTapeEntry *entries;
+
+	uint32_t childrenSize;
+	uint32_t childrenCapacity;
+	uint32_t *children;
+} CborTape;
+
+/** Build tape for document, returns false if document is truncated or malformed */
+bool CborTapeInit(CborTape *, const uint8_t *, size_t);
+void CborTapeFinalize(CborTape *);
+
+/** Find tape index for item with header at ptr, hint is tape index to check first */
+uint32_t CborTapeFind(const CborTape *, const uint8_t *ptr, uint32_t hint);
+
+/** Returns tape index of i-th direct child of container */
+static inline uint32_t CborTapeGetChild(const CborTape *tape, uint32_t idx, uint32_t i) {
+	const CborTapeEntry *entry = &tape->entries[idx];
+	if (i >= entry->count) {
+		return CBOR_TAPE_NOT_FOUND;
+	}
+	return tape->children[entry->children + i];
+}
+
+#endif /* INCLUDE_CBOR_TAPE_H_ */
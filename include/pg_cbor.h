@@ -8,5 +8,59 @@
 #include "lib/stringinfo.h"
 
 #include "cbor.h"
+#include "cbor_path.h"
+
+/** Returns compiled path from text[], cbor_path, text (single key) or integer (single index) argument,
+ * path is cached in fn_extra and recompiled only when argument is changed */
+const CborPath *PgCborGetPath(FunctionCallInfo fcinfo, int argno);
+
+/** @> strategy number within cbor_ops and cbor_path_ops, same as in jsonb_ops */
+#define PG_CBOR_CONTAINS_STRATEGY 7
+
+/** Stored form for cbor(bare) typmod: documents are stored without magic header */
+#define PG_CBOR_TYPMOD_BARE 1
+
+/** Returns true if argument data is CBOR document: bytea should start with magic header,
+ * cbor values are validated on input and can be stored without it */
+bool PgCborArgIsDocument(FunctionCallInfo fcinfo, int argno, const uint8_t *data, size_t size);
+
+/* Prefix of TOASTed document, fetched by growing slices: first slice covers about one
+ * TOAST chunk, every next one is twice as large, until the whole value is fetched */
+typedef struct PgCborSlice {
+	Datum datum;
+	bytea *ptr; // current slice, NULL before first fetch
+	int32 total;
+	int32 len;
+
+	const uint8_t *data;
+	size_t size;
+} PgCborSlice;
+
+void PgCborSliceInit(PgCborSlice *, Datum);
+
+/** Fetch next slice, previous slice is released. Returns false if previous slice was the whole value */
+bool PgCborSliceNext(PgCborSlice *);
+
+static inline bool PgCborSliceIsComplete(const PgCborSlice *slice) {
+	return slice->len == slice->total;
+}
+
+/** Init iterator at path value within document argument. TOASTed document is fetched by
+ * growing prefix slices, until path value is complete within slice. Returns false
+ * if document is not CBOR or path is not found */
+bool PgCborGetPathValue(FunctionCallInfo fcinfo, int argno, const CborPath *, CborIteratorContext *);
+
+/** Init encoder with reserved varlena header */
+void PgCborEncoderInit(CborEncoder *);
+
+/** Hand off encoded document as bytea without copy, encoder should be initialized
+ * with PgCborEncoderInit, all containers should be closed */
+bytea *PgCborEncoderGetBytea(CborEncoder *);
+
+/** Init output buffer with reserved varlena header and space for `expected` bytes */
+void PgCborBufferInit(CborBuffer *, size_t expected);
+
+/** Hand off buffer content as text or bytea without copy, buffer is left empty */
+struct varlena *PgCborBufferGetVarlena(CborBuffer *);
 
 #endif /* INCLUDE_PG_CBOR_H_ */
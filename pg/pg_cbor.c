@@ -2,14 +2,22 @@
 #include "pg_cbor.h"
 #include "utils/builtins.h"
 #include "utils/array.h"
+#include "utils/lsyscache.h"
 #include "catalog/pg_type.h"
+#include "access/htup_details.h"
+#include "funcapi.h"
+#include "mb/pg_wchar.h"
 
 #ifdef PG_MODULE_MAGIC
 PG_MODULE_MAGIC;
 #endif
 
 PG_FUNCTION_INFO_V1(is_cbor);
+PG_FUNCTION_INFO_V1(cbor_is_valid);
+PG_FUNCTION_INFO_V1(cbor_is_canonical);
+PG_FUNCTION_INFO_V1(cbor_canonicalize);
 PG_FUNCTION_INFO_V1(cbor_to_string);
+PG_FUNCTION_INFO_V1(cbor_to_json);
 PG_FUNCTION_INFO_V1(cbor_extract_path);
 PG_FUNCTION_INFO_V1(cbor_extract_path_text);
 
@@ -19,6 +27,24 @@ PG_FUNCTION_INFO_V1(cbor_path_as_int);
 PG_FUNCTION_INFO_V1(cbor_path_as_float);
 PG_FUNCTION_INFO_V1(cbor_path_as_bool);
 
+PG_FUNCTION_INFO_V1(cbor_extract_paths);
+PG_FUNCTION_INFO_V1(cbor_extract_paths_text);
+PG_FUNCTION_INFO_V1(cbor_paths_as_text);
+PG_FUNCTION_INFO_V1(cbor_paths_as_bytes);
+PG_FUNCTION_INFO_V1(cbor_paths_as_int);
+PG_FUNCTION_INFO_V1(cbor_paths_as_float);
+PG_FUNCTION_INFO_V1(cbor_paths_as_bool);
+
+PG_FUNCTION_INFO_V1(cbor_each);
+PG_FUNCTION_INFO_V1(cbor_each_text);
+PG_FUNCTION_INFO_V1(cbor_array_elements);
+PG_FUNCTION_INFO_V1(cbor_array_elements_text);
+PG_FUNCTION_INFO_V1(cbor_object_keys);
+PG_FUNCTION_INFO_V1(cbor_array_length);
+
+// text output is usually larger, than input: strings are copied, numbers and bytes are expanded
+#define PG_CBOR_TEXT_EXPECTED_SIZE(size) ((size) + (size) / 2)
+
 Datum
 is_cbor(PG_FUNCTION_ARGS) {
 	bytea *ptr;
@@ -40,14 +66,79 @@ is_cbor(PG_FUNCTION_ARGS) {
     PG_RETURN_BOOL(0);
 }
 
+Datum
+cbor_is_valid(PG_FUNCTION_ARGS) {
+	bytea *ptr;
+	size_t bsize;
+	const uint8_t *data;
+
+	if (PG_ARGISNULL(0)) {
+		PG_RETURN_NULL();
+	}
+
+	ptr = PG_GETARG_BYTEA_P(0);
+	bsize = VARSIZE(ptr) - VARHDRSZ;
+	data = (const uint8_t *)VARDATA(ptr);
+
+	// both documents with magic header and headerless items, as stored by cbor type, are accepted
+	PG_RETURN_BOOL(CborValidate(data, bsize));
+}
+
+Datum
+cbor_is_canonical(PG_FUNCTION_ARGS) {
+	bytea *ptr;
+	size_t bsize;
+	const uint8_t *data;
+
+	if (PG_ARGISNULL(0)) {
+		PG_RETURN_NULL();
+	}
+
+	ptr = PG_GETARG_BYTEA_P(0);
+	bsize = VARSIZE(ptr) - VARHDRSZ;
+	data = (const uint8_t *)VARDATA(ptr);
+
+	PG_RETURN_BOOL(PgCborArgIsDocument(fcinfo, 0, data, bsize) && CborIsCanonical(data, bsize));
+}
+
+// canonical documents are equal only when their bytes are equal
+Datum
+cbor_canonicalize(PG_FUNCTION_ARGS) {
+	bytea *ptr;
+	size_t bsize;
+	const uint8_t *data;
+	CborEncoder enc;
+
+	if (PG_ARGISNULL(0)) {
+		PG_RETURN_NULL();
+	}
+
+	ptr = PG_GETARG_BYTEA_P(0);
+	bsize = VARSIZE(ptr) - VARHDRSZ;
+	data = (const uint8_t *)VARDATA(ptr);
+	if (!PgCborArgIsDocument(fcinfo, 0, data, bsize)) {
+		PG_RETURN_NULL();
+	}
+
+	// stored form is kept, when it's already canonical
+	if (CborIsCanonical(data, bsize)) {
+		PG_RETURN_BYTEA_P(ptr);
+	}
+
+	PgCborEncoderInit(&enc);
+	if (!CborCanonicalize(&enc, data, bsize)) {
+		elog(ERROR, "Invalid CBOR data: document is malformed or has duplicate map keys");
+	}
+	PG_RETURN_BYTEA_P(PgCborEncoderGetBytea(&enc));
+}
+
 Datum
 cbor_to_string(PG_FUNCTION_ARGS) {
 	bytea *ptr;
 	size_t bsize;
 	const uint8_t *data;
-	StringInfoData str;
+	CborBuffer buf;
 	struct CborWriter writer;
-	text *ret;
 
 	if (PG_ARGISNULL(0)) {
 		PG_RETURN_NULL();
@@ -56,108 +147,100 @@ cbor_to_string(PG_FUNCTION_ARGS) {
 	ptr = PG_GETARG_BYTEA_P(0);
 	bsize = VARSIZE(ptr) - VARHDRSZ;
 	data = (const uint8_t *)VARDATA(ptr);
-	if (data_is_cbor(data, bsize)) {
-		initStringInfo(&str);
-		writer.plain = (CborWriterPlain)appendBinaryStringInfo;
-		writer.format = (CborWriterFormat)appendStringInfo;
-		writer.ctx = &str;
+	if (PgCborArgIsDocument(fcinfo, 0, data, bsize)) {
+		PgCborBufferInit(&buf, PG_CBOR_TEXT_EXPECTED_SIZE(bsize));
+		CborWriterInitBuffer(&writer, &buf);
 
 		CborToString(&writer, data, bsize);
-		ret = cstring_to_text_with_len(str.data, str.len);
-		pfree(str.data);
-		PG_RETURN_TEXT_P(ret);
+		PG_RETURN_TEXT_P((text *)PgCborBufferGetVarlena(&buf));
 	} else {
 		PG_RETURN_NULL();
 	}
 }
 
-struct PgCborIteratorPathData {
-	Datum *path;
-	int npath;
-};
+Datum
+cbor_to_json(PG_FUNCTION_ARGS) {
+	bytea *ptr;
+	size_t bsize;
+	const uint8_t *data;
+	CborBuffer buf;
+	struct CborWriter writer;
 
-static CborData PgCborIteratorPathIter(struct PgCborIteratorPathData *data) {
-	if (data->npath > 0) {
-		CborData ret;
-		ret.size = VARSIZE(*data->path) - VARHDRSZ;
-		ret.ptr = (const uint8_t *)VARDATA(*data->path);
+	if (PG_ARGISNULL(0)) {
+		PG_RETURN_NULL();
+	}
 
-		-- data->npath;
-		++ data->path;
-		return ret;
+	ptr = PG_GETARG_BYTEA_P(0);
+	bsize = VARSIZE(ptr) - VARHDRSZ;
+	data = (const uint8_t *)VARDATA(ptr);
+	if (PgCborArgIsDocument(fcinfo, 0, data, bsize)) {
+		PgCborBufferInit(&buf, PG_CBOR_TEXT_EXPECTED_SIZE(bsize));
+		CborWriterInitBuffer(&writer, &buf);
+
+		if (!CborToJson(&writer, data, bsize)) {
+			elog(ERROR, "Invalid CBOR data: document is malformed or can not be represented as JSON");
+		}
+
+		// JSON text is UTF-8, text result should be in database encoding
+		if (GetDatabaseEncoding() != PG_UTF8) {
+			const char *json = buf.data + buf.reserved;
+			size_t len = CborBufferGetSize(&buf);
+			char *str = pg_any_to_server(json, len, PG_UTF8);
+			PG_RETURN_TEXT_P(cstring_to_text_with_len(str, (str == json) ? len : strlen(str)));
+		}
+		PG_RETURN_TEXT_P((text *)PgCborBufferGetVarlena(&buf));
 	} else {
-		CborData ret;
-		ret.size = 0;
-		ret.ptr = NULL;
-		return ret;
+		PG_RETURN_NULL();
 	}
 }
 
-static bool PgCborIteratorPath(CborIteratorContext *ctx, Datum *path, int npath) {
-	struct PgCborIteratorPathData data;
-	data.path = path;
-	data.npath = npath;
+// single value as standalone document with magic header
+static bytea *
+pg_cbor_value_to_bytea(const uint8_t *ptr, size_t size) {
+	CborBuffer buf;
 
-	return CborIteratorPath(ctx, (CborIteratorPathCallback)&PgCborIteratorPathIter, &data);
+	PgCborBufferInit(&buf, CborHeaderSize + size);
+	CborBufferWrite(&buf, (const char *)CborHeaderData, CborHeaderSize);
+	CborBufferWrite(&buf, (const char *)ptr, size);
+	return (bytea *)PgCborBufferGetVarlena(&buf);
 }
 
 Datum
 cbor_extract_path(PG_FUNCTION_ARGS) {
 	bytea *ptr;
-	ArrayType *path;
+	const CborPath *path;
 	size_t bsize;
 	const uint8_t *data;
 
-	Datum *pathtext;
-	bool *pathnulls;
-	int	npath;
-
 	CborIteratorContext iter;
 	const uint8_t *begin;
 	const uint8_t *end;
-
-	int bc;
 	bytea *result;
 
 	if (PG_ARGISNULL(0) || PG_ARGISNULL(1)) {
 		PG_RETURN_NULL();
 	}
 
-	ptr = PG_GETARG_BYTEA_P(0);
-	path = PG_GETARG_ARRAYTYPE_P(1);
-	bsize = VARSIZE(ptr) - VARHDRSZ;
-	data = (const uint8_t *)VARDATA(ptr);
-
-	if (array_contains_nulls(path)) {
-		elog(ERROR, "Invalid path data");
-		PG_RETURN_NULL();
-	}
-
-	if (!data_is_cbor(data, bsize)) {
-		PG_RETURN_NULL();
-	}
+	path = PgCborGetPath(fcinfo, 1);
 
-	deconstruct_array(path, TEXTOID, -1, false, 'i', &pathtext, &pathnulls, &npath);
+	if (path->nsteps == 0) {
+		ptr = PG_GETARG_BYTEA_P(0);
+		bsize = VARSIZE(ptr) - VARHDRSZ;
+		data = (const uint8_t *)VARDATA(ptr);
 
-	if (npath <= 0) {
+		if (!PgCborArgIsDocument(fcinfo, 0, data, bsize)) {
+			PG_RETURN_NULL();
+		}
 		PG_RETURN_BYTEA_P(ptr);
 	}
 
-	if (CborIteratorInit(&iter, data, bsize)) {
-		if (PgCborIteratorPath(&iter, pathtext, npath)) {
-			begin = CborIteratorGetCurrentValuePtr(&iter);
-			end = CborIteratorReadCurrentValue(&iter);
-
-			bc = (end - begin) + CborHeaderSize;
-			result = palloc(bc + VARHDRSZ);
-
-			memcpy(VARDATA(result), CborHeaderData, CborHeaderSize);
-			memcpy(VARDATA(result) + CborHeaderSize, begin, end - begin);
-			SET_VARSIZE(result, bc + VARHDRSZ);
+	if (PgCborGetPathValue(fcinfo, 0, path, &iter)) {
+		begin = CborIteratorGetCurrentValuePtr(&iter);
+		end = CborIteratorReadCurrentValue(&iter);
+		result = pg_cbor_value_to_bytea(begin, end - begin);
 
-			CborIteratorFinalize(&iter);
-			PG_RETURN_BYTEA_P(result);
-		}
+		CborIteratorFinalize(&iter);
+		PG_RETURN_BYTEA_P(result);
 	}
 	PG_RETURN_NULL();
 }
@@ -167,15 +250,14 @@ pg_cbor_to_text(CborIteratorContext *iter) {
 	text *ret = NULL;
 	if (CborIteratorGetType(iter) == CborTypeCharString) {
 		if (iter->token == CborIteratorTokenBeginCharStrings) {
-			StringInfoData str;
-			initStringInfo(&str);
+			CborBuffer buf;
+			PgCborBufferInit(&buf, 0);
 			while (CborIteratorNext(iter) != CborIteratorTokenEndCharStrings) {
 				if (iter->token == CborIteratorTokenValue) {
-					appendBinaryStringInfo(&str, CborIteratorGetCharPtr(iter), CborIteratorGetObjectSize(iter));
+					CborBufferWrite(&buf, CborIteratorGetCharPtr(iter), CborIteratorGetObjectSize(iter));
 				}
 			}
-			ret = cstring_to_text_with_len(str.data, str.len);
-			pfree(str.data);
+			ret = (text *)PgCborBufferGetVarlena(&buf);
 		} else {
 			ret = cstring_to_text_with_len(CborIteratorGetCharPtr(iter), CborIteratorGetObjectSize(iter));
 		}
@@ -190,19 +272,14 @@ pg_cbor_to_bytes(CborIteratorContext *iter) {
 	uint32_t len;
 	if (CborIteratorGetType(iter) == CborTypeByteString) {
 		if (iter->token == CborIteratorTokenBeginByteStrings) {
-			StringInfoData str;
-			initStringInfo(&str);
+			CborBuffer buf;
+			PgCborBufferInit(&buf, 0);
 			while (CborIteratorNext(iter) != CborIteratorTokenEndByteStrings) {
 				if (iter->token == CborIteratorTokenValue) {
-					appendBinaryStringInfo(&str, CborIteratorGetCharPtr(iter), CborIteratorGetObjectSize(iter));
+					CborBufferWrite(&buf, (const char *)CborIteratorGetBytePtr(iter), CborIteratorGetObjectSize(iter));
 				}
 			}
-
-			result = palloc(str.len + VARHDRSZ);
-			memcpy(VARDATA(result), str.data, str.len);
-			SET_VARSIZE(result, str.len + VARHDRSZ);
-
-			pfree(str.data);
+			result = (bytea *)PgCborBufferGetVarlena(&buf);
 		} else {
 			ptr = CborIteratorGetBytePtr(iter);
 			len = CborIteratorGetObjectSize(iter);
@@ -218,17 +295,13 @@ pg_cbor_to_bytes(CborIteratorContext *iter) {
 Datum
 cbor_extract_path_text(PG_FUNCTION_ARGS) {
 	bytea *ptr;
-	ArrayType *path;
+	const CborPath *path;
 
 	size_t bsize;
 	const uint8_t *data;
 
-	Datum *pathtext;
-	bool *pathnulls;
-	int	npath;
-
 	struct CborWriter writer;
-	StringInfoData str;
+	CborBuffer buf;
 	CborIteratorContext iter;
 	text *ret = NULL;
 
@@ -236,54 +309,37 @@ cbor_extract_path_text(PG_FUNCTION_ARGS) {
 		PG_RETURN_NULL();
 	}
 
-	ptr = PG_GETARG_BYTEA_P(0);
-	path = PG_GETARG_ARRAYTYPE_P(1);
-
-	bsize = VARSIZE(ptr) - VARHDRSZ;
-	data = (const uint8_t *)VARDATA(ptr);
+	path = PgCborGetPath(fcinfo, 1);
 
-	if (array_contains_nulls(path)) {
-		elog(ERROR, "Invalid path data");
-		PG_RETURN_NULL();
-	}
+	if (path->nsteps == 0) {
+		ptr = PG_GETARG_BYTEA_P(0);
+		bsize = VARSIZE(ptr) - VARHDRSZ;
+		data = (const uint8_t *)VARDATA(ptr);
 
-	if (!data_is_cbor(data, bsize)) {
-		PG_RETURN_NULL();
-	}
-
-	deconstruct_array(path, TEXTOID, -1, false, 'i', &pathtext, &pathnulls, &npath);
+		if (!PgCborArgIsDocument(fcinfo, 0, data, bsize)) {
+			PG_RETURN_NULL();
+		}
 
-	if (npath <= 0) {
-		initStringInfo(&str);
-		writer.plain = (CborWriterPlain)appendBinaryStringInfo;
-		writer.format = (CborWriterFormat)appendStringInfo;
-		writer.ctx = &str;
+		PgCborBufferInit(&buf, PG_CBOR_TEXT_EXPECTED_SIZE(bsize));
+		CborWriterInitBuffer(&writer, &buf);
 
 		CborToString(&writer, data, bsize);
+		PG_RETURN_TEXT_P((text *)PgCborBufferGetVarlena(&buf));
+	}
 
-		ret = cstring_to_text_with_len(str.data, str.len);
-		pfree(str.data);
-		PG_RETURN_TEXT_P(ret);
-	}
-
-	if (CborIteratorInit(&iter, data, bsize)) {
-		if (PgCborIteratorPath(&iter, pathtext, npath)) {
-			if (CborIteratorGetType(&iter) == CborTypeCharString) {
-				ret = pg_cbor_to_text(&iter);
-			} else {
-				initStringInfo(&str);
-				writer.plain = (CborWriterPlain)appendBinaryStringInfo;
-				writer.format = (CborWriterFormat)appendStringInfo;
-				writer.ctx = &str;
-				CborIteratorValueToString(&writer, &iter);
-				ret = cstring_to_text_with_len(str.data, str.len);
-				pfree(str.data);
-			}
+	if (PgCborGetPathValue(fcinfo, 0, path, &iter)) {
+		if (CborIteratorGetType(&iter) == CborTypeCharString) {
+			ret = pg_cbor_to_text(&iter);
+		} else {
+			PgCborBufferInit(&buf, 0);
+			CborWriterInitBuffer(&writer, &buf);
+			CborIteratorValueToString(&writer, &iter);
+			ret = (text *)PgCborBufferGetVarlena(&buf);
+		}
 
-			CborIteratorFinalize(&iter);
-			if (ret) {
-				PG_RETURN_TEXT_P(ret);
-			}
+		CborIteratorFinalize(&iter);
+		if (ret) {
+			PG_RETURN_TEXT_P(ret);
 		}
 	}
 	PG_RETURN_NULL();
@@ -291,16 +347,7 @@ cbor_extract_path_text(PG_FUNCTION_ARGS) {
 
 Datum
 cbor_path_as_text(PG_FUNCTION_ARGS) {
-	bytea *ptr;
-	ArrayType *path;
-
-	size_t bsize;
-	const uint8_t *data;
-
-	Datum *pathtext;
-	bool *pathnulls;
-	int	npath;
-
+	const CborPath *path;
 	CborIteratorContext iter;
 	text *ret = NULL;
 
@@ -308,269 +355,586 @@ cbor_path_as_text(PG_FUNCTION_ARGS) {
 		PG_RETURN_NULL();
 	}
 
-	ptr = PG_GETARG_BYTEA_P(0);
-	path = PG_GETARG_ARRAYTYPE_P(1);
-
-	bsize = VARSIZE(ptr) - VARHDRSZ;
-	data = (const uint8_t *)VARDATA(ptr);
+	path = PgCborGetPath(fcinfo, 1);
 
-	if (array_contains_nulls(path)) {
-		elog(ERROR, "Invalid path data");
-		PG_RETURN_NULL();
+	if (PgCborGetPathValue(fcinfo, 0, path, &iter)) {
+		ret = pg_cbor_to_text(&iter);
+		if (ret) {
+			CborIteratorFinalize(&iter);
+			PG_RETURN_TEXT_P(ret);
+		}
+		CborIteratorFinalize(&iter);
 	}
+	PG_RETURN_NULL();
+}
+
+Datum
+cbor_path_as_bytes(PG_FUNCTION_ARGS) {
+	const CborPath *path;
+	CborIteratorContext iter;
+	bytea *ret = NULL;
 
-	if (!data_is_cbor(data, bsize)) {
+	if (PG_ARGISNULL(0) || PG_ARGISNULL(1)) {
 		PG_RETURN_NULL();
 	}
 
-	deconstruct_array(path, TEXTOID, -1, false, 'i', &pathtext, &pathnulls, &npath);
+	path = PgCborGetPath(fcinfo, 1);
 
-	if (CborIteratorInit(&iter, data, bsize)) {
-		if (npath <= 0) {
-			CborIteratorNext(&iter);
-			ret = pg_cbor_to_text(&iter);
-			CborIteratorFinalize(&iter);
-			if (ret) {
-				PG_RETURN_TEXT_P(ret);
-			}
-		} else if (PgCborIteratorPath(&iter, pathtext, npath)) {
-			ret = pg_cbor_to_text(&iter);
+	if (PgCborGetPathValue(fcinfo, 0, path, &iter)) {
+		ret = pg_cbor_to_bytes(&iter);
+		if (ret) {
 			CborIteratorFinalize(&iter);
-			if (ret) {
-				PG_RETURN_TEXT_P(ret);
-			}
+			PG_RETURN_BYTEA_P(ret);
 		}
+		CborIteratorFinalize(&iter);
 	}
 	PG_RETURN_NULL();
 }
 
 Datum
-cbor_path_as_bytes(PG_FUNCTION_ARGS) {
-	bytea *ptr;
-	ArrayType *path;
+cbor_path_as_int(PG_FUNCTION_ARGS) {
+	const CborPath *path;
+	CborIteratorContext iter;
+	int64_t ret;
 
-	size_t bsize;
-	const uint8_t *data;
+	if (PG_ARGISNULL(0) || PG_ARGISNULL(1)) {
+		PG_RETURN_NULL();
+	}
 
-	Datum *pathtext;
-	bool *pathnulls;
-	int	npath;
+	path = PgCborGetPath(fcinfo, 1);
 
+	if (PgCborGetPathValue(fcinfo, 0, path, &iter)) {
+		if (CborIteratorGetType(&iter) == CborTypeUnsigned || CborIteratorGetType(&iter) == CborTypeNegative) {
+			ret = CborIteratorGetInteger(&iter);
+			CborIteratorFinalize(&iter);
+			PG_RETURN_INT64(ret);
+		}
+		CborIteratorFinalize(&iter);
+	}
+	PG_RETURN_NULL();
+}
+
+Datum
+cbor_path_as_float(PG_FUNCTION_ARGS) {
+	const CborPath *path;
 	CborIteratorContext iter;
-	bytea *ret = NULL;
+	double ret;
 
 	if (PG_ARGISNULL(0) || PG_ARGISNULL(1)) {
 		PG_RETURN_NULL();
 	}
 
-	ptr = PG_GETARG_BYTEA_P(0);
-	path = PG_GETARG_ARRAYTYPE_P(1);
-
-	bsize = VARSIZE(ptr) - VARHDRSZ;
-	data = (const uint8_t *)VARDATA(ptr);
+	path = PgCborGetPath(fcinfo, 1);
 
-	if (array_contains_nulls(path)) {
-		elog(ERROR, "Invalid path data");
-		PG_RETURN_NULL();
+	if (PgCborGetPathValue(fcinfo, 0, path, &iter)) {
+		if (CborIteratorGetType(&iter) == CborTypeFloat) {
+			ret = CborIteratorGetFloat(&iter);
+			CborIteratorFinalize(&iter);
+			PG_RETURN_FLOAT8(ret);
+		}
+		CborIteratorFinalize(&iter);
 	}
+	PG_RETURN_NULL();
+}
 
-	if (!data_is_cbor(data, bsize)) {
+Datum
+cbor_path_as_bool(PG_FUNCTION_ARGS) {
+	const CborPath *path;
+	CborIteratorContext iter;
+
+	if (PG_ARGISNULL(0) || PG_ARGISNULL(1)) {
 		PG_RETURN_NULL();
 	}
 
-	deconstruct_array(path, TEXTOID, -1, false, 'i', &pathtext, &pathnulls, &npath);
+	path = PgCborGetPath(fcinfo, 1);
 
-	if (CborIteratorInit(&iter, data, bsize)) {
-		if (npath <= 0) {
-			CborIteratorNext(&iter);
-			ret = pg_cbor_to_bytes(&iter);
+	if (PgCborGetPathValue(fcinfo, 0, path, &iter)) {
+		if (CborIteratorGetType(&iter) == CborTypeTrue) {
 			CborIteratorFinalize(&iter);
-			if (ret) {
-				PG_RETURN_BYTEA_P(ptr);
-			}
-		} else if (PgCborIteratorPath(&iter, pathtext, npath)) {
-			ret = pg_cbor_to_bytes(&iter);
+			PG_RETURN_BOOL(true);
+		} else if (CborIteratorGetType(&iter) == CborTypeFalse) {
 			CborIteratorFinalize(&iter);
-			if (ret) {
-				PG_RETURN_BYTEA_P(ptr);
-			}
+			PG_RETURN_BOOL(false);
 		}
+		CborIteratorFinalize(&iter);
 	}
 	PG_RETURN_NULL();
 }
 
-Datum
-cbor_path_as_int(PG_FUNCTION_ARGS) {
-	bytea *ptr;
-	ArrayType *path;
+typedef Datum (*PgCborPathsValueCallback) (const CborData *, bool *isnull);
 
-	size_t bsize;
-	const uint8_t *data;
+/* Extract multiple paths from single document with one traversal
+ *
+ * Paths argument is text[][], every row is a path, NULLs at the end of row are ignored;
+ * for one-dimensional array every element is a path with single step.
+ * TOASTed document is fetched by growing prefix slices, until all paths are resolved */
+static Datum
+pg_cbor_extract_paths(FunctionCallInfo fcinfo, Oid elemtype, PgCborPathsValueCallback cb) {
+	PgCborSlice slice;
+	ArrayType *paths;
 
 	Datum *pathtext;
 	bool *pathnulls;
-	int	npath;
-
-	CborIteratorContext iter;
-	int64_t ret;
+	int npath;
+	int npaths, nsteps;
+	int i, j;
+
+	CborPathTrie trie;
+	CborData *steps;
+	Datum *values;
+	bool *nulls;
+	int dims[1];
+	int lbs[1];
+	int16 typlen;
+	bool typbyval;
+	char typalign;
+	ArrayType *result;
 
 	if (PG_ARGISNULL(0) || PG_ARGISNULL(1)) {
 		PG_RETURN_NULL();
 	}
 
-	ptr = PG_GETARG_BYTEA_P(0);
-	path = PG_GETARG_ARRAYTYPE_P(1);
+	paths = PG_GETARG_ARRAYTYPE_P(1);
 
-	bsize = VARSIZE(ptr) - VARHDRSZ;
-	data = (const uint8_t *)VARDATA(ptr);
+	get_typlenbyvalalign(elemtype, &typlen, &typbyval, &typalign);
 
-	if (array_contains_nulls(path)) {
-		elog(ERROR, "Invalid path data");
+	if (ARR_NDIM(paths) == 0) {
+		PG_RETURN_ARRAYTYPE_P(construct_empty_array(elemtype));
+	} else if (ARR_NDIM(paths) == 1) {
+		npaths = ARR_DIMS(paths)[0];
+		nsteps = 1;
+	} else if (ARR_NDIM(paths) == 2) {
+		npaths = ARR_DIMS(paths)[0];
+		nsteps = ARR_DIMS(paths)[1];
+	} else {
+		elog(ERROR, "Invalid path data: array of paths should be one- or two-dimensional");
 		PG_RETURN_NULL();
 	}
 
-	if (!data_is_cbor(data, bsize)) {
-		PG_RETURN_NULL();
+	deconstruct_array(paths, TEXTOID, -1, false, 'i', &pathtext, &pathnulls, &npath);
+
+	CborPathTrieInit(&trie);
+	steps = palloc(sizeof(CborData) * nsteps);
+	for (i = 0; i < npaths; ++ i) {
+		for (j = 0; j < nsteps; ++ j) {
+			Datum step = pathtext[i * nsteps + j];
+			if (pathnulls[i * nsteps + j]) {
+				break;
+			}
+			steps[j].size = VARSIZE_ANY_EXHDR(DatumGetPointer(step));
+			steps[j].ptr = (const uint8_t *)VARDATA_ANY(DatumGetPointer(step));
+		}
+
+		if (j == 0) {
+			elog(ERROR, "Invalid path data: empty path");
+		}
+
+		CborPathTrieAdd(&trie, steps, j);
 	}
 
-	deconstruct_array(path, TEXTOID, -1, false, 'i', &pathtext, &pathnulls, &npath);
+	values = palloc(sizeof(Datum) * npaths);
+	nulls = palloc(sizeof(bool) * npaths);
+
+	// values resolved within prefix are the same as within the whole document
+	PgCborSliceInit(&slice, PG_GETARG_DATUM(0));
+	while (PgCborSliceNext(&slice)) {
+		bool ok;
 
-	if (CborIteratorInit(&iter, data, bsize)) {
-		if (npath <= 0) {
-			CborIteratorNext(&iter);
-			if (CborIteratorGetType(&iter) == CborTypeUnsigned || CborIteratorGetType(&iter) == CborTypeNegative) {
-				ret = CborIteratorGetInteger(&iter);
-				CborIteratorFinalize(&iter);
-				PG_RETURN_INT64(ret);
+		if (!PgCborArgIsDocument(fcinfo, 0, slice.data, slice.size)) {
+			CborPathTrieFinalize(&trie);
+			PG_RETURN_NULL();
+		}
+
+		ok = CborPathTrieResolve(&trie, slice.data, slice.size);
+		if (PgCborSliceIsComplete(&slice)) {
+			if (!ok) {
+				CborPathTrieFinalize(&trie);
+				PG_RETURN_NULL();
 			}
-			CborIteratorFinalize(&iter);
-		} else if (PgCborIteratorPath(&iter, pathtext, npath)) {
-			if (CborIteratorGetType(&iter) == CborTypeUnsigned || CborIteratorGetType(&iter) == CborTypeNegative) {
-				ret = CborIteratorGetInteger(&iter);
-				CborIteratorFinalize(&iter);
-				PG_RETURN_INT64(ret);
+			break;
+		}
+
+		// all paths are resolved within prefix
+		for (i = 0; i < npaths; ++ i) {
+			if (!CborPathTrieGetValue(&trie, i)) {
+				break;
 			}
-			CborIteratorFinalize(&iter);
+		}
+		if (i == npaths) {
+			break;
 		}
 	}
-	PG_RETURN_NULL();
+
+	for (i = 0; i < npaths; ++ i) {
+		const CborData *value = CborPathTrieGetValue(&trie, i);
+		nulls[i] = true;
+		values[i] = (Datum)0;
+		if (value) {
+			values[i] = cb(value, &nulls[i]);
+		}
+	}
+
+	CborPathTrieFinalize(&trie);
+
+	dims[0] = npaths;
+	lbs[0] = 1;
+	result = construct_md_array(values, nulls, 1, dims, lbs, elemtype, typlen, typbyval, typalign);
+	PG_RETURN_ARRAYTYPE_P(result);
 }
 
-Datum
-cbor_path_as_float(PG_FUNCTION_ARGS) {
-	bytea *ptr;
-	ArrayType *path;
+static Datum
+pg_cbor_paths_value_cbor(const CborData *value, bool *isnull) {
+	*isnull = false;
+	return PointerGetDatum(pg_cbor_value_to_bytea(value->ptr, value->size));
+}
 
-	size_t bsize;
-	const uint8_t *data;
+static Datum
+pg_cbor_paths_value_string(const CborData *value, bool *isnull) {
+	CborIteratorContext iter;
+	struct CborWriter writer;
+	CborBuffer buf;
+	text *ret = NULL;
 
-	Datum *pathtext;
-	bool *pathnulls;
-	int	npath;
+	if (CborIteratorInit(&iter, value->ptr, value->size)) {
+		CborIteratorNext(&iter);
+		if (CborIteratorGetType(&iter) == CborTypeCharString) {
+			ret = pg_cbor_to_text(&iter);
+		} else {
+			PgCborBufferInit(&buf, 0);
+			CborWriterInitBuffer(&writer, &buf);
+			CborIteratorValueToString(&writer, &iter);
+			ret = (text *)PgCborBufferGetVarlena(&buf);
+		}
+		CborIteratorFinalize(&iter);
+	}
+
+	*isnull = (ret == NULL);
+	return PointerGetDatum(ret);
+}
 
+static Datum
+pg_cbor_paths_value_text(const CborData *value, bool *isnull) {
 	CborIteratorContext iter;
-	double ret;
+	text *ret = NULL;
 
-	if (PG_ARGISNULL(0) || PG_ARGISNULL(1)) {
-		PG_RETURN_NULL();
+	if (CborIteratorInit(&iter, value->ptr, value->size)) {
+		CborIteratorNext(&iter);
+		ret = pg_cbor_to_text(&iter);
+		CborIteratorFinalize(&iter);
 	}
 
-	ptr = PG_GETARG_BYTEA_P(0);
-	path = PG_GETARG_ARRAYTYPE_P(1);
+	*isnull = (ret == NULL);
+	return PointerGetDatum(ret);
+}
 
-	bsize = VARSIZE(ptr) - VARHDRSZ;
-	data = (const uint8_t *)VARDATA(ptr);
+static Datum
+pg_cbor_paths_value_bytes(const CborData *value, bool *isnull) {
+	CborIteratorContext iter;
+	bytea *ret = NULL;
 
-	if (array_contains_nulls(path)) {
-		elog(ERROR, "Invalid path data");
-		PG_RETURN_NULL();
+	if (CborIteratorInit(&iter, value->ptr, value->size)) {
+		CborIteratorNext(&iter);
+		ret = pg_cbor_to_bytes(&iter);
+		CborIteratorFinalize(&iter);
 	}
 
-	if (!data_is_cbor(data, bsize)) {
-		PG_RETURN_NULL();
+	*isnull = (ret == NULL);
+	return PointerGetDatum(ret);
+}
+
+static Datum
+pg_cbor_paths_value_int(const CborData *value, bool *isnull) {
+	CborIteratorContext iter;
+	Datum ret = (Datum)0;
+
+	*isnull = true;
+	if (CborIteratorInit(&iter, value->ptr, value->size)) {
+		CborIteratorNext(&iter);
+		if (CborIteratorGetType(&iter) == CborTypeUnsigned || CborIteratorGetType(&iter) == CborTypeNegative) {
+			ret = Int64GetDatum(CborIteratorGetInteger(&iter));
+			*isnull = false;
+		}
+		CborIteratorFinalize(&iter);
 	}
+	return ret;
+}
 
-	deconstruct_array(path, TEXTOID, -1, false, 'i', &pathtext, &pathnulls, &npath);
+static Datum
+pg_cbor_paths_value_float(const CborData *value, bool *isnull) {
+	CborIteratorContext iter;
+	Datum ret = (Datum)0;
+
+	*isnull = true;
+	if (CborIteratorInit(&iter, value->ptr, value->size)) {
+		CborIteratorNext(&iter);
+		if (CborIteratorGetType(&iter) == CborTypeFloat) {
+			ret = Float8GetDatum(CborIteratorGetFloat(&iter));
+			*isnull = false;
+		}
+		CborIteratorFinalize(&iter);
+	}
+	return ret;
+}
 
-	if (CborIteratorInit(&iter, data, bsize)) {
-		if (npath <= 0) {
-			CborIteratorNext(&iter);
-			if (CborIteratorGetType(&iter) == CborTypeFloat) {
-				ret = CborIteratorGetFloat(&iter);
-				CborIteratorFinalize(&iter);
-				PG_RETURN_FLOAT8(ret);
-			}
-			CborIteratorFinalize(&iter);
-		} else if (PgCborIteratorPath(&iter, pathtext, npath)) {
-			if (CborIteratorGetType(&iter) == CborTypeFloat) {
-				ret = CborIteratorGetFloat(&iter);
-				CborIteratorFinalize(&iter);
-				PG_RETURN_FLOAT8(ret);
+static Datum
+pg_cbor_paths_value_bool(const CborData *value, bool *isnull) {
+	CborIteratorContext iter;
+	Datum ret = (Datum)0;
+
+	*isnull = true;
+	if (CborIteratorInit(&iter, value->ptr, value->size)) {
+		CborIteratorNext(&iter);
+		if (CborIteratorGetType(&iter) == CborTypeTrue) {
+			ret = BoolGetDatum(true);
+			*isnull = false;
+		} else if (CborIteratorGetType(&iter) == CborTypeFalse) {
+			ret = BoolGetDatum(false);
+			*isnull = false;
+		}
+		CborIteratorFinalize(&iter);
+	}
+	return ret;
+}
+
+Datum
+cbor_extract_paths(PG_FUNCTION_ARGS) {
+	// cbor[] for cbor argument, bytea[] otherwise
+	Oid elemtype = get_element_type(get_fn_expr_rettype(fcinfo->flinfo));
+	return pg_cbor_extract_paths(fcinfo, OidIsValid(elemtype) ? elemtype : BYTEAOID, pg_cbor_paths_value_cbor);
+}
+
+Datum
+cbor_extract_paths_text(PG_FUNCTION_ARGS) {
+	return pg_cbor_extract_paths(fcinfo, TEXTOID, pg_cbor_paths_value_string);
+}
+
+Datum
+cbor_paths_as_text(PG_FUNCTION_ARGS) {
+	return pg_cbor_extract_paths(fcinfo, TEXTOID, pg_cbor_paths_value_text);
+}
+
+Datum
+cbor_paths_as_bytes(PG_FUNCTION_ARGS) {
+	return pg_cbor_extract_paths(fcinfo, BYTEAOID, pg_cbor_paths_value_bytes);
+}
+
+Datum
+cbor_paths_as_int(PG_FUNCTION_ARGS) {
+	return pg_cbor_extract_paths(fcinfo, INT8OID, pg_cbor_paths_value_int);
+}
+
+Datum
+cbor_paths_as_float(PG_FUNCTION_ARGS) {
+	return pg_cbor_extract_paths(fcinfo, FLOAT8OID, pg_cbor_paths_value_float);
+}
+
+Datum
+cbor_paths_as_bool(PG_FUNCTION_ARGS) {
+	return pg_cbor_extract_paths(fcinfo, BOOLOID, pg_cbor_paths_value_bool);
+}
+
+typedef enum {
+	PgCborEachCbor, // values as standalone CBOR documents
+	PgCborEachText, // values as text
+	PgCborEachKeys, // only object keys
+} PgCborEachMode;
+
+// null and undefined are SQL NULL, like in jsonb_each_text
+static Datum
+pg_cbor_each_value_text(const CborData *value, bool *isnull) {
+	CborIteratorContext iter;
+	CborType type = CborTypeNull;
+
+	if (CborIteratorInit(&iter, value->ptr, value->size)) {
+		CborIteratorNext(&iter);
+		type = CborIteratorGetType(&iter);
+		CborIteratorFinalize(&iter);
+	}
+
+	if (type == CborTypeNull || type == CborTypeUndefined) {
+		*isnull = true;
+		return (Datum)0;
+	}
+	return pg_cbor_paths_value_string(value, isnull);
+}
+
+/* SRF state: iterator lives in multi_call_memory_ctx and is advanced by one item per row,
+ * so every row costs only its own item */
+typedef struct PgCborEachState {
+	CborIteratorContext iter;
+	TupleDesc tupdesc;
+} PgCborEachState;
+
+static Datum
+pg_cbor_each(FunctionCallInfo fcinfo, bool object, PgCborEachMode mode) {
+	FuncCallContext *funcctx;
+	PgCborEachState *state;
+	MemoryContext oldcontext;
+
+	CborData key, keyContent;
+	CborData value, valueContent;
+	bool found;
+
+	Datum values[2];
+	bool nulls[2];
+	Datum result = (Datum)0;
+	bool isnull = true;
+
+	if (SRF_IS_FIRSTCALL()) {
+		bytea *ptr;
+		size_t bsize;
+		const uint8_t *data;
+		TupleDesc tupdesc;
+
+		funcctx = SRF_FIRSTCALL_INIT();
+		oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+		// detoasted document should outlive the first call: every row reads its own item
+		// and iterator keeps pointers into data between calls, so prefix slices are not used
+		ptr = PG_GETARG_BYTEA_P(0);
+		bsize = VARSIZE(ptr) - VARHDRSZ;
+		data = (const uint8_t *)VARDATA(ptr);
+
+		state = palloc0(sizeof(PgCborEachState));
+		if (!PgCborArgIsDocument(fcinfo, 0, data, bsize)) {
+			MemoryContextSwitchTo(oldcontext);
+			SRF_RETURN_DONE(funcctx);
+		}
+
+		CborIteratorInitRoot(&state->iter, data, bsize);
+		if (state->iter.token != (object ? CborIteratorTokenBeginObject : CborIteratorTokenBeginArray)) {
+			CborIteratorFinalize(&state->iter);
+			elog(ERROR, object ? "Invalid CBOR data: object expected" : "Invalid CBOR data: array expected");
+		}
+		CborIteratorNext(&state->iter);
+
+		if (object && mode != PgCborEachKeys) {
+			if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE) {
+				elog(ERROR, "Invalid function definition: function returning record called in context that cannot accept type record");
 			}
-			CborIteratorFinalize(&iter);
+			state->tupdesc = BlessTupleDesc(tupdesc);
 		}
+
+		funcctx->user_fctx = state;
+		MemoryContextSwitchTo(oldcontext);
 	}
-	PG_RETURN_NULL();
+
+	funcctx = SRF_PERCALL_SETUP();
+	state = (PgCborEachState *)funcctx->user_fctx;
+
+	// iterator stack can grow on nested containers, it should stay in multi-call context
+	oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+	found = (!object || CborIteratorReadElement(&state->iter, &key, &keyContent))
+			&& CborIteratorReadElement(&state->iter, &value, &valueContent);
+	MemoryContextSwitchTo(oldcontext);
+
+	if (!found) {
+		bool malformed = state->iter.malformed;
+		CborIteratorFinalize(&state->iter);
+		if (malformed) {
+			elog(ERROR, "Invalid CBOR data: document is truncated or malformed");
+		}
+		SRF_RETURN_DONE(funcctx);
+	}
+
+	switch (mode) {
+	case PgCborEachCbor: result = pg_cbor_paths_value_cbor(&value, &isnull); break;
+	case PgCborEachText: result = pg_cbor_each_value_text(&valueContent, &isnull); break;
+	case PgCborEachKeys: result = pg_cbor_paths_value_string(&keyContent, &isnull); break;
+	}
+
+	if (object && mode != PgCborEachKeys) {
+		values[0] = pg_cbor_paths_value_string(&keyContent, &nulls[0]);
+		values[1] = result;
+		nulls[1] = isnull;
+		SRF_RETURN_NEXT(funcctx, HeapTupleGetDatum(heap_form_tuple(state->tupdesc, values, nulls)));
+	}
+
+	if (isnull) {
+		SRF_RETURN_NEXT_NULL(funcctx);
+	}
+	SRF_RETURN_NEXT(funcctx, result);
 }
 
 Datum
-cbor_path_as_bool(PG_FUNCTION_ARGS) {
-	bytea *ptr;
-	ArrayType *path;
+cbor_each(PG_FUNCTION_ARGS) {
+	return pg_cbor_each(fcinfo, true, PgCborEachCbor);
+}
 
+Datum
+cbor_each_text(PG_FUNCTION_ARGS) {
+	return pg_cbor_each(fcinfo, true, PgCborEachText);
+}
+
+Datum
+cbor_array_elements(PG_FUNCTION_ARGS) {
+	return pg_cbor_each(fcinfo, false, PgCborEachCbor);
+}
+
+Datum
+cbor_array_elements_text(PG_FUNCTION_ARGS) {
+	return pg_cbor_each(fcinfo, false, PgCborEachText);
+}
+
+Datum
+cbor_object_keys(PG_FUNCTION_ARGS) {
+	return pg_cbor_each(fcinfo, true, PgCborEachKeys);
+}
+
+Datum
+cbor_array_length(PG_FUNCTION_ARGS) {
+	PgCborSlice slice;
+	bytea *ptr;
 	size_t bsize;
 	const uint8_t *data;
 
-	Datum *pathtext;
-	bool *pathnulls;
-	int	npath;
-
 	CborIteratorContext iter;
+	CborData item, content;
+	uint32_t count;
 
-	if (PG_ARGISNULL(0) || PG_ARGISNULL(1)) {
+	// size of definite length array is in its header, it is within first slice
+	PgCborSliceInit(&slice, PG_GETARG_DATUM(0));
+	PgCborSliceNext(&slice);
+	if (!PgCborArgIsDocument(fcinfo, 0, slice.data, slice.size)) {
 		PG_RETURN_NULL();
 	}
 
-	ptr = PG_GETARG_BYTEA_P(0);
-	path = PG_GETARG_ARRAYTYPE_P(1);
+	CborIteratorInitRoot(&iter, slice.data, slice.size);
+	if (iter.token == CborIteratorTokenBeginArray && CborIteratorGetContainerSize(&iter) != UINT32_MAX) {
+		count = CborIteratorGetContainerSize(&iter);
+		CborIteratorFinalize(&iter);
+		PG_RETURN_INT32(count);
+	}
 
-	bsize = VARSIZE(ptr) - VARHDRSZ;
-	data = (const uint8_t *)VARDATA(ptr);
+	if (!PgCborSliceIsComplete(&slice)) {
+		// undefined length array or root header beyond first slice: use the whole document
+		CborIteratorFinalize(&iter);
 
-	if (array_contains_nulls(path)) {
-		elog(ERROR, "Invalid path data");
-		PG_RETURN_NULL();
+		ptr = PG_GETARG_BYTEA_P(0);
+		bsize = VARSIZE(ptr) - VARHDRSZ;
+		data = (const uint8_t *)VARDATA(ptr);
+		CborIteratorInitRoot(&iter, data, bsize);
 	}
 
-	if (!data_is_cbor(data, bsize)) {
-		PG_RETURN_NULL();
+	if (iter.token != CborIteratorTokenBeginArray) {
+		CborIteratorFinalize(&iter);
+		elog(ERROR, "Invalid CBOR data: array expected");
 	}
 
-	deconstruct_array(path, TEXTOID, -1, false, 'i', &pathtext, &pathnulls, &npath);
+	// undefined length array: count items by skipping them
+	count = 0;
+	CborIteratorNext(&iter);
+	while (CborIteratorReadElement(&iter, &item, &content)) {
+		++ count;
+	}
 
-	if (CborIteratorInit(&iter, data, bsize)) {
-		if (npath <= 0) {
-			CborIteratorNext(&iter);
-			if (CborIteratorGetType(&iter) == CborTypeTrue) {
-				CborIteratorFinalize(&iter);
-				PG_RETURN_BOOL(true);
-			} else if (CborIteratorGetType(&iter) == CborTypeFalse) {
-				CborIteratorFinalize(&iter);
-				PG_RETURN_BOOL(false);
-			}
-			CborIteratorFinalize(&iter);
-		} else if (PgCborIteratorPath(&iter, pathtext, npath)) {
-			if (CborIteratorGetType(&iter) == CborTypeTrue) {
-				CborIteratorFinalize(&iter);
-				PG_RETURN_BOOL(true);
-			} else if (CborIteratorGetType(&iter) == CborTypeFalse) {
-				CborIteratorFinalize(&iter);
-				PG_RETURN_BOOL(false);
-			}
-			CborIteratorFinalize(&iter);
-		}
+	if (iter.malformed) {
+		CborIteratorFinalize(&iter);
+		elog(ERROR, "Invalid CBOR data: document is truncated or malformed");
 	}
-	PG_RETURN_NULL();
+
+	CborIteratorFinalize(&iter);
+	PG_RETURN_INT32(count);
 }
 
 /*
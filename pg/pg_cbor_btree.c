@@ -0,0 +1,171 @@
+
+#include "pg_cbor.h"
+
+#include "utils/builtins.h"
+#include "utils/sortsupport.h"
+#include "lib/hyperloglog.h"
+
+#if PG_VERSION_NUM >= 130000
+#include "common/hashfn.h"
+#elif PG_VERSION_NUM >= 120000
+#include "utils/hashutils.h"
+#else
+#include "access/hash.h"
+#endif
+
+PG_FUNCTION_INFO_V1(cbor_cmp);
+PG_FUNCTION_INFO_V1(cbor_lt);
+PG_FUNCTION_INFO_V1(cbor_le);
+PG_FUNCTION_INFO_V1(cbor_eq);
+PG_FUNCTION_INFO_V1(cbor_ne);
+PG_FUNCTION_INFO_V1(cbor_ge);
+PG_FUNCTION_INFO_V1(cbor_gt);
+PG_FUNCTION_INFO_V1(cbor_sortsupport);
+
+// abbreviated keys are full 64-bit CborCompareKey values
+#if PG_VERSION_NUM >= 90500 && SIZEOF_DATUM == 8
+#define PG_CBOR_ABBREVIATE 1
+#endif
+
+// same thresholds, as for builtin abbreviated keys (see uuid_abbrev_abort)
+#define PG_CBOR_ABBREV_MIN_ROWS 10000
+#define PG_CBOR_ABBREV_FULL_CARDINALITY 100000.0
+
+typedef struct PgCborSortState {
+	bool estimating;
+	int64 inputCount;
+	hyperLogLogState abbrCard;
+} PgCborSortState;
+
+static int
+pg_cbor_cmp_datum(Datum x, Datum y) {
+	struct varlena *a = PG_DETOAST_DATUM_PACKED(x);
+	struct varlena *b = PG_DETOAST_DATUM_PACKED(y);
+	int ret;
+
+	ret = CborCompare((const uint8_t *)VARDATA_ANY(a), VARSIZE_ANY_EXHDR(a),
+			(const uint8_t *)VARDATA_ANY(b), VARSIZE_ANY_EXHDR(b));
+
+	if ((Pointer)a != DatumGetPointer(x)) {
+		pfree(a);
+	}
+	if ((Pointer)b != DatumGetPointer(y)) {
+		pfree(b);
+	}
+	return ret;
+}
+
+Datum
+cbor_cmp(PG_FUNCTION_ARGS) {
+	PG_RETURN_INT32(pg_cbor_cmp_datum(PG_GETARG_DATUM(0), PG_GETARG_DATUM(1)));
+}
+
+Datum
+cbor_lt(PG_FUNCTION_ARGS) {
+	PG_RETURN_BOOL(pg_cbor_cmp_datum(PG_GETARG_DATUM(0), PG_GETARG_DATUM(1)) < 0);
+}
+
+Datum
+cbor_le(PG_FUNCTION_ARGS) {
+	PG_RETURN_BOOL(pg_cbor_cmp_datum(PG_GETARG_DATUM(0), PG_GETARG_DATUM(1)) <= 0);
+}
+
+Datum
+cbor_eq(PG_FUNCTION_ARGS) {
+	PG_RETURN_BOOL(pg_cbor_cmp_datum(PG_GETARG_DATUM(0), PG_GETARG_DATUM(1)) == 0);
+}
+
+Datum
+cbor_ne(PG_FUNCTION_ARGS) {
+	PG_RETURN_BOOL(pg_cbor_cmp_datum(PG_GETARG_DATUM(0), PG_GETARG_DATUM(1)) != 0);
+}
+
+Datum
+cbor_ge(PG_FUNCTION_ARGS) {
+	PG_RETURN_BOOL(pg_cbor_cmp_datum(PG_GETARG_DATUM(0), PG_GETARG_DATUM(1)) >= 0);
+}
+
+Datum
+cbor_gt(PG_FUNCTION_ARGS) {
+	PG_RETURN_BOOL(pg_cbor_cmp_datum(PG_GETARG_DATUM(0), PG_GETARG_DATUM(1)) > 0);
+}
+
+static int
+pg_cbor_fastcmp(Datum x, Datum y, SortSupport ssup) {
+	return pg_cbor_cmp_datum(x, y);
+}
+
+#ifdef PG_CBOR_ABBREVIATE
+
+static int
+pg_cbor_cmp_abbrev(Datum x, Datum y, SortSupport ssup) {
+	return (x < y) ? -1 : ((x > y) ? 1 : 0);
+}
+
+static Datum
+pg_cbor_abbrev_convert(Datum original, SortSupport ssup) {
+	PgCborSortState *state = (PgCborSortState *)ssup->ssup_extra;
+	struct varlena *doc = PG_DETOAST_DATUM_PACKED(original);
+	uint64 key;
+
+	key = CborCompareKey((const uint8_t *)VARDATA_ANY(doc), VARSIZE_ANY_EXHDR(doc));
+
+	++ state->inputCount;
+	if (state->estimating) {
+		addHyperLogLog(&state->abbrCard, DatumGetUInt32(hash_uint32((uint32)(key ^ (key >> 32)))));
+	}
+
+	if ((Pointer)doc != DatumGetPointer(original)) {
+		pfree(doc);
+	}
+	return (Datum)key;
+}
+
+// abbreviation is useless, when leading values are mostly the same (e.g. all documents are objects)
+static bool
+pg_cbor_abbrev_abort(int memtupcount, SortSupport ssup) {
+	PgCborSortState *state = (PgCborSortState *)ssup->ssup_extra;
+	double abbrCard;
+
+	if (memtupcount < PG_CBOR_ABBREV_MIN_ROWS || state->inputCount < PG_CBOR_ABBREV_MIN_ROWS || !state->estimating) {
+		return false;
+	}
+
+	abbrCard = estimateHyperLogLog(&state->abbrCard);
+	if (abbrCard > PG_CBOR_ABBREV_FULL_CARDINALITY) {
+		state->estimating = false;
+		return false;
+	}
+
+	return abbrCard < state->inputCount / 2000.0 + 0.5;
+}
+
+#endif
+
+Datum
+cbor_sortsupport(PG_FUNCTION_ARGS) {
+	SortSupport ssup = (SortSupport)PG_GETARG_POINTER(0);
+
+	ssup->comparator = pg_cbor_fastcmp;
+
+#ifdef PG_CBOR_ABBREVIATE
+	if (ssup->abbreviate) {
+		MemoryContext oldcontext = MemoryContextSwitchTo(ssup->ssup_cxt);
+		PgCborSortState *state = palloc(sizeof(PgCborSortState));
+
+		state->estimating = true;
+		state->inputCount = 0;
+		initHyperLogLog(&state->abbrCard, 10);
+
+		ssup->ssup_extra = state;
+		ssup->comparator = pg_cbor_cmp_abbrev;
+		ssup->abbrev_converter = pg_cbor_abbrev_convert;
+		ssup->abbrev_abort = pg_cbor_abbrev_abort;
+		ssup->abbrev_full_comparator = pg_cbor_fastcmp;
+
+		MemoryContextSwitchTo(oldcontext);
+	}
+#endif
+
+	PG_RETURN_VOID();
+}
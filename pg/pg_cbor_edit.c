@@ -0,0 +1,122 @@
+
+#include "pg_cbor.h"
+
+#include "utils/builtins.h"
+
+PG_FUNCTION_INFO_V1(cbor_set);
+PG_FUNCTION_INFO_V1(cbor_insert);
+PG_FUNCTION_INFO_V1(cbor_delete_path);
+PG_FUNCTION_INFO_V1(cbor_concat);
+PG_FUNCTION_INFO_V1(cbor_merge_patch);
+
+/* Edited document is spliced from unchanged byte ranges of original document and new value,
+ * when path is not found, original document is returned as is (like with jsonb_set) */
+static Datum
+pg_cbor_edit_document(FunctionCallInfo fcinfo, CborEditMode mode, int valarg) {
+	bytea *ptr = PG_GETARG_BYTEA_PP(0);
+	const uint8_t *data = (const uint8_t *)VARDATA_ANY(ptr);
+	size_t bsize = VARSIZE_ANY_EXHDR(ptr);
+	const CborPath *path = PgCborGetPath(fcinfo, 1);
+
+	bytea *value = NULL;
+	CborData vdata = { 0, NULL };
+	CborEditStatus status;
+	CborBuffer buf;
+
+	if (!PgCborArgIsDocument(fcinfo, 0, data, bsize)) {
+		elog(ERROR, "Invalid CBOR data: no magic header");
+	}
+
+	if (valarg >= 0) {
+		value = PG_GETARG_BYTEA_PP(valarg);
+		vdata.ptr = (const uint8_t *)VARDATA_ANY(value);
+		vdata.size = VARSIZE_ANY_EXHDR(value);
+		if (!PgCborArgIsDocument(fcinfo, valarg, vdata.ptr, vdata.size)) {
+			elog(ERROR, "Invalid CBOR data: no magic header in value");
+		}
+		// bytea values are not validated on input, spliced value should be single well-formed item
+		if (!CborValidate(vdata.ptr, vdata.size)) {
+			elog(ERROR, "Invalid CBOR data: value should be single well-formed item");
+		}
+		if (data_is_cbor(vdata.ptr, vdata.size)) {
+			CborDataOffset(&vdata, CborHeaderSize);
+		}
+	}
+
+	PgCborBufferInit(&buf, CborHeaderSize + bsize + vdata.size);
+	CborBufferWrite(&buf, (const char *)CborHeaderData, CborHeaderSize);
+
+	status = CborEditPath(&buf, data, bsize, path, mode, &vdata);
+	switch (status) {
+	case CborEditStatusOk:
+		break;
+	case CborEditStatusNotFound:
+		CborBufferFinalize(&buf);
+		PG_RETURN_BYTEA_P(ptr);
+		break;
+	case CborEditStatusKeyExists:
+		elog(ERROR, "Invalid path data: key already exists, use cbor_set to replace its value");
+		break;
+	case CborEditStatusMalformed:
+		elog(ERROR, "Invalid CBOR data: document is malformed");
+		break;
+	}
+
+	PG_FREE_IF_COPY(ptr, 0);
+	if (value) {
+		PG_FREE_IF_COPY(value, valarg);
+	}
+	PG_RETURN_BYTEA_P((bytea *)PgCborBufferGetVarlena(&buf));
+}
+
+Datum
+cbor_set(PG_FUNCTION_ARGS) {
+	return pg_cbor_edit_document(fcinfo, PG_GETARG_BOOL(3) ? CborEditSet : CborEditReplace, 2);
+}
+
+Datum
+cbor_insert(PG_FUNCTION_ARGS) {
+	return pg_cbor_edit_document(fcinfo, PG_GETARG_BOOL(3) ? CborEditInsertAfter : CborEditInsertBefore, 2);
+}
+
+Datum
+cbor_delete_path(PG_FUNCTION_ARGS) {
+	return pg_cbor_edit_document(fcinfo, CborEditDelete, -1);
+}
+
+// both documents are walked once, result is built from their byte ranges
+static Datum
+pg_cbor_merge_documents(FunctionCallInfo fcinfo, bool patch) {
+	bytea *a = PG_GETARG_BYTEA_PP(0);
+	bytea *b = PG_GETARG_BYTEA_PP(1);
+	const uint8_t *adata = (const uint8_t *)VARDATA_ANY(a);
+	const uint8_t *bdata = (const uint8_t *)VARDATA_ANY(b);
+	size_t asize = VARSIZE_ANY_EXHDR(a);
+	size_t bsize = VARSIZE_ANY_EXHDR(b);
+	CborBuffer buf;
+
+	if (!PgCborArgIsDocument(fcinfo, 0, adata, asize) || !PgCborArgIsDocument(fcinfo, 1, bdata, bsize)) {
+		elog(ERROR, "Invalid CBOR data: no magic header");
+	}
+
+	PgCborBufferInit(&buf, CborHeaderSize + asize + bsize);
+	CborBufferWrite(&buf, (const char *)CborHeaderData, CborHeaderSize);
+
+	if (!(patch ? CborMergePatch(&buf, adata, asize, bdata, bsize) : CborConcat(&buf, adata, asize, bdata, bsize))) {
+		elog(ERROR, "Invalid CBOR data: document is malformed");
+	}
+
+	PG_FREE_IF_COPY(a, 0);
+	PG_FREE_IF_COPY(b, 1);
+	PG_RETURN_BYTEA_P((bytea *)PgCborBufferGetVarlena(&buf));
+}
+
+Datum
+cbor_concat(PG_FUNCTION_ARGS) {
+	return pg_cbor_merge_documents(fcinfo, false);
+}
+
+Datum
+cbor_merge_patch(PG_FUNCTION_ARGS) {
+	return pg_cbor_merge_documents(fcinfo, true);
+}
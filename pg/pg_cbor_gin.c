@@ -0,0 +1,628 @@
+
+#include "pg_cbor.h"
+
+#include "access/gin.h"
+#include "catalog/pg_type.h"
+#include "utils/array.h"
+#include "utils/builtins.h"
+
+#if PG_VERSION_NUM >= 130000
+#include "common/hashfn.h"
+#elif PG_VERSION_NUM >= 120000
+#include "utils/hashutils.h"
+#else
+#include "access/hash.h"
+#endif
+
+#if PG_VERSION_NUM >= 90600
+#include "access/stratnum.h"
+#else
+#include "access/skey.h"
+#endif
+
+PG_FUNCTION_INFO_V1(cbor_exists);
+PG_FUNCTION_INFO_V1(cbor_exists_any);
+PG_FUNCTION_INFO_V1(cbor_exists_all);
+PG_FUNCTION_INFO_V1(cbor_contains);
+PG_FUNCTION_INFO_V1(cbor_contained);
+PG_FUNCTION_INFO_V1(cbor_path_equals);
+
+PG_FUNCTION_INFO_V1(cbor_gin_extract_value);
+PG_FUNCTION_INFO_V1(cbor_gin_extract_query);
+PG_FUNCTION_INFO_V1(cbor_gin_consistent);
+
+PG_FUNCTION_INFO_V1(cbor_gin_extract_value_path);
+PG_FUNCTION_INFO_V1(cbor_gin_extract_query_path);
+PG_FUNCTION_INFO_V1(cbor_gin_consistent_path);
+
+// same strategy numbers as jsonb_ops
+#define PG_CBOR_EXISTS_STRATEGY 9
+#define PG_CBOR_EXISTS_ANY_STRATEGY 10
+#define PG_CBOR_EXISTS_ALL_STRATEGY 11
+
+/* GIN entry is bytea with flag byte, followed by normalized scalar (see CBOR_SCALAR_*).
+ * Long scalars are replaced with their hash, such entries require recheck */
+#define PG_CBOR_GIN_FLAG_MEMBER 0x01 // top-level object key or top-level array string element
+#define PG_CBOR_GIN_FLAG_KEY 0x02 // nested object key
+#define PG_CBOR_GIN_FLAG_VALUE 0x03 // scalar value at any level
+#define PG_CBOR_GIN_FLAG_HASHED 0x80
+
+// longer scalars are hashed
+#define PG_CBOR_GIN_MAX_LENGTH 125
+
+typedef struct PgCborGinEntries {
+	Datum *entries;
+	int32 count;
+	int32 capacity;
+	CborBuffer scalar;
+} PgCborGinEntries;
+
+typedef struct PgCborGinFrame {
+	bool object;
+	bool key; // object: next item is key
+	uint32 hash; // cbor_path_ops: hash of path to container
+	uint32 keyHash; // cbor_path_ops: hash of path to current object value
+} PgCborGinFrame;
+
+static void
+pg_cbor_gin_push(PgCborGinEntries *entries, Datum entry) {
+	if (entries->count == entries->capacity) {
+		entries->capacity = entries->capacity ? entries->capacity * 2 : 16;
+		entries->entries = entries->entries
+				? repalloc(entries->entries, sizeof(Datum) * entries->capacity)
+				: palloc(sizeof(Datum) * entries->capacity);
+	}
+	entries->entries[entries->count ++] = entry;
+}
+
+static void
+pg_cbor_gin_add_entry(PgCborGinEntries *entries, uint8 flag, const char *data, size_t size) {
+	bytea *entry;
+	uint32 hash;
+
+	if (size > PG_CBOR_GIN_MAX_LENGTH) {
+		hash = DatumGetUInt32(hash_any((const unsigned char *)data, size));
+		flag |= PG_CBOR_GIN_FLAG_HASHED;
+		data = (const char *)&hash;
+		size = sizeof(uint32);
+	}
+
+	entry = palloc(VARHDRSZ + 1 + size);
+	*((uint8 *)VARDATA(entry)) = flag;
+	memcpy(VARDATA(entry) + 1, data, size);
+	SET_VARSIZE(entry, VARHDRSZ + 1 + size);
+
+	pg_cbor_gin_push(entries, PointerGetDatum(entry));
+}
+
+// add normalized scalar at iterator position with one or two flags
+static bool
+pg_cbor_gin_add_scalar(PgCborGinEntries *entries, CborIteratorContext *iter, uint8 flag, uint8 extraFlag) {
+	entries->scalar.size = 0;
+	if (!CborIteratorNormalizeScalar(iter, &entries->scalar)) {
+		return false;
+	}
+
+	pg_cbor_gin_add_entry(entries, flag, entries->scalar.data, entries->scalar.size);
+	if (extraFlag) {
+		pg_cbor_gin_add_entry(entries, extraFlag, entries->scalar.data, entries->scalar.size);
+	}
+	return true;
+}
+
+/* Walk whole document: keys are indexed with their level (top-level or nested),
+ * scalar values - at any level, top-level array strings are indexed as members for ? operators */
+static void
+pg_cbor_gin_extract(PgCborGinEntries *entries, const uint8_t *data, size_t size) {
+	CborIteratorContext iter;
+	CborIteratorToken token;
+	PgCborGinFrame *frames;
+	uint32 depth = 0, capacity = 8;
+	PgCborGinFrame *frame;
+	uint8 flag, extraFlag;
+
+	memset(entries, 0, sizeof(PgCborGinEntries));
+	if (!CborIteratorInit(&iter, data, size)) {
+		return;
+	}
+
+	CborBufferInit(&entries->scalar, 0, 0);
+	frames = palloc(sizeof(PgCborGinFrame) * capacity);
+
+	while ((token = CborIteratorNext(&iter)) != CborIteratorTokenDone) {
+		frame = (depth > 0) ? &frames[depth - 1] : NULL;
+		switch (token) {
+		case CborIteratorTokenKey:
+		case CborIteratorTokenValue:
+		case CborIteratorTokenBeginByteStrings:
+		case CborIteratorTokenBeginCharStrings:
+			if (CborIteratorGetType(&iter) == CborTypeTag) {
+				break;
+			}
+
+			extraFlag = 0;
+			if (frame && frame->object && frame->key) {
+				flag = (depth == 1) ? PG_CBOR_GIN_FLAG_MEMBER : PG_CBOR_GIN_FLAG_KEY;
+			} else {
+				flag = PG_CBOR_GIN_FLAG_VALUE;
+				if (depth == 1 && !frame->object && CborIteratorGetType(&iter) == CborTypeCharString) {
+					extraFlag = PG_CBOR_GIN_FLAG_MEMBER;
+				}
+			}
+
+			pg_cbor_gin_add_scalar(entries, &iter, flag, extraFlag);
+			if (frame && frame->object) {
+				frame->key = !frame->key;
+			}
+			break;
+		case CborIteratorTokenBeginArray:
+		case CborIteratorTokenBeginObject:
+			if (frame && frame->object) {
+				frame->key = !frame->key;
+			}
+			if (depth == capacity) {
+				capacity *= 2;
+				frames = repalloc(frames, sizeof(PgCborGinFrame) * capacity);
+			}
+			frames[depth].object = (token == CborIteratorTokenBeginObject);
+			frames[depth].key = true;
+			++ depth;
+			break;
+		case CborIteratorTokenEndArray:
+		case CborIteratorTokenEndObject:
+			if (depth > 0) {
+				-- depth;
+			}
+			break;
+		default:
+			break;
+		}
+	}
+
+	CborIteratorFinalize(&iter);
+	CborBufferFinalize(&entries->scalar);
+	pfree(frames);
+}
+
+// path hash, extended with next step or leaf value, like in jsonb_path_ops
+static inline uint32
+pg_cbor_gin_path_combine(uint32 hash, uint32 step) {
+	return ((hash << 1) | (hash >> 31)) ^ step;
+}
+
+static uint32
+pg_cbor_gin_scalar_hash(PgCborGinEntries *entries, CborIteratorContext *iter, bool *valid) {
+	entries->scalar.size = 0;
+	*valid = CborIteratorNormalizeScalar(iter, &entries->scalar);
+	if (!*valid) {
+		return 0;
+	}
+	return DatumGetUInt32(hash_any((const unsigned char *)entries->scalar.data, entries->scalar.size));
+}
+
+/* cbor_path_ops: one hash per root-to-leaf path, combined from object keys and leaf value;
+ * array levels are transparent, so containment within arrays does not depend on positions */
+static void
+pg_cbor_gin_extract_paths(PgCborGinEntries *entries, const uint8_t *data, size_t size) {
+	CborIteratorContext iter;
+	CborIteratorToken token;
+	PgCborGinFrame *frames;
+	uint32 depth = 0, capacity = 8;
+	PgCborGinFrame *frame;
+	uint32 hash, step;
+	bool valid;
+
+	memset(entries, 0, sizeof(PgCborGinEntries));
+	if (!CborIteratorInit(&iter, data, size)) {
+		return;
+	}
+
+	CborBufferInit(&entries->scalar, 0, 0);
+	frames = palloc(sizeof(PgCborGinFrame) * capacity);
+
+	while ((token = CborIteratorNext(&iter)) != CborIteratorTokenDone) {
+		frame = (depth > 0) ? &frames[depth - 1] : NULL;
+
+		// path to current item
+		hash = !frame ? 0 : (frame->object ? frame->keyHash : frame->hash);
+
+		switch (token) {
+		case CborIteratorTokenKey:
+		case CborIteratorTokenValue:
+		case CborIteratorTokenBeginByteStrings:
+		case CborIteratorTokenBeginCharStrings:
+			if (CborIteratorGetType(&iter) == CborTypeTag) {
+				break;
+			}
+
+			step = pg_cbor_gin_scalar_hash(entries, &iter, &valid);
+			if (frame && frame->object && frame->key) {
+				frame->keyHash = pg_cbor_gin_path_combine(frame->hash, step);
+			} else if (valid) {
+				pg_cbor_gin_push(entries, UInt32GetDatum(pg_cbor_gin_path_combine(hash, step)));
+			}
+
+			if (frame && frame->object) {
+				frame->key = !frame->key;
+			}
+			break;
+		case CborIteratorTokenBeginArray:
+		case CborIteratorTokenBeginObject:
+			if (frame && frame->object) {
+				if (frame->key) {
+					// container as key can not be matched by path
+					frame->keyHash = pg_cbor_gin_path_combine(frame->hash, 0);
+				}
+				frame->key = !frame->key;
+			}
+			if (depth == capacity) {
+				capacity *= 2;
+				frames = repalloc(frames, sizeof(PgCborGinFrame) * capacity);
+			}
+			frames[depth].object = (token == CborIteratorTokenBeginObject);
+			frames[depth].key = true;
+			frames[depth].hash = hash;
+			frames[depth].keyHash = hash;
+			++ depth;
+			break;
+		case CborIteratorTokenEndArray:
+		case CborIteratorTokenEndObject:
+			if (depth > 0) {
+				-- depth;
+			}
+			break;
+		default:
+			break;
+		}
+	}
+
+	CborIteratorFinalize(&iter);
+	CborBufferFinalize(&entries->scalar);
+	pfree(frames);
+}
+
+static bool
+pg_cbor_gin_entry_is_hashed(Datum entry) {
+	return (*((const uint8 *)VARDATA_ANY(DatumGetPointer(entry))) & PG_CBOR_GIN_FLAG_HASHED) != 0;
+}
+
+// scalar CBOR_SCALAR_STRING for text key, written into buffer
+static void
+pg_cbor_text_scalar(CborBuffer *buf, Datum key) {
+	text *str = DatumGetTextPP(key);
+
+	buf->size = buf->reserved;
+	CborBufferWriteChar(buf, CBOR_SCALAR_STRING);
+	CborBufferWrite(buf, VARDATA_ANY(str), VARSIZE_ANY_EXHDR(str));
+}
+
+/* Existence of top-level object keys or top-level array strings (like jsonb ?, ?| and ?&) */
+static bool
+pg_cbor_exists(FunctionCallInfo fcinfo, Datum *keys, bool *nulls, int nkeys, bool all) {
+	bytea *doc = PG_GETARG_BYTEA_P(0);
+	const uint8_t *data = (const uint8_t *)VARDATA(doc);
+	size_t size = VARSIZE(doc) - VARHDRSZ;
+
+	CborIteratorContext iter;
+	CborData item, content;
+	CborBuffer member, key;
+	bool object;
+	bool *found;
+	int i, nfound = 0, nrequired = 0;
+
+	for (i = 0; i < nkeys; ++ i) {
+		if (!nulls || !nulls[i]) {
+			++ nrequired;
+		}
+	}
+
+	if (!PgCborArgIsDocument(fcinfo, 0, data, size) || !CborIteratorInitRoot(&iter, data, size)) {
+		return false;
+	}
+
+	if (iter.token != CborIteratorTokenBeginObject && iter.token != CborIteratorTokenBeginArray) {
+		CborIteratorFinalize(&iter);
+		return false;
+	}
+
+	object = (iter.token == CborIteratorTokenBeginObject);
+	found = palloc0(sizeof(bool) * Max(nkeys, 1));
+	CborBufferInit(&member, 0, 0);
+	CborBufferInit(&key, 0, 0);
+
+	CborIteratorNext(&iter);
+	while (nfound < nrequired && CborIteratorReadElement(&iter, &item, &content)) {
+		member.size = 0;
+		if (CborNormalizeScalar(&content, &member) && member.data[0] == CBOR_SCALAR_STRING) {
+			for (i = 0; i < nkeys; ++ i) {
+				if (found[i] || (nulls && nulls[i])) {
+					continue;
+				}
+				pg_cbor_text_scalar(&key, keys[i]);
+				if (key.size == member.size && memcmp(key.data, member.data, key.size) == 0) {
+					found[i] = true;
+					++ nfound;
+				}
+			}
+		}
+
+		if (!all && nfound > 0) {
+			break;
+		}
+
+		// skip value for object
+		if (object && !CborIteratorReadElement(&iter, &item, &content)) {
+			break;
+		}
+	}
+
+	CborBufferFinalize(&member);
+	CborBufferFinalize(&key);
+	CborIteratorFinalize(&iter);
+	pfree(found);
+
+	return all ? (nfound == nrequired) : (nfound > 0);
+}
+
+Datum
+cbor_exists(PG_FUNCTION_ARGS) {
+	Datum key = PG_GETARG_DATUM(1);
+
+	PG_RETURN_BOOL(pg_cbor_exists(fcinfo, &key, NULL, 1, false));
+}
+
+static Datum
+pg_cbor_exists_array(FunctionCallInfo fcinfo, bool all) {
+	ArrayType *keys = PG_GETARG_ARRAYTYPE_P(1);
+	Datum *keyDatums;
+	bool *keyNulls;
+	int nkeys;
+
+	deconstruct_array(keys, TEXTOID, -1, false, 'i', &keyDatums, &keyNulls, &nkeys);
+
+	PG_RETURN_BOOL(pg_cbor_exists(fcinfo, keyDatums, keyNulls, nkeys, all));
+}
+
+Datum
+cbor_exists_any(PG_FUNCTION_ARGS) {
+	return pg_cbor_exists_array(fcinfo, false);
+}
+
+Datum
+cbor_exists_all(PG_FUNCTION_ARGS) {
+	return pg_cbor_exists_array(fcinfo, true);
+}
+
+static bool
+pg_cbor_contains(FunctionCallInfo fcinfo, int docArg, int queryArg) {
+	bytea *doc = PG_GETARG_BYTEA_P(docArg);
+	bytea *query = PG_GETARG_BYTEA_P(queryArg);
+	const uint8_t *data = (const uint8_t *)VARDATA(doc);
+	size_t size = VARSIZE(doc) - VARHDRSZ;
+	const uint8_t *qdata = (const uint8_t *)VARDATA(query);
+	size_t qsize = VARSIZE(query) - VARHDRSZ;
+
+	if (!PgCborArgIsDocument(fcinfo, docArg, data, size) || !PgCborArgIsDocument(fcinfo, queryArg, qdata, qsize)) {
+		return false;
+	}
+
+	return CborContains(data, size, qdata, qsize);
+}
+
+Datum
+cbor_contains(PG_FUNCTION_ARGS) {
+	PG_RETURN_BOOL(pg_cbor_contains(fcinfo, 0, 1));
+}
+
+Datum
+cbor_contained(PG_FUNCTION_ARGS) {
+	PG_RETURN_BOOL(pg_cbor_contains(fcinfo, 1, 0));
+}
+
+/* Value at path is equal to value: both values contain each other, so every document,
+ * where value is found, contains object built from path and value (see cbor_path_support) */
+Datum
+cbor_path_equals(PG_FUNCTION_ARGS) {
+	const CborPath *path = PgCborGetPath(fcinfo, 1);
+	bytea *value = PG_GETARG_BYTEA_P(2);
+	const uint8_t *vdata = (const uint8_t *)VARDATA(value);
+	size_t vsize = VARSIZE(value) - VARHDRSZ;
+
+	CborIteratorContext iter;
+	const uint8_t *begin, *end;
+	bytea *doc;
+	bool ret = false;
+
+	if (path->nsteps == 0) {
+		doc = PG_GETARG_BYTEA_P(0);
+		begin = (const uint8_t *)VARDATA(doc);
+		end = begin + VARSIZE(doc) - VARHDRSZ;
+		PG_RETURN_BOOL(CborContains(begin, end - begin, vdata, vsize) && CborContains(vdata, vsize, begin, end - begin));
+	}
+
+	if (PgCborGetPathValue(fcinfo, 0, path, &iter)) {
+		begin = CborIteratorGetCurrentValuePtr(&iter);
+		end = CborIteratorReadCurrentValue(&iter);
+		ret = CborContains(begin, end - begin, vdata, vsize) && CborContains(vdata, vsize, begin, end - begin);
+		CborIteratorFinalize(&iter);
+	}
+
+	PG_RETURN_BOOL(ret);
+}
+
+Datum
+cbor_gin_extract_value(PG_FUNCTION_ARGS) {
+	bytea *doc = PG_GETARG_BYTEA_P(0);
+	int32 *nentries = (int32 *)PG_GETARG_POINTER(1);
+	PgCborGinEntries entries;
+
+	pg_cbor_gin_extract(&entries, (const uint8_t *)VARDATA(doc), VARSIZE(doc) - VARHDRSZ);
+
+	*nentries = entries.count;
+	PG_RETURN_POINTER(entries.entries);
+}
+
+Datum
+cbor_gin_extract_query(PG_FUNCTION_ARGS) {
+	int32 *nentries = (int32 *)PG_GETARG_POINTER(1);
+	StrategyNumber strategy = PG_GETARG_UINT16(2);
+	int32 *searchMode = (int32 *)PG_GETARG_POINTER(6);
+	PgCborGinEntries entries;
+	CborBuffer buf;
+	Datum *keys;
+	bool *nulls;
+	int i, nkeys;
+
+	memset(&entries, 0, sizeof(PgCborGinEntries));
+
+	switch (strategy) {
+	case PG_CBOR_CONTAINS_STRATEGY: {
+		bytea *query = PG_GETARG_BYTEA_P(0);
+		pg_cbor_gin_extract(&entries, (const uint8_t *)VARDATA(query), VARSIZE(query) - VARHDRSZ);
+		if (entries.count == 0) {
+			// empty containers are contained in any container of the same type
+			*searchMode = GIN_SEARCH_MODE_ALL;
+		}
+		break;
+	}
+	case PG_CBOR_EXISTS_STRATEGY:
+		CborBufferInit(&buf, 0, 0);
+		pg_cbor_text_scalar(&buf, PG_GETARG_DATUM(0));
+		pg_cbor_gin_add_entry(&entries, PG_CBOR_GIN_FLAG_MEMBER, buf.data, buf.size);
+		CborBufferFinalize(&buf);
+		break;
+	case PG_CBOR_EXISTS_ANY_STRATEGY:
+	case PG_CBOR_EXISTS_ALL_STRATEGY:
+		deconstruct_array(PG_GETARG_ARRAYTYPE_P(0), TEXTOID, -1, false, 'i', &keys, &nulls, &nkeys);
+		CborBufferInit(&buf, 0, 0);
+		for (i = 0; i < nkeys; ++ i) {
+			if (!nulls[i]) {
+				pg_cbor_text_scalar(&buf, keys[i]);
+				pg_cbor_gin_add_entry(&entries, PG_CBOR_GIN_FLAG_MEMBER, buf.data, buf.size);
+			}
+		}
+		CborBufferFinalize(&buf);
+
+		// ?& with no keys is true for any document, ?| with no keys - for none
+		if (entries.count == 0 && strategy == PG_CBOR_EXISTS_ALL_STRATEGY) {
+			*searchMode = GIN_SEARCH_MODE_ALL;
+		}
+		break;
+	default:
+		elog(ERROR, "Invalid GIN strategy: %d", strategy);
+		break;
+	}
+
+	*nentries = entries.count;
+	PG_RETURN_POINTER(entries.entries);
+}
+
+/* Existence matches of non-hashed entries are exact: member entries are indexed only
+ * for top level, so recheck is required only for hashed entries. Containment always
+ * requires recheck, index has no information about structure */
+Datum
+cbor_gin_consistent(PG_FUNCTION_ARGS) {
+	bool *check = (bool *)PG_GETARG_POINTER(0);
+	StrategyNumber strategy = PG_GETARG_UINT16(1);
+	int32 nkeys = PG_GETARG_INT32(3);
+	bool *recheck = (bool *)PG_GETARG_POINTER(5);
+	Datum *queryKeys = (Datum *)PG_GETARG_POINTER(6);
+	bool res = true;
+	int32 i;
+
+	switch (strategy) {
+	case PG_CBOR_CONTAINS_STRATEGY:
+		for (i = 0; i < nkeys && res; ++ i) {
+			res = check[i];
+		}
+		*recheck = true;
+		break;
+	case PG_CBOR_EXISTS_STRATEGY:
+	case PG_CBOR_EXISTS_ALL_STRATEGY:
+		*recheck = false;
+		for (i = 0; i < nkeys && res; ++ i) {
+			res = check[i];
+			if (pg_cbor_gin_entry_is_hashed(queryKeys[i])) {
+				*recheck = true;
+			}
+		}
+		break;
+	case PG_CBOR_EXISTS_ANY_STRATEGY:
+		// exact match of any non-hashed key is enough
+		res = false;
+		*recheck = false;
+		for (i = 0; i < nkeys; ++ i) {
+			if (check[i]) {
+				if (!pg_cbor_gin_entry_is_hashed(queryKeys[i])) {
+					res = true;
+					*recheck = false;
+					break;
+				}
+				res = true;
+				*recheck = true;
+			}
+		}
+		break;
+	default:
+		elog(ERROR, "Invalid GIN strategy: %d", strategy);
+		break;
+	}
+
+	PG_RETURN_BOOL(res);
+}
+
+Datum
+cbor_gin_extract_value_path(PG_FUNCTION_ARGS) {
+	bytea *doc = PG_GETARG_BYTEA_P(0);
+	int32 *nentries = (int32 *)PG_GETARG_POINTER(1);
+	PgCborGinEntries entries;
+
+	pg_cbor_gin_extract_paths(&entries, (const uint8_t *)VARDATA(doc), VARSIZE(doc) - VARHDRSZ);
+
+	*nentries = entries.count;
+	PG_RETURN_POINTER(entries.entries);
+}
+
+Datum
+cbor_gin_extract_query_path(PG_FUNCTION_ARGS) {
+	bytea *query = PG_GETARG_BYTEA_P(0);
+	int32 *nentries = (int32 *)PG_GETARG_POINTER(1);
+	StrategyNumber strategy = PG_GETARG_UINT16(2);
+	int32 *searchMode = (int32 *)PG_GETARG_POINTER(6);
+	PgCborGinEntries entries;
+
+	if (strategy != PG_CBOR_CONTAINS_STRATEGY) {
+		elog(ERROR, "Invalid GIN strategy: %d", strategy);
+	}
+
+	pg_cbor_gin_extract_paths(&entries, (const uint8_t *)VARDATA(query), VARSIZE(query) - VARHDRSZ);
+	if (entries.count == 0) {
+		*searchMode = GIN_SEARCH_MODE_ALL;
+	}
+
+	*nentries = entries.count;
+	PG_RETURN_POINTER(entries.entries);
+}
+
+/* All path hashes of query should be present, hashes can collide and do not
+ * preserve array structure, so matches are always rechecked */
+Datum
+cbor_gin_consistent_path(PG_FUNCTION_ARGS) {
+	bool *check = (bool *)PG_GETARG_POINTER(0);
+	StrategyNumber strategy = PG_GETARG_UINT16(1);
+	int32 nkeys = PG_GETARG_INT32(3);
+	bool *recheck = (bool *)PG_GETARG_POINTER(5);
+	bool res = true;
+	int32 i;
+
+	if (strategy != PG_CBOR_CONTAINS_STRATEGY) {
+		elog(ERROR, "Invalid GIN strategy: %d", strategy);
+	}
+
+	for (i = 0; i < nkeys && res; ++ i) {
+		res = check[i];
+	}
+
+	*recheck = true;
+	PG_RETURN_BOOL(res);
+}
@@ -0,0 +1,79 @@
+
+#include "pg_cbor.h"
+
+#include "utils/builtins.h"
+
+#if PG_VERSION_NUM >= 130000
+#include "common/hashfn.h"
+#elif PG_VERSION_NUM >= 120000
+#include "utils/hashutils.h"
+#else
+#include "access/hash.h"
+#endif
+
+PG_FUNCTION_INFO_V1(cbor_hash);
+PG_FUNCTION_INFO_V1(cbor_type_hash);
+
+#if PG_VERSION_NUM >= 110000
+PG_FUNCTION_INFO_V1(cbor_hash_extended);
+PG_FUNCTION_INFO_V1(cbor_type_hash_extended);
+#endif
+
+/* Hash of hash form (see CborHash), so documents, equal by cbor_eq, have equal hash regardless
+ * of encoding, tags and map order. Low 32 bits of extended hash with zero seed are the same as standard hash.
+ *
+ * Hash support functions are called without fn_expr, so argument type can not be resolved: values of cbor type
+ * (validated on input, possibly stored without magic header) are always documents, bytea without magic header
+ * is hashed as plain bytes */
+static Datum
+pg_cbor_hash_document(FunctionCallInfo fcinfo, bool typed, bool extended, uint64 seed) {
+	bytea *ptr = PG_GETARG_BYTEA_PP(0);
+	const uint8_t *data = (const uint8_t *)VARDATA_ANY(ptr);
+	size_t bsize = VARSIZE_ANY_EXHDR(ptr);
+	uint64_t hash;
+	Datum ret;
+
+	if (!typed && !data_is_cbor(data, bsize)) {
+#if PG_VERSION_NUM >= 110000
+		ret = extended ? hash_any_extended(data, bsize, seed) : hash_any(data, bsize);
+#else
+		ret = hash_any(data, bsize);
+#endif
+		PG_FREE_IF_COPY(ptr, 0);
+		return ret;
+	}
+
+	if (!CborHash(data, bsize, seed, &hash)) {
+		elog(ERROR, "Invalid CBOR data: document is malformed");
+	}
+
+	PG_FREE_IF_COPY(ptr, 0);
+	if (extended) {
+		return UInt64GetDatum(hash);
+	}
+	return UInt32GetDatum((uint32)hash);
+}
+
+Datum
+cbor_hash(PG_FUNCTION_ARGS) {
+	return pg_cbor_hash_document(fcinfo, false, false, 0);
+}
+
+Datum
+cbor_type_hash(PG_FUNCTION_ARGS) {
+	return pg_cbor_hash_document(fcinfo, true, false, 0);
+}
+
+#if PG_VERSION_NUM >= 110000
+
+Datum
+cbor_hash_extended(PG_FUNCTION_ARGS) {
+	return pg_cbor_hash_document(fcinfo, false, true, (uint64)PG_GETARG_INT64(1));
+}
+
+Datum
+cbor_type_hash_extended(PG_FUNCTION_ARGS) {
+	return pg_cbor_hash_document(fcinfo, true, true, (uint64)PG_GETARG_INT64(1));
+}
+
+#endif
@@ -0,0 +1,476 @@
+
+#include "pg_cbor.h"
+
+#include "utils/builtins.h"
+#include "utils/jsonb.h"
+#include "utils/numeric.h"
+#include "mb/pg_wchar.h"
+
+#include <math.h>
+
+#if PG_VERSION_NUM < 110000
+#define PG_GETARG_JSONB_P(n) PG_GETARG_JSONB(n)
+#define PG_RETURN_JSONB_P(x) PG_RETURN_JSONB(x)
+#endif
+
+PG_FUNCTION_INFO_V1(cbor_to_jsonb);
+PG_FUNCTION_INFO_V1(jsonb_to_cbor);
+
+// decimal scale, for which double can be converted exactly with single multiplication or division
+#define PG_CBOR_DECIMAL_MAX_SCALE 15
+
+// largest integer, that can be represented exactly with double
+#define PG_CBOR_DOUBLE_MAX_EXACT INT64CONST(9007199254740992)
+
+typedef enum PgCborJsonbFrame {
+	PgCborJsonbFrameArray,
+	PgCborJsonbFrameKey, // object, next item is key
+	PgCborJsonbFrameValue, // object, next item is value
+} PgCborJsonbFrame;
+
+typedef struct PgCborJsonbState {
+	JsonbParseState *parse;
+	JsonbValue *result;
+
+	uint32 depth;
+	uint32 capacity;
+	PgCborJsonbFrame *frames;
+} PgCborJsonbState;
+
+typedef struct PgCborNumericBounds {
+	bool init;
+	Datum int64Min;
+	Datum int64Max;
+	Datum exactMin;
+	Datum exactMax;
+} PgCborNumericBounds;
+
+static const double pg_cbor_pow10[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15
+};
+
+// RFC 8949, section 6.1: byte strings are converted into unpadded base64url
+static void
+pg_cbor_jsonb_bytes(JsonbValue *v, const uint8_t *data, size_t size) {
+	char *out = palloc((size + 2) / 3 * 4 + 1);
+	size_t len = CborBase64UrlEncode(out, data, size);
+
+	out[len] = 0;
+	v->type = jbvString;
+	v->val.string.val = out;
+	v->val.string.len = len;
+}
+
+static void
+pg_cbor_jsonb_string(JsonbValue *v, const char *data, size_t size) {
+	char *str = pg_any_to_server(data, size, PG_UTF8);
+
+	v->type = jbvString;
+	v->val.string.val = str;
+	v->val.string.len = (str == data) ? size : strlen(str);
+}
+
+static void
+pg_cbor_jsonb_cstring(JsonbValue *v, const char *str, size_t len) {
+	v->type = jbvString;
+	v->val.string.val = pnstrdup(str, len);
+	v->val.string.len = len;
+}
+
+static Numeric
+pg_cbor_numeric_from_unsigned(uint64_t value) {
+	Datum ret;
+
+	if (value <= (uint64_t)PG_INT64_MAX) {
+		return DatumGetNumeric(DirectFunctionCall1(int8_numeric, Int64GetDatum((int64)value)));
+	}
+
+	// (value / 2) * 2 + value % 2
+	ret = DirectFunctionCall1(int8_numeric, Int64GetDatum((int64)(value >> 1)));
+	ret = DirectFunctionCall2(numeric_mul, ret, DirectFunctionCall1(int8_numeric, Int64GetDatum(2)));
+	ret = DirectFunctionCall2(numeric_add, ret, DirectFunctionCall1(int8_numeric, Int64GetDatum((int64)(value & 1))));
+	return DatumGetNumeric(ret);
+}
+
+// shortest decimal, that is converted back into the same double (float8_numeric rounds to 15 digits):
+// values with up to PG_CBOR_DECIMAL_MAX_SCALE fraction digits use exact integer arithmetic
+static Numeric
+pg_cbor_numeric_from_double(double value) {
+	char buf[CBOR_NUMBER_MAX_SIZE + 1];
+	uint32_t len;
+	uint32 scale;
+
+	for (scale = 0; scale <= PG_CBOR_DECIMAL_MAX_SCALE; ++ scale) {
+		double shifted = value * pg_cbor_pow10[scale];
+		int64 mantissa;
+		Datum ret;
+
+		if (fabs(shifted) >= (double)PG_CBOR_DOUBLE_MAX_EXACT) {
+			break;
+		}
+
+		mantissa = (int64)llrint(shifted);
+		if ((double)mantissa / pg_cbor_pow10[scale] != value) {
+			continue;
+		}
+
+		ret = DirectFunctionCall1(int8_numeric, Int64GetDatum(mantissa));
+		if (scale > 0) {
+			ret = DirectFunctionCall2(numeric_div, ret,
+					DirectFunctionCall1(int8_numeric, Int64GetDatum((int64)pg_cbor_pow10[scale])));
+			ret = DirectFunctionCall2(numeric_round, ret, Int32GetDatum(scale));
+		}
+		return DatumGetNumeric(ret);
+	}
+
+	// large or long values: shortest round-trip text, integral values keep zero scale
+	len = CborFormatDouble(buf, value);
+	if (len > 2 && buf[len - 2] == '.' && buf[len - 1] == '0') {
+		len -= 2;
+	}
+	buf[len] = 0;
+
+	return DatumGetNumeric(DirectFunctionCall3(numeric_in,
+			CStringGetDatum(buf), ObjectIdGetDatum(InvalidOid), Int32GetDatum(-1)));
+}
+
+static void
+pg_cbor_jsonb_scalar(CborIteratorContext *iter, JsonbValue *v, bool isKey) {
+	char buf[CBOR_NUMBER_MAX_SIZE];
+
+	switch (CborIteratorGetType(iter)) {
+	case CborTypeUnsigned:
+		if (isKey) {
+			pg_cbor_jsonb_cstring(v, buf, CborFormatUnsigned(buf, CborIteratorGetUnsigned(iter)));
+		} else {
+			v->type = jbvNumeric;
+			v->val.numeric = pg_cbor_numeric_from_unsigned(CborIteratorGetUnsigned(iter));
+		}
+		break;
+	case CborTypeNegative: {
+		// value is -1 - n, n can be out of int64 range
+		uint64_t n = CborDataGetUnsignedValue(&iter->current, iter->info);
+		if (isKey) {
+			buf[0] = '-';
+			if (n == UINT64_MAX) {
+				pg_cbor_jsonb_cstring(v, "-18446744073709551616", 21);
+			} else {
+				pg_cbor_jsonb_cstring(v, buf, CborFormatUnsigned(buf + 1, n + 1) + 1);
+			}
+		} else {
+			v->type = jbvNumeric;
+			v->val.numeric = DatumGetNumeric(DirectFunctionCall2(numeric_sub,
+					DirectFunctionCall1(int8_numeric, Int64GetDatum(-1)),
+					NumericGetDatum(pg_cbor_numeric_from_unsigned(n))));
+		}
+		break;
+	}
+	case CborTypeFloat: {
+		double value = CborIteratorGetFloat(iter);
+		if (isnan(value)) {
+			pg_cbor_jsonb_cstring(v, "NaN", 3);
+		} else if (isinf(value)) {
+			pg_cbor_jsonb_cstring(v, value > 0 ? "Infinity" : "-Infinity", value > 0 ? 8 : 9);
+		} else if (isKey) {
+			pg_cbor_jsonb_cstring(v, buf, CborFormatDouble(buf, value));
+		} else {
+			v->type = jbvNumeric;
+			v->val.numeric = pg_cbor_numeric_from_double(value);
+		}
+		break;
+	}
+	case CborTypeByteString:
+		pg_cbor_jsonb_bytes(v, CborIteratorGetBytePtr(iter), CborIteratorGetObjectSize(iter));
+		break;
+	case CborTypeCharString:
+		pg_cbor_jsonb_string(v, CborIteratorGetCharPtr(iter), CborIteratorGetObjectSize(iter));
+		break;
+	case CborTypeTrue:
+	case CborTypeFalse:
+		if (isKey) {
+			if (CborIteratorGetType(iter) == CborTypeTrue) {
+				pg_cbor_jsonb_cstring(v, "true", 4);
+			} else {
+				pg_cbor_jsonb_cstring(v, "false", 5);
+			}
+		} else {
+			v->type = jbvBool;
+			v->val.boolean = (CborIteratorGetType(iter) == CborTypeTrue);
+		}
+		break;
+	default:
+		// null, undefined and other simple values
+		if (isKey) {
+			pg_cbor_jsonb_cstring(v, "null", 4);
+		} else {
+			v->type = jbvNull;
+		}
+		break;
+	}
+}
+
+static bool
+pg_cbor_jsonb_expect_key(const PgCborJsonbState *state) {
+	return state->depth > 0 && state->frames[state->depth - 1] == PgCborJsonbFrameKey;
+}
+
+static void
+pg_cbor_jsonb_push(PgCborJsonbState *state, JsonbValue *v) {
+	PgCborJsonbFrame *frame;
+
+	if (state->depth == 0) {
+		// scalar document is stored as raw scalar pseudo-array
+		JsonbValue arr;
+		arr.type = jbvArray;
+		arr.val.array.rawScalar = true;
+		arr.val.array.nElems = 1;
+
+		pushJsonbValue(&state->parse, WJB_BEGIN_ARRAY, &arr);
+		pushJsonbValue(&state->parse, WJB_ELEM, v);
+		state->result = pushJsonbValue(&state->parse, WJB_END_ARRAY, NULL);
+		return;
+	}
+
+	frame = &state->frames[state->depth - 1];
+	switch (*frame) {
+	case PgCborJsonbFrameArray:
+		pushJsonbValue(&state->parse, WJB_ELEM, v);
+		break;
+	case PgCborJsonbFrameKey:
+		pushJsonbValue(&state->parse, WJB_KEY, v);
+		*frame = PgCborJsonbFrameValue;
+		break;
+	case PgCborJsonbFrameValue:
+		pushJsonbValue(&state->parse, WJB_VALUE, v);
+		*frame = PgCborJsonbFrameKey;
+		break;
+	}
+}
+
+static void
+pg_cbor_jsonb_begin(PgCborJsonbState *state, bool object) {
+	if (pg_cbor_jsonb_expect_key(state)) {
+		elog(ERROR, "Invalid CBOR data: container can not be converted into jsonb object key");
+	}
+
+	if (state->depth > 0 && state->frames[state->depth - 1] == PgCborJsonbFrameValue) {
+		state->frames[state->depth - 1] = PgCborJsonbFrameKey;
+	}
+
+	if (state->depth == state->capacity) {
+		state->capacity *= 2;
+		state->frames = repalloc(state->frames, state->capacity * sizeof(PgCborJsonbFrame));
+	}
+
+	state->frames[state->depth ++] = object ? PgCborJsonbFrameKey : PgCborJsonbFrameArray;
+	pushJsonbValue(&state->parse, object ? WJB_BEGIN_OBJECT : WJB_BEGIN_ARRAY, NULL);
+}
+
+static void
+pg_cbor_jsonb_end(PgCborJsonbState *state, bool object) {
+	JsonbValue *v;
+
+	-- state->depth;
+	v = pushJsonbValue(&state->parse, object ? WJB_END_OBJECT : WJB_END_ARRAY, NULL);
+	if (state->depth == 0) {
+		state->result = v;
+	}
+}
+
+Datum
+cbor_to_jsonb(PG_FUNCTION_ARGS) {
+	bytea *ptr = PG_GETARG_BYTEA_P(0);
+	size_t bsize = VARSIZE(ptr) - VARHDRSZ;
+	const uint8_t *data = (const uint8_t *)VARDATA(ptr);
+
+	CborIteratorContext iter;
+	CborIteratorToken token;
+	PgCborJsonbState state;
+	StringInfoData chunks;
+	bool chunked = false;
+	bool malformed;
+	JsonbValue v;
+
+	if (!PgCborArgIsDocument(fcinfo, 0, data, bsize)) {
+		elog(ERROR, "Invalid CBOR data: no magic header");
+	}
+
+	if (!CborIteratorInit(&iter, data, bsize)) {
+		elog(ERROR, "Invalid CBOR data");
+	}
+
+	memset(&state, 0, sizeof(PgCborJsonbState));
+	state.capacity = CBOR_STACK_DEFAULT_SIZE;
+	state.frames = palloc(state.capacity * sizeof(PgCborJsonbFrame));
+
+	while ((token = CborIteratorNext(&iter)) != CborIteratorTokenDone) {
+		switch (token) {
+		case CborIteratorTokenKey:
+		case CborIteratorTokenValue:
+			if (chunked) {
+				appendBinaryStringInfo(&chunks, (const char *)CborIteratorGetBytePtr(&iter), CborIteratorGetObjectSize(&iter));
+				break;
+			}
+			if (CborIteratorGetType(&iter) == CborTypeTag) {
+				// tags are not represented in JSON, tagged item is converted as is
+				break;
+			}
+			pg_cbor_jsonb_scalar(&iter, &v, pg_cbor_jsonb_expect_key(&state));
+			pg_cbor_jsonb_push(&state, &v);
+			break;
+		case CborIteratorTokenBeginArray:
+			pg_cbor_jsonb_begin(&state, false);
+			break;
+		case CborIteratorTokenEndArray:
+			pg_cbor_jsonb_end(&state, false);
+			break;
+		case CborIteratorTokenBeginObject:
+			pg_cbor_jsonb_begin(&state, true);
+			break;
+		case CborIteratorTokenEndObject:
+			pg_cbor_jsonb_end(&state, true);
+			break;
+		case CborIteratorTokenBeginByteStrings:
+		case CborIteratorTokenBeginCharStrings:
+			initStringInfo(&chunks);
+			chunked = true;
+			break;
+		case CborIteratorTokenEndByteStrings:
+			pg_cbor_jsonb_bytes(&v, (const uint8_t *)chunks.data, chunks.len);
+			pg_cbor_jsonb_push(&state, &v);
+			chunked = false;
+			break;
+		case CborIteratorTokenEndCharStrings:
+			pg_cbor_jsonb_string(&v, chunks.data, chunks.len);
+			pg_cbor_jsonb_push(&state, &v);
+			chunked = false;
+			break;
+		default:
+			break;
+		}
+	}
+
+	malformed = iter.malformed;
+	CborIteratorFinalize(&iter);
+
+	if (!state.result || state.depth > 0 || malformed) {
+		elog(ERROR, "Invalid CBOR data: document is truncated or malformed");
+	}
+
+	PG_RETURN_JSONB_P(JsonbValueToJsonb(state.result));
+}
+
+static void
+pg_cbor_numeric_bounds_init(PgCborNumericBounds *bounds) {
+	if (!bounds->init) {
+		bounds->int64Min = DirectFunctionCall1(int8_numeric, Int64GetDatum(PG_INT64_MIN));
+		bounds->int64Max = DirectFunctionCall1(int8_numeric, Int64GetDatum(PG_INT64_MAX));
+		bounds->exactMin = DirectFunctionCall1(int8_numeric, Int64GetDatum(-PG_CBOR_DOUBLE_MAX_EXACT));
+		bounds->exactMax = DirectFunctionCall1(int8_numeric, Int64GetDatum(PG_CBOR_DOUBLE_MAX_EXACT));
+		bounds->init = true;
+	}
+}
+
+static bool
+pg_cbor_numeric_within(Datum value, Datum min, Datum max) {
+	return DatumGetInt32(DirectFunctionCall2(numeric_cmp, value, min)) >= 0
+			&& DatumGetInt32(DirectFunctionCall2(numeric_cmp, value, max)) <= 0;
+}
+
+/* Integers within int64 are encoded as integers, decimals with small scale and mantissa
+ * are converted into double exactly with integer arithmetic, other values use numeric_float8 */
+static void
+pg_cbor_encode_numeric(CborEncoder *enc, Numeric num, PgCborNumericBounds *bounds) {
+	Datum value = NumericGetDatum(num);
+	int32 scale;
+
+	if (numeric_is_nan(num)) {
+		CborEncodeFloat(enc, NAN);
+		return;
+	}
+
+	pg_cbor_numeric_bounds_init(bounds);
+
+	scale = DatumGetInt32(DirectFunctionCall1(numeric_scale, value));
+	if (scale == 0) {
+		if (pg_cbor_numeric_within(value, bounds->int64Min, bounds->int64Max)) {
+			CborEncodeInteger(enc, DatumGetInt64(DirectFunctionCall1(numeric_int8, value)));
+			return;
+		}
+	} else if (scale > 0 && scale <= PG_CBOR_DECIMAL_MAX_SCALE) {
+		Datum shifted = DirectFunctionCall2(numeric_mul, value,
+				DirectFunctionCall1(int8_numeric, Int64GetDatum((int64)pg_cbor_pow10[scale])));
+		if (pg_cbor_numeric_within(shifted, bounds->exactMin, bounds->exactMax)) {
+			// both operands are exact, so division is correctly rounded
+			int64 mantissa = DatumGetInt64(DirectFunctionCall1(numeric_int8, shifted));
+			CborEncodeFloat(enc, (double)mantissa / pg_cbor_pow10[scale]);
+			return;
+		}
+	}
+
+	CborEncodeFloat(enc, DatumGetFloat8(DirectFunctionCall1(numeric_float8, value)));
+}
+
+static void
+pg_cbor_encode_jsonb_string(CborEncoder *enc, const JsonbValue *v) {
+	const char *str = pg_server_to_any(v->val.string.val, v->val.string.len, PG_UTF8);
+	CborEncodeString(enc, str, (str == v->val.string.val) ? v->val.string.len : strlen(str));
+}
+
+Datum
+jsonb_to_cbor(PG_FUNCTION_ARGS) {
+	Jsonb *jb = PG_GETARG_JSONB_P(0);
+	JsonbIterator *it;
+	JsonbIteratorToken token;
+	JsonbValue v;
+	CborEncoder enc;
+	PgCborNumericBounds bounds;
+	bool rawScalar = false;
+
+	memset(&bounds, 0, sizeof(PgCborNumericBounds));
+
+	PgCborEncoderInit(&enc);
+
+	it = JsonbIteratorInit(&jb->root);
+	while ((token = JsonbIteratorNext(&it, &v, false)) != WJB_DONE) {
+		switch (token) {
+		case WJB_BEGIN_ARRAY:
+			if (v.val.array.rawScalar) {
+				rawScalar = true;
+			} else {
+				CborEncodeBeginArray(&enc, v.val.array.nElems);
+			}
+			break;
+		case WJB_BEGIN_OBJECT:
+			CborEncodeBeginMap(&enc, v.val.object.nPairs);
+			break;
+		case WJB_END_ARRAY:
+			if (rawScalar) {
+				rawScalar = false;
+			} else {
+				CborEncodeEnd(&enc);
+			}
+			break;
+		case WJB_END_OBJECT:
+			CborEncodeEnd(&enc);
+			break;
+		case WJB_KEY:
+		case WJB_VALUE:
+		case WJB_ELEM:
+			switch (v.type) {
+			case jbvNull: CborEncodeNull(&enc); break;
+			case jbvBool: CborEncodeBool(&enc, v.val.boolean); break;
+			case jbvString: pg_cbor_encode_jsonb_string(&enc, &v); break;
+			case jbvNumeric: pg_cbor_encode_numeric(&enc, v.val.numeric, &bounds); break;
+			default:
+				elog(ERROR, "Invalid jsonb data: unexpected value type %d", (int)v.type);
+				break;
+			}
+			break;
+		default:
+			break;
+		}
+	}
+
+	PG_RETURN_BYTEA_P(PgCborEncoderGetBytea(&enc));
+}
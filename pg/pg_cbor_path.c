@@ -0,0 +1,217 @@
+
+#include "pg_cbor.h"
+
+#include "utils/builtins.h"
+#include "utils/array.h"
+#include "utils/lsyscache.h"
+#include "catalog/pg_type.h"
+
+PG_FUNCTION_INFO_V1(cbor_path_in);
+PG_FUNCTION_INFO_V1(cbor_path_out);
+PG_FUNCTION_INFO_V1(cbor_path_from_text_array);
+
+/* On-disk format for cbor_path: number of steps, then nsteps + 1 offsets
+ * of step bounds within step data, then step data itself */
+typedef struct PgCborPathData {
+	int32 vl_len_;
+	uint32 nsteps;
+	uint32 offsets[FLEXIBLE_ARRAY_MEMBER];
+} PgCborPathData;
+
+#define PG_CBOR_PATH_DATA(path) ((const char *)&(path)->offsets[(path)->nsteps + 1])
+
+typedef enum PgCborPathArgType {
+	PgCborPathArgArray, // text[] with steps
+	PgCborPathArgPath, // cbor_path
+	PgCborPathArgKey, // text with single step
+	PgCborPathArgIndex, // integer with single array index
+} PgCborPathArgType;
+
+typedef struct PgCborPathCache {
+	PgCborPathArgType argType;
+	Size size;
+	char *raw; // copy of last argument, steps data points into it
+	int32 index; // last integer argument, for PgCborPathArgIndex
+	CborData *steps;
+	CborPath path;
+} PgCborPathCache;
+
+static PgCborPathData *
+pg_cbor_path_from_array(ArrayType *arr) {
+	Datum *elems;
+	bool *nulls;
+	int nelems;
+	int i;
+	Size size;
+	uint32 offset;
+	PgCborPathData *ret;
+
+	if (ARR_NDIM(arr) > 1) {
+		elog(ERROR, "Invalid path data: path should be one-dimensional array");
+	}
+
+	if (array_contains_nulls(arr)) {
+		elog(ERROR, "Invalid path data");
+	}
+
+	deconstruct_array(arr, TEXTOID, -1, false, 'i', &elems, &nulls, &nelems);
+
+	size = offsetof(PgCborPathData, offsets) + sizeof(uint32) * (nelems + 1);
+	for (i = 0; i < nelems; ++ i) {
+		size += VARSIZE_ANY_EXHDR(DatumGetPointer(elems[i]));
+	}
+
+	ret = palloc(size);
+	SET_VARSIZE(ret, size);
+	ret->nsteps = nelems;
+
+	offset = 0;
+	for (i = 0; i < nelems; ++ i) {
+		uint32 len = VARSIZE_ANY_EXHDR(DatumGetPointer(elems[i]));
+		ret->offsets[i] = offset;
+		memcpy((char *)PG_CBOR_PATH_DATA(ret) + offset, VARDATA_ANY(DatumGetPointer(elems[i])), len);
+		offset += len;
+	}
+	ret->offsets[nelems] = offset;
+
+	return ret;
+}
+
+static PgCborPathData *
+pg_cbor_path_from_step(const char *step, uint32 len) {
+	Size size = offsetof(PgCborPathData, offsets) + sizeof(uint32) * 2 + len;
+	PgCborPathData *ret = palloc(size);
+
+	SET_VARSIZE(ret, size);
+	ret->nsteps = 1;
+	ret->offsets[0] = 0;
+	ret->offsets[1] = len;
+	memcpy((char *)PG_CBOR_PATH_DATA(ret), step, len);
+	return ret;
+}
+
+Datum
+cbor_path_in(PG_FUNCTION_ARGS) {
+	char *str = PG_GETARG_CSTRING(0);
+	Oid func, ioparam;
+	Datum arr;
+
+	// path literal uses text[] syntax
+	getTypeInputInfo(TEXTARRAYOID, &func, &ioparam);
+	arr = OidInputFunctionCall(func, str, ioparam, -1);
+
+	PG_RETURN_POINTER(pg_cbor_path_from_array(DatumGetArrayTypeP(arr)));
+}
+
+Datum
+cbor_path_out(PG_FUNCTION_ARGS) {
+	PgCborPathData *path = (PgCborPathData *)PG_DETOAST_DATUM(PG_GETARG_DATUM(0));
+	const char *data = PG_CBOR_PATH_DATA(path);
+	Datum *elems;
+	ArrayType *arr;
+	Oid func;
+	bool isvarlena;
+	uint32 i;
+
+	elems = palloc(sizeof(Datum) * (path->nsteps + 1));
+	for (i = 0; i < path->nsteps; ++ i) {
+		elems[i] = PointerGetDatum(cstring_to_text_with_len(data + path->offsets[i], path->offsets[i + 1] - path->offsets[i]));
+	}
+
+	arr = construct_array(elems, path->nsteps, TEXTOID, -1, false, 'i');
+	getTypeOutputInfo(TEXTARRAYOID, &func, &isvarlena);
+	PG_RETURN_CSTRING(OidOutputFunctionCall(func, PointerGetDatum(arr)));
+}
+
+Datum
+cbor_path_from_text_array(PG_FUNCTION_ARGS) {
+	PG_RETURN_POINTER(pg_cbor_path_from_array(PG_GETARG_ARRAYTYPE_P(0)));
+}
+
+const CborPath *
+PgCborGetPath(FunctionCallInfo fcinfo, int argno) {
+	PgCborPathCache *cache = (PgCborPathCache *)fcinfo->flinfo->fn_extra;
+	struct varlena *arg;
+	Size size;
+	MemoryContext oldcxt;
+	PgCborPathData *path;
+	uint32 i;
+
+	if (!cache) {
+		Oid argtype = get_fn_expr_argtype(fcinfo->flinfo, argno);
+
+		cache = MemoryContextAllocZero(fcinfo->flinfo->fn_mcxt, sizeof(PgCborPathCache));
+		if (!OidIsValid(argtype) || OidIsValid(get_base_element_type(argtype))) {
+			cache->argType = PgCborPathArgArray;
+		} else if (argtype == INT4OID) {
+			cache->argType = PgCborPathArgIndex;
+		} else if (argtype == TEXTOID) {
+			cache->argType = PgCborPathArgKey;
+		} else {
+			cache->argType = PgCborPathArgPath;
+		}
+		fcinfo->flinfo->fn_extra = cache;
+	}
+
+	// index is compared as integer, text form is built only to compile changed index
+	if (cache->argType == PgCborPathArgIndex) {
+		int32 index = PG_GETARG_INT32(argno);
+		char buf[16];
+
+		if (cache->raw && cache->index == index) {
+			return &cache->path;
+		}
+
+		cache->index = index;
+		arg = (struct varlena *)cstring_to_text_with_len(buf, snprintf(buf, sizeof(buf), "%d", index));
+	} else {
+		arg = PG_DETOAST_DATUM(PG_GETARG_DATUM(argno));
+	}
+	size = VARSIZE(arg);
+
+	if (cache->raw && cache->size == size && memcmp(cache->raw, arg, size) == 0) {
+		// path argument is the same as in previous call
+		return &cache->path;
+	}
+
+	switch (cache->argType) {
+	case PgCborPathArgArray: path = pg_cbor_path_from_array((ArrayType *)arg); break;
+	case PgCborPathArgKey:
+	case PgCborPathArgIndex:
+		path = pg_cbor_path_from_step(VARDATA(arg), VARSIZE(arg) - VARHDRSZ);
+		break;
+	default: path = (PgCborPathData *)arg; break;
+	}
+
+	oldcxt = MemoryContextSwitchTo(fcinfo->flinfo->fn_mcxt);
+
+	if (cache->raw) {
+		CborPathFinalize(&cache->path);
+		if (cache->steps) {
+			pfree(cache->steps);
+		}
+		pfree(cache->raw);
+		cache->raw = NULL;
+		cache->steps = NULL;
+	}
+
+	cache->raw = palloc(MAXALIGN(size) + VARSIZE(path));
+	cache->size = size;
+	memcpy(cache->raw, arg, size);
+
+	// compiled path points into own copy of path data
+	path = memcpy(cache->raw + MAXALIGN(size), path, VARSIZE(path));
+
+	if (path->nsteps > 0) {
+		cache->steps = palloc(sizeof(CborData) * path->nsteps);
+		for (i = 0; i < path->nsteps; ++ i) {
+			cache->steps[i].ptr = (const uint8_t *)PG_CBOR_PATH_DATA(path) + path->offsets[i];
+			cache->steps[i].size = path->offsets[i + 1] - path->offsets[i];
+		}
+	}
+
+	CborPathInit(&cache->path, cache->steps, path->nsteps);
+
+	MemoryContextSwitchTo(oldcxt);
+	return &cache->path;
+}
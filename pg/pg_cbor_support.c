@@ -0,0 +1,206 @@
+
+#include "pg_cbor.h"
+
+#include "utils/builtins.h"
+#include "utils/array.h"
+#include "utils/lsyscache.h"
+#include "catalog/pg_type.h"
+
+#if PG_VERSION_NUM >= 120000
+
+#include "nodes/makefuncs.h"
+#include "nodes/nodeFuncs.h"
+#include "nodes/supportnodes.h"
+#include "parser/parse_func.h"
+
+PG_FUNCTION_INFO_V1(cbor_path_support);
+
+// steps from constant text, integer or text[] path argument, returns false if argument is not constant
+static bool
+pg_cbor_support_const_steps(Node *arg, List **steps) {
+	Const *c;
+	Datum *elems;
+	bool *nulls;
+	int nelems, i;
+
+	*steps = NIL;
+	if (!IsA(arg, Const) || ((Const *)arg)->constisnull) {
+		return false;
+	}
+
+	c = (Const *)arg;
+	switch (c->consttype) {
+	case TEXTOID:
+		*steps = list_make1(DatumGetTextPP(c->constvalue));
+		return true;
+	case INT4OID:
+		*steps = list_make1(cstring_to_text(psprintf("%d", DatumGetInt32(c->constvalue))));
+		return true;
+	case TEXTARRAYOID:
+		deconstruct_array(DatumGetArrayTypeP(c->constvalue), TEXTOID, -1, false, 'i', &elems, &nulls, &nelems);
+		for (i = 0; i < nelems; ++ i) {
+			if (nulls[i]) {
+				return false;
+			}
+			*steps = lappend(*steps, DatumGetTextPP(elems[i]));
+		}
+		return true;
+	default:
+		break;
+	}
+	return false;
+}
+
+// function call or operator with two arguments
+static bool
+pg_cbor_support_get_call(Node *node, Oid *funcid, List **args) {
+	if (IsA(node, FuncExpr)) {
+		*funcid = ((FuncExpr *)node)->funcid;
+		*args = ((FuncExpr *)node)->args;
+	} else if (IsA(node, OpExpr)) {
+		set_opfuncid((OpExpr *)node);
+		*funcid = ((OpExpr *)node)->opfuncid;
+		*args = ((OpExpr *)node)->args;
+	} else {
+		return false;
+	}
+	return list_length(*args) == 2;
+}
+
+static Const *
+pg_cbor_support_make_path(List *steps) {
+	Datum *elems = palloc(sizeof(Datum) * Max(list_length(steps), 1));
+	ListCell *lc;
+	int i = 0;
+
+	foreach (lc, steps) {
+		elems[i ++] = PointerGetDatum(lfirst(lc));
+	}
+
+	return makeConst(TEXTARRAYOID, -1, InvalidOid, -1,
+		PointerGetDatum(construct_array(elems, i, TEXTOID, -1, false, 'i')), false, false);
+}
+
+/* Chained access: doc -> 'a' -> 'b' ->> 'c' is folded into single multi-step lookup
+ * cbor_extract_path_text_op(doc, '{a,b,c}'), so document is parsed once. Only constant steps are folded */
+static Node *
+pg_cbor_support_simplify(FuncExpr *expr) {
+	Oid innerFunc, docType, argtypes[2];
+	List *innerArgs, *innerSteps, *steps, *name;
+	FuncExpr *ret;
+	Oid funcid;
+
+	if (list_length(expr->args) != 2 || !pg_cbor_support_get_call(linitial(expr->args), &innerFunc, &innerArgs)) {
+		return NULL;
+	}
+
+	// inner call should be one of our document lookups, not text one
+	docType = exprType(linitial(innerArgs));
+	if (get_func_support(innerFunc) != get_func_support(expr->funcid) || get_func_rettype(innerFunc) != docType) {
+		return NULL;
+	}
+
+	if (!pg_cbor_support_const_steps(lsecond(innerArgs), &innerSteps)
+			|| !pg_cbor_support_const_steps(lsecond(expr->args), &steps)) {
+		return NULL;
+	}
+
+	name = list_make2(makeString(get_namespace_name(get_func_namespace(expr->funcid))),
+		makeString((expr->funcresulttype == TEXTOID) ? "cbor_extract_path_text_op" : "cbor_extract_path_op"));
+	argtypes[0] = docType;
+	argtypes[1] = TEXTARRAYOID;
+	funcid = LookupFuncName(name, 2, argtypes, true);
+	if (!OidIsValid(funcid)) {
+		return NULL;
+	}
+
+	ret = makeFuncExpr(funcid, expr->funcresulttype,
+		list_make2(linitial(innerArgs), pg_cbor_support_make_path(list_concat(innerSteps, steps))),
+		expr->funccollid, expr->inputcollid, COERCE_EXPLICIT_CALL);
+	ret->location = expr->location;
+	return (Node *)ret;
+}
+
+/* cbor_path_equals(doc, path, value) is turned into lossy doc @> '{"path": {"to": value}}'.
+ * Numeric steps can be array indexes, object with such key would not be contained
+ * in array, so only paths with object keys are converted */
+static List *
+pg_cbor_support_index_condition(SupportRequestIndexCondition *req) {
+	List *args;
+	Node *indexkey, *pathArg, *valueArg;
+	List *steps;
+	ListCell *lc;
+	bytea *value;
+	CborEncoder enc;
+	Oid docType, oper;
+	long int index;
+	Const *query;
+
+	if (!IsA(req->node, FuncExpr) || req->indexarg != 0) {
+		return NIL;
+	}
+
+	args = ((FuncExpr *)req->node)->args;
+	if (list_length(args) != 3) {
+		return NIL;
+	}
+
+	indexkey = linitial(args);
+	pathArg = lsecond(args);
+	valueArg = lthird(args);
+	if (!pg_cbor_support_const_steps(pathArg, &steps) || !IsA(valueArg, Const) || ((Const *)valueArg)->constisnull) {
+		return NIL;
+	}
+
+	foreach (lc, steps) {
+		text *step = (text *)lfirst(lc);
+		CborData data = { VARSIZE_ANY_EXHDR(step), (const uint8_t *)VARDATA_ANY(step) };
+		if (CborPathParseIndex(&data, &index)) {
+			return NIL;
+		}
+	}
+
+	docType = exprType(indexkey);
+	oper = get_opfamily_member(req->opfamily, docType, docType, PG_CBOR_CONTAINS_STRATEGY);
+	if (!OidIsValid(oper)) {
+		return NIL;
+	}
+
+	value = DatumGetByteaPP(((Const *)valueArg)->constvalue);
+
+	PgCborEncoderInit(&enc);
+	foreach (lc, steps) {
+		text *step = (text *)lfirst(lc);
+		CborEncodeBeginMap(&enc, 1);
+		CborEncodeString(&enc, VARDATA_ANY(step), VARSIZE_ANY_EXHDR(step));
+	}
+	if (data_is_cbor((const uint8_t *)VARDATA_ANY(value), VARSIZE_ANY_EXHDR(value))) {
+		CborEncodeRaw(&enc, (const uint8_t *)VARDATA_ANY(value) + CborHeaderSize, VARSIZE_ANY_EXHDR(value) - CborHeaderSize);
+	} else {
+		CborEncodeRaw(&enc, (const uint8_t *)VARDATA_ANY(value), VARSIZE_ANY_EXHDR(value));
+	}
+	foreach (lc, steps) {
+		CborEncodeEnd(&enc);
+	}
+
+	query = makeConst(docType, -1, InvalidOid, -1, PointerGetDatum(PgCborEncoderGetBytea(&enc)), false, false);
+
+	req->lossy = true;
+	return list_make1(make_opclause(oper, BOOLOID, false, (Expr *)indexkey, (Expr *)query, InvalidOid, InvalidOid));
+}
+
+Datum
+cbor_path_support(PG_FUNCTION_ARGS) {
+	Node *rawreq = (Node *)PG_GETARG_POINTER(0);
+	Node *ret = NULL;
+
+	if (IsA(rawreq, SupportRequestSimplify)) {
+		ret = pg_cbor_support_simplify(((SupportRequestSimplify *)rawreq)->fcall);
+	} else if (IsA(rawreq, SupportRequestIndexCondition)) {
+		ret = (Node *)pg_cbor_support_index_condition((SupportRequestIndexCondition *)rawreq);
+	}
+
+	PG_RETURN_POINTER(ret);
+}
+
+#endif
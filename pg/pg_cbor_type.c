@@ -0,0 +1,175 @@
+
+#include "pg_cbor.h"
+
+#include "utils/builtins.h"
+#include "utils/array.h"
+#include "catalog/pg_type.h"
+#include "libpq/pqformat.h"
+
+#include <ctype.h>
+
+PG_FUNCTION_INFO_V1(cbor_in);
+PG_FUNCTION_INFO_V1(cbor_out);
+PG_FUNCTION_INFO_V1(cbor_recv);
+PG_FUNCTION_INFO_V1(cbor_send);
+PG_FUNCTION_INFO_V1(cbor_typmod_in);
+PG_FUNCTION_INFO_V1(cbor_typmod_out);
+PG_FUNCTION_INFO_V1(cbor_coerce);
+PG_FUNCTION_INFO_V1(cbor_from_bytea);
+PG_FUNCTION_INFO_V1(cbor_to_bytea);
+
+extern Datum jsonb_to_cbor(PG_FUNCTION_ARGS);
+
+static void
+pg_cbor_type_validate(const bytea *doc) {
+	if (!CborValidate((const uint8_t *)VARDATA_ANY(doc), VARSIZE_ANY_EXHDR(doc))) {
+		elog(ERROR, "Invalid CBOR data: document is malformed");
+	}
+}
+
+// document with or without magic header, copied only when form should be changed
+static bytea *
+pg_cbor_type_set_header(bytea *doc, bool header) {
+	const uint8_t *data = (const uint8_t *)VARDATA_ANY(doc);
+	size_t size = VARSIZE_ANY_EXHDR(doc);
+	bytea *result;
+
+	if (data_is_cbor(data, size) == header) {
+		return doc;
+	}
+
+	if (header) {
+		result = palloc(VARHDRSZ + CborHeaderSize + size);
+		memcpy(VARDATA(result), CborHeaderData, CborHeaderSize);
+		memcpy(VARDATA(result) + CborHeaderSize, data, size);
+		SET_VARSIZE(result, VARHDRSZ + CborHeaderSize + size);
+	} else {
+		result = palloc(VARHDRSZ + size - CborHeaderSize);
+		memcpy(VARDATA(result), data + CborHeaderSize, size - CborHeaderSize);
+		SET_VARSIZE(result, VARHDRSZ + size - CborHeaderSize);
+	}
+	return result;
+}
+
+static bytea *
+pg_cbor_type_apply_typmod(bytea *doc, int32 typmod) {
+	return pg_cbor_type_set_header(doc, typmod != PG_CBOR_TYPMOD_BARE);
+}
+
+/* Input is bytea hex literal (\x...) with CBOR document, with or without magic header,
+ * any other input is parsed as JSON */
+Datum
+cbor_in(PG_FUNCTION_ARGS) {
+	char *str = PG_GETARG_CSTRING(0);
+	int32 typmod = PG_GETARG_INT32(2);
+	bytea *result;
+
+	while (isspace((unsigned char)*str)) {
+		++ str;
+	}
+
+	if (str[0] == '\\' && str[1] == 'x') {
+		result = DatumGetByteaPP(DirectFunctionCall1(byteain, CStringGetDatum(str)));
+		pg_cbor_type_validate(result);
+	} else {
+		// encoder output is always valid
+		result = DatumGetByteaPP(DirectFunctionCall1(jsonb_to_cbor, DirectFunctionCall1(jsonb_in, CStringGetDatum(str))));
+	}
+
+	PG_RETURN_BYTEA_P(pg_cbor_type_apply_typmod(result, typmod));
+}
+
+// output is hex literal, that always includes magic header
+Datum
+cbor_out(PG_FUNCTION_ARGS) {
+	bytea *doc = PG_GETARG_BYTEA_PP(0);
+	const uint8_t *data = (const uint8_t *)VARDATA_ANY(doc);
+	size_t size = VARSIZE_ANY_EXHDR(doc);
+	char *result, *ptr;
+
+	result = ptr = palloc(2 + (size + CborHeaderSize) * 2 + 1);
+	*ptr ++ = '\\';
+	*ptr ++ = 'x';
+	if (!data_is_cbor(data, size)) {
+		ptr += CborHexEncode(ptr, CborHeaderData, CborHeaderSize);
+	}
+	ptr += CborHexEncode(ptr, data, size);
+	*ptr = 0;
+
+	PG_RETURN_CSTRING(result);
+}
+
+Datum
+cbor_recv(PG_FUNCTION_ARGS) {
+	StringInfo buf = (StringInfo)PG_GETARG_POINTER(0);
+	int32 typmod = PG_GETARG_INT32(2);
+	int nbytes = buf->len - buf->cursor;
+	bytea *result;
+
+	result = palloc(nbytes + VARHDRSZ);
+	SET_VARSIZE(result, nbytes + VARHDRSZ);
+	pq_copymsgbytes(buf, VARDATA(result), nbytes);
+
+	pg_cbor_type_validate(result);
+	PG_RETURN_BYTEA_P(pg_cbor_type_apply_typmod(result, typmod));
+}
+
+// binary form is self-described document with magic header
+Datum
+cbor_send(PG_FUNCTION_ARGS) {
+	bytea *doc = PG_GETARG_BYTEA_PP(0);
+	const uint8_t *data = (const uint8_t *)VARDATA_ANY(doc);
+	size_t size = VARSIZE_ANY_EXHDR(doc);
+	StringInfoData buf;
+
+	pq_begintypsend(&buf);
+	if (!data_is_cbor(data, size)) {
+		pq_sendbytes(&buf, (const char *)CborHeaderData, CborHeaderSize);
+	}
+	pq_sendbytes(&buf, (const char *)data, size);
+	PG_RETURN_BYTEA_P(pq_endtypsend(&buf));
+}
+
+// only cbor(bare) is supported
+Datum
+cbor_typmod_in(PG_FUNCTION_ARGS) {
+	ArrayType *arr = PG_GETARG_ARRAYTYPE_P(0);
+	Datum *elems;
+	int nelems;
+
+	deconstruct_array(arr, CSTRINGOID, -2, false, 'c', &elems, NULL, &nelems);
+
+	if (nelems != 1 || pg_strcasecmp(DatumGetCString(elems[0]), "bare") != 0) {
+		elog(ERROR, "Invalid type modifier: cbor supports only cbor(bare)");
+	}
+
+	PG_RETURN_INT32(PG_CBOR_TYPMOD_BARE);
+}
+
+Datum
+cbor_typmod_out(PG_FUNCTION_ARGS) {
+	int32 typmod = PG_GETARG_INT32(0);
+
+	PG_RETURN_CSTRING(pstrdup(typmod == PG_CBOR_TYPMOD_BARE ? "(bare)" : ""));
+}
+
+// length coercion cast: converts stored form for target typmod
+Datum
+cbor_coerce(PG_FUNCTION_ARGS) {
+	PG_RETURN_BYTEA_P(pg_cbor_type_apply_typmod(PG_GETARG_BYTEA_PP(0), PG_GETARG_INT32(1)));
+}
+
+// bytea with or without magic header, stored as is after validation
+Datum
+cbor_from_bytea(PG_FUNCTION_ARGS) {
+	bytea *doc = PG_GETARG_BYTEA_PP(0);
+
+	pg_cbor_type_validate(doc);
+	PG_RETURN_BYTEA_P(doc);
+}
+
+// bytea functions expect magic header, it's added only for bare documents
+Datum
+cbor_to_bytea(PG_FUNCTION_ARGS) {
+	PG_RETURN_BYTEA_P(pg_cbor_type_set_header(PG_GETARG_BYTEA_PP(0), true));
+}
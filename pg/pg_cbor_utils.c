@@ -2,4 +2,146 @@
 #include "pg_cbor.h"
 
 #include "utils/builtins.h"
+#include "utils/lsyscache.h"
+#include "catalog/pg_type.h"
 #include <limits.h>
+
+#if PG_VERSION_NUM >= 130000
+#include "access/detoast.h"
+#else
+#include "access/tuptoaster.h"
+#endif
+
+// first slice covers about one TOAST chunk
+#define PG_CBOR_SLICE_INITIAL_SIZE 2048
+
+bool
+PgCborArgIsDocument(FunctionCallInfo fcinfo, int argno, const uint8_t *data, size_t size) {
+	Oid argtype;
+
+	if (data_is_cbor(data, size)) {
+		return true;
+	} else if (size == 0) {
+		return false;
+	}
+
+	// headerless data is accepted only from cbor type, argument type is checked only for them
+	argtype = get_fn_expr_argtype(fcinfo->flinfo, argno);
+	return OidIsValid(argtype) && getBaseType(argtype) != BYTEAOID;
+}
+
+void
+PgCborSliceInit(PgCborSlice *slice, Datum datum) {
+	struct varlena *attr = (struct varlena *)DatumGetPointer(datum);
+
+	slice->datum = datum;
+	slice->ptr = NULL;
+	slice->data = NULL;
+	slice->size = 0;
+
+	if (VARATT_IS_EXTENDED(attr)) {
+		slice->total = toast_raw_datum_size(datum) - VARHDRSZ;
+		slice->len = 0;
+	} else {
+		slice->total = VARSIZE(attr) - VARHDRSZ;
+		slice->len = slice->total;
+	}
+}
+
+bool
+PgCborSliceNext(PgCborSlice *slice) {
+	if (slice->ptr) {
+		if (slice->len == slice->total) {
+			return false;
+		}
+		if ((Pointer)slice->ptr != DatumGetPointer(slice->datum)) {
+			pfree(slice->ptr);
+		}
+		slice->len = (slice->len > slice->total / 2) ? slice->total : slice->len * 2;
+	} else if (slice->len < slice->total) {
+		slice->len = Min(PG_CBOR_SLICE_INITIAL_SIZE, slice->total);
+	}
+
+	if (slice->len < slice->total) {
+		slice->ptr = (bytea *)PG_DETOAST_DATUM_SLICE(slice->datum, 0, slice->len);
+	} else {
+		slice->ptr = (bytea *)PG_DETOAST_DATUM(slice->datum);
+	}
+
+	slice->size = VARSIZE(slice->ptr) - VARHDRSZ;
+	slice->data = (const uint8_t *)VARDATA(slice->ptr);
+	return true;
+}
+
+bool
+PgCborGetPathValue(FunctionCallInfo fcinfo, int argno, const CborPath *path, CborIteratorContext *iter) {
+	PgCborSlice slice;
+
+	PgCborSliceInit(&slice, PG_GETARG_DATUM(argno));
+	while (PgCborSliceNext(&slice)) {
+		if (!PgCborArgIsDocument(fcinfo, argno, slice.data, slice.size)) {
+			return false;
+		}
+
+		if (CborIteratorInit(iter, slice.data, slice.size)) {
+			if (CborIteratorGetPath(iter, path)) {
+				// value should be complete within slice
+				const uint8_t *begin = CborIteratorGetCurrentValuePtr(iter);
+				if (PgCborSliceIsComplete(&slice)) {
+					return true;
+				} else if (begin) {
+					CborData value = { (slice.data + slice.size) - begin, begin };
+					if (CborDataSkipItems(&value, 1)) {
+						return true;
+					}
+				}
+			}
+			CborIteratorFinalize(iter);
+		}
+	}
+
+	// path was not found within the whole document
+	return false;
+}
+
+void
+PgCborEncoderInit(CborEncoder *enc) {
+	CborEncoderInit(enc, VARHDRSZ, true);
+}
+
+bytea *
+PgCborEncoderGetBytea(CborEncoder *enc) {
+	bytea *result;
+	size_t size;
+
+	if (!CborEncoderIsComplete(enc)) {
+		elog(ERROR, "Invalid encoder state: document is incomplete");
+	}
+
+	result = (bytea *)CborEncoderRelease(enc, &size);
+	if (size > MaxAllocSize) {
+		elog(ERROR, "Invalid encoder state: document is too large");
+	}
+
+	SET_VARSIZE(result, size);
+	return result;
+}
+
+void
+PgCborBufferInit(CborBuffer *buf, size_t expected) {
+	CborBufferInit(buf, VARHDRSZ, expected);
+}
+
+struct varlena *
+PgCborBufferGetVarlena(CborBuffer *buf) {
+	struct varlena *result;
+	size_t size;
+
+	result = (struct varlena *)CborBufferRelease(buf, &size);
+	if (size > MaxAllocSize) {
+		elog(ERROR, "Invalid buffer state: result is too large");
+	}
+
+	SET_VARSIZE(result, size);
+	return result;
+}
@@ -2,85 +2,226 @@
 #include "cbor.h"
 
 #include <limits.h>
+#include <stdarg.h>
 #include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
 
-static void print_hex(const struct CborWriter *writer, const uint8_t *s, size_t size) {
+#define CBOR_STRING_BLOCK_SIZE 3072
+
+struct CborStringState {
+	CborByteEncodingScope scope;
+	CborByteEncoding chunked; // encoding for chunks of undefined length byte string
+	uint32_t carrySize;
+	uint8_t carry[3];
+};
+
+static void CborBufferWriterPlain(void *ctx, const char *data, int size) {
+	CborBufferWrite((CborBuffer *)ctx, data, size);
+}
+
+static void CborBufferWriterFormat(void *ctx, const char *format, ...) {
+	CborBuffer *buf = (CborBuffer *)ctx;
+	va_list argv;
+	int len;
+
+	va_start(argv, format);
+	len = vsnprintf(NULL, 0, format, argv);
+	va_end(argv);
+
+	if (len > 0) {
+		va_start(argv, format);
+		vsnprintf(CborBufferReserve(buf, len + 1), len + 1, format, argv);
+		va_end(argv);
+		buf->size += len;
+	}
+}
+
+void CborWriterInitBuffer(struct CborWriter *writer, CborBuffer *buf) {
+	writer->plain = CborBufferWriterPlain;
+	writer->format = CborBufferWriterFormat;
+	writer->ctx = buf;
+	writer->buffer = buf;
+}
+
+// number is formatted in place within output buffer, or on stack for callback writer
+static inline char *print_number_begin(const struct CborWriter *writer, char *buf) {
+	return writer->buffer ? CborBufferReserve(writer->buffer, CBOR_NUMBER_MAX_SIZE) : buf;
+}
+
+static inline void print_number_end(const struct CborWriter *writer, const char *ptr, uint32_t len) {
+	if (writer->buffer) {
+		writer->buffer->size += len;
+	} else {
+		writer->plain(writer->ctx, ptr, len);
+	}
+}
+
+static void print_unsigned(const struct CborWriter *writer, uint64_t value) {
+	char buf[CBOR_NUMBER_MAX_SIZE];
+	char *ptr = print_number_begin(writer, buf);
+	print_number_end(writer, ptr, CborFormatUnsigned(ptr, value));
+}
+
+static void print_integer(const struct CborWriter *writer, int64_t value) {
+	char buf[CBOR_NUMBER_MAX_SIZE];
+	char *ptr = print_number_begin(writer, buf);
+	if (value < 0) {
+		*ptr = '-';
+		print_number_end(writer, ptr, CborFormatUnsigned(ptr + 1, ~(uint64_t)value + 1) + 1);
+	} else {
+		print_number_end(writer, ptr, CborFormatUnsigned(ptr, (uint64_t)value));
+	}
+}
+
+static void print_float(const struct CborWriter *writer, double value) {
+	char buf[CBOR_NUMBER_MAX_SIZE];
+	char *ptr = print_number_begin(writer, buf);
+	print_number_end(writer, ptr, snprintf(ptr, CBOR_NUMBER_MAX_SIZE, "%.10e", value));
+}
+
+static void print_bytes(const struct CborWriter *writer, CborByteEncoding encoding, const uint8_t *s, size_t size) {
+	char buf[CBOR_STRING_BLOCK_SIZE / 3 * 4];
+
+	if (writer->buffer) {
+		// whole string is encoded in place
+		char *out = CborBufferReserve(writer->buffer, CborByteEncodingSize(encoding, size));
+		writer->buffer->size += CborByteEncode(encoding, out, s, size);
+		return;
+	}
+
+	// blocks are multiple of 3 bytes, so base64 groups are not split
 	while (size > 0) {
-		writer->format(writer->ctx, "%02x", *s++);
-		-- size;
+		size_t block = (size > CBOR_STRING_BLOCK_SIZE) ? CBOR_STRING_BLOCK_SIZE : size;
+		CborWriterWrite(writer, buf, CborByteEncode(encoding, buf, s, block));
+		s += block;
+		size -= block;
+	}
+}
+
+// chunk of undefined length byte string: incomplete base64 group is kept for the next chunk
+static void print_bytes_chunk(const struct CborWriter *writer, struct CborStringState *state, const uint8_t *s, size_t size) {
+	size_t tail;
+
+	if (state->chunked == CborByteEncodingHex) {
+		print_bytes(writer, state->chunked, s, size);
+		return;
+	}
+
+	if (state->carrySize > 0) {
+		while (state->carrySize < 3 && size > 0) {
+			state->carry[state->carrySize ++] = *s ++;
+			-- size;
+		}
+		if (state->carrySize < 3) {
+			return;
+		}
+		print_bytes(writer, state->chunked, state->carry, 3);
+		state->carrySize = 0;
+	}
+
+	tail = size % 3;
+	print_bytes(writer, state->chunked, s, size - tail);
+	memcpy(state->carry, s + size - tail, tail);
+	state->carrySize = tail;
+}
+
+static void print_bytes_prefix(const struct CborWriter *writer, CborByteEncoding encoding) {
+	switch (encoding) {
+	case CborByteEncodingHex: CborWriterWrite(writer, "\"hex(", 5); break;
+	case CborByteEncodingBase64: CborWriterWrite(writer, "\"base64(", 8); break;
+	case CborByteEncodingBase64Url: CborWriterWrite(writer, "\"base64url(", 11); break;
 	}
 }
 
-static void CborValueToString(const struct CborWriter *writer, const CborIteratorContext *iter) {
+static void CborValueToString(const struct CborWriter *writer, const CborIteratorContext *iter, CborByteEncoding encoding) {
 	switch (CborIteratorGetType(iter)) {
-	case CborTypeUnsigned: writer->format(writer->ctx, "%lu", CborIteratorGetUnsigned(iter)); break;
-	case CborTypeNegative: writer->format(writer->ctx, "%ld", CborIteratorGetInteger(iter)); break;
+	case CborTypeUnsigned: print_unsigned(writer, CborIteratorGetUnsigned(iter)); break;
+	case CborTypeNegative: print_integer(writer, CborIteratorGetInteger(iter)); break;
 	case CborTypeByteString:
 		if (!iter->isStreaming) {
-			writer->plain(writer->ctx, "\"hex(", 5);
+			print_bytes_prefix(writer, encoding);
 		}
-		print_hex(writer, CborIteratorGetBytePtr(iter), CborIteratorGetObjectSize(iter));
+		print_bytes(writer, encoding, CborIteratorGetBytePtr(iter), CborIteratorGetObjectSize(iter));
 		if (!iter->isStreaming) {
-			writer->plain(writer->ctx, ")\"", 2);
+			CborWriterWrite(writer, ")\"", 2);
 		}
 		break;
 	case CborTypeCharString:
 		if (!iter->isStreaming) {
-			writer->plain(writer->ctx, "\"", 1);
+			CborWriterWrite(writer, "\"", 1);
 		}
-		writer->plain(writer->ctx, CborIteratorGetCharPtr(iter), CborIteratorGetObjectSize(iter));
+		CborWriterWrite(writer, CborIteratorGetCharPtr(iter), CborIteratorGetObjectSize(iter));
 		if (!iter->isStreaming) {
-			writer->plain(writer->ctx, "\"", 1);
+			CborWriterWrite(writer, "\"", 1);
 		}
 		break;
 	case CborTypeArray:
 	case CborTypeMap:
 	case CborTypeTag:
 		break;
-	case CborTypeSimple:	writer->format(writer->ctx, "%lu", CborIteratorGetUnsigned(iter)); break;
-	case CborTypeFloat:		writer->format(writer->ctx, "%.10e", CborIteratorGetFloat(iter)); break;
-	case CborTypeFalse:		writer->plain(writer->ctx, "false", 5); break;
-	case CborTypeTrue:		writer->plain(writer->ctx, "true", 4); break;
-	case CborTypeNull:		writer->plain(writer->ctx, "null", 4); break;
-	case CborTypeUndefined:	writer->plain(writer->ctx, "undefined", 9); break;
+	case CborTypeSimple:	print_unsigned(writer, CborIteratorGetUnsigned(iter)); break;
+	case CborTypeFloat:		print_float(writer, CborIteratorGetFloat(iter)); break;
+	case CborTypeFalse:		CborWriterWrite(writer, "false", 5); break;
+	case CborTypeTrue:		CborWriterWrite(writer, "true", 4); break;
+	case CborTypeNull:		CborWriterWrite(writer, "null", 4); break;
+	case CborTypeUndefined:	CborWriterWrite(writer, "undefined", 9); break;
 	default: break;
 	}
 }
 
-static void CborValueIterToString(const struct CborWriter *writer, CborIteratorContext *iter) {
+static void CborValueIterToString(const struct CborWriter *writer, CborIteratorContext *iter, struct CborStringState *state) {
+	CborByteEncoding encoding = CborByteEncodingScopeNext(&state->scope, iter);
+
 	switch (iter->token) {
 	case CborIteratorTokenDone: break;
 	case CborIteratorTokenKey:
 		if (CborIteratorGetContainerPosition(iter) != 0) {
-			writer->plain(writer->ctx, ";", 1);
+			CborWriterWrite(writer, ";", 1);
 		}
-		CborValueToString(writer, iter);
-		writer->plain(writer->ctx, ":", 1);
+		CborValueToString(writer, iter, encoding);
+		CborWriterWrite(writer, ":", 1);
 		break;
 	case CborIteratorTokenValue:
+		if (CborIteratorGetContainerType(iter) == (int)CborStackTypeByteString) {
+			print_bytes_chunk(writer, state, CborIteratorGetBytePtr(iter), CborIteratorGetObjectSize(iter));
+			break;
+		}
 		if (CborIteratorGetContainerType(iter) == (int)CborStackTypeArray && CborIteratorGetContainerPosition(iter) != 0) {
-			writer->plain(writer->ctx, ",", 1);
+			CborWriterWrite(writer, ",", 1);
 		}
-		CborValueToString(writer, iter);
+		CborValueToString(writer, iter, encoding);
 		break;
-	case CborIteratorTokenBeginArray:			writer->plain(writer->ctx, "[", 1); break;
-	case CborIteratorTokenEndArray:				writer->plain(writer->ctx, "]", 1); break;
-	case CborIteratorTokenBeginObject:			writer->plain(writer->ctx, "{", 1); break;
-	case CborIteratorTokenEndObject:			writer->plain(writer->ctx, "}", 1); break;
-	case CborIteratorTokenBeginByteStrings:		writer->plain(writer->ctx, "\"hex(", 5); break;
-	case CborIteratorTokenEndByteStrings:		writer->plain(writer->ctx, ")\"", 2); break;
-	case CborIteratorTokenBeginCharStrings:		writer->plain(writer->ctx, "\"", 1); break;
-	case CborIteratorTokenEndCharStrings:		writer->plain(writer->ctx, "\"", 1); break;
+	case CborIteratorTokenBeginArray:			CborWriterWrite(writer, "[", 1); break;
+	case CborIteratorTokenEndArray:				CborWriterWrite(writer, "]", 1); break;
+	case CborIteratorTokenBeginObject:			CborWriterWrite(writer, "{", 1); break;
+	case CborIteratorTokenEndObject:			CborWriterWrite(writer, "}", 1); break;
+	case CborIteratorTokenBeginByteStrings:
+		print_bytes_prefix(writer, encoding);
+		state->chunked = encoding;
+		state->carrySize = 0;
+		break;
+	case CborIteratorTokenEndByteStrings:
+		print_bytes(writer, state->chunked, state->carry, state->carrySize);
+		state->carrySize = 0;
+		CborWriterWrite(writer, ")\"", 2);
+		break;
+	case CborIteratorTokenBeginCharStrings:		CborWriterWrite(writer, "\"", 1); break;
+	case CborIteratorTokenEndCharStrings:		CborWriterWrite(writer, "\"", 1); break;
 	default: break;
 	}
 }
 
 bool CborToString(const struct CborWriter *writer, const uint8_t *data, uint32_t size) {
 	CborIteratorContext iter;
+	struct CborStringState state;
+
+	memset(&state, 0, sizeof(struct CborStringState));
+	CborByteEncodingScopeInit(&state.scope, CborByteEncodingHex);
 	if (CborIteratorInit(&iter, data, size)) {
 		CborIteratorToken token = CborIteratorNext(&iter);
 		while (token != CborIteratorTokenDone) {
-			CborValueIterToString(writer, &iter);
+			CborValueIterToString(writer, &iter, &state);
 			token = CborIteratorNext(&iter);
 		}
 
@@ -91,48 +232,52 @@ bool CborToString(const struct CborWriter *writer, const uint8_t *data, uint32_t
 }
 
 bool CborIteratorValueToString(const struct CborWriter *writer, CborIteratorContext *iter) {
+	struct CborStringState state;
+
+	memset(&state, 0, sizeof(struct CborStringState));
+	CborByteEncodingScopeInit(&state.scope, CborByteEncodingHex);
 	switch (iter->token) {
 	case CborIteratorTokenValue:
-		CborValueToString(writer, iter);
+		CborValueToString(writer, iter, CborByteEncodingHex);
 		return true;
 		break;
 	case CborIteratorTokenBeginArray: {
 		uint32_t stack = iter->stackSize;
-		writer->plain(writer->ctx, "[", 1);
+		CborWriterWrite(writer, "[", 1);
 		while (CborIteratorNext(iter) != CborIteratorTokenEndArray && iter->stackSize > stack - 1) {
-			CborValueIterToString(writer, iter);
+			CborValueIterToString(writer, iter, &state);
 		}
 		CborIteratorNext(iter);
-		writer->plain(writer->ctx, "]", 1);
+		CborWriterWrite(writer, "]", 1);
 		break;
 	}
 	case CborIteratorTokenBeginObject: {
 		uint32_t stack = iter->stackSize;
-		writer->plain(writer->ctx, "{", 1);
+		CborWriterWrite(writer, "{", 1);
 		while (CborIteratorNext(iter) != CborIteratorTokenEndObject && iter->stackSize > stack - 1) {
-			CborValueIterToString(writer, iter);
+			CborValueIterToString(writer, iter, &state);
 		}
 		CborIteratorNext(iter);
-		writer->plain(writer->ctx, "}", 1);
+		CborWriterWrite(writer, "}", 1);
 		break;
 	}
 	case CborIteratorTokenBeginByteStrings:
-		writer->plain(writer->ctx, "\"hex(", 5);
+		print_bytes_prefix(writer, CborByteEncodingHex);
 		while (CborIteratorNext(iter) != CborIteratorTokenEndByteStrings) {
 			if (iter->token == CborIteratorTokenValue) {
-				CborValueToString(writer, iter);
+				CborValueToString(writer, iter, CborByteEncodingHex);
 			}
 		}
-		writer->plain(writer->ctx, ")\"", 2);
+		CborWriterWrite(writer, ")\"", 2);
 		break;
 	case CborIteratorTokenBeginCharStrings:
-		writer->plain(writer->ctx, "\"", 1);
+		CborWriterWrite(writer, "\"", 1);
 		while (CborIteratorNext(iter) != CborIteratorTokenEndCharStrings) {
 			if (iter->token == CborIteratorTokenValue) {
-				CborValueToString(writer, iter);
+				CborValueToString(writer, iter, CborByteEncodingHex);
 			}
 		}
-		writer->plain(writer->ctx, "\"", 1);
+		CborWriterWrite(writer, "\"", 1);
 		break;
 	default:
 		return false;
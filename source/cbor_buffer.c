@@ -0,0 +1,46 @@
+
+#include "cbor_buffer.h"
+
+#define CBOR_BUFFER_INITIAL_CAPACITY 256
+
+void CborBufferInit(CborBuffer *buf, size_t reserved, size_t expected) {
+	size_t cap = CBOR_BUFFER_INITIAL_CAPACITY;
+	while (cap < reserved + expected) {
+		cap *= 2;
+	}
+
+	buf->data = CborAlloc(cap);
+	buf->size = reserved;
+	buf->capacity = cap;
+	buf->reserved = reserved;
+}
+
+void CborBufferFinalize(CborBuffer *buf) {
+	if (buf->data) {
+		CborFree(buf->data);
+	}
+	memset(buf, 0, sizeof(CborBuffer));
+}
+
+void CborBufferGrow(CborBuffer *buf, size_t size) {
+	size_t cap = buf->capacity ? buf->capacity : CBOR_BUFFER_INITIAL_CAPACITY;
+	while (cap < buf->size + size) {
+		cap *= 2;
+	}
+
+	if (cap != buf->capacity || !buf->data) {
+		buf->data = buf->data ? CborRealloc(buf->data, cap) : CborAlloc(cap);
+		buf->capacity = cap;
+	}
+}
+
+char *CborBufferRelease(CborBuffer *buf, size_t *size) {
+	char *ret = buf->data;
+	if (size) {
+		*size = buf->size;
+	}
+
+	buf->data = NULL;
+	CborBufferFinalize(buf);
+	return ret;
+}
@@ -0,0 +1,664 @@
+
+#include "cbor.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// nesting limit for check, same as for validation
+#define CBOR_CANONICAL_MAX_DEPTH 512
+
+// key-value pair of map, written into scratch encoder before sorting
+struct CborCanonicalPair {
+	size_t offset;
+	size_t keySize;
+	size_t size; // key and value
+	const uint8_t *ptr;
+};
+
+struct CborCanonicalContext {
+	bool hash; // hash form: tags are dropped, zero is unsigned, duplicate keys are allowed
+	bool buffer; // buffer is initialized
+	CborBuffer chunks;
+};
+
+static inline int CborCanonicalCompareBytes(const uint8_t *a, size_t asize, const uint8_t *b, size_t bsize) {
+	int ret = memcmp(a, b, (asize < bsize) ? asize : bsize);
+	if (ret != 0) {
+		return ret;
+	}
+	return (asize < bsize) ? -1 : ((asize > bsize) ? 1 : 0);
+}
+
+// pairs with equal keys are ordered by value
+static int CborCanonicalComparePairs(const void *a, const void *b) {
+	const struct CborCanonicalPair *pa = (const struct CborCanonicalPair *)a;
+	const struct CborCanonicalPair *pb = (const struct CborCanonicalPair *)b;
+	int ret = CborCanonicalCompareBytes(pa->ptr, pa->keySize, pb->ptr, pb->keySize);
+	if (ret != 0) {
+		return ret;
+	}
+	return CborCanonicalCompareBytes(pa->ptr + pa->keySize, pa->size - pa->keySize,
+			pb->ptr + pb->keySize, pb->size - pb->keySize);
+}
+
+// shortest argument length for value, as written by encoder
+static inline uint8_t CborCanonicalArgumentLength(uint64_t value) {
+	if (value < CborFlagsMaxAdditionalNumber) {
+		return 0;
+	} else if (value <= UINT8_MAX) {
+		return 1;
+	} else if (value <= UINT16_MAX) {
+		return 2;
+	} else if (value <= UINT32_MAX) {
+		return 4;
+	}
+	return 8;
+}
+
+// read initial byte with argument from well-formed data
+static inline const CborInitialByte *CborCanonicalReadHeader(CborData *data, uint64_t *value) {
+	const CborInitialByte *desc = &CborInitialByteTable[*data->ptr];
+	uint8_t info = *data->ptr & CborFlagsAdditionalInfoMask;
+
+	CborDataOffset(data, 1);
+	*value = CborDataReadUnsignedValue(data, info);
+	return desc;
+}
+
+static bool CborCanonicalWriteItem(struct CborCanonicalContext *ctx, CborEncoder *enc, CborData *data);
+
+static bool CborCanonicalWriteMap(struct CborCanonicalContext *ctx, CborEncoder *enc, CborData *data, uint64_t count, bool indefinite) {
+	struct CborCanonicalPair *pairs = NULL;
+	size_t npairs = 0, capacity = 0, i;
+	CborEncoder tmp;
+	bool ret = true;
+
+	CborEncoderInit(&tmp, 0, false);
+
+	while (indefinite ? *data->ptr != CborFlagsInterrupt : npairs < count) {
+		if (npairs == capacity) {
+			capacity = capacity ? capacity * 2 : 8;
+			pairs = pairs ? CborRealloc(pairs, capacity * sizeof(struct CborCanonicalPair))
+					: CborAlloc(capacity * sizeof(struct CborCanonicalPair));
+		}
+
+		pairs[npairs].offset = tmp.size;
+		if (!CborCanonicalWriteItem(ctx, &tmp, data)) {
+			ret = false;
+			break;
+		}
+		pairs[npairs].keySize = tmp.size - pairs[npairs].offset;
+		if (!CborCanonicalWriteItem(ctx, &tmp, data)) {
+			ret = false;
+			break;
+		}
+		pairs[npairs].size = tmp.size - pairs[npairs].offset;
+		++ npairs;
+	}
+
+	if (ret && indefinite) {
+		CborDataOffset(data, 1);
+	}
+
+	if (ret) {
+		// scratch buffer is complete, pointers are stable now
+		for (i = 0; i < npairs; ++ i) {
+			pairs[i].ptr = tmp.data + pairs[i].offset;
+		}
+
+		if (npairs > 1) {
+			qsort(pairs, npairs, sizeof(struct CborCanonicalPair), CborCanonicalComparePairs);
+		}
+
+		// deterministic encoding is not defined for duplicate keys
+		for (i = 1; i < npairs && !ctx->hash; ++ i) {
+			if (CborCanonicalCompareBytes(pairs[i - 1].ptr, pairs[i - 1].keySize, pairs[i].ptr, pairs[i].keySize) == 0) {
+				ret = false;
+				break;
+			}
+		}
+	}
+
+	if (ret) {
+		CborEncodeBeginMap(enc, (uint32_t)npairs);
+		for (i = 0; i < npairs; ++ i) {
+			CborEncodeRaw(enc, pairs[i].ptr, pairs[i].keySize);
+			CborEncodeRaw(enc, pairs[i].ptr + pairs[i].keySize, pairs[i].size - pairs[i].keySize);
+		}
+		CborEncodeEnd(enc);
+	}
+
+	if (pairs) {
+		CborFree(pairs);
+	}
+	CborEncoderFinalize(&tmp);
+	return ret;
+}
+
+static bool CborCanonicalWriteItem(struct CborCanonicalContext *ctx, CborEncoder *enc, CborData *data) {
+	const CborInitialByte *desc;
+	uint64_t value, i;
+	uint32_t u32;
+	uint8_t info;
+	float f;
+	double d;
+
+	info = *data->ptr & CborFlagsAdditionalInfoMask;
+	desc = CborCanonicalReadHeader(data, &value);
+
+	switch (desc->major) {
+	case CborMajorTypeUnsigned:
+		CborEncodeUnsigned(enc, value);
+		break;
+	case CborMajorTypeNegative:
+		CborEncodeNegative(enc, value);
+		break;
+	case CborMajorTypeByteString:
+	case CborMajorTypeCharString:
+		if (desc->flags & CborInitialByteFlagIndefinite) {
+			if (!ctx->buffer) {
+				CborBufferInit(&ctx->chunks, 0, 0);
+				ctx->buffer = true;
+			}
+
+			// chunks are definite strings of the same type
+			ctx->chunks.size = ctx->chunks.reserved;
+			while (*data->ptr != CborFlagsInterrupt) {
+				CborCanonicalReadHeader(data, &value);
+				CborBufferWrite(&ctx->chunks, (const char *)data->ptr, value);
+				CborDataOffset(data, (uint32_t)value);
+			}
+			CborDataOffset(data, 1);
+
+			if (desc->major == CborMajorTypeByteString) {
+				CborEncodeBytes(enc, (const uint8_t *)ctx->chunks.data + ctx->chunks.reserved, CborBufferGetSize(&ctx->chunks));
+			} else {
+				CborEncodeString(enc, ctx->chunks.data + ctx->chunks.reserved, CborBufferGetSize(&ctx->chunks));
+			}
+		} else {
+			if (desc->major == CborMajorTypeByteString) {
+				CborEncodeBytes(enc, data->ptr, value);
+			} else {
+				CborEncodeString(enc, (const char *)data->ptr, value);
+			}
+			CborDataOffset(data, (uint32_t)value);
+		}
+		break;
+	case CborMajorTypeArray:
+		if (desc->flags & CborInitialByteFlagIndefinite) {
+			CborEncodeBeginArray(enc, CBOR_ENCODER_UNKNOWN_COUNT);
+			while (*data->ptr != CborFlagsInterrupt) {
+				if (!CborCanonicalWriteItem(ctx, enc, data)) {
+					return false;
+				}
+			}
+			CborDataOffset(data, 1);
+		} else {
+			CborEncodeBeginArray(enc, (uint32_t)value);
+			for (i = 0; i < value; ++ i) {
+				if (!CborCanonicalWriteItem(ctx, enc, data)) {
+					return false;
+				}
+			}
+		}
+		CborEncodeEnd(enc);
+		break;
+	case CborMajorTypeMap:
+		return CborCanonicalWriteMap(ctx, enc, data, value, (desc->flags & CborInitialByteFlagIndefinite) != 0);
+		break;
+	case CborMajorTypeTag:
+		if (!ctx->hash) {
+			CborEncodeTag(enc, value);
+		}
+		return CborCanonicalWriteItem(ctx, enc, data);
+		break;
+	case CborMajorTypeSimple:
+		switch (info) {
+		case CborFlagsAdditionalFloat16Bit:
+			d = CborDataDecodeFloat16((uint16_t)value);
+			break;
+		case CborFlagsAdditionalFloat32Bit:
+			u32 = (uint32_t)value;
+			memcpy(&f, &u32, sizeof(float));
+			d = f;
+			break;
+		case CborFlagsAdditionalFloat64Bit:
+			memcpy(&d, &value, sizeof(double));
+			break;
+		default:
+			CborEncodeSimple(enc, (uint8_t)value);
+			return true;
+			break;
+		}
+
+		// -0.0 == 0.0 for CborCompare
+		if (ctx->hash && d == 0.0) {
+			d = 0.0;
+		}
+		CborEncodeFloat(enc, d);
+		break;
+	}
+
+	return true;
+}
+
+static bool CborCanonicalWrite(CborEncoder *enc, const uint8_t *data, size_t size, bool hash) {
+	struct CborCanonicalContext ctx;
+	CborData cur;
+	bool ret;
+
+	// writer trusts structure, so bounds are checked once
+	if (!CborValidate(data, size)) {
+		return false;
+	}
+
+	if (data_is_cbor(data, size)) {
+		data += CborHeaderSize;
+		size -= CborHeaderSize;
+	}
+
+	cur.ptr = data;
+	cur.size = (uint32_t)size;
+
+	ctx.hash = hash;
+	ctx.buffer = false;
+	ret = CborCanonicalWriteItem(&ctx, enc, &cur);
+	if (ctx.buffer) {
+		CborBufferFinalize(&ctx.chunks);
+	}
+	return ret;
+}
+
+bool CborCanonicalize(CborEncoder *enc, const uint8_t *data, size_t size) {
+	return CborCanonicalWrite(enc, data, size, false);
+}
+
+bool CborCanonicalizeForHash(CborEncoder *enc, const uint8_t *data, size_t size) {
+	return CborCanonicalWrite(enc, data, size, true);
+}
+
+// float is canonical, if it can not be written shorter with the same value (see CborEncodeFloat)
+static bool CborCanonicalCheckFloat(uint8_t info, uint64_t value, bool hash) {
+	uint32_t u32;
+	float f;
+	double d;
+
+	switch (info) {
+	case CborFlagsAdditionalFloat16Bit:
+		if (hash && value == 0x8000) {
+			return false;
+		}
+		return !isnan(CborDataDecodeFloat16((uint16_t)value)) || value == 0x7e00;
+		break;
+	case CborFlagsAdditionalFloat32Bit:
+		u32 = (uint32_t)value;
+		memcpy(&f, &u32, sizeof(float));
+		return !isnan(f) && CborDataDecodeFloat16(CborDataEncodeFloat16(f)) != f;
+		break;
+	case CborFlagsAdditionalFloat64Bit:
+		memcpy(&d, &value, sizeof(double));
+		return !isnan(d) && (double)(float)d != d;
+		break;
+	default:
+		break;
+	}
+	return false;
+}
+
+// returns end of canonical item or NULL
+static const uint8_t *CborCanonicalCheckItem(const uint8_t *ptr, const uint8_t *end, uint32_t depth, bool hash) {
+	const CborInitialByte *desc;
+	const uint8_t *key, *prevKey = NULL, *prevValue = NULL;
+	size_t prevKeySize = 0, prevValueSize = 0;
+	uint64_t value, i;
+	uint8_t info;
+	int cmp;
+
+	if (ptr >= end || depth > CBOR_CANONICAL_MAX_DEPTH) {
+		return NULL;
+	}
+
+	desc = &CborInitialByteTable[*ptr];
+	info = *ptr & CborFlagsAdditionalInfoMask;
+	if (desc->flags & (CborInitialByteFlagIndefinite | CborInitialByteFlagBreak | CborInitialByteFlagInvalid)) {
+		return NULL;
+	}
+
+	if ((size_t)(end - ptr) <= desc->length) {
+		return NULL;
+	}
+
+	if (desc->length > 0) {
+		CborData arg = { desc->length, ptr + 1 };
+		value = CborDataGetUnsignedValue(&arg, info);
+	} else {
+		value = info;
+	}
+	ptr += 1 + desc->length;
+
+	if (desc->major == CborMajorTypeSimple) {
+		if (info == CborFlagsSimple8Bit) {
+			// values below 32 should be written within initial byte
+			return (value < 32) ? NULL : ptr;
+		} else if (desc->length > 0) {
+			return CborCanonicalCheckFloat(info, value, hash) ? ptr : NULL;
+		}
+		return ptr;
+	}
+
+	if (CborCanonicalArgumentLength(value) != desc->length) {
+		return NULL;
+	}
+
+	switch (desc->major) {
+	case CborMajorTypeByteString:
+	case CborMajorTypeCharString:
+		if (value > (uint64_t)(end - ptr)) {
+			return NULL;
+		}
+		ptr += value;
+		break;
+	case CborMajorTypeArray:
+		if (value > (uint64_t)(end - ptr)) {
+			return NULL;
+		}
+		for (i = 0; i < value && ptr; ++ i) {
+			ptr = CborCanonicalCheckItem(ptr, end, depth + 1, hash);
+		}
+		break;
+	case CborMajorTypeMap:
+		if (value > (uint64_t)(end - ptr) / 2) {
+			return NULL;
+		}
+		for (i = 0; i < value && ptr; ++ i) {
+			// keys should be strictly increasing, so duplicates are not canonical too,
+			// hash form allows duplicates with ordered values
+			key = ptr;
+			ptr = CborCanonicalCheckItem(ptr, end, depth + 1, hash);
+			if (!ptr) {
+				return NULL;
+			}
+			cmp = prevKey ? CborCanonicalCompareBytes(prevKey, prevKeySize, key, ptr - key) : -1;
+			if (cmp > 0 || (cmp == 0 && !hash)) {
+				return NULL;
+			}
+			prevKey = key;
+			prevKeySize = ptr - key;
+
+			key = ptr;
+			ptr = CborCanonicalCheckItem(ptr, end, depth + 1, hash);
+			if (!ptr || (cmp == 0 && CborCanonicalCompareBytes(prevValue, prevValueSize, key, ptr - key) > 0)) {
+				return NULL;
+			}
+			prevValue = key;
+			prevValueSize = ptr - key;
+		}
+		break;
+	case CborMajorTypeTag:
+		if (hash) {
+			return NULL;
+		}
+		ptr = CborCanonicalCheckItem(ptr, end, depth + 1, hash);
+		break;
+	default:
+		break;
+	}
+
+	return ptr;
+}
+
+static bool CborCanonicalCheck(const uint8_t *data, size_t size, bool hash) {
+	if (data_is_cbor(data, size)) {
+		data += CborHeaderSize;
+		size -= CborHeaderSize;
+	} else if (size == 0) {
+		return false;
+	}
+
+	return CborCanonicalCheckItem(data, data + size, 0, hash) == data + size;
+}
+
+bool CborIsCanonical(const uint8_t *data, size_t size) {
+	return CborCanonicalCheck(data, size, false);
+}
+
+bool CborIsCanonicalForHash(const uint8_t *data, size_t size) {
+	return CborCanonicalCheck(data, size, true);
+}
+
+// streaming 64-bit hash, 8-byte words are mixed like in MurmurHash3, result does not depend on update boundaries
+#define CBOR_HASH_C1 0x87c37b91114253d5ULL
+#define CBOR_HASH_C2 0x4cf5ad432745937fULL
+
+struct CborHashState {
+	uint64_t hash;
+	uint64_t length;
+	uint8_t tail[8];
+	uint32_t ntail;
+};
+
+static inline uint64_t CborHashRotate(uint64_t x, uint32_t r) {
+	return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t CborHashMixWord(uint64_t k) {
+	k *= CBOR_HASH_C1;
+	k = CborHashRotate(k, 31);
+	return k * CBOR_HASH_C2;
+}
+
+static inline void CborHashWord(struct CborHashState *state, const uint8_t *ptr) {
+	uint64_t k;
+
+	memcpy(&k, ptr, sizeof(uint64_t));
+	state->hash ^= CborHashMixWord(k);
+	state->hash = CborHashRotate(state->hash, 27) * 5 + 0x52dce729;
+}
+
+static void CborHashUpdate(struct CborHashState *state, const uint8_t *ptr, size_t size) {
+	size_t n;
+
+	state->length += size;
+	if (state->ntail > 0) {
+		n = (size < 8 - state->ntail) ? size : 8 - state->ntail;
+		memcpy(state->tail + state->ntail, ptr, n);
+		state->ntail += n;
+		ptr += n;
+		size -= n;
+		if (state->ntail < 8) {
+			return;
+		}
+		CborHashWord(state, state->tail);
+		state->ntail = 0;
+	}
+
+	while (size >= 8) {
+		CborHashWord(state, ptr);
+		ptr += 8;
+		size -= 8;
+	}
+
+	memcpy(state->tail, ptr, size);
+	state->ntail = size;
+}
+
+static uint64_t CborHashFinal(struct CborHashState *state) {
+	uint64_t h = state->hash, k = 0;
+
+	if (state->ntail > 0) {
+		memset(state->tail + state->ntail, 0, 8 - state->ntail);
+		memcpy(&k, state->tail, sizeof(uint64_t));
+		h ^= CborHashMixWord(k);
+	}
+
+	// fmix64
+	h ^= state->length;
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdULL;
+	h ^= h >> 33;
+	h *= 0xc4ceb93e7f4a7c63ULL;
+	h ^= h >> 33;
+	return h;
+}
+
+/* Single pass over canonical document, hash form is fed into hash without copy: tags are skipped,
+ * negative zero is written as unsigned. Returns end of item or NULL, when document is not canonical
+ * or hash form can not be produced in place: map keys should be clean (without tags and negative zero),
+ * so their order is the same in hash form, as well as values for duplicate keys */
+static const uint8_t *CborCanonicalHashItem(struct CborHashState *state, const uint8_t *ptr, const uint8_t *end, uint32_t depth, bool *clean) {
+	static const uint8_t zero[] = { CborMajorTypeEncodedSimple | CborFlagsAdditionalFloat16Bit, 0, 0 };
+	const CborInitialByte *desc;
+	const uint8_t *start = ptr, *key, *prevKey = NULL, *prevValue = NULL;
+	size_t prevKeySize = 0, prevValueSize = 0;
+	bool itemClean, prevClean = true;
+	uint64_t value, i;
+	uint8_t info;
+	int cmp;
+
+	if (ptr >= end || depth > CBOR_CANONICAL_MAX_DEPTH) {
+		return NULL;
+	}
+
+	desc = &CborInitialByteTable[*ptr];
+	info = *ptr & CborFlagsAdditionalInfoMask;
+	if (desc->flags & (CborInitialByteFlagIndefinite | CborInitialByteFlagBreak | CborInitialByteFlagInvalid)) {
+		return NULL;
+	}
+
+	if ((size_t)(end - ptr) <= desc->length) {
+		return NULL;
+	}
+
+	if (desc->length > 0) {
+		CborData arg = { desc->length, ptr + 1 };
+		value = CborDataGetUnsignedValue(&arg, info);
+	} else {
+		value = info;
+	}
+	ptr += 1 + desc->length;
+
+	if (desc->major == CborMajorTypeSimple) {
+		if (info == CborFlagsSimple8Bit) {
+			if (value < 32) {
+				return NULL;
+			}
+		} else if (desc->length > 0) {
+			if (!CborCanonicalCheckFloat(info, value, false)) {
+				return NULL;
+			}
+			if (info == CborFlagsAdditionalFloat16Bit && value == 0x8000) {
+				*clean = false;
+				CborHashUpdate(state, zero, sizeof(zero));
+				return ptr;
+			}
+		}
+		CborHashUpdate(state, start, ptr - start);
+		return ptr;
+	}
+
+	if (CborCanonicalArgumentLength(value) != desc->length) {
+		return NULL;
+	}
+
+	switch (desc->major) {
+	case CborMajorTypeByteString:
+	case CborMajorTypeCharString:
+		if (value > (uint64_t)(end - ptr)) {
+			return NULL;
+		}
+		ptr += value;
+		CborHashUpdate(state, start, ptr - start);
+		break;
+	case CborMajorTypeArray:
+		if (value > (uint64_t)(end - ptr)) {
+			return NULL;
+		}
+		CborHashUpdate(state, start, ptr - start);
+		for (i = 0; i < value && ptr; ++ i) {
+			ptr = CborCanonicalHashItem(state, ptr, end, depth + 1, clean);
+		}
+		break;
+	case CborMajorTypeMap:
+		if (value > (uint64_t)(end - ptr) / 2) {
+			return NULL;
+		}
+		CborHashUpdate(state, start, ptr - start);
+		for (i = 0; i < value && ptr; ++ i) {
+			key = ptr;
+			itemClean = true;
+			ptr = CborCanonicalHashItem(state, ptr, end, depth + 1, &itemClean);
+			if (!ptr || !itemClean) {
+				return NULL;
+			}
+			cmp = prevKey ? CborCanonicalCompareBytes(prevKey, prevKeySize, key, ptr - key) : -1;
+			if (cmp > 0) {
+				return NULL;
+			}
+			prevKey = key;
+			prevKeySize = ptr - key;
+
+			key = ptr;
+			itemClean = true;
+			ptr = CborCanonicalHashItem(state, ptr, end, depth + 1, &itemClean);
+			if (!ptr) {
+				return NULL;
+			}
+			if (cmp == 0 && (!prevClean || !itemClean
+					|| CborCanonicalCompareBytes(prevValue, prevValueSize, key, ptr - key) > 0)) {
+				return NULL;
+			}
+			*clean = *clean && itemClean;
+			prevClean = itemClean;
+			prevValue = key;
+			prevValueSize = ptr - key;
+		}
+		break;
+	case CborMajorTypeTag:
+		*clean = false;
+		ptr = CborCanonicalHashItem(state, ptr, end, depth + 1, clean);
+		break;
+	default:
+		CborHashUpdate(state, start, ptr - start);
+		break;
+	}
+
+	return ptr;
+}
+
+bool CborHash(const uint8_t *data, size_t size, uint64_t seed, uint64_t *hash) {
+	struct CborHashState state;
+	CborEncoder enc;
+	CborData form;
+	bool clean = true;
+
+	if (data_is_cbor(data, size)) {
+		data += CborHeaderSize;
+		size -= CborHeaderSize;
+	} else if (size == 0) {
+		return false;
+	}
+
+	memset(&state, 0, sizeof(struct CborHashState));
+	state.hash = seed;
+	if (CborCanonicalHashItem(&state, data, data + size, 0, &clean) == data + size) {
+		*hash = CborHashFinal(&state);
+		return true;
+	}
+
+	// document should be converted into hash form first
+	CborEncoderInit(&enc, 0, false);
+	if (!CborCanonicalizeForHash(&enc, data, size)) {
+		CborEncoderFinalize(&enc);
+		return false;
+	}
+
+	form = CborEncoderGetData(&enc);
+	memset(&state, 0, sizeof(struct CborHashState));
+	state.hash = seed;
+	CborHashUpdate(&state, form.ptr, form.size);
+	*hash = CborHashFinal(&state);
+
+	CborEncoderFinalize(&enc);
+	return true;
+}
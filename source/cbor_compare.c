@@ -0,0 +1,361 @@
+
+#include "cbor.h"
+
+#include <math.h>
+#include <string.h>
+
+// 2^64, first double above uint64_t range
+#define CBOR_COMPARE_UINT64_LIMIT 18446744073709551616.0
+
+// sort key: rank in top bits, then order-preserving prefix of leading value
+#define CBOR_COMPARE_KEY_RANK_BITS 3
+#define CBOR_COMPARE_KEY_PREFIX 7 // string bytes within key
+
+// kind of current item, end of container sorts first, so shorter container sorts before longer one
+typedef enum {
+	CborCompareRankEnd,
+	CborCompareRankSimple,
+	CborCompareRankNumber,
+	CborCompareRankBytes,
+	CborCompareRankString,
+	CborCompareRankArray,
+	CborCompareRankMap,
+} CborCompareRank;
+
+struct CborCompareContext {
+	const uint8_t *aend; // end of compared data
+	const uint8_t *bend;
+	bool buffers; // buffers are initialized
+	CborBuffer a;
+	CborBuffer b;
+};
+
+static CborCompareRank CborCompareGetRank(const CborIteratorContext *iter) {
+	switch (iter->token) {
+	case CborIteratorTokenKey:
+	case CborIteratorTokenValue:
+		switch (CborIteratorGetType(iter)) {
+		case CborTypeUnsigned:
+		case CborTypeNegative:
+		case CborTypeFloat:
+			return CborCompareRankNumber;
+			break;
+		case CborTypeByteString: return CborCompareRankBytes; break;
+		case CborTypeCharString: return CborCompareRankString; break;
+		default: return CborCompareRankSimple; break;
+		}
+		break;
+	case CborIteratorTokenBeginByteStrings: return CborCompareRankBytes; break;
+	case CborIteratorTokenBeginCharStrings: return CborCompareRankString; break;
+	case CborIteratorTokenBeginArray: return CborCompareRankArray; break;
+	case CborIteratorTokenBeginObject: return CborCompareRankMap; break;
+	default: break;
+	}
+	return CborCompareRankEnd;
+}
+
+static uint8_t CborCompareGetSimple(const CborIteratorContext *iter) {
+	switch (CborIteratorGetType(iter)) {
+	case CborTypeFalse: return CborSimpleValueFalse; break;
+	case CborTypeTrue: return CborSimpleValueTrue; break;
+	case CborTypeNull: return CborSimpleValueNull; break;
+	case CborTypeUndefined: return CborSimpleValueUndefined; break;
+	default: break;
+	}
+	return (uint8_t)CborIteratorGetUnsigned(iter);
+}
+
+static inline int CborCompareUnsigned(uint64_t a, uint64_t b) {
+	return (a < b) ? -1 : ((a > b) ? 1 : 0);
+}
+
+// exact comparison of double (not NaN) with integer
+static int CborCompareFloatUnsigned(double d, uint64_t u) {
+	uint64_t t;
+
+	if (d < 0) {
+		return -1;
+	} else if (d >= CBOR_COMPARE_UINT64_LIMIT) {
+		return 1;
+	}
+
+	t = (uint64_t)d;
+	if (t != u) {
+		return (t < u) ? -1 : 1;
+	}
+	return (d > (double)t) ? 1 : 0;
+}
+
+// negative integer is -1 - n
+static int CborCompareFloatNegative(double d, uint64_t n) {
+	if (d >= 0) {
+		return 1;
+	} else if (n == UINT64_MAX) {
+		return (-d > CBOR_COMPARE_UINT64_LIMIT) ? -1 : ((-d < CBOR_COMPARE_UINT64_LIMIT) ? 1 : 0);
+	}
+	return -CborCompareFloatUnsigned(-d, n + 1);
+}
+
+// integers and floats are compared by value, integer sorts before equal float, NaN is the largest number
+static int CborCompareNumbers(const CborIteratorContext *a, const CborIteratorContext *b) {
+	CborType ta = CborIteratorGetType(a);
+	CborType tb = CborIteratorGetType(b);
+	double fa, fb;
+	int ret;
+
+	if (ta != CborTypeFloat && tb != CborTypeFloat) {
+		if (ta != tb) {
+			return (ta == CborTypeNegative) ? -1 : 1;
+		} else if (ta == CborTypeUnsigned) {
+			return CborCompareUnsigned(CborIteratorGetUnsigned(a), CborIteratorGetUnsigned(b));
+		}
+		// larger n is smaller -1 - n
+		return CborCompareUnsigned(~(uint64_t)CborIteratorGetInteger(b), ~(uint64_t)CborIteratorGetInteger(a));
+	}
+
+	if (ta == CborTypeFloat && tb == CborTypeFloat) {
+		fa = CborIteratorGetFloat(a);
+		fb = CborIteratorGetFloat(b);
+		if (isnan(fa) || isnan(fb)) {
+			return isnan(fb) ? (isnan(fa) ? 0 : -1) : 1;
+		}
+		return (fa < fb) ? -1 : ((fa > fb) ? 1 : 0);
+	}
+
+	if (ta == CborTypeFloat) {
+		fa = CborIteratorGetFloat(a);
+		if (isnan(fa)) {
+			return 1;
+		}
+		ret = (tb == CborTypeUnsigned)
+			? CborCompareFloatUnsigned(fa, CborIteratorGetUnsigned(b))
+			: CborCompareFloatNegative(fa, ~(uint64_t)CborIteratorGetInteger(b));
+		return ret ? ret : 1;
+	}
+
+	fb = CborIteratorGetFloat(b);
+	if (isnan(fb)) {
+		return -1;
+	}
+	ret = (ta == CborTypeUnsigned)
+		? CborCompareFloatUnsigned(fb, CborIteratorGetUnsigned(a))
+		: CborCompareFloatNegative(fb, ~(uint64_t)CborIteratorGetInteger(a));
+	return ret ? -ret : -1;
+}
+
+static int CborCompareBytes(const uint8_t *a, size_t asize, const uint8_t *b, size_t bsize) {
+	int ret = memcmp(a, b, (asize < bsize) ? asize : bsize);
+	if (ret != 0) {
+		return (ret < 0) ? -1 : 1;
+	}
+	return (asize < bsize) ? -1 : ((asize > bsize) ? 1 : 0);
+}
+
+static const uint8_t *CborCompareGetStringPtr(const CborIteratorContext *iter) {
+	if (CborIteratorGetType(iter) == CborTypeCharString) {
+		return (const uint8_t *)CborIteratorGetCharPtr(iter);
+	}
+	return CborIteratorGetBytePtr(iter);
+}
+
+// strings with the same rank, chunked strings are collected into buffers
+static int CborCompareStrings(struct CborCompareContext *ctx, CborIteratorContext *a, CborIteratorContext *b) {
+	if (a->token != CborIteratorTokenBeginByteStrings && a->token != CborIteratorTokenBeginCharStrings
+			&& b->token != CborIteratorTokenBeginByteStrings && b->token != CborIteratorTokenBeginCharStrings) {
+		return CborCompareBytes(CborCompareGetStringPtr(a), CborIteratorGetObjectSize(a),
+				CborCompareGetStringPtr(b), CborIteratorGetObjectSize(b));
+	}
+
+	if (!ctx->buffers) {
+		CborBufferInit(&ctx->a, 0, 0);
+		CborBufferInit(&ctx->b, 0, 0);
+		ctx->buffers = true;
+	}
+
+	ctx->a.size = ctx->a.reserved;
+	ctx->b.size = ctx->b.reserved;
+	CborIteratorNormalizeScalar(a, &ctx->a);
+	CborIteratorNormalizeScalar(b, &ctx->b);
+
+	// both have the same type byte
+	return CborCompareBytes((const uint8_t *)ctx->a.data, ctx->a.size, (const uint8_t *)ctx->b.data, ctx->b.size);
+}
+
+// containers at current positions have the same encoding, items are not decoded for that
+static bool CborCompareSameEncoding(const struct CborCompareContext *ctx, const CborIteratorContext *a, const CborIteratorContext *b) {
+	const uint8_t *pa = CborIteratorGetCurrentValuePtr(a);
+	const uint8_t *pb = CborIteratorGetCurrentValuePtr(b);
+	CborData da = { ctx->aend - pa, pa };
+	CborData db = { ctx->bend - pb, pb };
+	size_t size;
+
+	if (!CborDataSkipItems(&da, 1) || !CborDataSkipItems(&db, 1)) {
+		return false;
+	}
+
+	size = da.ptr - pa;
+	return size == (size_t)(db.ptr - pb) && memcmp(pa, pb, size) == 0;
+}
+
+static int CborCompareIterators(struct CborCompareContext *ctx, CborIteratorContext *a, CborIteratorContext *b) {
+	CborCompareRank ra, rb;
+	int ret = 0;
+
+	while (true) {
+		CborIteratorNext(a);
+		CborIteratorNext(b);
+		CborIteratorSkipTags(a);
+		CborIteratorSkipTags(b);
+
+		ra = CborCompareGetRank(a);
+		rb = CborCompareGetRank(b);
+		if (ra != rb) {
+			return (ra < rb) ? -1 : 1;
+		}
+
+		switch (ra) {
+		case CborCompareRankEnd:
+			if (a->token == CborIteratorTokenDone || b->token == CborIteratorTokenDone) {
+				return 0;
+			}
+			break;
+		case CborCompareRankSimple:
+			ret = CborCompareUnsigned(CborCompareGetSimple(a), CborCompareGetSimple(b));
+			break;
+		case CborCompareRankNumber:
+			ret = CborCompareNumbers(a, b);
+			break;
+		case CborCompareRankBytes:
+		case CborCompareRankString:
+			ret = CborCompareStrings(ctx, a, b);
+			break;
+		case CborCompareRankArray:
+		case CborCompareRankMap:
+			// equal encoding is equal value, only containers with differences are compared item by item
+			if (CborCompareSameEncoding(ctx, a, b)) {
+				CborIteratorSkipValue(a);
+				CborIteratorSkipValue(b);
+			}
+			break;
+		}
+
+		if (ret != 0) {
+			return ret;
+		}
+	}
+
+	return 0;
+}
+
+int CborCompare(const uint8_t *a, size_t asize, const uint8_t *b, size_t bsize) {
+	struct CborCompareContext ctx;
+	CborIteratorContext ia, ib;
+	int ret;
+
+	if (data_is_cbor(a, asize)) {
+		a += CborHeaderSize;
+		asize -= CborHeaderSize;
+	}
+	if (data_is_cbor(b, bsize)) {
+		b += CborHeaderSize;
+		bsize -= CborHeaderSize;
+	}
+
+	// equal encoding is equal value, decoding is required only for differences
+	if (asize == bsize && memcmp(a, b, asize) == 0) {
+		return 0;
+	}
+
+	// malformed data sorts first
+	if (!CborIteratorInit(&ia, a, asize)) {
+		ret = CborIteratorInit(&ib, b, bsize) ? -1 : 0;
+		if (ret) {
+			CborIteratorFinalize(&ib);
+		}
+		return ret;
+	}
+	if (!CborIteratorInit(&ib, b, bsize)) {
+		CborIteratorFinalize(&ia);
+		return 1;
+	}
+
+	ctx.aend = a + asize;
+	ctx.bend = b + bsize;
+	ctx.buffers = false;
+	ret = CborCompareIterators(&ctx, &ia, &ib);
+	if (ctx.buffers) {
+		CborBufferFinalize(&ctx.a);
+		CborBufferFinalize(&ctx.b);
+	}
+
+	CborIteratorFinalize(&ia);
+	CborIteratorFinalize(&ib);
+	return ret;
+}
+
+// order-preserving unsigned form of double, NaN is the largest
+static uint64_t CborCompareFloatKey(double d) {
+	uint64_t bits;
+
+	if (isnan(d)) {
+		return UINT64_MAX;
+	} else if (d == 0.0) {
+		d = 0.0;
+	}
+
+	memcpy(&bits, &d, sizeof(uint64_t));
+	return (bits & ((uint64_t)1 << 63)) ? ~bits : (bits | ((uint64_t)1 << 63));
+}
+
+static uint64_t CborCompareStringKey(const uint8_t *ptr, size_t size) {
+	uint64_t ret = 0;
+	uint32_t i;
+
+	for (i = 0; i < CBOR_COMPARE_KEY_PREFIX; ++ i) {
+		ret = (ret << 8) | ((i < size) ? ptr[i] : 0);
+	}
+	return ret;
+}
+
+uint64_t CborCompareKey(const uint8_t *data, size_t size) {
+	CborIteratorContext iter;
+	CborCompareRank rank;
+	CborBuffer buf;
+	uint64_t value = 0;
+
+	if (!CborIteratorInitRoot(&iter, data, size)) {
+		return 0;
+	}
+
+	rank = CborCompareGetRank(&iter);
+	switch (rank) {
+	case CborCompareRankSimple:
+		value = CborCompareGetSimple(&iter);
+		break;
+	case CborCompareRankNumber:
+		// integers are rounded to nearest double, rounding keeps the order
+		switch (CborIteratorGetType(&iter)) {
+		case CborTypeUnsigned: value = CborCompareFloatKey((double)CborIteratorGetUnsigned(&iter)); break;
+		case CborTypeNegative: value = CborCompareFloatKey(-1.0 - (double)~(uint64_t)CborIteratorGetInteger(&iter)); break;
+		default: value = CborCompareFloatKey(CborIteratorGetFloat(&iter)); break;
+		}
+		value >>= CBOR_COMPARE_KEY_RANK_BITS;
+		break;
+	case CborCompareRankBytes:
+	case CborCompareRankString:
+		if (iter.token == CborIteratorTokenKey || iter.token == CborIteratorTokenValue) {
+			value = CborCompareStringKey(CborCompareGetStringPtr(&iter), CborIteratorGetObjectSize(&iter));
+		} else {
+			CborBufferInit(&buf, 0, 0);
+			CborIteratorNormalizeScalar(&iter, &buf);
+			value = CborCompareStringKey((const uint8_t *)buf.data + 1, buf.size - 1);
+			CborBufferFinalize(&buf);
+		}
+		break;
+	default:
+		break;
+	}
+
+	CborIteratorFinalize(&iter);
+	return ((uint64_t)rank << (64 - CBOR_COMPARE_KEY_RANK_BITS)) | value;
+}
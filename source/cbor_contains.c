@@ -0,0 +1,541 @@
+
+#include "cbor.h"
+
+#include <math.h>
+#include <string.h>
+
+// nesting limit for query, same as for validation
+#define CBOR_CONTAINS_MAX_DEPTH 512
+
+// data container is indexed, when linear search would take more comparisons
+#define CBOR_CONTAINS_INDEX_MIN 32
+
+#define CBOR_CONTAINS_FNV_OFFSET 14695981039346656037ULL
+#define CBOR_CONTAINS_FNV_PRIME 1099511628211ULL
+
+struct CborContainsContext {
+	CborBuffer data;
+	CborBuffer query;
+};
+
+// elements of definite or indefinite container within encoded data
+struct CborContainsList {
+	CborData data; // rest of elements
+	uint64_t count; // elements left in definite container (pairs are counted as two elements)
+	bool indefinite;
+};
+
+// map key or array scalar within index, entry with zero size is empty
+struct CborContainsEntry {
+	uint64_t hash;
+	size_t offset; // normalized scalar within index buffer
+	size_t size;
+	CborData value; // map value or array element
+};
+
+// open addressing hash table over normalized scalars of data container, first key wins
+struct CborContainsIndex {
+	struct CborContainsEntry *entries;
+	size_t mask;
+	CborBuffer scalars;
+};
+
+static inline void CborScalarWriteUnsigned(CborBuffer *buf, uint8_t type, uint64_t value) {
+	uint8_t *ptr = (uint8_t *)CborBufferReserve(buf, 9);
+	uint32_t i;
+
+	ptr[0] = type;
+	for (i = 8; i > 0; -- i) {
+		ptr[i] = (uint8_t)(value & 0xFF);
+		value >>= 8;
+	}
+	buf->size += 9;
+}
+
+static inline void CborScalarWriteSimple(CborBuffer *buf, uint8_t value) {
+	CborBufferWriteChar(buf, CBOR_SCALAR_SIMPLE);
+	CborBufferWriteChar(buf, (char)value);
+}
+
+bool CborIteratorNormalizeScalar(CborIteratorContext *iter, CborBuffer *buf) {
+	double f;
+	uint64_t u64;
+
+	switch (iter->token) {
+	case CborIteratorTokenBeginByteStrings:
+	case CborIteratorTokenBeginCharStrings:
+		CborBufferWriteChar(buf, (iter->token == CborIteratorTokenBeginByteStrings) ? CBOR_SCALAR_BYTES : CBOR_SCALAR_STRING);
+		while (CborIteratorNext(iter) == CborIteratorTokenValue) {
+			if (CborIteratorGetType(iter) == CborTypeCharString) {
+				CborBufferWrite(buf, CborIteratorGetCharPtr(iter), CborIteratorGetObjectSize(iter));
+			} else {
+				CborBufferWrite(buf, (const char *)CborIteratorGetBytePtr(iter), CborIteratorGetObjectSize(iter));
+			}
+		}
+		return iter->token == CborIteratorTokenEndByteStrings || iter->token == CborIteratorTokenEndCharStrings;
+		break;
+	case CborIteratorTokenKey:
+	case CborIteratorTokenValue:
+		break;
+	default:
+		return false;
+		break;
+	}
+
+	switch (CborIteratorGetType(iter)) {
+	case CborTypeUnsigned:
+		CborScalarWriteUnsigned(buf, CBOR_SCALAR_UNSIGNED, CborIteratorGetUnsigned(iter));
+		break;
+	case CborTypeNegative:
+		// -1 - n is stored as n, so full 64-bit range is preserved
+		CborScalarWriteUnsigned(buf, CBOR_SCALAR_NEGATIVE, ~(uint64_t)CborIteratorGetInteger(iter));
+		break;
+	case CborTypeFloat:
+		f = CborIteratorGetFloat(iter);
+		if (isnan(f)) {
+			f = NAN;
+		} else if (f == 0.0) {
+			f = 0.0;
+		}
+		memcpy(&u64, &f, sizeof(uint64_t));
+		CborScalarWriteUnsigned(buf, CBOR_SCALAR_FLOAT, u64);
+		break;
+	case CborTypeByteString:
+		CborBufferWriteChar(buf, CBOR_SCALAR_BYTES);
+		CborBufferWrite(buf, (const char *)CborIteratorGetBytePtr(iter), CborIteratorGetObjectSize(iter));
+		break;
+	case CborTypeCharString:
+		CborBufferWriteChar(buf, CBOR_SCALAR_STRING);
+		CborBufferWrite(buf, CborIteratorGetCharPtr(iter), CborIteratorGetObjectSize(iter));
+		break;
+	case CborTypeSimple: CborScalarWriteSimple(buf, (uint8_t)CborIteratorGetUnsigned(iter)); break;
+	case CborTypeFalse: CborScalarWriteSimple(buf, CborSimpleValueFalse); break;
+	case CborTypeTrue: CborScalarWriteSimple(buf, CborSimpleValueTrue); break;
+	case CborTypeNull: CborScalarWriteSimple(buf, CborSimpleValueNull); break;
+	case CborTypeUndefined: CborScalarWriteSimple(buf, CborSimpleValueUndefined); break;
+	default:
+		return false;
+		break;
+	}
+	return true;
+}
+
+bool CborNormalizeScalar(const CborData *item, CborBuffer *buf) {
+	CborIteratorContext iter;
+	bool ret = false;
+
+	if (CborIteratorInitRoot(&iter, item->ptr, item->size)) {
+		ret = CborIteratorNormalizeScalar(&iter, buf);
+		CborIteratorFinalize(&iter);
+	}
+	return ret;
+}
+
+// read initial byte with argument, returns NULL if data is truncated
+static const CborInitialByte *CborContainsReadHeader(CborData *data, uint64_t *value) {
+	const CborInitialByte *desc;
+	uint8_t info;
+
+	if (data->size == 0) {
+		return NULL;
+	}
+
+	desc = &CborInitialByteTable[*data->ptr];
+	info = *data->ptr & CborFlagsAdditionalInfoMask;
+	if (data->size <= desc->length || (desc->flags & (CborInitialByteFlagBreak | CborInitialByteFlagInvalid))) {
+		return NULL;
+	}
+
+	CborDataOffset(data, 1);
+	*value = CborDataReadUnsignedValue(data, info);
+	return desc;
+}
+
+// item without leading tags, returns false if nothing left
+static bool CborContainsSkipTags(CborData *item) {
+	CborData data = *item;
+	const CborInitialByte *desc;
+	uint64_t value;
+
+	while (item->size > 0 && CborInitialByteTable[*item->ptr].major == CborMajorTypeTag) {
+		desc = CborContainsReadHeader(&data, &value);
+		if (!desc) {
+			return false;
+		}
+		*item = data;
+	}
+	return item->size > 0;
+}
+
+static bool CborContainsOpen(const CborData *item, struct CborContainsList *list) {
+	const CborInitialByte *desc;
+	uint64_t value;
+
+	list->data = *item;
+	desc = CborContainsReadHeader(&list->data, &value);
+	if (!desc) {
+		return false;
+	}
+
+	list->indefinite = (desc->flags & CborInitialByteFlagIndefinite) != 0;
+	list->count = (desc->major == CborMajorTypeMap) ? value * 2 : value;
+	return true;
+}
+
+// next element bytes (with tags), header arithmetic only
+static bool CborContainsNext(struct CborContainsList *list, CborData *element) {
+	if (list->indefinite) {
+		if (list->data.size == 0 || *list->data.ptr == CborFlagsInterrupt) {
+			return false;
+		}
+	} else if (list->count == 0) {
+		return false;
+	} else {
+		-- list->count;
+	}
+
+	*element = list->data;
+	if (!CborDataSkipItems(&list->data, 1)) {
+		return false;
+	}
+	element->size = list->data.ptr - element->ptr;
+	return true;
+}
+
+// number of elements for definite container, large value for indefinite
+static inline uint64_t CborContainsCount(const struct CborContainsList *list) {
+	return list->indefinite ? UINT32_MAX : list->count;
+}
+
+// normalized scalar type for initial byte, 0 for containers
+static inline char CborContainsScalarType(uint8_t byte) {
+	switch (byte >> CborFlagsMajorTypeShift) {
+	case CborMajorTypeUnsigned: return CBOR_SCALAR_UNSIGNED; break;
+	case CborMajorTypeNegative: return CBOR_SCALAR_NEGATIVE; break;
+	case CborMajorTypeByteString: return CBOR_SCALAR_BYTES; break;
+	case CborMajorTypeCharString: return CBOR_SCALAR_STRING; break;
+	case CborMajorTypeSimple:
+		switch (byte & CborFlagsAdditionalInfoMask) {
+		case CborFlagsAdditionalFloat16Bit:
+		case CborFlagsAdditionalFloat32Bit:
+		case CborFlagsAdditionalFloat64Bit:
+			return CBOR_SCALAR_FLOAT;
+			break;
+		default:
+			return CBOR_SCALAR_SIMPLE;
+			break;
+		}
+		break;
+	default:
+		break;
+	}
+	return 0;
+}
+
+// normalized form of scalar item (without tags), definite strings and integers are written without iterator
+static bool CborContainsNormalize(const CborData *item, CborBuffer *buf) {
+	const CborInitialByte *desc;
+	CborData data = *item;
+	char type = CborContainsScalarType(*item->ptr);
+	uint64_t value;
+
+	if (type == CBOR_SCALAR_FLOAT || type == CBOR_SCALAR_SIMPLE || type == 0
+			|| (CborInitialByteTable[*item->ptr].flags & CborInitialByteFlagIndefinite)) {
+		return CborNormalizeScalar(item, buf);
+	}
+
+	desc = CborContainsReadHeader(&data, &value);
+	if (!desc) {
+		return false;
+	}
+
+	if (type == CBOR_SCALAR_UNSIGNED || type == CBOR_SCALAR_NEGATIVE) {
+		CborScalarWriteUnsigned(buf, type, value);
+	} else {
+		if (value > data.size) {
+			return false;
+		}
+		CborBufferWriteChar(buf, type);
+		CborBufferWrite(buf, (const char *)data.ptr, value);
+	}
+	return true;
+}
+
+static inline uint64_t CborContainsHash(const uint8_t *ptr, size_t size) {
+	uint64_t hash = CBOR_CONTAINS_FNV_OFFSET;
+	size_t i;
+
+	for (i = 0; i < size; ++ i) {
+		hash = (hash ^ ptr[i]) * CBOR_CONTAINS_FNV_PRIME;
+	}
+	return hash;
+}
+
+/* Equality of scalar items (without tags): encodings with the same initial byte are equal
+ * only with equal bytes, except for floats (signed zero, NaN payloads). Other encodings are normalized */
+static bool CborContainsScalarEquals(struct CborContainsContext *ctx, const CborData *data, const CborData *query) {
+	char type = CborContainsScalarType(*data->ptr);
+
+	if (type == 0 || type != CborContainsScalarType(*query->ptr)) {
+		return false;
+	}
+
+	if (data->size == query->size && memcmp(data->ptr, query->ptr, data->size) == 0) {
+		return true;
+	}
+
+	if (*data->ptr == *query->ptr && type != CBOR_SCALAR_FLOAT
+			&& !(CborInitialByteTable[*data->ptr].flags & CborInitialByteFlagIndefinite)) {
+		return false;
+	}
+
+	ctx->data.size = ctx->data.reserved;
+	ctx->query.size = ctx->query.reserved;
+	return CborContainsNormalize(data, &ctx->data) && CborContainsNormalize(query, &ctx->query)
+			&& ctx->data.size == ctx->query.size
+			&& memcmp(ctx->data.data, ctx->query.data, ctx->data.size) == 0;
+}
+
+static void CborContainsIndexInsert(struct CborContainsIndex *index, const CborData *key, const CborData *value) {
+	struct CborContainsEntry *entry;
+	size_t offset = index->scalars.size;
+	uint64_t hash;
+	size_t pos;
+
+	if (!CborContainsNormalize(key, &index->scalars)) {
+		return;
+	}
+
+	hash = CborContainsHash((const uint8_t *)index->scalars.data + offset, index->scalars.size - offset);
+	for (pos = hash & index->mask; index->entries[pos].size > 0; pos = (pos + 1) & index->mask) {
+		entry = &index->entries[pos];
+		if (entry->hash == hash && entry->size == index->scalars.size - offset
+				&& memcmp(index->scalars.data + entry->offset, index->scalars.data + offset, entry->size) == 0) {
+			// duplicate key, first one is used
+			index->scalars.size = offset;
+			return;
+		}
+	}
+
+	entry = &index->entries[pos];
+	entry->hash = hash;
+	entry->offset = offset;
+	entry->size = index->scalars.size - offset;
+	entry->value = *value;
+}
+
+/* Index of map keys (with their values) or array scalars, containers are not indexed.
+ * Table is at most half full, so probing always stops at empty slot. Every element takes
+ * at least one byte, so container size limits table for indefinite containers */
+static void CborContainsIndexBuild(struct CborContainsIndex *index, const CborData *container, bool map) {
+	struct CborContainsList list;
+	CborData key, value;
+	size_t capacity = 16;
+	uint64_t count;
+
+	CborContainsOpen(container, &list);
+	count = map ? CborContainsCount(&list) / 2 : CborContainsCount(&list);
+	while (capacity < count * 2 && capacity < (size_t)container->size * 2) {
+		capacity *= 2;
+	}
+
+	index->mask = capacity - 1;
+	index->entries = CborAlloc(capacity * sizeof(struct CborContainsEntry));
+	memset(index->entries, 0, capacity * sizeof(struct CborContainsEntry));
+	CborBufferInit(&index->scalars, 0, 0);
+
+	while (CborContainsNext(&list, &key)) {
+		if (map && !CborContainsNext(&list, &value)) {
+			break;
+		}
+		if (!map) {
+			value = key;
+		}
+		if (CborContainsSkipTags(&key) && CborContainsScalarType(*key.ptr) != 0) {
+			CborContainsIndexInsert(index, &key, &value);
+		}
+	}
+}
+
+static void CborContainsIndexFinalize(struct CborContainsIndex *index) {
+	CborFree(index->entries);
+	CborBufferFinalize(&index->scalars);
+}
+
+// search by normalized scalar in query buffer of context
+static const struct CborContainsEntry *CborContainsIndexFind(const struct CborContainsIndex *index, const CborBuffer *scalar) {
+	const struct CborContainsEntry *entry;
+	size_t size = scalar->size - scalar->reserved;
+	uint64_t hash = CborContainsHash((const uint8_t *)scalar->data + scalar->reserved, size);
+	size_t pos;
+
+	for (pos = hash & index->mask; index->entries[pos].size > 0; pos = (pos + 1) & index->mask) {
+		entry = &index->entries[pos];
+		if (entry->hash == hash && entry->size == size
+				&& memcmp(index->scalars.data + entry->offset, scalar->data + scalar->reserved, size) == 0) {
+			return entry;
+		}
+	}
+	return NULL;
+}
+
+static bool CborContainsValue(struct CborContainsContext *ctx, CborData data, CborData query, uint32_t depth);
+
+// value for first data key, equal to query key (both without tags)
+static bool CborContainsFindKey(struct CborContainsContext *ctx, const CborData *data, const CborData *key, CborData *value) {
+	struct CborContainsList list;
+	CborData dkey;
+
+	CborContainsOpen(data, &list);
+	while (CborContainsNext(&list, &dkey)) {
+		if (!CborContainsNext(&list, value)) {
+			return false;
+		}
+		if (CborContainsSkipTags(&dkey) && CborContainsScalarEquals(ctx, &dkey, key)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/* Object contains object with subset of its keys, where every value is contained by value for the same key.
+ * Wide data objects are indexed once, so every query key is found without scan */
+static bool CborContainsMap(struct CborContainsContext *ctx, const CborData *data, const CborData *query, uint32_t depth) {
+	struct CborContainsList dlist, qlist;
+	struct CborContainsIndex index;
+	const struct CborContainsEntry *entry;
+	CborData key, value, dvalue;
+	bool indexed, ret = true;
+
+	if (!CborContainsOpen(data, &dlist) || !CborContainsOpen(query, &qlist)) {
+		return false;
+	}
+
+	indexed = CborContainsCount(&dlist) / 2 * (CborContainsCount(&qlist) / 2) >= CBOR_CONTAINS_INDEX_MIN;
+	if (indexed) {
+		CborContainsIndexBuild(&index, data, true);
+	}
+
+	while (ret && CborContainsNext(&qlist, &key)) {
+		if (!CborContainsNext(&qlist, &value) || !CborContainsSkipTags(&key) || CborContainsScalarType(*key.ptr) == 0) {
+			// container keys are never matched
+			ret = false;
+		} else if (indexed) {
+			ctx->query.size = ctx->query.reserved;
+			entry = CborContainsNormalize(&key, &ctx->query) ? CborContainsIndexFind(&index, &ctx->query) : NULL;
+			ret = entry && CborContainsValue(ctx, entry->value, value, depth + 1);
+		} else {
+			ret = CborContainsFindKey(ctx, data, &key, &dvalue) && CborContainsValue(ctx, dvalue, value, depth + 1);
+		}
+	}
+
+	if (indexed) {
+		CborContainsIndexFinalize(&index);
+	}
+	return ret;
+}
+
+/* Array contains array, where every element is contained by some of its elements.
+ * Scalar elements of wide data arrays are indexed, container elements are searched among data containers */
+static bool CborContainsArray(struct CborContainsContext *ctx, const CborData *data, const CborData *query, uint32_t depth) {
+	struct CborContainsList dlist, qlist;
+	struct CborContainsIndex index;
+	CborData element, delement;
+	bool indexed = false, useIndex, found, ret = true;
+
+	if (!CborContainsOpen(data, &dlist) || !CborContainsOpen(query, &qlist)) {
+		return false;
+	}
+
+	useIndex = CborContainsCount(&dlist) * CborContainsCount(&qlist) >= CBOR_CONTAINS_INDEX_MIN;
+
+	while (ret && CborContainsNext(&qlist, &element)) {
+		if (!CborContainsSkipTags(&element)) {
+			ret = false;
+			break;
+		}
+
+		if (useIndex && CborContainsScalarType(*element.ptr) != 0) {
+			if (!indexed) {
+				CborContainsIndexBuild(&index, data, false);
+				indexed = true;
+			}
+			ctx->query.size = ctx->query.reserved;
+			ret = CborContainsNormalize(&element, &ctx->query) && CborContainsIndexFind(&index, &ctx->query) != NULL;
+			continue;
+		}
+
+		found = false;
+		CborContainsOpen(data, &dlist);
+		while (!found && CborContainsNext(&dlist, &delement)) {
+			found = CborContainsValue(ctx, delement, element, depth + 1);
+		}
+		ret = found;
+	}
+
+	if (indexed) {
+		CborContainsIndexFinalize(&index);
+	}
+	return ret;
+}
+
+static bool CborContainsComplete(CborData *item) {
+	CborData rest = *item;
+	if (!CborDataSkipItems(&rest, 1)) {
+		return false;
+	}
+	item->size = rest.ptr - item->ptr;
+	return true;
+}
+
+// data and query items are walked together, both sides stay encoded
+static bool CborContainsValue(struct CborContainsContext *ctx, CborData data, CborData query, uint32_t depth) {
+	uint8_t qmajor;
+
+	if (depth > CBOR_CONTAINS_MAX_DEPTH || !CborContainsSkipTags(&data) || !CborContainsSkipTags(&query)) {
+		return false;
+	}
+
+	qmajor = *query.ptr >> CborFlagsMajorTypeShift;
+	switch (qmajor) {
+	case CborMajorTypeMap:
+	case CborMajorTypeArray:
+		if ((*data.ptr >> CborFlagsMajorTypeShift) != qmajor) {
+			return false;
+		}
+		return (qmajor == CborMajorTypeMap)
+			? CborContainsMap(ctx, &data, &query, depth)
+			: CborContainsArray(ctx, &data, &query, depth);
+		break;
+	default:
+		return CborContainsScalarEquals(ctx, &data, &query);
+		break;
+	}
+	return false;
+}
+
+bool CborContains(const uint8_t *data, size_t size, const uint8_t *query, size_t qsize) {
+	struct CborContainsContext ctx;
+	CborData d = { size, data };
+	CborData q = { qsize, query };
+	bool ret;
+
+	if (data_is_cbor(data, size)) {
+		CborDataOffset(&d, CborHeaderSize);
+	}
+	if (data_is_cbor(query, qsize)) {
+		CborDataOffset(&q, CborHeaderSize);
+	}
+
+	// nested items are bounded by their containers, so only root items are checked
+	if (!CborContainsComplete(&d) || !CborContainsComplete(&q)) {
+		return false;
+	}
+
+	CborBufferInit(&ctx.data, 0, 0);
+	CborBufferInit(&ctx.query, 0, 0);
+	ret = CborContainsValue(&ctx, d, q, 0);
+	CborBufferFinalize(&ctx.data);
+	CborBufferFinalize(&ctx.query);
+	return ret;
+}
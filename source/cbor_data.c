@@ -145,6 +145,14 @@ static uint16_t CborHalfFloatEncode(float val) {
 	return bits;
 }
 
+uint16_t CborDataEncodeFloat16(float val) {
+	return CborHalfFloatEncode(val);
+}
+
+float CborDataDecodeFloat16(uint16_t half) {
+	return CborHalfFloatDecode(half);
+}
+
 const uint8_t CborHeaderData[] = { (uint8_t)0xd9, (uint8_t)0xd9, (uint8_t)0xf7 };
 uint32_t CborHeaderSize = 3;
 
@@ -231,3 +239,116 @@ uint64_t CborDataReadUnsignedValue(CborData *data, uint8_t type) {
 	}
 	return ret;
 }
+
+// nesting limit for indefinite-length containers within skip kernel
+#define CBOR_SKIP_MAX_DEPTH 512
+
+static const uint8_t *CborDataSkipRange(const uint8_t *ptr, const uint8_t *end, uint64_t count, bool untilBreak, uint32_t depth) {
+	uint8_t type, info;
+	uint64_t value;
+
+	if (depth > CBOR_SKIP_MAX_DEPTH) {
+		return NULL;
+	}
+
+	// `count` holds number of pending items from definite containers,
+	// items of indefinite container (when count is 0) are read until break
+	while (count > 0 || untilBreak) {
+		if (ptr >= end) {
+			return NULL;
+		}
+
+		type = *ptr ++;
+		if (type == CborFlagsInterrupt) {
+			return (untilBreak && count == 0) ? ptr : NULL;
+		}
+
+		if (count > 0) {
+			-- count;
+		}
+
+		info = type & CborFlagsAdditionalInfoMask;
+		type = (type & CborFlagsMajorTypeMaskEncoded) >> CborFlagsMajorTypeShift;
+
+		if (info < CborFlagsMaxAdditionalNumber) {
+			value = info;
+		} else if (info <= CborFlagsAdditionalNumber64Bit) {
+			uint32_t len = 1 << (info - CborFlagsAdditionalNumber8Bit);
+			CborData data = { len, ptr };
+			if ((size_t)(end - ptr) < len) {
+				return NULL;
+			}
+			value = CborDataGetUnsignedValue(&data, info);
+			ptr += len;
+		} else if (info == CborFlagsUndefinedLength) {
+			switch (type) {
+			case CborMajorTypeByteString:
+			case CborMajorTypeCharString:
+			case CborMajorTypeArray:
+			case CborMajorTypeMap:
+				ptr = CborDataSkipRange(ptr, end, 0, true, depth + 1);
+				if (!ptr) {
+					return NULL;
+				}
+				continue;
+				break;
+			default:
+				return NULL;
+				break;
+			}
+		} else {
+			return NULL;
+		}
+
+		switch (type) {
+		case CborMajorTypeByteString:
+		case CborMajorTypeCharString:
+			if (value > (uint64_t)(end - ptr)) {
+				return NULL;
+			}
+			ptr += value;
+			break;
+		case CborMajorTypeArray:
+			// every item takes at least one byte
+			if (value > (uint64_t)(end - ptr)) {
+				return NULL;
+			}
+			count += value;
+			break;
+		case CborMajorTypeMap:
+			if (value > (uint64_t)(end - ptr) / 2) {
+				return NULL;
+			}
+			count += value * 2;
+			break;
+		case CborMajorTypeTag:
+			++ count;
+			break;
+		default: break;
+		}
+	}
+
+	return ptr;
+}
+
+bool CborDataSkipItems(CborData *data, uint32_t count) {
+	const uint8_t *ptr = CborDataSkipRange(data->ptr, data->ptr + data->size, count, false, 0);
+	if (!ptr) {
+		return false;
+	}
+
+	data->size -= ptr - data->ptr;
+	data->ptr = ptr;
+	return true;
+}
+
+bool CborDataSkipUntilBreak(CborData *data) {
+	const uint8_t *ptr = CborDataSkipRange(data->ptr, data->ptr + data->size, 0, true, 0);
+	if (!ptr) {
+		return false;
+	}
+
+	data->size -= ptr - data->ptr;
+	data->ptr = ptr;
+	return true;
+}
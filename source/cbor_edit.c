@@ -0,0 +1,780 @@
+
+#include "cbor.h"
+#include "cbor_path.h"
+
+#include <string.h>
+
+// container, that holds edited item
+struct CborEditContainer {
+	const uint8_t *header; // initial byte
+	const uint8_t *first; // first element, right after header
+	const uint8_t *end; // after last element (break byte for indefinite containers)
+	uint8_t major;
+	bool indefinite;
+	uint64_t count; // elements, pairs for map
+};
+
+// bytes [from, to) are replaced with new value (and key from step for new object pair)
+struct CborEditSplice {
+	const uint8_t *from;
+	const uint8_t *to;
+	int delta; // change of container count
+	bool value;
+	bool key;
+};
+
+// read initial byte with argument, returns false for truncated data, reserved values and break
+static bool CborEditReadHeader(CborData *data, uint8_t *initial, uint64_t *value) {
+	uint8_t info;
+	uint32_t len = 0;
+
+	if (data->size == 0) {
+		return false;
+	}
+
+	*initial = *data->ptr;
+	info = *initial & CborFlagsAdditionalInfoMask;
+	if (info >= CborFlagsMaxAdditionalNumber && info <= CborFlagsAdditionalNumber64Bit) {
+		len = 1 << (info - CborFlagsAdditionalNumber8Bit);
+	} else if (info == CborFlagsUndefinedLength) {
+		switch (*initial >> CborFlagsMajorTypeShift) {
+		case CborMajorTypeByteString:
+		case CborMajorTypeCharString:
+		case CborMajorTypeArray:
+		case CborMajorTypeMap:
+			break;
+		default:
+			return false;
+			break;
+		}
+	} else if (info > CborFlagsAdditionalNumber64Bit) {
+		return false;
+	}
+
+	if (data->size <= len) {
+		return false;
+	}
+
+	CborDataOffset(data, 1);
+	*value = CborDataReadUnsignedValue(data, info);
+	return true;
+}
+
+// shortest header, same as written by encoder
+static void CborEditWriteHeader(CborBuffer *out, uint8_t major, uint64_t value) {
+	uint8_t *ptr = (uint8_t *)CborBufferReserve(out, 9);
+	uint32_t i, len;
+
+	major <<= CborFlagsMajorTypeShift;
+	if (value < CborFlagsMaxAdditionalNumber) {
+		ptr[0] = major | (uint8_t)value;
+		len = 0;
+	} else if (value <= UINT8_MAX) {
+		ptr[0] = major | CborFlagsAdditionalNumber8Bit;
+		len = 1;
+	} else if (value <= UINT16_MAX) {
+		ptr[0] = major | CborFlagsAdditionalNumber16Bit;
+		len = 2;
+	} else if (value <= UINT32_MAX) {
+		ptr[0] = major | CborFlagsAdditionalNumber32Bit;
+		len = 4;
+	} else {
+		ptr[0] = major | CborFlagsAdditionalNumber64Bit;
+		len = 8;
+	}
+
+	for (i = len; i > 0; -- i) {
+		ptr[i] = (uint8_t)(value & 0xFF);
+		value >>= 8;
+	}
+	out->size += len + 1;
+}
+
+// container bounds and number of elements, indefinite containers are scanned up to break
+static CborEditStatus CborEditOpen(const CborData *item, struct CborEditContainer *c) {
+	CborData data = *item;
+	uint8_t initial;
+	uint64_t value;
+
+	if (!CborEditReadHeader(&data, &initial, &value)) {
+		return CborEditStatusMalformed;
+	}
+
+	// tagged containers are not traversed, like with CborIteratorGetPath
+	c->major = initial >> CborFlagsMajorTypeShift;
+	if (c->major != CborMajorTypeArray && c->major != CborMajorTypeMap) {
+		return CborEditStatusNotFound;
+	}
+
+	c->header = item->ptr;
+	c->first = data.ptr;
+	c->indefinite = (initial & CborFlagsAdditionalInfoMask) == CborFlagsUndefinedLength;
+	if (c->indefinite) {
+		c->count = 0;
+		while (data.size > 0 && *data.ptr != CborFlagsInterrupt) {
+			if (!CborDataSkipItems(&data, (c->major == CborMajorTypeMap) ? 2 : 1)) {
+				return CborEditStatusMalformed;
+			}
+			++ c->count;
+		}
+		if (data.size == 0) {
+			return CborEditStatusMalformed;
+		}
+	} else {
+		if (value > UINT32_MAX || !CborDataSkipItems(&data, (uint32_t)((c->major == CborMajorTypeMap) ? value * 2 : value))) {
+			return CborEditStatusMalformed;
+		}
+		c->count = value;
+	}
+	c->end = data.ptr;
+	return CborEditStatusOk;
+}
+
+// text or byte string key (definite or chunked) with the same content as step
+static bool CborEditMatchKey(const uint8_t *ptr, const uint8_t *end, const CborData *step) {
+	CborData data = { end - ptr, ptr };
+	const uint8_t *key = step->ptr;
+	uint32_t left = step->size;
+	uint8_t initial, major;
+	uint64_t value;
+
+	if (!CborEditReadHeader(&data, &initial, &value)) {
+		return false;
+	}
+
+	major = initial >> CborFlagsMajorTypeShift;
+	if (major != CborMajorTypeByteString && major != CborMajorTypeCharString) {
+		return false;
+	}
+
+	if ((initial & CborFlagsAdditionalInfoMask) != CborFlagsUndefinedLength) {
+		return value == left && memcmp(data.ptr, key, left) == 0;
+	}
+
+	while (data.size > 0 && *data.ptr != CborFlagsInterrupt) {
+		if (!CborEditReadHeader(&data, &initial, &value) || value > left || value > data.size
+				|| memcmp(data.ptr, key, value) != 0) {
+			return false;
+		}
+		key += value;
+		left -= value;
+		CborDataOffset(&data, (uint32_t)value);
+	}
+	return left == 0;
+}
+
+// first pair with step key: key begin, value begin and value end
+static bool CborEditFindKey(const struct CborEditContainer *c, const CborData *step, const uint8_t **key, const uint8_t **value, const uint8_t **end) {
+	CborData data = { c->end - c->first, c->first };
+	uint64_t i;
+
+	for (i = 0; i < c->count; ++ i) {
+		*key = data.ptr;
+		CborDataSkipItems(&data, 1);
+		*value = data.ptr;
+		CborDataSkipItems(&data, 1);
+		*end = data.ptr;
+		if (CborEditMatchKey(*key, *value, step)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// position of i-th element, container end for i == count
+static const uint8_t *CborEditGetElement(const struct CborEditContainer *c, uint64_t i) {
+	CborData data = { c->end - c->first, c->first };
+
+	if (i >= c->count) {
+		return c->end;
+	}
+	CborDataSkipItems(&data, (uint32_t)i);
+	return data.ptr;
+}
+
+static CborEditStatus CborEditPrepareArray(const struct CborEditContainer *c, const CborPathStep *step, CborEditMode mode, struct CborEditSplice *splice) {
+	long int index = step->index;
+	uint64_t pos;
+
+	if (!step->isIndex) {
+		return CborEditStatusNotFound;
+	}
+
+	// negative index counts from the end, out of range index for set and insert is clamped to array bounds
+	if (index < 0) {
+		index += (long int)c->count;
+	}
+
+	switch (mode) {
+	case CborEditSet:
+	case CborEditReplace:
+	case CborEditDelete:
+		if (index >= 0 && (uint64_t)index < c->count) {
+			splice->from = CborEditGetElement(c, index);
+			splice->to = CborEditGetElement(c, index + 1);
+			splice->delta = 0;
+			splice->value = (mode != CborEditDelete);
+			if (mode == CborEditDelete) {
+				splice->delta = -1;
+			}
+			return CborEditStatusOk;
+		} else if (mode != CborEditSet) {
+			return CborEditStatusNotFound;
+		}
+		pos = (index < 0) ? 0 : c->count;
+		break;
+	default:
+		if (mode == CborEditInsertAfter) {
+			++ index;
+		}
+		pos = (index < 0) ? 0 : (((uint64_t)index > c->count) ? c->count : (uint64_t)index);
+		break;
+	}
+
+	splice->from = splice->to = CborEditGetElement(c, pos);
+	splice->delta = 1;
+	splice->value = true;
+	return CborEditStatusOk;
+}
+
+static CborEditStatus CborEditPrepareMap(const struct CborEditContainer *c, const CborPathStep *step, CborEditMode mode, struct CborEditSplice *splice) {
+	const uint8_t *key, *value, *end;
+
+	if (CborEditFindKey(c, &step->key, &key, &value, &end)) {
+		switch (mode) {
+		case CborEditSet:
+		case CborEditReplace:
+			splice->from = value;
+			splice->to = end;
+			splice->delta = 0;
+			splice->value = true;
+			break;
+		case CborEditDelete:
+			splice->from = key;
+			splice->to = end;
+			splice->delta = -1;
+			splice->value = false;
+			break;
+		default:
+			return CborEditStatusKeyExists;
+			break;
+		}
+		return CborEditStatusOk;
+	}
+
+	if (mode == CborEditReplace || mode == CborEditDelete) {
+		return CborEditStatusNotFound;
+	}
+
+	// new pair is appended
+	splice->from = splice->to = c->end;
+	splice->delta = 1;
+	splice->value = true;
+	splice->key = true;
+	return CborEditStatusOk;
+}
+
+CborEditStatus CborEditPath(CborBuffer *out, const uint8_t *data, size_t size, const CborPath *path, CborEditMode mode, const CborData *value) {
+	struct CborEditContainer c;
+	struct CborEditSplice splice;
+	CborData item = { size, data };
+	const uint8_t *key, *end = NULL;
+	CborEditStatus status;
+	uint32_t i;
+
+	if (data_is_cbor(data, size)) {
+		CborDataOffset(&item, CborHeaderSize);
+		data += CborHeaderSize;
+		size -= CborHeaderSize;
+	}
+
+	if (path->nsteps == 0) {
+		return CborEditStatusNotFound;
+	}
+
+	// only container of edited item is decoded, containers above it are copied as is
+	for (i = 0; i < path->nsteps; ++ i) {
+		const CborPathStep *step = &path->steps[i];
+
+		status = CborEditOpen(&item, &c);
+		if (status != CborEditStatusOk) {
+			return status;
+		}
+
+		if (i + 1 == path->nsteps) {
+			break;
+		}
+
+		if (c.major == CborMajorTypeMap) {
+			if (!CborEditFindKey(&c, &step->key, &key, &item.ptr, &end)) {
+				return CborEditStatusNotFound;
+			}
+		} else {
+			long int index = (step->index < 0) ? step->index + (long int)c.count : step->index;
+
+			if (!step->isIndex || index < 0 || (uint64_t)index >= c.count) {
+				return CborEditStatusNotFound;
+			}
+			item.ptr = CborEditGetElement(&c, index);
+			end = CborEditGetElement(&c, index + 1);
+		}
+		item.size = end - item.ptr;
+	}
+
+	memset(&splice, 0, sizeof(struct CborEditSplice));
+	status = (c.major == CborMajorTypeMap)
+		? CborEditPrepareMap(&c, &path->steps[path->nsteps - 1], mode, &splice)
+		: CborEditPrepareArray(&c, &path->steps[path->nsteps - 1], mode, &splice);
+	if (status != CborEditStatusOk) {
+		return status;
+	}
+
+	// value should be exactly one complete item, otherwise result is not well-formed
+	if (splice.value) {
+		CborData rest;
+
+		if (!value || value->size == 0) {
+			return CborEditStatusMalformed;
+		}
+		rest = *value;
+		if (!CborDataSkipItems(&rest, 1) || rest.size != 0) {
+			return CborEditStatusMalformed;
+		}
+	}
+
+	CborBufferReserve(out, size + (value ? value->size : 0) + path->steps[path->nsteps - 1].key.size + 18);
+
+	// indefinite containers have no count within header
+	CborBufferWrite(out, (const char *)data, c.header - data);
+	if (splice.delta != 0 && !c.indefinite) {
+		CborEditWriteHeader(out, c.major, c.count + splice.delta);
+	} else {
+		CborBufferWrite(out, (const char *)c.header, c.first - c.header);
+	}
+	CborBufferWrite(out, (const char *)c.first, splice.from - c.first);
+
+	if (splice.key) {
+		CborEditWriteHeader(out, CborMajorTypeCharString, path->steps[path->nsteps - 1].key.size);
+		CborBufferWrite(out, (const char *)path->steps[path->nsteps - 1].key.ptr, path->steps[path->nsteps - 1].key.size);
+	}
+	if (splice.value) {
+		CborBufferWrite(out, (const char *)value->ptr, value->size);
+	}
+
+	CborBufferWrite(out, (const char *)splice.to, (data + size) - splice.to);
+	return CborEditStatusOk;
+}
+
+#define CBOR_MERGE_MAX_DEPTH 512
+
+// map key with comparable form: type byte and content, like normalized scalar
+struct CborMergeKey {
+	uint8_t type;
+	CborData form;
+	size_t offset; // form offset within normalized keys buffer
+	bool normalized;
+	const uint8_t *key;
+	const uint8_t *value;
+	const uint8_t *end;
+	uint32_t index;
+	bool matched;
+	bool duplicate; // same key was found earlier within patch
+};
+
+// target pair with key from patch
+struct CborMergeMatch {
+	const uint8_t *key;
+	const uint8_t *value;
+	const uint8_t *end;
+	const struct CborMergeKey *patch;
+};
+
+struct CborMergeContext {
+	CborBuffer *out;
+	CborBuffer scratch; // normalized form for target key
+	bool recursive; // RFC 7396: nested maps are merged, null removes key
+	uint32_t depth;
+};
+
+static const uint8_t CborMergeNull = CborMajorTypeEncodedSimple | CborSimpleValueNull;
+
+// definite strings are compared in place, other keys are normalized into buffer (see CborNormalizeScalar)
+static void CborMergeKeyForm(CborBuffer *buf, struct CborMergeKey *k) {
+	CborData data = { k->value - k->key, k->key };
+	uint8_t initial, major;
+	uint64_t value;
+
+	major = *k->key >> CborFlagsMajorTypeShift;
+	if ((major == CborMajorTypeByteString || major == CborMajorTypeCharString)
+			&& (*k->key & CborFlagsAdditionalInfoMask) != CborFlagsUndefinedLength
+			&& CborEditReadHeader(&data, &initial, &value) && value <= data.size) {
+		k->type = (major == CborMajorTypeByteString) ? CBOR_SCALAR_BYTES : CBOR_SCALAR_STRING;
+		k->form.ptr = data.ptr;
+		k->form.size = (uint32_t)value;
+		k->normalized = false;
+		return;
+	}
+
+	k->offset = buf->size;
+	if (CborNormalizeScalar(&data, buf)) {
+		k->type = (uint8_t)buf->data[k->offset];
+		k->offset += 1;
+		k->form.size = buf->size - k->offset;
+		k->normalized = true;
+	} else {
+		// containers as keys are compared by encoding
+		buf->size = k->offset;
+		k->type = 0;
+		k->form = data;
+		k->normalized = false;
+	}
+}
+
+static int CborMergeCompareForm(const struct CborMergeKey *a, const struct CborMergeKey *b) {
+	int ret;
+
+	if (a->type != b->type) {
+		return (a->type < b->type) ? -1 : 1;
+	}
+	ret = memcmp(a->form.ptr, b->form.ptr, (a->form.size < b->form.size) ? a->form.size : b->form.size);
+	if (ret == 0 && a->form.size != b->form.size) {
+		ret = (a->form.size < b->form.size) ? -1 : 1;
+	}
+	return ret;
+}
+
+static int CborMergeCompareKeys(const void *a, const void *b) {
+	const struct CborMergeKey *ka = *(const struct CborMergeKey **)a;
+	const struct CborMergeKey *kb = *(const struct CborMergeKey **)b;
+	int ret = CborMergeCompareForm(ka, kb);
+
+	if (ret == 0) {
+		ret = (ka->index < kb->index) ? -1 : 1;
+	}
+	return ret;
+}
+
+// first patch key with the same form, duplicates are sorted after it
+static struct CborMergeKey *CborMergeFindKey(struct CborMergeKey **sorted, uint32_t n, const struct CborMergeKey *k) {
+	uint32_t lo = 0, hi = n, mid;
+
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (CborMergeCompareForm(sorted[mid], k) < 0) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	return (lo < n && CborMergeCompareForm(sorted[lo], k) == 0) ? sorted[lo] : NULL;
+}
+
+static bool CborMergeValue(struct CborMergeContext *ctx, const CborData *target, const CborData *patch);
+
+/* Pairs of target are copied by byte ranges, only values for keys from patch are written;
+ * target can be NULL, when patch is applied to empty map */
+static bool CborMergeMap(struct CborMergeContext *ctx, const struct CborEditContainer *target, const struct CborEditContainer *patch) {
+	struct CborMergeKey *keys = NULL, **sorted = NULL, tkey;
+	struct CborMergeMatch *matches = NULL;
+	uint32_t nmatches = 0, matchesCapacity = 0, i;
+	uint64_t count = target ? target->count : 0;
+	CborData data, tvalue, pvalue;
+	const uint8_t *ptr;
+	CborBuffer forms;
+	bool hasForms = false, ret = false;
+
+	if (patch->count > UINT32_MAX / 2) {
+		return false;
+	}
+
+	if (patch->count > 0) {
+		keys = CborAlloc(patch->count * sizeof(struct CborMergeKey));
+		sorted = CborAlloc(patch->count * sizeof(struct CborMergeKey *));
+		CborBufferInit(&forms, 0, 0);
+		hasForms = true;
+
+		data.ptr = patch->first;
+		data.size = patch->end - patch->first;
+		for (i = 0; i < patch->count; ++ i) {
+			keys[i].key = data.ptr;
+			CborDataSkipItems(&data, 1);
+			keys[i].value = data.ptr;
+			CborDataSkipItems(&data, 1);
+			keys[i].end = data.ptr;
+			keys[i].index = i;
+			keys[i].matched = false;
+			keys[i].duplicate = false;
+
+			CborMergeKeyForm(&forms, &keys[i]);
+			sorted[i] = &keys[i];
+		}
+
+		// buffer is complete, so normalized forms can be addressed directly
+		for (i = 0; i < patch->count; ++ i) {
+			if (keys[i].normalized) {
+				keys[i].form.ptr = (const uint8_t *)forms.data + keys[i].offset;
+			}
+		}
+
+		qsort(sorted, patch->count, sizeof(struct CborMergeKey *), CborMergeCompareKeys);
+		for (i = 1; i < patch->count; ++ i) {
+			if (CborMergeCompareForm(sorted[i - 1], sorted[i]) == 0) {
+				sorted[i]->duplicate = true;
+			}
+		}
+	}
+
+	// every target pair with key from patch is matched, other pairs are copied as is
+	if (target && patch->count > 0) {
+		data.ptr = target->first;
+		data.size = target->end - target->first;
+		for (i = 0; i < target->count; ++ i) {
+			struct CborMergeKey *k;
+
+			tkey.key = data.ptr;
+			CborDataSkipItems(&data, 1);
+			tkey.value = data.ptr;
+			CborDataSkipItems(&data, 1);
+			tkey.end = data.ptr;
+
+			ctx->scratch.size = 0;
+			CborMergeKeyForm(&ctx->scratch, &tkey);
+			if (tkey.normalized) {
+				tkey.form.ptr = (const uint8_t *)ctx->scratch.data + tkey.offset;
+			}
+
+			k = CborMergeFindKey(sorted, (uint32_t)patch->count, &tkey);
+			if (k) {
+				if (nmatches == matchesCapacity) {
+					matchesCapacity = matchesCapacity ? matchesCapacity * 2 : 8;
+					matches = matches ? CborRealloc(matches, matchesCapacity * sizeof(struct CborMergeMatch))
+							: CborAlloc(matchesCapacity * sizeof(struct CborMergeMatch));
+				}
+				matches[nmatches].key = tkey.key;
+				matches[nmatches].value = tkey.value;
+				matches[nmatches].end = tkey.end;
+				matches[nmatches].patch = k;
+				++ nmatches;
+				k->matched = true;
+				if (ctx->recursive && *k->value == CborMergeNull) {
+					-- count;
+				}
+			}
+		}
+	}
+
+	for (i = 0; i < patch->count; ++ i) {
+		if (!keys[i].matched && !keys[i].duplicate && !(ctx->recursive && *keys[i].value == CborMergeNull)) {
+			++ count;
+		}
+	}
+
+	// header is rewritten only when number of keys is changed
+	if (target && (target->indefinite || count == target->count)) {
+		CborBufferWrite(ctx->out, (const char *)target->header, target->first - target->header);
+	} else {
+		CborEditWriteHeader(ctx->out, CborMajorTypeMap, count);
+	}
+
+	if (target) {
+		ptr = target->first;
+		for (i = 0; i < nmatches; ++ i) {
+			CborBufferWrite(ctx->out, (const char *)ptr, matches[i].key - ptr);
+			ptr = matches[i].end;
+			if (ctx->recursive && *matches[i].patch->value == CborMergeNull) {
+				continue;
+			}
+
+			CborBufferWrite(ctx->out, (const char *)matches[i].key, matches[i].value - matches[i].key);
+			pvalue.ptr = matches[i].patch->value;
+			pvalue.size = matches[i].patch->end - pvalue.ptr;
+			if (ctx->recursive) {
+				tvalue.ptr = matches[i].value;
+				tvalue.size = matches[i].end - tvalue.ptr;
+				if (!CborMergeValue(ctx, &tvalue, &pvalue)) {
+					goto cleanup;
+				}
+			} else {
+				CborBufferWrite(ctx->out, (const char *)pvalue.ptr, pvalue.size);
+			}
+		}
+		CborBufferWrite(ctx->out, (const char *)ptr, target->end - ptr);
+	}
+
+	// new keys in patch order
+	for (i = 0; i < patch->count; ++ i) {
+		if (keys[i].matched || keys[i].duplicate || (ctx->recursive && *keys[i].value == CborMergeNull)) {
+			continue;
+		}
+
+		pvalue.ptr = keys[i].value;
+		pvalue.size = keys[i].end - pvalue.ptr;
+		CborBufferWrite(ctx->out, (const char *)keys[i].key, keys[i].value - keys[i].key);
+		if (ctx->recursive) {
+			if (!CborMergeValue(ctx, NULL, &pvalue)) {
+				goto cleanup;
+			}
+		} else {
+			CborBufferWrite(ctx->out, (const char *)pvalue.ptr, pvalue.size);
+		}
+	}
+
+	if (target && target->indefinite) {
+		CborBufferWriteChar(ctx->out, (char)CborFlagsInterrupt);
+	}
+	ret = true;
+
+cleanup:
+	if (hasForms) {
+		CborBufferFinalize(&forms);
+	}
+	if (matches) {
+		CborFree(matches);
+	}
+	if (keys) {
+		CborFree(keys);
+		CborFree(sorted);
+	}
+	return ret;
+}
+
+// RFC 7396 MergePatch: patch map is merged into target map (or empty map), other patch values replace target
+static bool CborMergeValue(struct CborMergeContext *ctx, const CborData *target, const CborData *patch) {
+	struct CborEditContainer t, p;
+	CborEditStatus status;
+	bool ret;
+
+	status = CborEditOpen(patch, &p);
+	if (status == CborEditStatusMalformed) {
+		return false;
+	} else if (status != CborEditStatusOk || p.major != CborMajorTypeMap) {
+		CborBufferWrite(ctx->out, (const char *)patch->ptr, patch->size);
+		return true;
+	}
+
+	if (ctx->depth >= CBOR_MERGE_MAX_DEPTH) {
+		return false;
+	}
+
+	if (target) {
+		status = CborEditOpen(target, &t);
+		if (status == CborEditStatusMalformed) {
+			return false;
+		}
+	}
+
+	++ ctx->depth;
+	ret = CborMergeMap(ctx, (target && status == CborEditStatusOk && t.major == CborMajorTypeMap) ? &t : NULL, &p);
+	-- ctx->depth;
+	return ret;
+}
+
+// single root item, magic header is skipped
+static bool CborMergeGetRoot(const uint8_t *data, size_t size, CborData *item) {
+	CborData tmp;
+
+	item->ptr = data;
+	item->size = (uint32_t)size;
+	if (data_is_cbor(data, size)) {
+		CborDataOffset(item, CborHeaderSize);
+	}
+
+	tmp = *item;
+	if (item->size == 0 || !CborDataSkipItems(&tmp, 1)) {
+		return false;
+	}
+	item->size = tmp.ptr - item->ptr;
+	return true;
+}
+
+bool CborMergePatch(CborBuffer *out, const uint8_t *target, size_t tsize, const uint8_t *patch, size_t psize) {
+	struct CborMergeContext ctx;
+	CborData t, p;
+	bool ret;
+
+	if (!CborMergeGetRoot(target, tsize, &t) || !CborMergeGetRoot(patch, psize, &p)) {
+		return false;
+	}
+
+	ctx.out = out;
+	ctx.recursive = true;
+	ctx.depth = 0;
+	CborBufferInit(&ctx.scratch, 0, 0);
+
+	ret = CborMergeValue(&ctx, &t, &p);
+
+	CborBufferFinalize(&ctx.scratch);
+	return ret;
+}
+
+bool CborConcat(CborBuffer *out, const uint8_t *a, size_t asize, const uint8_t *b, size_t bsize) {
+	struct CborMergeContext ctx;
+	struct CborEditContainer ca, cb;
+	CborEditStatus astatus, bstatus;
+	CborData da, db;
+	bool ret;
+
+	if (!CborMergeGetRoot(a, asize, &da) || !CborMergeGetRoot(b, bsize, &db)) {
+		return false;
+	}
+
+	astatus = CborEditOpen(&da, &ca);
+	bstatus = CborEditOpen(&db, &cb);
+	if (astatus == CborEditStatusMalformed || bstatus == CborEditStatusMalformed) {
+		return false;
+	}
+
+	CborBufferReserve(out, da.size + db.size + 18);
+
+	// object || object: keys of right object replace keys of left object
+	if (astatus == CborEditStatusOk && bstatus == CborEditStatusOk
+			&& ca.major == CborMajorTypeMap && cb.major == CborMajorTypeMap) {
+		ctx.out = out;
+		ctx.recursive = false;
+		ctx.depth = 0;
+		CborBufferInit(&ctx.scratch, 0, 0);
+		ret = CborMergeMap(&ctx, &ca, &cb);
+		CborBufferFinalize(&ctx.scratch);
+		return ret;
+	}
+
+	// arrays are joined, other values are appended or prepended as elements
+	if (astatus == CborEditStatusOk && ca.major == CborMajorTypeArray) {
+		if (bstatus == CborEditStatusOk && cb.major == CborMajorTypeArray) {
+			if (ca.indefinite) {
+				CborBufferWrite(out, (const char *)ca.header, ca.first - ca.header);
+			} else {
+				CborEditWriteHeader(out, CborMajorTypeArray, ca.count + cb.count);
+			}
+			CborBufferWrite(out, (const char *)ca.first, ca.end - ca.first);
+			CborBufferWrite(out, (const char *)cb.first, cb.end - cb.first);
+		} else {
+			if (ca.indefinite) {
+				CborBufferWrite(out, (const char *)ca.header, ca.first - ca.header);
+			} else {
+				CborEditWriteHeader(out, CborMajorTypeArray, ca.count + 1);
+			}
+			CborBufferWrite(out, (const char *)ca.first, ca.end - ca.first);
+			CborBufferWrite(out, (const char *)db.ptr, db.size);
+		}
+		if (ca.indefinite) {
+			CborBufferWriteChar(out, (char)CborFlagsInterrupt);
+		}
+	} else if (bstatus == CborEditStatusOk && cb.major == CborMajorTypeArray) {
+		if (cb.indefinite) {
+			CborBufferWrite(out, (const char *)cb.header, cb.first - cb.header);
+		} else {
+			CborEditWriteHeader(out, CborMajorTypeArray, cb.count + 1);
+		}
+		CborBufferWrite(out, (const char *)da.ptr, da.size);
+		CborBufferWrite(out, (const char *)cb.first, cb.end - cb.first);
+		if (cb.indefinite) {
+			CborBufferWriteChar(out, (char)CborFlagsInterrupt);
+		}
+	} else {
+		CborEditWriteHeader(out, CborMajorTypeArray, 2);
+		CborBufferWrite(out, (const char *)da.ptr, da.size);
+		CborBufferWrite(out, (const char *)db.ptr, db.size);
+	}
+	return true;
+}
@@ -0,0 +1,324 @@
+
+#include "cbor_alloc.h"
+#include "cbor_encoder.h"
+
+#include <math.h>
+#include <string.h>
+
+#define CBOR_ENCODER_INITIAL_CAPACITY 256
+
+static inline uint32_t CborEncoderHeaderSize(uint64_t value) {
+	if (value < CborFlagsMaxAdditionalNumber) {
+		return 1;
+	} else if (value <= UINT8_MAX) {
+		return 2;
+	} else if (value <= UINT16_MAX) {
+		return 3;
+	} else if (value <= UINT32_MAX) {
+		return 5;
+	}
+	return 9;
+}
+
+// write header with shortest argument, buffer should have enough space
+static inline uint8_t *CborEncoderPutHeader(uint8_t *ptr, uint8_t major, uint64_t value) {
+	uint32_t i, len;
+
+	major <<= CborFlagsMajorTypeShift;
+	len = CborEncoderHeaderSize(value) - 1;
+	switch (len) {
+	case 0: *ptr = major | (uint8_t)value; break;
+	case 1: *ptr = major | CborFlagsAdditionalNumber8Bit; break;
+	case 2: *ptr = major | CborFlagsAdditionalNumber16Bit; break;
+	case 4: *ptr = major | CborFlagsAdditionalNumber32Bit; break;
+	default: *ptr = major | CborFlagsAdditionalNumber64Bit; break;
+	}
+
+	// network byte order
+	for (i = len; i > 0; -- i) {
+		ptr[i] = (uint8_t)(value & 0xFF);
+		value >>= 8;
+	}
+	return ptr + len + 1;
+}
+
+static void *CborEncoderGrow(void *ptr, size_t *capacity, size_t required, size_t elt) {
+	size_t cap = *capacity ? *capacity : CBOR_ENCODER_INITIAL_CAPACITY / elt;
+	while (cap < required) {
+		cap *= 2;
+	}
+
+	if (cap != *capacity || !ptr) {
+		ptr = ptr ? CborRealloc(ptr, cap * elt) : CborAlloc(cap * elt);
+		*capacity = cap;
+	}
+	return ptr;
+}
+
+// item is written at current level: count it within container, tag and its content counts as single item
+static inline void CborEncoderItem(CborEncoder *enc) {
+	if (enc->tagged) {
+		enc->tagged = false;
+	} else if (enc->stackSize > 0) {
+		++ enc->stack[enc->stackSize - 1].items;
+	}
+}
+
+static inline void CborEncoderWriteHeader(CborEncoder *enc, uint8_t major, uint64_t value) {
+	CborEncoderReserve(enc, 9);
+	enc->size = CborEncoderPutHeader(enc->data + enc->size, major, value) - enc->data;
+}
+
+static inline void CborEncoderWriteByte(CborEncoder *enc, uint8_t byte) {
+	CborEncoderReserve(enc, 1);
+	enc->data[enc->size ++] = byte;
+}
+
+static inline void CborEncoderWriteBigEndian(CborEncoder *enc, uint8_t byte, uint64_t value, uint32_t len) {
+	uint32_t i;
+	uint8_t *ptr;
+
+	CborEncoderReserve(enc, len + 1);
+	ptr = enc->data + enc->size;
+	*ptr = byte;
+	for (i = len; i > 0; -- i) {
+		ptr[i] = (uint8_t)(value & 0xFF);
+		value >>= 8;
+	}
+	enc->size += len + 1;
+}
+
+void CborEncoderInit(CborEncoder *enc, size_t reserved, bool header) {
+	memset(enc, 0, sizeof(CborEncoder));
+
+	enc->data = CborEncoderGrow(NULL, &enc->capacity, reserved + CborHeaderSize + 1, sizeof(uint8_t));
+	enc->size = reserved;
+	enc->reserved = reserved;
+
+	if (header) {
+		memcpy(enc->data + enc->size, CborHeaderData, CborHeaderSize);
+		enc->size += CborHeaderSize;
+	}
+}
+
+void CborEncoderFinalize(CborEncoder *enc) {
+	if (enc->data) {
+		CborFree(enc->data);
+	}
+	if (enc->stack) {
+		CborFree(enc->stack);
+	}
+	memset(enc, 0, sizeof(CborEncoder));
+}
+
+void CborEncoderReserve(CborEncoder *enc, size_t size) {
+	if (enc->size + size > enc->capacity) {
+		enc->data = CborEncoderGrow(enc->data, &enc->capacity, enc->size + size, sizeof(uint8_t));
+	}
+}
+
+bool CborEncoderIsComplete(const CborEncoder *enc) {
+	CborData data = CborEncoderGetData(enc);
+	return enc->stackSize == 0 && !enc->tagged && data.size > 0
+			&& !(data.size == CborHeaderSize && memcmp(data.ptr, CborHeaderData, CborHeaderSize) == 0);
+}
+
+uint8_t *CborEncoderRelease(CborEncoder *enc, size_t *size) {
+	uint8_t *ret;
+
+	if (enc->stackSize > 0 || enc->tagged) {
+		return NULL;
+	}
+
+	ret = enc->data;
+	if (size) {
+		*size = enc->size;
+	}
+
+	enc->data = NULL;
+	CborEncoderFinalize(enc);
+	return ret;
+}
+
+void CborEncodeUnsigned(CborEncoder *enc, uint64_t value) {
+	CborEncoderItem(enc);
+	CborEncoderWriteHeader(enc, CborMajorTypeUnsigned, value);
+}
+
+void CborEncodeNegative(CborEncoder *enc, uint64_t value) {
+	CborEncoderItem(enc);
+	CborEncoderWriteHeader(enc, CborMajorTypeNegative, value);
+}
+
+void CborEncodeInteger(CborEncoder *enc, int64_t value) {
+	if (value >= 0) {
+		CborEncodeUnsigned(enc, (uint64_t)value);
+	} else {
+		// -1 - value without overflow for INT64_MIN
+		CborEncodeNegative(enc, ~(uint64_t)value);
+	}
+}
+
+void CborEncodeFloat(CborEncoder *enc, double value) {
+	float f = (float)value;
+	uint32_t u32;
+	uint16_t half;
+
+	if (isnan(value)) {
+		// canonical quiet NaN, payload is not preserved
+		CborEncoderItem(enc);
+		CborEncoderWriteBigEndian(enc, CborMajorTypeEncodedSimple | CborFlagsAdditionalFloat16Bit, 0x7e00, 2);
+		return;
+	}
+
+	if ((double)f != value) {
+		CborEncodeDouble(enc, value);
+		return;
+	}
+
+	CborEncoderItem(enc);
+
+	half = CborDataEncodeFloat16(f);
+	if (CborDataDecodeFloat16(half) == f) {
+		CborEncoderWriteBigEndian(enc, CborMajorTypeEncodedSimple | CborFlagsAdditionalFloat16Bit, half, 2);
+		return;
+	}
+
+	memcpy(&u32, &f, sizeof(uint32_t));
+	CborEncoderWriteBigEndian(enc, CborMajorTypeEncodedSimple | CborFlagsAdditionalFloat32Bit, u32, 4);
+}
+
+void CborEncodeDouble(CborEncoder *enc, double value) {
+	uint64_t u64;
+
+	CborEncoderItem(enc);
+	memcpy(&u64, &value, sizeof(uint64_t));
+	CborEncoderWriteBigEndian(enc, CborMajorTypeEncodedSimple | CborFlagsAdditionalFloat64Bit, u64, 8);
+}
+
+void CborEncodeBool(CborEncoder *enc, bool value) {
+	CborEncodeSimple(enc, value ? CborSimpleValueTrue : CborSimpleValueFalse);
+}
+
+void CborEncodeNull(CborEncoder *enc) {
+	CborEncodeSimple(enc, CborSimpleValueNull);
+}
+
+void CborEncodeUndefined(CborEncoder *enc) {
+	CborEncodeSimple(enc, CborSimpleValueUndefined);
+}
+
+void CborEncodeSimple(CborEncoder *enc, uint8_t value) {
+	CborEncoderItem(enc);
+	if (value < CborFlagsMaxAdditionalNumber) {
+		CborEncoderWriteByte(enc, CborMajorTypeEncodedSimple | value);
+	} else {
+		CborEncoderWriteBigEndian(enc, CborMajorTypeEncodedSimple | CborFlagsSimple8Bit, value, 1);
+	}
+}
+
+static void CborEncodeStringData(CborEncoder *enc, uint8_t major, const uint8_t *data, size_t size) {
+	CborEncoderItem(enc);
+	CborEncoderReserve(enc, size + 9);
+	enc->size = CborEncoderPutHeader(enc->data + enc->size, major, size) - enc->data;
+	if (size > 0) {
+		memcpy(enc->data + enc->size, data, size);
+		enc->size += size;
+	}
+}
+
+void CborEncodeBytes(CborEncoder *enc, const uint8_t *data, size_t size) {
+	CborEncodeStringData(enc, CborMajorTypeByteString, data, size);
+}
+
+void CborEncodeString(CborEncoder *enc, const char *data, size_t size) {
+	CborEncodeStringData(enc, CborMajorTypeCharString, (const uint8_t *)data, size);
+}
+
+void CborEncodeTag(CborEncoder *enc, uint64_t tag) {
+	CborEncoderItem(enc);
+	CborEncoderWriteHeader(enc, CborMajorTypeTag, tag);
+	enc->tagged = true;
+}
+
+static void CborEncodeBegin(CborEncoder *enc, uint8_t major, uint32_t count) {
+	CborEncoderFrame *frame;
+
+	CborEncoderItem(enc);
+
+	if (enc->stackSize == enc->stackCapacity) {
+		enc->stack = CborEncoderGrow(enc->stack, &enc->stackCapacity, enc->stackSize + 1, sizeof(CborEncoderFrame));
+	}
+
+	frame = &enc->stack[enc->stackSize ++];
+	frame->offset = enc->size;
+	frame->count = count;
+	frame->items = 0;
+	frame->major = major;
+
+	if (count == CBOR_ENCODER_INDEFINITE) {
+		CborEncoderWriteByte(enc, (major << CborFlagsMajorTypeShift) | CborFlagsUndefinedLength);
+	} else if (count == CBOR_ENCODER_UNKNOWN_COUNT) {
+		// placeholder for short header, moved on end if count does not fit
+		CborEncoderWriteByte(enc, major << CborFlagsMajorTypeShift);
+	} else {
+		CborEncoderWriteHeader(enc, major, count);
+	}
+}
+
+void CborEncodeBeginArray(CborEncoder *enc, uint32_t count) {
+	CborEncodeBegin(enc, CborMajorTypeArray, count);
+}
+
+void CborEncodeBeginMap(CborEncoder *enc, uint32_t count) {
+	CborEncodeBegin(enc, CborMajorTypeMap, count);
+}
+
+bool CborEncodeEnd(CborEncoder *enc) {
+	CborEncoderFrame *frame;
+	uint64_t count;
+	uint32_t len;
+
+	if (enc->stackSize == 0 || enc->tagged) {
+		return false;
+	}
+
+	// container is closed only after checks, so failed call leaves encoder state unchanged
+	frame = &enc->stack[enc->stackSize - 1];
+	if (frame->major == CborMajorTypeMap && (frame->items & 1)) {
+		return false;
+	}
+
+	count = (frame->major == CborMajorTypeMap) ? frame->items / 2 : frame->items;
+	if (frame->count != CBOR_ENCODER_INDEFINITE && frame->count != CBOR_ENCODER_UNKNOWN_COUNT && count != frame->count) {
+		return false;
+	}
+
+	-- enc->stackSize;
+	switch (frame->count) {
+	case CBOR_ENCODER_INDEFINITE:
+		CborEncoderWriteByte(enc, CborFlagsInterrupt);
+		break;
+	case CBOR_ENCODER_UNKNOWN_COUNT:
+		len = CborEncoderHeaderSize(count);
+		if (len > 1) {
+			// shift container content to fit longer header
+			CborEncoderReserve(enc, len - 1);
+			memmove(enc->data + frame->offset + len, enc->data + frame->offset + 1, enc->size - frame->offset - 1);
+			enc->size += len - 1;
+		}
+		CborEncoderPutHeader(enc->data + frame->offset, frame->major, count);
+		break;
+	default:
+		break;
+	}
+
+	return true;
+}
+
+void CborEncodeRaw(CborEncoder *enc, const uint8_t *data, size_t size) {
+	CborEncoderItem(enc);
+	CborEncoderReserve(enc, size);
+	memcpy(enc->data + enc->size, data, size);
+	enc->size += size;
+}
@@ -0,0 +1,201 @@
+
+#include "cbor.h"
+
+#include <string.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSSE3__)
+#include <tmmintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+static const char CborHexTable[] = "0123456789abcdef";
+static const char CborBase64Table[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+static const char CborBase64UrlTable[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+#if defined(__SSE2__)
+// nibbles into hex digits: n + '0', plus ('a' - '0' - 10) for n > 9
+static inline __m128i CborHexNibbles(__m128i n) {
+	__m128i letters = _mm_and_si128(_mm_cmpgt_epi8(n, _mm_set1_epi8(9)), _mm_set1_epi8('a' - '0' - 10));
+	return _mm_add_epi8(_mm_add_epi8(n, _mm_set1_epi8('0')), letters);
+}
+#endif
+
+size_t CborHexEncode(char *out, const uint8_t *data, size_t size) {
+	char *ptr = out;
+
+#if defined(__SSE2__)
+	const __m128i mask = _mm_set1_epi8(0x0F);
+	while (size >= 16) {
+		__m128i v = _mm_loadu_si128((const __m128i *)data);
+		__m128i hi = CborHexNibbles(_mm_and_si128(_mm_srli_epi16(v, 4), mask));
+		__m128i lo = CborHexNibbles(_mm_and_si128(v, mask));
+		_mm_storeu_si128((__m128i *)ptr, _mm_unpacklo_epi8(hi, lo));
+		_mm_storeu_si128((__m128i *)(ptr + 16), _mm_unpackhi_epi8(hi, lo));
+		data += 16;
+		size -= 16;
+		ptr += 32;
+	}
+#endif
+
+	while (size > 0) {
+		*ptr ++ = CborHexTable[*data >> 4];
+		*ptr ++ = CborHexTable[*data & 0x0F];
+		++ data;
+		-- size;
+	}
+
+	return ptr - out;
+}
+
+#if defined(__SSSE3__)
+/* Vector base64, as described by Wojciech Muła: 12 input bytes are spread into 16 lanes
+ * with shuffle, 6-bit groups are moved into place with multiplications, then translated
+ * into alphabet with per-range offsets. Only last two alphabet offsets differ for base64url */
+static inline __m128i CborBase64Reshuffle(__m128i in) {
+	__m128i t0, t1, t2, t3;
+
+	in = _mm_shuffle_epi8(in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+
+	t0 = _mm_and_si128(in, _mm_set1_epi32(0x0FC0FC00));
+	t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+	t2 = _mm_and_si128(in, _mm_set1_epi32(0x003F03F0));
+	t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+
+	return _mm_or_si128(t1, t3);
+}
+
+static inline __m128i CborBase64Translate(__m128i in, __m128i offsets) {
+	__m128i indices = _mm_subs_epu8(in, _mm_set1_epi8(51));
+	__m128i mask = _mm_cmpgt_epi8(in, _mm_set1_epi8(25));
+	indices = _mm_sub_epi8(indices, mask);
+	return _mm_add_epi8(in, _mm_shuffle_epi8(offsets, indices));
+}
+#endif
+
+static size_t CborBase64EncodeTable(char *out, const uint8_t *data, size_t size, const char *table, bool padding) {
+	char *ptr = out;
+
+#if defined(__SSSE3__)
+	// offsets for ranges A-Z, a-z, 0-9 and two last symbols
+	const __m128i offsets = (table == CborBase64UrlTable)
+		? _mm_setr_epi8(65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -17, 32, 0, 0)
+		: _mm_setr_epi8(65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -19, -16, 0, 0);
+
+	// every iteration consumes 12 bytes, but loads 16
+	while (size >= 16) {
+		__m128i v = _mm_loadu_si128((const __m128i *)data);
+		_mm_storeu_si128((__m128i *)ptr, CborBase64Translate(CborBase64Reshuffle(v), offsets));
+		data += 12;
+		size -= 12;
+		ptr += 16;
+	}
+#endif
+
+	while (size >= 3) {
+		*ptr ++ = table[data[0] >> 2];
+		*ptr ++ = table[((data[0] & 0x03) << 4) | (data[1] >> 4)];
+		*ptr ++ = table[((data[1] & 0x0f) << 2) | (data[2] >> 6)];
+		*ptr ++ = table[data[2] & 0x3f];
+		data += 3;
+		size -= 3;
+	}
+
+	if (size > 0) {
+		*ptr ++ = table[data[0] >> 2];
+		if (size == 1) {
+			*ptr ++ = table[(data[0] & 0x03) << 4];
+			if (padding) {
+				*ptr ++ = '=';
+			}
+		} else {
+			*ptr ++ = table[((data[0] & 0x03) << 4) | (data[1] >> 4)];
+			*ptr ++ = table[(data[1] & 0x0f) << 2];
+		}
+		if (padding) {
+			*ptr ++ = '=';
+		}
+	}
+
+	return ptr - out;
+}
+
+size_t CborBase64Encode(char *out, const uint8_t *data, size_t size) {
+	return CborBase64EncodeTable(out, data, size, CborBase64Table, true);
+}
+
+size_t CborBase64UrlEncode(char *out, const uint8_t *data, size_t size) {
+	return CborBase64EncodeTable(out, data, size, CborBase64UrlTable, false);
+}
+
+size_t CborByteEncodingSize(CborByteEncoding encoding, size_t size) {
+	switch (encoding) {
+	case CborByteEncodingHex: return size * 2; break;
+	case CborByteEncodingBase64: return (size + 2) / 3 * 4; break;
+	case CborByteEncodingBase64Url: return (size + 2) / 3 * 4; break;
+	}
+	return 0;
+}
+
+size_t CborByteEncode(CborByteEncoding encoding, char *out, const uint8_t *data, size_t size) {
+	switch (encoding) {
+	case CborByteEncodingHex: return CborHexEncode(out, data, size); break;
+	case CborByteEncodingBase64: return CborBase64Encode(out, data, size); break;
+	case CborByteEncodingBase64Url: return CborBase64UrlEncode(out, data, size); break;
+	}
+	return 0;
+}
+
+void CborByteEncodingScopeInit(CborByteEncodingScope *scope, CborByteEncoding encoding) {
+	memset(scope, 0, sizeof(CborByteEncodingScope));
+	scope->defaultEncoding = encoding;
+}
+
+CborByteEncoding CborByteEncodingScopeNext(CborByteEncodingScope *scope, const CborIteratorContext *iter) {
+	CborByteEncoding ret;
+
+	// scopes of closed containers
+	while (scope->nscopes > 0 && scope->scopes[scope->nscopes - 1].depth > iter->stackSize) {
+		-- scope->nscopes;
+	}
+
+	ret = (scope->nscopes > 0) ? scope->scopes[scope->nscopes - 1].encoding : scope->defaultEncoding;
+
+	switch (iter->token) {
+	case CborIteratorTokenKey:
+	case CborIteratorTokenValue:
+		if (CborIteratorGetType(iter) == CborTypeTag) {
+			switch (CborIteratorGetUnsigned(iter)) {
+			case CborTagExpectedBase64Url: scope->pending = CborByteEncodingBase64Url; scope->hasPending = true; break;
+			case CborTagExpectedBase64: scope->pending = CborByteEncodingBase64; scope->hasPending = true; break;
+			case CborTagExpectedBase16: scope->pending = CborByteEncodingHex; scope->hasPending = true; break;
+			default: break;
+			}
+		} else if (scope->hasPending) {
+			ret = scope->pending;
+			scope->hasPending = false;
+		}
+		break;
+	case CborIteratorTokenBeginArray:
+	case CborIteratorTokenBeginObject:
+	case CborIteratorTokenBeginByteStrings:
+	case CborIteratorTokenBeginCharStrings:
+		// expected conversion applies to all nested items of tagged container
+		if (scope->hasPending) {
+			ret = scope->pending;
+			scope->hasPending = false;
+			if (scope->nscopes < CBOR_ENCODING_SCOPE_MAX) {
+				scope->scopes[scope->nscopes].depth = iter->stackSize;
+				scope->scopes[scope->nscopes].encoding = ret;
+				++ scope->nscopes;
+			}
+		}
+		break;
+	default:
+		break;
+	}
+
+	return ret;
+}
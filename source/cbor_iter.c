@@ -1,6 +1,7 @@
 
 #include "cbor_alloc.h"
 #include "cbor_iter.h"
+#include "cbor_path.h"
 #include "cbor_typeinfo.h"
 
 #include "postgres.h"
@@ -10,17 +11,54 @@
 #include <string.h>
 #include <limits.h>
 
-static inline uint32_t get_cbor_integer_length(uint8_t info) {
-	switch (info) {
-	case CborFlagsAdditionalNumber8Bit: return 1; break;
-	case CborFlagsAdditionalNumber16Bit: return 2; break;
-	case CborFlagsAdditionalNumber32Bit: return 4; break;
-	case CborFlagsAdditionalNumber64Bit: return 8; break;
-	default: return 0; break;
-	}
-
-	return 0;
-}
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define CBOR_IB(major, type, length, flags) { major, type, length, flags }
+#define CBOR_IB_4(...) CBOR_IB(__VA_ARGS__), CBOR_IB(__VA_ARGS__), CBOR_IB(__VA_ARGS__), CBOR_IB(__VA_ARGS__)
+#define CBOR_IB_20(...) CBOR_IB_4(__VA_ARGS__), CBOR_IB_4(__VA_ARGS__), CBOR_IB_4(__VA_ARGS__), \
+	CBOR_IB_4(__VA_ARGS__), CBOR_IB_4(__VA_ARGS__)
+
+// values 0-23 are encoded within initial byte, 24-27 - in 1, 2, 4 or 8 following bytes, 28-30 are reserved
+#define CBOR_IB_MAJOR(major, type, flags, indefinite) \
+	CBOR_IB_20(major, type, 0, flags), CBOR_IB_4(major, type, 0, flags), \
+	CBOR_IB(major, type, 1, flags), CBOR_IB(major, type, 2, flags), \
+	CBOR_IB(major, type, 4, flags), CBOR_IB(major, type, 8, flags), \
+	CBOR_IB(major, type, 0, CborInitialByteFlagInvalid), \
+	CBOR_IB(major, type, 0, CborInitialByteFlagInvalid), \
+	CBOR_IB(major, type, 0, CborInitialByteFlagInvalid), \
+	CBOR_IB(major, type, 0, indefinite)
+
+const CborInitialByte CborInitialByteTable[256] = {
+	CBOR_IB_MAJOR(CborMajorTypeUnsigned, CborTypeUnsigned, 0, CborInitialByteFlagInvalid),
+	CBOR_IB_MAJOR(CborMajorTypeNegative, CborTypeNegative, 0, CborInitialByteFlagInvalid),
+	CBOR_IB_MAJOR(CborMajorTypeByteString, CborTypeByteString, CborInitialByteFlagString,
+			CborInitialByteFlagString | CborInitialByteFlagIndefinite),
+	CBOR_IB_MAJOR(CborMajorTypeCharString, CborTypeCharString, CborInitialByteFlagString,
+			CborInitialByteFlagString | CborInitialByteFlagIndefinite),
+	CBOR_IB_MAJOR(CborMajorTypeArray, CborTypeArray, CborInitialByteFlagContainer,
+			CborInitialByteFlagContainer | CborInitialByteFlagIndefinite),
+	CBOR_IB_MAJOR(CborMajorTypeMap, CborTypeMap, CborInitialByteFlagContainer,
+			CborInitialByteFlagContainer | CborInitialByteFlagIndefinite),
+	CBOR_IB_MAJOR(CborMajorTypeTag, CborTypeTag, CborInitialByteFlagTag, CborInitialByteFlagInvalid),
+
+	CBOR_IB_20(CborMajorTypeSimple, CborTypeSimple, 0, 0),
+	CBOR_IB(CborMajorTypeSimple, CborTypeFalse, 0, 0),
+	CBOR_IB(CborMajorTypeSimple, CborTypeTrue, 0, 0),
+	CBOR_IB(CborMajorTypeSimple, CborTypeNull, 0, 0),
+	CBOR_IB(CborMajorTypeSimple, CborTypeUndefined, 0, 0),
+	CBOR_IB(CborMajorTypeSimple, CborTypeSimple, 1, 0),
+	CBOR_IB(CborMajorTypeSimple, CborTypeFloat, 2, 0),
+	CBOR_IB(CborMajorTypeSimple, CborTypeFloat, 4, 0),
+	CBOR_IB(CborMajorTypeSimple, CborTypeFloat, 8, 0),
+	CBOR_IB(CborMajorTypeSimple, CborTypeUnknown, 0, CborInitialByteFlagInvalid),
+	CBOR_IB(CborMajorTypeSimple, CborTypeUnknown, 0, CborInitialByteFlagInvalid),
+	CBOR_IB(CborMajorTypeSimple, CborTypeUnknown, 0, CborInitialByteFlagInvalid),
+	CBOR_IB(CborMajorTypeSimple, CborTypeUnknown, 0, CborInitialByteFlagBreak),
+};
 
 bool CborIteratorInit(CborIteratorContext *ctx, const uint8_t *data, size_t size) {
 	memset(ctx, 0, sizeof(CborIteratorContext));
@@ -41,6 +79,66 @@ bool CborIteratorInit(CborIteratorContext *ctx, const uint8_t *data, size_t size
 	return true;
 }
 
+bool CborIteratorInitTape(CborIteratorContext *ctx, const CborTape *tape) {
+	memset(ctx, 0, sizeof(CborIteratorContext));
+
+	if (tape->size == 0) {
+		return false;
+	}
+
+	ctx->current = tape->data;
+	ctx->tape = tape;
+
+	ctx->currentStack = ctx->defaultStack;
+	ctx->stackCapacity = CBOR_STACK_DEFAULT_SIZE;
+
+	return true;
+}
+
+void CborIteratorInitStream(CborIteratorContext *ctx) {
+	memset(ctx, 0, sizeof(CborIteratorContext));
+
+	ctx->feed = true;
+	ctx->feedStart = true;
+	ctx->currentStack = ctx->defaultStack;
+	ctx->stackCapacity = CBOR_STACK_DEFAULT_SIZE;
+}
+
+void CborIteratorFeed(CborIteratorContext *ctx, const uint8_t *data, size_t size, bool last) {
+	ctx->feedLast = last;
+	ctx->stream.ptr = NULL;
+	ctx->stream.size = 0;
+
+	if (ctx->pendingSize > 0) {
+		uint32_t required = 1 + CborInitialByteTable[ctx->pending[0]].length;
+		uint32_t len = required - ctx->pendingSize;
+		if (len > size) {
+			len = size;
+		}
+
+		memcpy(ctx->pending + ctx->pendingSize, data, len);
+		ctx->pendingSize += len;
+		data += len;
+		size -= len;
+
+		if (ctx->pendingSize < required) {
+			ctx->current.ptr = data;
+			ctx->current.size = 0;
+			return;
+		}
+
+		// decode header from pending buffer, then continue with chunk
+		ctx->current.ptr = ctx->pending;
+		ctx->current.size = ctx->pendingSize;
+		ctx->pendingSize = 0;
+		ctx->stream.ptr = data;
+		ctx->stream.size = size;
+	} else {
+		ctx->current.ptr = data;
+		ctx->current.size = size;
+	}
+}
+
 void CborIteratorFinalize(CborIteratorContext *ctx) {
 	if (ctx->extendedStack) {
 		CborFree(ctx->extendedStack);
@@ -74,6 +172,7 @@ static CborIteratorToken CborIteratorPushStack(CborIteratorContext *ctx, CborSta
 	newStackValue->type = type;
 	newStackValue->position = 0;
 	newStackValue->ptr = ptr;
+	newStackValue->tape = CBOR_TAPE_NOT_FOUND;
 	if (type == CborStackTypeObject && count != UINT32_MAX) {
 		newStackValue->count = count * 2;
 	} else {
@@ -141,14 +240,66 @@ static CborIteratorToken CborIteratorPopStack(CborIteratorContext *ctx) {
 	return CborIteratorTokenDone;
 }
 
+// decode item with complete header at ptr
+static inline CborIteratorToken CborIteratorReadItem(CborIteratorContext *ctx, struct CborIteratorStackValue *head,
+		const uint8_t *ptr, const CborInitialByte *desc) {
+	uint64_t value;
+
+	ctx->type = desc->major;
+	ctx->info = *ptr & CborFlagsAdditionalInfoMask;
+	ctx->itemType = desc->type;
+	ctx->value = ptr;
+
+	++ ctx->current.ptr;
+	-- ctx->current.size;
+
+	if (head && !(desc->flags & CborInitialByteFlagTag)) {
+		++ head->position;
+	}
+
+	if (desc->flags & (CborInitialByteFlagContainer | CborInitialByteFlagString)) {
+		if (desc->flags & CborInitialByteFlagIndefinite) {
+			value = UINT32_MAX;
+		} else {
+			value = CborDataReadUnsignedValue(&ctx->current, ctx->info);
+		}
+
+		if (desc->flags & CborInitialByteFlagContainer) {
+			return CborIteratorPushStack(ctx,
+					(desc->major == CborMajorTypeArray) ? CborStackTypeArray : CborStackTypeObject, value, ptr);
+		} else if (desc->flags & CborInitialByteFlagIndefinite) {
+			return CborIteratorPushStack(ctx,
+					(desc->major == CborMajorTypeByteString) ? CborStackTypeByteString : CborStackTypeCharString, value, ptr);
+		}
+
+		ctx->objectSize = value;
+	} else {
+		ctx->objectSize = desc->length;
+	}
+
+	return (head && head->type == CborStackTypeObject)
+		? ( head->position % 2 == 1 ? CborIteratorTokenKey : CborIteratorTokenValue )
+		: CborIteratorTokenValue;
+}
+
+static CborIteratorToken CborIteratorNextFeed(CborIteratorContext *ctx);
+
 CborIteratorToken CborIteratorNext(CborIteratorContext *ctx) {
 	struct CborIteratorStackValue *head;
-	CborStackType nextStackType;
-	uint8_t type;
+	const CborInitialByte *desc;
 	const uint8_t *ptr;
+	uint32_t tapeIndex = CBOR_TAPE_NOT_FOUND;
+
+	if (ctx->feed) {
+		return CborIteratorNextFeed(ctx);
+	}
 
 	if (!CborDataOffset(&ctx->current, ctx->objectSize)) {
-		if (ctx->stackHead) {
+		head = ctx->stackHead;
+		if (head && (head->count == UINT32_MAX || head->position < head->count)) {
+			ctx->malformed = true;
+		}
+		if (head) {
 			ctx->token = CborIteratorPopStack(ctx);
 		} else {
 			ctx->token = CborIteratorTokenDone;
@@ -166,122 +317,173 @@ CborIteratorToken CborIteratorNext(CborIteratorContext *ctx) {
 		return ctx->token;
 	}
 
-	// read flag value
 	ptr = ctx->current.ptr;
-	type = CborDataGetUnsigned(&ctx->current);
-	CborDataOffset(&ctx->current, 1);
+	desc = &CborInitialByteTable[*ptr];
 
 	// pop stack value for undefined length container
-	if (head && head->count == UINT32_MAX && type == (CborFlagsUndefinedLength | CborMajorTypeEncodedSimple)) {
+	if ((desc->flags & CborInitialByteFlagBreak) && head && head->count == UINT32_MAX) {
+		CborDataOffset(&ctx->current, 1);
 		ctx->token = CborIteratorPopStack(ctx);
+		ctx->value = ptr;
 		return ctx->token;
 	}
 
-	ctx->type = (type & CborFlagsMajorTypeMaskEncoded) >> CborFlagsMajorTypeShift;
-	ctx->info = type & CborFlagsAdditionalInfoMask;
+	// malformed or truncated item: stop iteration
+	if ((desc->flags & (CborInitialByteFlagInvalid | CborInitialByteFlagBreak)) || ctx->current.size <= desc->length) {
+		CborDataOffset(&ctx->current, ctx->current.size);
+		ctx->objectSize = 0;
+		ctx->value = ptr;
+		ctx->malformed = true;
+		ctx->token = CborIteratorTokenDone;
+		return ctx->token;
+	}
 
-	nextStackType = CborStackTypeNone;
+	if (ctx->tape) {
+		// items are read in document order, so tape index is known without search, unless data was skipped without tape
+		tapeIndex = ctx->tapeHint;
+		if (tapeIndex >= ctx->tape->size || ctx->tape->entries[tapeIndex].offset != (uint32_t)(ptr - ctx->tape->data.ptr)) {
+			tapeIndex = CborTapeFind(ctx->tape, ptr, tapeIndex);
+		}
+		ctx->tapeHint = (tapeIndex != CBOR_TAPE_NOT_FOUND) ? tapeIndex + 1 : 0;
+	}
 
-	switch (ctx->type) {
-	case CborMajorTypeUnsigned:
-	case CborMajorTypeNegative:
-		ctx->objectSize = get_cbor_integer_length(ctx->info);
-		if (head) { ++ head->position; }
+	ctx->token = CborIteratorReadItem(ctx, head, ptr, desc);
 
-		break;
-	case CborMajorTypeTag:
-		ctx->objectSize = get_cbor_integer_length(ctx->info);
-		break;
+	if (ctx->tape && ctx->stackHead && ctx->stackHead->ptr == ptr) {
+		ctx->stackHead->tape = tapeIndex;
+	}
 
-	case CborMajorTypeSimple:
-		ctx->objectSize = get_cbor_integer_length(ctx->info);
-		if (head) { ++ head->position; }
+	// string data should be within document, value accessors do not check bounds
+	if ((desc->flags & CborInitialByteFlagString) && !(desc->flags & CborInitialByteFlagIndefinite)
+			&& ctx->objectSize > ctx->current.size) {
+		CborDataOffset(&ctx->current, ctx->current.size);
+		ctx->objectSize = 0;
+		ctx->malformed = true;
+		ctx->token = CborIteratorTokenDone;
+	}
+	return ctx->token;
+}
 
-		break;
-	case CborMajorTypeByteString:
-		if (ctx->info == CborFlagsUndefinedLength) {
-			nextStackType = CborStackTypeByteString;
-		} else {
-			ctx->objectSize = CborDataReadUnsignedValue(&ctx->current, ctx->info);
+static void CborIteratorFeedSwitch(CborIteratorContext *ctx) {
+	if (ctx->current.size == 0 && ctx->stream.size > 0) {
+		ctx->current = ctx->stream;
+		ctx->stream.ptr = NULL;
+		ctx->stream.size = 0;
+	}
+}
+
+static CborIteratorToken CborIteratorNextFeed(CborIteratorContext *ctx) {
+	struct CborIteratorStackValue *head;
+	const CborInitialByte *desc;
+	const uint8_t *ptr;
+
+	CborDataOffset(&ctx->current, ctx->objectSize);
+	ctx->objectSize = 0;
+	CborIteratorFeedSwitch(ctx);
+
+	// continue string, that was split between chunks
+	if (ctx->splitRemaining > 0 || ctx->splitPushed) {
+		if (ctx->splitRemaining == 0) {
+			ctx->splitPushed = false;
+			ctx->token = CborIteratorPopStack(ctx);
+			ctx->value = ctx->current.ptr;
+			return ctx->token;
 		}
-		if (head) { ++ head->position; }
-		break;
-	case CborMajorTypeCharString:
-		if (ctx->info == CborFlagsUndefinedLength) {
-			nextStackType = CborStackTypeCharString;
-		} else {
-			ctx->objectSize = CborDataReadUnsignedValue(&ctx->current, ctx->info);
+
+		if (ctx->current.size == 0) {
+			ctx->token = ctx->feedLast ? CborIteratorTokenDone : CborIteratorTokenNeedData;
+			return ctx->token;
 		}
-		if (head) { ++ head->position; }
-		break;
-	case CborMajorTypeArray:
-		nextStackType = CborStackTypeArray;
-		if (head) { ++ head->position; }
-		break;
-	case CborMajorTypeMap:
-		nextStackType = CborStackTypeObject;
-		if (head) { ++ head->position; }
-		break;
-	default: break;
+
+		ctx->objectSize = (ctx->splitRemaining < ctx->current.size) ? ctx->splitRemaining : ctx->current.size;
+		ctx->splitRemaining -= ctx->objectSize;
+		ctx->value = ctx->current.ptr;
+		ctx->token = CborIteratorTokenValue;
+		return ctx->token;
 	}
 
-	ctx->value = ptr;
-	if (nextStackType != CborStackTypeNone) {
-		if (ctx->info == CborFlagsUndefinedLength) {
-			ctx->token = CborIteratorPushStack(ctx, nextStackType, UINT32_MAX, ptr);
+	head = ctx->stackHead;
+
+	// pop stack value if all objects was parsed
+	if (head && head->position >= head->count) {
+		ctx->token = CborIteratorPopStack(ctx);
+		ctx->value = ctx->current.ptr;
+		return ctx->token;
+	}
+
+	if (ctx->current.size == 0) {
+		ctx->value = ctx->current.ptr;
+		if (!ctx->feedLast) {
+			ctx->token = CborIteratorTokenNeedData;
+		} else if (ctx->stackHead && ctx->pendingSize == 0) {
+			ctx->token = CborIteratorPopStack(ctx);
 		} else {
-			ctx->token = CborIteratorPushStack(ctx, nextStackType, CborDataReadUnsignedValue(&ctx->current, ctx->info), ptr);
+			ctx->token = CborIteratorTokenDone;
 		}
 		return ctx->token;
 	}
 
-	ctx->token = (head && head->type == CborStackTypeObject)
-		? ( head->position % 2 == 1 ? CborIteratorTokenKey : CborIteratorTokenValue )
-		: CborIteratorTokenValue;
-	return ctx->token;
-}
+	ptr = ctx->current.ptr;
+	desc = &CborInitialByteTable[*ptr];
 
-CborType CborIteratorGetType(const CborIteratorContext *ctx) {
-	switch (ctx->type) {
-	case CborMajorTypeUnsigned:
-		return CborTypeUnsigned;
-		break;
-	case CborMajorTypeNegative:
-		return CborTypeNegative;
-		break;
-	case CborMajorTypeByteString:
-		return CborTypeByteString;
-		break;
-	case CborMajorTypeCharString:
-		return CborTypeCharString;
-		break;
-	case CborMajorTypeArray:
-		return CborTypeArray;
-		break;
-	case CborMajorTypeMap:
-		return CborTypeMap;
-		break;
-	case CborMajorTypeTag:
-		return CborTypeTag;
-		break;
-	case CborMajorTypeSimple:
-		switch (ctx->info) {
-		case CborSimpleValueFalse: return CborTypeFalse; break;
-		case CborSimpleValueTrue: return CborTypeTrue; break;
-		case CborSimpleValueNull: return CborTypeNull; break;
-		case CborSimpleValueUndefined: return CborTypeUndefined; break;
-		case CborFlagsAdditionalFloat16Bit:
-		case CborFlagsAdditionalFloat32Bit:
-		case CborFlagsAdditionalFloat64Bit:
-			return CborTypeFloat;
-			break;
+	// pop stack value for undefined length container
+	if ((desc->flags & CborInitialByteFlagBreak) && head && head->count == UINT32_MAX) {
+		CborDataOffset(&ctx->current, 1);
+		ctx->token = CborIteratorPopStack(ctx);
+		ctx->value = ptr;
+		return ctx->token;
+	}
+
+	if (desc->flags & (CborInitialByteFlagInvalid | CborInitialByteFlagBreak)) {
+		CborDataOffset(&ctx->current, ctx->current.size);
+		ctx->value = ptr;
+		ctx->token = CborIteratorTokenDone;
+		return ctx->token;
+	}
+
+	// header is split between chunks: keep its beginning until next chunk
+	if (ctx->current.size <= desc->length) {
+		memcpy(ctx->pending, ptr, ctx->current.size);
+		ctx->pendingSize = ctx->current.size;
+		CborDataOffset(&ctx->current, ctx->current.size);
+		ctx->value = ptr;
+		ctx->token = ctx->feedLast ? CborIteratorTokenDone : CborIteratorTokenNeedData;
+		return ctx->token;
+	}
+
+	ctx->token = CborIteratorReadItem(ctx, head, ptr, desc);
+
+	// self-described CBOR tag at the beginning of stream replaces magic header
+	if (ctx->feedStart) {
+		ctx->feedStart = false;
+		if (desc->major == CborMajorTypeTag && !head
+				&& CborDataGetUnsignedValue(&ctx->current, ctx->info) == CborTagCborMagick) {
+			return CborIteratorNextFeed(ctx);
 		}
-		return CborTypeSimple;
-		break;
-	default: break;
 	}
 
-	return CborTypeUnknown;
+	// header was decoded from pending buffer, string data follows in chunk
+	CborIteratorFeedSwitch(ctx);
+
+	if ((ctx->token == CborIteratorTokenKey || ctx->token == CborIteratorTokenValue)
+			&& (desc->flags & CborInitialByteFlagString) && ctx->objectSize > ctx->current.size) {
+		ctx->splitRemaining = ctx->objectSize;
+		ctx->objectSize = 0;
+		if (head && (head->type == CborStackTypeByteString || head->type == CborStackTypeCharString)) {
+			// chunk of undefined length string, continue with values within its stack
+			return CborIteratorNextFeed(ctx);
+		}
+
+		ctx->splitPushed = true;
+		ctx->token = CborIteratorPushStack(ctx,
+				(desc->major == CborMajorTypeByteString) ? CborStackTypeByteString : CborStackTypeCharString, UINT32_MAX, ptr);
+	}
+
+	return ctx->token;
+}
+
+CborType CborIteratorGetType(const CborIteratorContext *ctx) {
+	return ctx->itemType;
 }
 
 CborStackType CborIteratorGetContainerType(const CborIteratorContext *ctx) {
@@ -317,7 +519,7 @@ uint32_t CborIteratorGetObjectSize(const CborIteratorContext *ctx) {
 
 int64_t CborIteratorGetInteger(const CborIteratorContext *ctx) {
 	int64_t ret = 0;
-	switch (CborIteratorGetType(ctx)) {
+	switch (ctx->itemType) {
 	case CborTypeUnsigned:
 	case CborTypeTag:
 	case CborTypeSimple:
@@ -333,7 +535,7 @@ int64_t CborIteratorGetInteger(const CborIteratorContext *ctx) {
 
 uint64_t CborIteratorGetUnsigned(const CborIteratorContext *ctx) {
 	uint64_t ret = 0;
-	switch (CborIteratorGetType(ctx)) {
+	switch (ctx->itemType) {
 	case CborTypeUnsigned:
 	case CborTypeTag:
 	case CborTypeSimple:
@@ -346,7 +548,7 @@ uint64_t CborIteratorGetUnsigned(const CborIteratorContext *ctx) {
 
 double CborIteratorGetFloat(const CborIteratorContext *ctx) {
 	double ret = 0.0;
-	switch (CborIteratorGetType(ctx)) {
+	switch (ctx->itemType) {
 	case CborTypeFloat:
 		switch (ctx->info) {
 		case CborFlagsAdditionalFloat16Bit:
@@ -368,7 +570,7 @@ double CborIteratorGetFloat(const CborIteratorContext *ctx) {
 
 const char *CborIteratorGetCharPtr(const CborIteratorContext *ctx) {
 	const char *ret = NULL;
-	switch (CborIteratorGetType(ctx)) {
+	switch (ctx->itemType) {
 	case CborTypeCharString:
 		ret = (const char *)ctx->current.ptr;
 		break;
@@ -379,7 +581,7 @@ const char *CborIteratorGetCharPtr(const CborIteratorContext *ctx) {
 
 const uint8_t *CborIteratorGetBytePtr(const CborIteratorContext *ctx) {
 	const uint8_t *ret = NULL;
-	switch (CborIteratorGetType(ctx)) {
+	switch (ctx->itemType) {
 	case CborTypeByteString:
 		ret = ctx->current.ptr;
 		break;
@@ -405,53 +607,207 @@ const uint8_t *CborIteratorGetCurrentValuePtr(const CborIteratorContext *ctx) {
 	return NULL;
 }
 
-const uint8_t *CborIteratorReadCurrentValue(CborIteratorContext *iter) {
-	switch (iter->token) {
+// move iterator to data offset within tape
+static void CborIteratorSeekTape(CborIteratorContext *ctx, uint32_t offset) {
+	ctx->current.ptr = ctx->tape->data.ptr + offset;
+	ctx->current.size = ctx->tape->data.size - offset;
+	ctx->objectSize = 0;
+}
+
+static uint32_t CborIteratorFindTapeContainer(CborIteratorContext *ctx) {
+	if (!ctx->tape || !ctx->stackHead) {
+		return CBOR_TAPE_NOT_FOUND;
+	} else if (ctx->stackHead->tape != CBOR_TAPE_NOT_FOUND) {
+		return ctx->stackHead->tape;
+	}
+	return CborTapeFind(ctx->tape, ctx->stackHead->ptr, ctx->tapeHint);
+}
+
+bool CborIteratorSkipValue(CborIteratorContext *ctx) {
+	if (ctx->feed) {
+		return false;
+	}
+
+	switch (ctx->token) {
 	case CborIteratorTokenValue:
 	case CborIteratorTokenKey:
-		CborIteratorNext(iter);
-		return iter->value;
+		if (ctx->objectSize > ctx->current.size) {
+			ctx->malformed = true;
+			return false;
+		}
+		CborDataOffset(&ctx->current, ctx->objectSize);
+		ctx->objectSize = 0;
+
+		// tag is not an item by itself, skip tagged value with it
+		if (ctx->type == CborMajorTypeTag && !ctx->isStreaming) {
+			if (!CborDataSkipItems(&ctx->current, 1)) {
+				ctx->malformed = true;
+				return false;
+			}
+			if (ctx->stackHead) { ++ ctx->stackHead->position; }
+		}
+		return true;
 		break;
-	case CborIteratorTokenBeginArray: {
-		uint32_t stack = iter->stackSize;
-		while (CborIteratorNext(iter) != CborIteratorTokenEndArray && iter->stackSize > stack - 1) { }
-		CborIteratorNext(iter);
-		return iter->value;
+	case CborIteratorTokenBeginArray:
+	case CborIteratorTokenBeginObject:
+	case CborIteratorTokenBeginByteStrings:
+	case CborIteratorTokenBeginCharStrings:
+		return CborIteratorSkipContainer(ctx);
+		break;
+	default:
 		break;
 	}
-	case CborIteratorTokenBeginObject: {
-		uint32_t stack = iter->stackSize;
-		while (CborIteratorNext(iter) != CborIteratorTokenEndObject && iter->stackSize > stack - 1) { }
+	return false;
+}
+
+bool CborIteratorSkipContainer(CborIteratorContext *ctx) {
+	struct CborIteratorStackValue *head = ctx->stackHead;
+	uint32_t idx;
+
+	if (!head || ctx->feed) {
+		return false;
+	} else if (ctx->objectSize > ctx->current.size) {
+		ctx->malformed = true;
+		return false;
+	}
+
+	CborDataOffset(&ctx->current, ctx->objectSize);
+	ctx->objectSize = 0;
+
+	idx = CborIteratorFindTapeContainer(ctx);
+	if (idx != CBOR_TAPE_NOT_FOUND) {
+		ctx->tapeHint = ctx->tape->entries[idx].next;
+		CborIteratorSeekTape(ctx, ctx->tape->entries[idx].end);
+	} else if (head->count == UINT32_MAX) {
+		if (!CborDataSkipUntilBreak(&ctx->current)) {
+			ctx->malformed = true;
+			return false;
+		}
+	} else if (!CborDataSkipItems(&ctx->current, head->count - head->position)) {
+		ctx->malformed = true;
+		return false;
+	}
+
+	ctx->token = CborIteratorPopStack(ctx);
+	ctx->value = ctx->current.ptr;
+	return true;
+}
+
+bool CborIteratorSkip(CborIteratorContext *ctx, uint32_t count) {
+	uint32_t idx;
+
+	if (ctx->feed || ctx->objectSize > ctx->current.size) {
+		return false;
+	}
+
+	idx = CborIteratorFindTapeContainer(ctx);
+	if (idx != CBOR_TAPE_NOT_FOUND) {
+		const CborTapeEntry *entry = &ctx->tape->entries[idx];
+		uint32_t target = ctx->stackHead->position + count;
+		if (target < entry->count) {
+			ctx->tapeHint = CborTapeGetChild(ctx->tape, idx, target);
+			CborIteratorSeekTape(ctx, ctx->tape->entries[ctx->tapeHint].offset);
+		} else if (target == entry->count) {
+			// stop at break byte for undefined length container
+			ctx->tapeHint = entry->next;
+			CborIteratorSeekTape(ctx, entry->end - (entry->info == CborFlagsUndefinedLength ? 1 : 0));
+		} else {
+			return false;
+		}
+		ctx->stackHead->position = target;
+		return true;
+	}
+
+	CborDataOffset(&ctx->current, ctx->objectSize);
+	ctx->objectSize = 0;
+
+	if (!CborDataSkipItems(&ctx->current, count)) {
+		return false;
+	}
+
+	if (ctx->stackHead) {
+		ctx->stackHead->position += count;
+	}
+	return true;
+}
+
+const uint8_t *CborIteratorReadCurrentValue(CborIteratorContext *iter) {
+	if (!CborIteratorSkipValue(iter)) {
+		return NULL;
+	}
+
+	CborIteratorNext(iter);
+	return iter->value;
+}
+
+bool CborIteratorInitRoot(CborIteratorContext *iter, const uint8_t *data, size_t size) {
+	if (!CborIteratorInit(iter, data, size)) {
+		return false;
+	}
+
+	CborIteratorNext(iter);
+	CborIteratorSkipTags(iter);
+	return true;
+}
+
+CborIteratorToken CborIteratorSkipTags(CborIteratorContext *iter) {
+	while ((iter->token == CborIteratorTokenKey || iter->token == CborIteratorTokenValue)
+			&& iter->itemType == CborTypeTag) {
 		CborIteratorNext(iter);
-		return iter->value;
-		break;
 	}
+	return iter->token;
+}
+
+bool CborIteratorReadElement(CborIteratorContext *iter, CborData *item, CborData *content) {
+	const uint8_t *begin;
+	const uint8_t *end;
+
+	switch (iter->token) {
+	case CborIteratorTokenKey:
+	case CborIteratorTokenValue:
+	case CborIteratorTokenBeginArray:
+	case CborIteratorTokenBeginObject:
 	case CborIteratorTokenBeginByteStrings:
-		while (CborIteratorNext(iter) != CborIteratorTokenEndByteStrings) { }
-		CborIteratorNext(iter);
-		return iter->value;
-		break;
 	case CborIteratorTokenBeginCharStrings:
-		while (CborIteratorNext(iter) != CborIteratorTokenEndCharStrings) { }
-		CborIteratorNext(iter);
-		return iter->value;
 		break;
 	default:
-		return NULL;
+		return false;
 		break;
 	}
-	return NULL;
+
+	begin = CborIteratorGetCurrentValuePtr(iter);
+	CborIteratorSkipTags(iter);
+
+	content->ptr = CborIteratorGetCurrentValuePtr(iter);
+	end = CborIteratorReadCurrentValue(iter);
+	if (!begin || !content->ptr || !end) {
+		return false;
+	}
+
+	item->ptr = begin;
+	item->size = end - begin;
+	content->size = end - content->ptr;
+	return true;
 }
 
 bool CborIteratorGetIth(CborIteratorContext *ctx, long int lindex) {
-	uint32_t stackSize;
-	struct CborIteratorStackValue *h;
+	uint32_t idx;
 
 	if (!ctx->stackHead || ctx->stackHead->type != CborStackTypeArray || ctx->token != CborIteratorTokenBeginArray) {
 		return false;
 	}
 
-	if (lindex >= 0) {
+	idx = CborIteratorFindTapeContainer(ctx);
+	if (idx != CBOR_TAPE_NOT_FOUND) {
+		// tape knows size of undefined length arrays too
+		uint32_t count = ctx->tape->entries[idx].count;
+		if (lindex < 0) {
+			lindex += count;
+		}
+		if (lindex < 0 || (uint32_t)lindex >= count) {
+			return false;
+		}
+	} else if (lindex >= 0) {
 		if ((uint32_t)lindex >= ctx->stackHead->count) {
 			return false;
 		}
@@ -467,73 +823,239 @@ bool CborIteratorGetIth(CborIteratorContext *ctx, long int lindex) {
 		}
 	}
 
-	stackSize = ctx->stackSize;
-	h = ctx->stackHead;
-
-	while ((h->position != lindex || ctx->stackSize > stackSize) && ctx->token != CborIteratorTokenDone) {
-		CborIteratorNext(ctx);
+	if (!CborIteratorSkip(ctx, (uint32_t)lindex)) {
+		return false;
 	}
 
-	if (ctx->stackSize < stackSize || ctx->token == CborIteratorTokenDone) {
+	switch (CborIteratorNext(ctx)) {
+	case CborIteratorTokenDone:
+	case CborIteratorTokenEndArray:
 		return false;
+		break;
+	default:
+		break;
+	}
+	return true;
+}
+
+static bool CborIteratorMatchStrings(CborIteratorContext *ctx, const char *str, uint32_t size) {
+	CborIteratorToken end = (ctx->token == CborIteratorTokenBeginCharStrings)
+		? CborIteratorTokenEndCharStrings : CborIteratorTokenEndByteStrings;
+	bool match = true;
+
+	while (CborIteratorNext(ctx) != end) {
+		if (ctx->token != CborIteratorTokenValue) {
+			return false;
+		}
+		if (match) {
+			if (ctx->objectSize <= size && memcmp(str, ctx->current.ptr, ctx->objectSize) == 0) {
+				str += ctx->objectSize;
+				size -= ctx->objectSize;
+			} else {
+				match = false;
+			}
+		}
+	}
+
+	return match && size == 0;
+}
+
+void CborKeyProbeInit(CborKeyProbe *probe, const char *str, uint32_t size) {
+	memset(probe, 0, sizeof(CborKeyProbe));
+	probe->key = str;
+	probe->size = size;
+
+	if (size < CborFlagsMaxAdditionalNumber) {
+		probe->prefix[0] = CborMajorTypeEncodedCharString | size;
+		probe->headerSize = 1;
+	} else if (size <= UINT8_MAX) {
+		probe->prefix[0] = CborMajorTypeEncodedCharString | CborFlagsAdditionalNumber8Bit;
+		probe->prefix[1] = size;
+		probe->headerSize = 2;
+	} else if (size <= UINT16_MAX) {
+		probe->prefix[0] = CborMajorTypeEncodedCharString | CborFlagsAdditionalNumber16Bit;
+		probe->prefix[1] = size >> 8;
+		probe->prefix[2] = size;
+		probe->headerSize = 3;
 	} else {
-		CborIteratorNext(ctx);
-		return true;
+		probe->prefix[0] = CborMajorTypeEncodedCharString | CborFlagsAdditionalNumber32Bit;
+		probe->prefix[1] = size >> 24;
+		probe->prefix[2] = size >> 16;
+		probe->prefix[3] = size >> 8;
+		probe->prefix[4] = size;
+		probe->headerSize = 5;
+	}
+
+	probe->prefixSize = probe->headerSize + size;
+	if (probe->prefixSize > CBOR_KEY_PROBE_SIZE) {
+		probe->prefixSize = CBOR_KEY_PROBE_SIZE;
+	}
+	memcpy(probe->prefix + probe->headerSize, str, probe->prefixSize - probe->headerSize);
+}
+
+// compare encoded key at ptr with probe prefix, then the rest of the key, if it's longer then prefix
+static inline bool CborKeyProbeMatch(const CborKeyProbe *probe, const uint8_t *ptr, uint32_t avail) {
+	uint32_t total = probe->headerSize + probe->size;
+	bool match;
+
+	if (avail < total) {
+		return false;
+	}
+
+#if defined(__AVX2__)
+	if (avail >= 32) {
+		uint32_t mask = (probe->prefixSize >= 32) ? UINT32_MAX : ((1u << probe->prefixSize) - 1);
+		__m256i a = _mm256_loadu_si256((const __m256i *)ptr);
+		__m256i b = _mm256_loadu_si256((const __m256i *)probe->prefix);
+		match = (((uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, b))) & mask) == mask;
+	} else
+#elif defined(__SSE2__)
+	if (avail >= 16) {
+		uint32_t mask = (probe->prefixSize >= 16) ? 0xFFFF : ((1u << probe->prefixSize) - 1);
+		__m128i a = _mm_loadu_si128((const __m128i *)ptr);
+		__m128i b = _mm_loadu_si128((const __m128i *)probe->prefix);
+		match = (((uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(a, b))) & mask) == mask;
+		if (match && probe->prefixSize > 16) {
+			match = memcmp(ptr + 16, probe->prefix + 16, probe->prefixSize - 16) == 0;
+		}
+	} else
+#endif
+	{
+		match = memcmp(ptr, probe->prefix, probe->prefixSize) == 0;
+	}
+
+	// full compare only for candidates with keys longer then probe
+	if (match && total > probe->prefixSize) {
+		match = memcmp(ptr + probe->prefixSize, probe->key + (probe->prefixSize - probe->headerSize), total - probe->prefixSize) == 0;
+	}
+
+	return match;
+}
+
+// skip one item, single-byte headers and short strings are skipped inline
+static inline bool CborIteratorSkipItemFast(CborData *data) {
+	uint8_t type = *data->ptr;
+	uint8_t info = type & CborFlagsAdditionalInfoMask;
+	uint32_t size;
+
+	switch ((type & CborFlagsMajorTypeMaskEncoded) >> CborFlagsMajorTypeShift) {
+	case CborMajorTypeUnsigned:
+	case CborMajorTypeNegative:
+	case CborMajorTypeSimple:
+		if (info < CborFlagsMaxAdditionalNumber) {
+			size = 1;
+		} else if (info <= CborFlagsAdditionalNumber64Bit) {
+			size = 1 + CborInitialByteTable[type].length;
+		} else {
+			return CborDataSkipItems(data, 1);
+		}
+		break;
+	case CborMajorTypeByteString:
+	case CborMajorTypeCharString:
+		if (info < CborFlagsMaxAdditionalNumber) {
+			size = 1 + info;
+		} else {
+			return CborDataSkipItems(data, 1);
+		}
+		break;
+	default:
+		return CborDataSkipItems(data, 1);
+		break;
 	}
+
+	if (size > data->size) {
+		return false;
+	}
+	data->ptr += size;
+	data->size -= size;
+	return true;
 }
 
 bool CborIteratorGetKey(CborIteratorContext *ctx, const char *str, uint32_t size) {
+	CborKeyProbe probe;
+	CborKeyProbeInit(&probe, str, size);
+	return CborIteratorGetKeyProbe(ctx, &probe);
+}
+
+bool CborIteratorGetKeyProbe(CborIteratorContext *ctx, const CborKeyProbe *probe) {
 	uint32_t stackSize;
-	const char *tmpstr = str;
-	uint32_t tmpsize = size;
 
-	if (!ctx->stackHead || ctx->stackHead->type != CborStackTypeObject || ctx->token != CborIteratorTokenBeginObject) {
+	if (ctx->feed || !ctx->stackHead || ctx->stackHead->type != CborStackTypeObject || ctx->token != CborIteratorTokenBeginObject) {
 		return false;
 	}
 
 	stackSize = ctx->stackSize;
-	while (ctx->token != CborIteratorTokenDone && ctx->stackSize >= stackSize) {
-		CborIteratorToken token = CborIteratorNext(ctx);
-		if (ctx->stackSize == stackSize) {
-			switch (token) {
-			case CborIteratorTokenKey:
-				if (ctx->isStreaming) {
-					if (tmpstr && ctx->objectSize <= size) {
-						if (memcmp(str, ctx->current.ptr, ctx->objectSize) == 0) {
-							tmpstr += ctx->objectSize;
-							size -= ctx->objectSize;
-						} else {
-							// invalid key
-							tmpstr = NULL;
-						}
-					} else {
-						tmpstr = NULL;
-					}
-				} else if (ctx->type == CborMajorTypeByteString || ctx->type == CborMajorTypeCharString) {
-					if (ctx->objectSize == size && memcmp(str, ctx->current.ptr, size) == 0) {
-						CborIteratorNext(ctx);
-						return true;
-					}
-				}
-				break;
-			case CborIteratorTokenValue:
-				if (tmpsize == 0) {
+	while (true) {
+		CborIteratorToken token;
+		const struct CborIteratorStackValue *head = ctx->stackHead;
+
+		// fast path: compare raw encoded key with probe, without key decoding
+		if (ctx->objectSize == 0 && ctx->stackSize == stackSize && head->position < head->count && ctx->current.size > 0) {
+			uint8_t type = *ctx->current.ptr;
+			uint32_t keySize = 0;
+			if (type == probe->prefix[0]) {
+				if (CborKeyProbeMatch(probe, ctx->current.ptr, ctx->current.size)) {
+					CborIteratorNext(ctx);
+					CborIteratorNext(ctx);
 					return true;
 				}
-				tmpstr = str;
-				tmpsize = size;
-				break;
-			default:
-				break;
+				if (probe->headerSize == 1) {
+					keySize = 1 + probe->size;
+				}
+			} else if ((type & CborFlagsMajorTypeMaskEncoded) == CborMajorTypeEncodedCharString
+					&& (type & CborFlagsAdditionalInfoMask) < CborFlagsMaxAdditionalNumber) {
+				// short text key with other length, can not be equal
+				keySize = 1 + (type & CborFlagsAdditionalInfoMask);
+			}
+
+			if (keySize > 0 && !ctx->tape && keySize < ctx->current.size) {
+				// key size is known from header, skip key in place and value with kernel
+				ctx->current.ptr += keySize;
+				ctx->current.size -= keySize;
+				if (!CborIteratorSkipItemFast(&ctx->current)) {
+					return false;
+				}
+				ctx->stackHead->position += 2;
+				continue;
+			} else if (keySize > 0 || type == probe->prefix[0]) {
+				if (!CborIteratorSkip(ctx, 2)) {
+					return false;
+				}
+				continue;
 			}
 		}
-	}
 
-	if (ctx->stackSize < stackSize || ctx->token == CborIteratorTokenDone) {
-		return false;
-	} else {
-		return true;
+		// generic path: other header encodings, byte strings and chunked strings
+		token = CborIteratorNext(ctx);
+		if (ctx->stackSize < stackSize || token == CborIteratorTokenDone) {
+			return false;
+		}
+
+		if (token == CborIteratorTokenKey) {
+			if ((ctx->type == CborMajorTypeByteString || ctx->type == CborMajorTypeCharString)
+					&& ctx->objectSize == probe->size && memcmp(probe->key, ctx->current.ptr, probe->size) == 0) {
+				CborIteratorNext(ctx);
+				return true;
+			}
+			if (!CborIteratorSkipValue(ctx)) {
+				return false;
+			}
+		} else if (token == CborIteratorTokenBeginCharStrings || token == CborIteratorTokenBeginByteStrings) {
+			if (CborIteratorMatchStrings(ctx, probe->key, probe->size)) {
+				CborIteratorNext(ctx);
+				return true;
+			}
+		} else if (!CborIteratorSkipValue(ctx)) {
+			return false;
+		}
+
+		// skip value for non-matched key
+		if (!CborIteratorSkip(ctx, 1)) {
+			return false;
+		}
 	}
+
+	return false;
 }
 
 bool CborIteratorPath(CborIteratorContext *ctx, CborIteratorPathCallback cb, void *ptr) {
@@ -561,10 +1083,8 @@ bool CborIteratorPath(CborIteratorContext *ctx, CborIteratorPathCallback cb, voi
 	while (data.ptr) {
 		switch (token) {
 		case CborIteratorTokenBeginArray: {
-			const char *indextext = (const char *)data.ptr;
-			char *endptr;
-			long int lindex = strtol(indextext, &endptr, 10);
-			if (endptr == indextext || *endptr != '\0' || lindex > INT_MAX || lindex < INT_MIN) {
+			long int lindex;
+			if (!CborPathParseIndex(&data, &lindex)) {
 				return false;
 			}
 
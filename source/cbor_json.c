@@ -0,0 +1,592 @@
+
+#include "cbor.h"
+
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define CBOR_JSON_BUFFER_SIZE 4096
+
+// decimal scale, for which double can be converted exactly with single multiplication or division
+#define CBOR_JSON_DECIMAL_MAX_SCALE 15
+
+// largest integer, that can be represented exactly with double
+#define CBOR_JSON_DOUBLE_MAX_EXACT 9007199254740992.0
+
+typedef enum {
+	CborJsonFrameArray,
+	CborJsonFrameObject,
+} CborJsonFrameType;
+
+struct CborJsonFrame {
+	uint8_t type;
+	bool first; // no items was written into container
+	bool key; // object: next item is key
+};
+
+struct CborJsonContext {
+	const struct CborWriter *writer;
+
+	uint32_t depth;
+	uint32_t capacity;
+	struct CborJsonFrame *frames;
+
+	CborByteEncodingScope scope;
+
+	bool chunked; // within undefined length string
+	bool chunkedBytes;
+	CborByteEncoding chunkedEncoding;
+	uint32_t carrySize; // bytes of chunked byte string, not yet encoded into base64 group
+	uint8_t carry[3];
+
+	CborBuffer *out; // writer's buffer or staging buffer below
+	bool staged; // output is flushed into writer callback when staging buffer is full
+	CborBuffer stage;
+	char buf[CBOR_JSON_BUFFER_SIZE]; // not allocated when writing into writer's buffer
+};
+
+static const char CborDigitPairs[] =
+	"00010203040506070809"
+	"10111213141516171819"
+	"20212223242526272829"
+	"30313233343536373839"
+	"40414243444546474849"
+	"50515253545556575859"
+	"60616263646566676869"
+	"70717273747576777879"
+	"80818283848586878889"
+	"90919293949596979899";
+
+static const double CborPow10[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15
+};
+
+static const char CborHexTable[] = "0123456789abcdef";
+
+uint32_t CborFormatUnsigned(char *buf, uint64_t value) {
+	char tmp[CBOR_NUMBER_MAX_SIZE];
+	char *ptr = tmp + sizeof(tmp);
+	uint32_t len;
+
+	while (value >= 100) {
+		uint32_t pair = (uint32_t)(value % 100) * 2;
+		value /= 100;
+		ptr -= 2;
+		ptr[0] = CborDigitPairs[pair];
+		ptr[1] = CborDigitPairs[pair + 1];
+	}
+	if (value >= 10) {
+		ptr -= 2;
+		ptr[0] = CborDigitPairs[value * 2];
+		ptr[1] = CborDigitPairs[value * 2 + 1];
+	} else {
+		*(-- ptr) = '0' + (char)value;
+	}
+
+	len = tmp + sizeof(tmp) - ptr;
+	memcpy(buf, ptr, len);
+	return len;
+}
+
+uint32_t CborFormatDouble(char *buf, double value) {
+	uint32_t scale;
+	int precision;
+
+	// fast path: shortest decimal with few fraction digits, checked with exact integer arithmetic
+	for (scale = 0; scale <= CBOR_JSON_DECIMAL_MAX_SCALE; ++ scale) {
+		double shifted = value * CborPow10[scale];
+		uint64_t mantissa;
+		char digits[CBOR_NUMBER_MAX_SIZE];
+		uint32_t ndigits, len = 0;
+
+		if (fabs(shifted) >= CBOR_JSON_DOUBLE_MAX_EXACT) {
+			break;
+		}
+
+		mantissa = (uint64_t)llrint(fabs(shifted));
+		if ((double)mantissa / CborPow10[scale] != fabs(value)) {
+			continue;
+		}
+
+		if (signbit(value)) {
+			buf[len ++] = '-';
+		}
+
+		ndigits = CborFormatUnsigned(digits, mantissa);
+		if (scale == 0) {
+			memcpy(buf + len, digits, ndigits);
+			memcpy(buf + len + ndigits, ".0", 2);
+			return len + ndigits + 2;
+		} else if (ndigits > scale) {
+			memcpy(buf + len, digits, ndigits - scale);
+			len += ndigits - scale;
+			buf[len ++] = '.';
+			memcpy(buf + len, digits + ndigits - scale, scale);
+			return len + scale;
+		} else {
+			buf[len ++] = '0';
+			buf[len ++] = '.';
+			memset(buf + len, '0', scale - ndigits);
+			len += scale - ndigits;
+			memcpy(buf + len, digits, ndigits);
+			return len + ndigits;
+		}
+	}
+
+	/* any 15-digit decimal survives round trip through normal double, so %.15g is already
+	 * shortest, when it converts back into the same value; subnormals have fewer digits */
+	for (precision = (fabs(value) < DBL_MIN) ? 1 : 15; precision < 17; ++ precision) {
+		snprintf(buf, CBOR_NUMBER_MAX_SIZE, "%.*g", precision, value);
+		if (strtod(buf, NULL) == value) {
+			return strlen(buf);
+		}
+	}
+	return snprintf(buf, CBOR_NUMBER_MAX_SIZE, "%.17g", value);
+}
+
+static void CborJsonFlush(struct CborJsonContext *json) {
+	if (json->staged && json->out->size > 0) {
+		json->writer->plain(json->writer->ctx, json->out->data, json->out->size);
+		json->out->size = 0;
+	}
+}
+
+// staging buffer is flushed instead of growing, so `size` should not exceed CBOR_JSON_BUFFER_SIZE there
+static void CborJsonGrow(struct CborJsonContext *json, size_t size) {
+	if (json->staged) {
+		CborJsonFlush(json);
+	} else {
+		CborBufferGrow(json->out, size);
+	}
+}
+
+// returns space for at least `size` bytes
+static inline char *CborJsonReserve(struct CborJsonContext *json, size_t size) {
+	if (json->out->size + size > json->out->capacity) {
+		CborJsonGrow(json, size);
+	}
+	return json->out->data + json->out->size;
+}
+
+static inline void CborJsonWrite(struct CborJsonContext *json, const char *data, size_t size) {
+	if (json->out->size + size > json->out->capacity) {
+		if (json->staged && size > CBOR_JSON_BUFFER_SIZE / 2) {
+			// large run is passed to writer directly
+			CborJsonFlush(json);
+			while (size > INT32_MAX) {
+				json->writer->plain(json->writer->ctx, data, INT32_MAX);
+				data += INT32_MAX;
+				size -= INT32_MAX;
+			}
+			json->writer->plain(json->writer->ctx, data, (int)size);
+			return;
+		}
+		CborJsonGrow(json, size);
+	}
+	memcpy(json->out->data + json->out->size, data, size);
+	json->out->size += size;
+}
+
+static inline void CborJsonWriteChar(struct CborJsonContext *json, char c) {
+	if (json->out->size == json->out->capacity) {
+		CborJsonGrow(json, 1);
+	}
+	json->out->data[json->out->size ++] = c;
+}
+
+// returns offset of first byte, that should be escaped: control character, quote or backslash
+static inline size_t CborJsonScanClean(const uint8_t *ptr, size_t size) {
+	size_t offset = 0;
+
+#if defined(__AVX2__)
+	{
+	const __m256i quote32 = _mm256_set1_epi8('"');
+	const __m256i slash32 = _mm256_set1_epi8('\\');
+	const __m256i ctrl32 = _mm256_set1_epi8(0x1F);
+	while (size - offset >= 32) {
+		__m256i v = _mm256_loadu_si256((const __m256i *)(ptr + offset));
+		__m256i m = _mm256_or_si256(
+				_mm256_or_si256(_mm256_cmpeq_epi8(v, quote32), _mm256_cmpeq_epi8(v, slash32)),
+				_mm256_cmpeq_epi8(_mm256_min_epu8(v, ctrl32), v));
+		uint32_t mask = (uint32_t)_mm256_movemask_epi8(m);
+		if (mask != 0) {
+			return offset + __builtin_ctz(mask);
+		}
+		offset += 32;
+	}
+	}
+#endif
+#if defined(__SSE2__)
+	{
+	const __m128i quote16 = _mm_set1_epi8('"');
+	const __m128i slash16 = _mm_set1_epi8('\\');
+	const __m128i ctrl16 = _mm_set1_epi8(0x1F);
+	while (size - offset >= 16) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(ptr + offset));
+		__m128i m = _mm_or_si128(
+				_mm_or_si128(_mm_cmpeq_epi8(v, quote16), _mm_cmpeq_epi8(v, slash16)),
+				_mm_cmpeq_epi8(_mm_min_epu8(v, ctrl16), v));
+		uint32_t mask = (uint32_t)_mm_movemask_epi8(m);
+		if (mask != 0) {
+			return offset + __builtin_ctz(mask);
+		}
+		offset += 16;
+	}
+	}
+#endif
+	while (offset < size) {
+		uint8_t c = ptr[offset];
+		if (c < 0x20 || c == '"' || c == '\\') {
+			break;
+		}
+		++ offset;
+	}
+	return offset;
+}
+
+// write string content with escapes, clean runs are copied in bulk, returns false for invalid UTF-8
+static bool CborJsonWriteEscaped(struct CborJsonContext *json, const uint8_t *ptr, size_t size) {
+	if (!CborValidateUtf8(ptr, ptr + size)) {
+		return false;
+	}
+
+	while (size > 0) {
+		size_t clean = CborJsonScanClean(ptr, size);
+		uint8_t c;
+		char *out;
+
+		if (clean > 0) {
+			CborJsonWrite(json, (const char *)ptr, clean);
+			ptr += clean;
+			size -= clean;
+			if (size == 0) {
+				break;
+			}
+		}
+
+		c = *ptr ++;
+		-- size;
+
+		out = CborJsonReserve(json, 6);
+		switch (c) {
+		case '"': memcpy(out, "\\\"", 2); json->out->size += 2; break;
+		case '\\': memcpy(out, "\\\\", 2); json->out->size += 2; break;
+		case '\b': memcpy(out, "\\b", 2); json->out->size += 2; break;
+		case '\f': memcpy(out, "\\f", 2); json->out->size += 2; break;
+		case '\n': memcpy(out, "\\n", 2); json->out->size += 2; break;
+		case '\r': memcpy(out, "\\r", 2); json->out->size += 2; break;
+		case '\t': memcpy(out, "\\t", 2); json->out->size += 2; break;
+		default:
+			memcpy(out, "\\u00", 4);
+			out[4] = CborHexTable[c >> 4];
+			out[5] = CborHexTable[c & 0xF];
+			json->out->size += 6;
+			break;
+		}
+	}
+	return true;
+}
+
+static void CborJsonWriteBytes(struct CborJsonContext *json, CborByteEncoding encoding, const uint8_t *ptr, size_t size) {
+	// encode by blocks of whole groups, that fit into staging buffer, or whole string in place
+	const size_t maxBlock = !json->staged ? size
+			: (encoding == CborByteEncodingHex) ? CBOR_JSON_BUFFER_SIZE / 2 : (CBOR_JSON_BUFFER_SIZE / 4) * 3;
+
+	while (size > 0) {
+		size_t block = (size > maxBlock) ? maxBlock : size;
+		char *out = CborJsonReserve(json, CborByteEncodingSize(encoding, block));
+		json->out->size += CborByteEncode(encoding, out, ptr, block);
+		ptr += block;
+		size -= block;
+	}
+}
+
+// chunk of undefined length byte string: keep incomplete base64 group for the next chunk
+static void CborJsonWriteBytesChunk(struct CborJsonContext *json, const uint8_t *ptr, size_t size) {
+	size_t tail;
+
+	if (json->chunkedEncoding == CborByteEncodingHex) {
+		CborJsonWriteBytes(json, json->chunkedEncoding, ptr, size);
+		return;
+	}
+
+	if (json->carrySize > 0) {
+		while (json->carrySize < 3 && size > 0) {
+			json->carry[json->carrySize ++] = *ptr ++;
+			-- size;
+		}
+		if (json->carrySize < 3) {
+			return;
+		}
+		CborJsonWriteBytes(json, json->chunkedEncoding, json->carry, 3);
+		json->carrySize = 0;
+	}
+
+	tail = size % 3;
+	CborJsonWriteBytes(json, json->chunkedEncoding, ptr, size - tail);
+	memcpy(json->carry, ptr + size - tail, tail);
+	json->carrySize = tail;
+}
+
+static void CborJsonWriteNumber(struct CborJsonContext *json, const CborIteratorContext *iter) {
+	char *out = CborJsonReserve(json, CBOR_NUMBER_MAX_SIZE + 1);
+	uint64_t value;
+
+	switch (CborIteratorGetType(iter)) {
+	case CborTypeUnsigned:
+		json->out->size += CborFormatUnsigned(out, CborIteratorGetUnsigned(iter));
+		break;
+	case CborTypeNegative:
+		// value is -1 - n
+		value = CborDataGetUnsignedValue(&iter->current, iter->info);
+		*out ++ = '-';
+		if (value == UINT64_MAX) {
+			memcpy(out, "18446744073709551616", 20);
+			json->out->size += 21;
+		} else {
+			json->out->size += CborFormatUnsigned(out, value + 1) + 1;
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+// returns false if text string is not valid UTF-8
+static bool CborJsonWriteScalar(struct CborJsonContext *json, const CborIteratorContext *iter, CborByteEncoding encoding, bool key) {
+	double value;
+
+	switch (CborIteratorGetType(iter)) {
+	case CborTypeUnsigned:
+	case CborTypeNegative:
+		if (key) {
+			CborJsonWriteChar(json, '"');
+			CborJsonWriteNumber(json, iter);
+			CborJsonWriteChar(json, '"');
+		} else {
+			CborJsonWriteNumber(json, iter);
+		}
+		break;
+	case CborTypeFloat:
+		value = CborIteratorGetFloat(iter);
+		if (isfinite(value)) {
+			char *out = CborJsonReserve(json, CBOR_NUMBER_MAX_SIZE + 2);
+			if (key) {
+				uint32_t len;
+				*out ++ = '"';
+				len = CborFormatDouble(out, value);
+				out[len] = '"';
+				json->out->size += len + 2;
+			} else {
+				json->out->size += CborFormatDouble(out, value);
+			}
+		} else {
+			CborJsonWrite(json, key ? "\"null\"" : "null", key ? 6 : 4);
+		}
+		break;
+	case CborTypeByteString:
+		CborJsonWriteChar(json, '"');
+		CborJsonWriteBytes(json, encoding, CborIteratorGetBytePtr(iter), CborIteratorGetObjectSize(iter));
+		CborJsonWriteChar(json, '"');
+		break;
+	case CborTypeCharString:
+		CborJsonWriteChar(json, '"');
+		if (!CborJsonWriteEscaped(json, (const uint8_t *)CborIteratorGetCharPtr(iter), CborIteratorGetObjectSize(iter))) {
+			return false;
+		}
+		CborJsonWriteChar(json, '"');
+		break;
+	case CborTypeTrue:
+		CborJsonWrite(json, key ? "\"true\"" : "true", key ? 6 : 4);
+		break;
+	case CborTypeFalse:
+		CborJsonWrite(json, key ? "\"false\"" : "false", key ? 7 : 5);
+		break;
+	default:
+		// null, undefined and other simple values
+		CborJsonWrite(json, key ? "\"null\"" : "null", key ? 6 : 4);
+		break;
+	}
+	return true;
+}
+
+// write separator before next item within current container, returns true if item is object key
+static inline bool CborJsonBeginItem(struct CborJsonContext *json) {
+	struct CborJsonFrame *frame;
+
+	if (json->depth == 0) {
+		return false;
+	}
+
+	frame = &json->frames[json->depth - 1];
+	if (frame->type == CborJsonFrameObject && !frame->key) {
+		return false;
+	}
+
+	if (!frame->first) {
+		CborJsonWriteChar(json, ',');
+	}
+	frame->first = false;
+	return frame->type == CborJsonFrameObject;
+}
+
+static inline void CborJsonEndItem(struct CborJsonContext *json) {
+	struct CborJsonFrame *frame;
+
+	if (json->depth == 0) {
+		return;
+	}
+
+	frame = &json->frames[json->depth - 1];
+	if (frame->type == CborJsonFrameObject) {
+		if (frame->key) {
+			CborJsonWriteChar(json, ':');
+		}
+		frame->key = !frame->key;
+	}
+}
+
+static bool CborJsonPush(struct CborJsonContext *json, CborJsonFrameType type) {
+	struct CborJsonFrame *frame;
+
+	if (CborJsonBeginItem(json)) {
+		// JSON object keys should be strings
+		return false;
+	}
+
+	if (json->depth == json->capacity) {
+		struct CborJsonFrame *frames = CborAlloc(json->capacity * 2 * sizeof(struct CborJsonFrame));
+		memcpy(frames, json->frames, json->capacity * sizeof(struct CborJsonFrame));
+		if (json->capacity > CBOR_STACK_DEFAULT_SIZE) {
+			CborFree(json->frames);
+		}
+		json->frames = frames;
+		json->capacity *= 2;
+	}
+
+	frame = &json->frames[json->depth ++];
+	frame->type = type;
+	frame->first = true;
+	frame->key = (type == CborJsonFrameObject);
+
+	CborJsonWriteChar(json, type == CborJsonFrameObject ? '{' : '[');
+	return true;
+}
+
+static bool CborJsonPop(struct CborJsonContext *json, CborJsonFrameType type) {
+	if (json->depth == 0 || json->frames[json->depth - 1].type != type) {
+		return false;
+	}
+
+	-- json->depth;
+	CborJsonWriteChar(json, type == CborJsonFrameObject ? '}' : ']');
+	CborJsonEndItem(json);
+	return true;
+}
+
+bool CborToJson(const struct CborWriter *writer, const uint8_t *data, uint32_t size) {
+	struct CborJsonFrame defaultFrames[CBOR_STACK_DEFAULT_SIZE];
+	struct CborJsonContext *json;
+	CborIteratorContext iter;
+	CborIteratorToken token;
+	bool ret = true, complete = false;
+
+	if (!CborIteratorInit(&iter, data, size)) {
+		return false;
+	}
+
+	json = CborAlloc(writer->buffer ? offsetof(struct CborJsonContext, buf) : sizeof(struct CborJsonContext));
+	memset(json, 0, offsetof(struct CborJsonContext, buf));
+	json->writer = writer;
+	if (writer->buffer) {
+		json->out = writer->buffer;
+	} else {
+		json->stage.data = json->buf;
+		json->stage.capacity = CBOR_JSON_BUFFER_SIZE;
+		json->out = &json->stage;
+		json->staged = true;
+	}
+	json->frames = defaultFrames;
+	json->capacity = CBOR_STACK_DEFAULT_SIZE;
+
+	CborByteEncodingScopeInit(&json->scope, CborByteEncodingBase64Url);
+
+	while (ret && (token = CborIteratorNext(&iter)) != CborIteratorTokenDone) {
+		CborByteEncoding encoding = CborByteEncodingScopeNext(&json->scope, &iter);
+
+		switch (token) {
+		case CborIteratorTokenKey:
+		case CborIteratorTokenValue:
+			if (json->chunked) {
+				if (json->chunkedBytes) {
+					CborJsonWriteBytesChunk(json, CborIteratorGetBytePtr(&iter), CborIteratorGetObjectSize(&iter));
+				} else {
+					ret = CborJsonWriteEscaped(json, (const uint8_t *)CborIteratorGetCharPtr(&iter), CborIteratorGetObjectSize(&iter));
+				}
+				break;
+			}
+			if (CborIteratorGetType(&iter) == CborTypeTag) {
+				// tags are not represented in JSON, tagged item is written as is
+				break;
+			}
+			ret = CborJsonWriteScalar(json, &iter, encoding, CborJsonBeginItem(json));
+			CborJsonEndItem(json);
+			complete = (json->depth == 0);
+			break;
+		case CborIteratorTokenBeginArray:
+			ret = CborJsonPush(json, CborJsonFrameArray);
+			break;
+		case CborIteratorTokenEndArray:
+			ret = CborJsonPop(json, CborJsonFrameArray);
+			complete = (json->depth == 0);
+			break;
+		case CborIteratorTokenBeginObject:
+			ret = CborJsonPush(json, CborJsonFrameObject);
+			break;
+		case CborIteratorTokenEndObject:
+			ret = CborJsonPop(json, CborJsonFrameObject);
+			complete = (json->depth == 0);
+			break;
+		case CborIteratorTokenBeginByteStrings:
+		case CborIteratorTokenBeginCharStrings:
+			CborJsonBeginItem(json);
+			json->chunked = true;
+			json->chunkedBytes = (token == CborIteratorTokenBeginByteStrings);
+			json->chunkedEncoding = encoding;
+			json->carrySize = 0;
+			CborJsonWriteChar(json, '"');
+			break;
+		case CborIteratorTokenEndByteStrings:
+		case CborIteratorTokenEndCharStrings:
+			if (json->carrySize > 0) {
+				CborJsonWriteBytes(json, json->chunkedEncoding, json->carry, json->carrySize);
+				json->carrySize = 0;
+			}
+			json->chunked = false;
+			CborJsonWriteChar(json, '"');
+			CborJsonEndItem(json);
+			complete = (json->depth == 0);
+			break;
+		default:
+			break;
+		}
+	}
+
+	CborJsonFlush(json);
+	CborIteratorFinalize(&iter);
+
+	if (json->capacity > CBOR_STACK_DEFAULT_SIZE) {
+		CborFree(json->frames);
+	}
+	CborFree(json);
+
+	return ret && complete && !iter.malformed;
+}
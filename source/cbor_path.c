@@ -0,0 +1,503 @@
+
+#include "cbor_alloc.h"
+#include "cbor_path.h"
+#include "cbor_tape.h"
+#include "cbor_typeinfo.h"
+
+#include <string.h>
+#include <limits.h>
+
+struct CborPathTrieIndexChild {
+	long int index;
+	uint32_t node;
+};
+
+bool CborPathParseIndex(const CborData *step, long int *ret) {
+	const uint8_t *ptr = step->ptr;
+	const uint8_t *end = step->ptr + step->size;
+	bool negative = false;
+	long int value = 0;
+
+	if (ptr < end && (*ptr == '-' || *ptr == '+')) {
+		negative = (*ptr == '-');
+		++ ptr;
+	}
+
+	if (ptr == end) {
+		return false;
+	}
+
+	while (ptr < end) {
+		if (*ptr < '0' || *ptr > '9') {
+			return false;
+		}
+		value = value * 10 + (*ptr - '0');
+		if (value > INT_MAX) {
+			return false;
+		}
+		++ ptr;
+	}
+
+	*ret = negative ? -value : value;
+	return true;
+}
+
+void CborPathInit(CborPath *path, const CborData *steps, uint32_t nsteps) {
+	uint32_t i;
+
+	path->nsteps = nsteps;
+	path->steps = NULL;
+
+	if (nsteps == 0) {
+		return;
+	}
+
+	path->steps = CborAlloc(sizeof(CborPathStep) * nsteps);
+	for (i = 0; i < nsteps; ++ i) {
+		CborPathStep *step = &path->steps[i];
+		step->key = steps[i];
+		step->index = 0;
+		step->isIndex = CborPathParseIndex(&steps[i], &step->index);
+		CborKeyProbeInit(&step->probe, (const char *)steps[i].ptr, steps[i].size);
+	}
+}
+
+void CborPathFinalize(CborPath *path) {
+	if (path->steps) {
+		CborFree(path->steps);
+	}
+	path->steps = NULL;
+	path->nsteps = 0;
+}
+
+bool CborIteratorGetPath(CborIteratorContext *ctx, const CborPath *path) {
+	CborIteratorToken token = CborIteratorNext(ctx);
+	uint32_t i;
+
+	switch (token) {
+	case CborIteratorTokenBeginArray:
+	case CborIteratorTokenBeginObject:
+		break;
+	case CborIteratorTokenValue:
+	case CborIteratorTokenBeginByteStrings:
+	case CborIteratorTokenBeginCharStrings:
+		return path->nsteps == 0;
+		break;
+	default:
+		return false;
+		break;
+	}
+
+	for (i = 0; i < path->nsteps; ++ i) {
+		const CborPathStep *step = &path->steps[i];
+		switch (token) {
+		case CborIteratorTokenBeginArray:
+			if (!step->isIndex || !CborIteratorGetIth(ctx, step->index)) {
+				return false;
+			}
+			break;
+		case CborIteratorTokenBeginObject:
+			if (!CborIteratorGetKeyProbe(ctx, &step->probe)) {
+				return false;
+			}
+			break;
+		default:
+			return false;
+			break;
+		}
+		token = ctx->token;
+	}
+
+	return true;
+}
+
+static uint32_t CborPathTrieAddNode(CborPathTrie *trie, uint32_t parent, const CborData *step) {
+	CborPathTrieNode *node;
+	uint32_t idx = trie->nnodes;
+
+	if (trie->nnodes == trie->nodesCapacity) {
+		trie->nodesCapacity = trie->nodesCapacity ? trie->nodesCapacity * 2 : 8;
+		if (trie->nodes) {
+			trie->nodes = CborRealloc(trie->nodes, trie->nodesCapacity * sizeof(CborPathTrieNode));
+		} else {
+			trie->nodes = CborAlloc(trie->nodesCapacity * sizeof(CborPathTrieNode));
+		}
+	}
+
+	node = &trie->nodes[trie->nnodes ++];
+	memset(node, 0, sizeof(CborPathTrieNode));
+	node->parent = parent;
+	node->child = CBOR_PATH_NONE;
+	node->sibling = CBOR_PATH_NONE;
+
+	if (step) {
+		node->step = *step;
+		node->isIndex = CborPathParseIndex(step, &node->index);
+
+		// append as last child to keep path order
+		if (trie->nodes[parent].child == CBOR_PATH_NONE) {
+			trie->nodes[parent].child = idx;
+		} else {
+			uint32_t it = trie->nodes[parent].child;
+			while (trie->nodes[it].sibling != CBOR_PATH_NONE) {
+				it = trie->nodes[it].sibling;
+			}
+			trie->nodes[it].sibling = idx;
+		}
+		++ trie->nodes[parent].nchildren;
+	} else {
+		node->parent = CBOR_PATH_NONE;
+	}
+
+	return idx;
+}
+
+void CborPathTrieInit(CborPathTrie *trie) {
+	memset(trie, 0, sizeof(CborPathTrie));
+	CborPathTrieAddNode(trie, CBOR_PATH_NONE, NULL);
+}
+
+void CborPathTrieFinalize(CborPathTrie *trie) {
+	if (trie->nodes) {
+		CborFree(trie->nodes);
+	}
+	if (trie->paths) {
+		CborFree(trie->paths);
+	}
+	memset(trie, 0, sizeof(CborPathTrie));
+}
+
+uint32_t CborPathTrieAdd(CborPathTrie *trie, const CborData *steps, uint32_t nsteps) {
+	uint32_t node = 0;
+	uint32_t i;
+
+	for (i = 0; i < nsteps; ++ i) {
+		uint32_t it = trie->nodes[node].child;
+		while (it != CBOR_PATH_NONE) {
+			const CborData *step = &trie->nodes[it].step;
+			if (step->size == steps[i].size && memcmp(step->ptr, steps[i].ptr, step->size) == 0) {
+				break;
+			}
+			it = trie->nodes[it].sibling;
+		}
+
+		if (it == CBOR_PATH_NONE) {
+			it = CborPathTrieAddNode(trie, node, &steps[i]);
+		}
+		node = it;
+	}
+
+	trie->nodes[node].terminal = true;
+
+	if (trie->npaths == trie->pathsCapacity) {
+		trie->pathsCapacity = trie->pathsCapacity ? trie->pathsCapacity * 2 : 8;
+		if (trie->paths) {
+			trie->paths = CborRealloc(trie->paths, trie->pathsCapacity * sizeof(uint32_t));
+		} else {
+			trie->paths = CborAlloc(trie->pathsCapacity * sizeof(uint32_t));
+		}
+	}
+
+	trie->paths[trie->npaths] = node;
+	return trie->npaths ++;
+}
+
+static bool CborPathTrieResolveNode(CborPathTrie *trie, CborIteratorContext *ctx, uint32_t idx);
+
+static bool CborPathTrieResolveArray(CborPathTrie *trie, CborIteratorContext *ctx, uint32_t idx) {
+	struct CborPathTrieIndexChild *children;
+	uint32_t stackSize = ctx->stackSize;
+	uint32_t count = ctx->stackHead->count;
+	uint32_t nchildren = 0;
+	uint32_t it, i, j;
+
+	children = CborAlloc(sizeof(struct CborPathTrieIndexChild) * trie->nodes[idx].nchildren);
+
+	it = trie->nodes[idx].child;
+	while (it != CBOR_PATH_NONE) {
+		const CborPathTrieNode *node = &trie->nodes[it];
+		long int index = node->index;
+
+		it = node->sibling;
+		if (!node->isIndex) {
+			continue;
+		}
+
+		if (index < 0) {
+			if (count == UINT32_MAX) {
+				// size of undefined length array is not known in forward pass
+				trie->nodes[node - trie->nodes].deferred = true;
+				continue;
+			}
+			index += count;
+		}
+
+		if (index < 0 || (count != UINT32_MAX && index >= count)) {
+			continue;
+		}
+
+		// insert, ordered by index
+		j = nchildren ++;
+		while (j > 0 && children[j - 1].index > index) {
+			children[j] = children[j - 1];
+			-- j;
+		}
+		children[j].index = index;
+		children[j].node = node - trie->nodes;
+	}
+
+	for (i = 0; i < nchildren; ++ i) {
+		uint32_t position = ctx->stackHead->position;
+
+		// same element, referenced with another index step (like `-1` and `2` or `1` and `01`),
+		// whole subtree will be resolved with fallback
+		if ((uint32_t)children[i].index < position) {
+			trie->nodes[children[i].node].deferred = true;
+			continue;
+		}
+
+		if (!CborIteratorSkip(ctx, children[i].index - position)) {
+			break;
+		}
+
+		CborIteratorNext(ctx);
+		if (ctx->stackSize < stackSize || ctx->token == CborIteratorTokenDone) {
+			// end of undefined length array
+			CborFree(children);
+			return ctx->token != CborIteratorTokenDone;
+		}
+
+		if (!CborPathTrieResolveNode(trie, ctx, children[i].node)) {
+			CborFree(children);
+			return false;
+		}
+	}
+
+	CborFree(children);
+	return CborIteratorSkipContainer(ctx);
+}
+
+static uint32_t CborPathTrieMatchKey(CborPathTrie *trie, uint32_t idx, uint32_t epoch, const uint8_t *key, uint32_t size) {
+	uint32_t it = trie->nodes[idx].child;
+	while (it != CBOR_PATH_NONE) {
+		CborPathTrieNode *node = &trie->nodes[it];
+		if (node->epoch != epoch && node->step.size == size && memcmp(node->step.ptr, key, size) == 0) {
+			return it;
+		}
+		it = node->sibling;
+	}
+	return CBOR_PATH_NONE;
+}
+
+static bool CborPathTrieResolveObject(CborPathTrie *trie, CborIteratorContext *ctx, uint32_t idx) {
+	uint32_t stackSize = ctx->stackSize;
+	uint32_t remaining = trie->nodes[idx].nchildren;
+	uint32_t epoch = ++ trie->epoch; // marks children, that was already matched within this object
+	bool ret = true;
+
+	uint8_t *buf = NULL;
+	uint32_t bufSize = 0;
+	uint32_t bufCapacity = 0;
+
+	while (remaining > 0 && ret) {
+		CborIteratorToken token = CborIteratorNext(ctx);
+		uint32_t match = CBOR_PATH_NONE;
+
+		if (ctx->stackSize < stackSize || token == CborIteratorTokenDone) {
+			break;
+		}
+
+		if (token == CborIteratorTokenKey) {
+			if (ctx->type == CborMajorTypeByteString || ctx->type == CborMajorTypeCharString) {
+				match = CborPathTrieMatchKey(trie, idx, epoch, ctx->current.ptr, ctx->objectSize);
+			}
+			if (match == CBOR_PATH_NONE) {
+				ret = CborIteratorSkipValue(ctx);
+			}
+		} else if (token == CborIteratorTokenBeginCharStrings || token == CborIteratorTokenBeginByteStrings) {
+			// collect chunked key
+			bufSize = 0;
+			while (CborIteratorNext(ctx) == CborIteratorTokenValue) {
+				if (bufSize + ctx->objectSize > bufCapacity) {
+					bufCapacity = (bufSize + ctx->objectSize) * 2;
+					buf = buf ? CborRealloc(buf, bufCapacity) : CborAlloc(bufCapacity);
+				}
+				memcpy(buf + bufSize, ctx->current.ptr, ctx->objectSize);
+				bufSize += ctx->objectSize;
+			}
+			match = CborPathTrieMatchKey(trie, idx, epoch, buf, bufSize);
+		} else {
+			ret = CborIteratorSkipValue(ctx);
+		}
+
+		if (!ret) {
+			break;
+		} else if (match == CBOR_PATH_NONE) {
+			ret = CborIteratorSkip(ctx, 1);
+		} else {
+			trie->nodes[match].epoch = epoch;
+			-- remaining;
+
+			CborIteratorNext(ctx);
+			ret = CborPathTrieResolveNode(trie, ctx, match);
+		}
+	}
+
+	if (buf) {
+		CborFree(buf);
+	}
+
+	if (!ret) {
+		return false;
+	} else if (ctx->stackSize < stackSize) {
+		return true;
+	}
+	return CborIteratorSkipContainer(ctx);
+}
+
+static bool CborPathTrieResolveNode(CborPathTrie *trie, CborIteratorContext *ctx, uint32_t idx) {
+	const uint8_t *begin = CborIteratorGetCurrentValuePtr(ctx);
+	bool ret;
+
+	if (!begin) {
+		return false;
+	}
+
+	if (trie->nodes[idx].nchildren > 0 && ctx->token == CborIteratorTokenBeginArray) {
+		ret = CborPathTrieResolveArray(trie, ctx, idx);
+	} else if (trie->nodes[idx].nchildren > 0 && ctx->token == CborIteratorTokenBeginObject) {
+		ret = CborPathTrieResolveObject(trie, ctx, idx);
+	} else {
+		ret = CborIteratorSkipValue(ctx);
+	}
+
+	// container, that was closed at the end of truncated data, is not complete value
+	if (ret && trie->nodes[idx].terminal && !ctx->malformed) {
+		trie->nodes[idx].resolved = true;
+		trie->nodes[idx].value.ptr = begin;
+		trie->nodes[idx].value.size = ctx->current.ptr - begin;
+	}
+
+	return ret;
+}
+
+// resolve single path from root, used when one array element is referenced
+// with several index steps, and can not be resolved in one pass;
+// tape is shared by all fallback lookups, NULL if document can not be indexed (like truncated prefix)
+static bool CborPathTrieResolveFallback(CborPathTrie *trie, const CborTape *tape, const uint8_t *data, size_t size, uint32_t idx) {
+	CborIteratorContext iter;
+	uint32_t depth = 0;
+	uint32_t *chain;
+	uint32_t it = idx;
+	uint32_t i;
+	bool ret = true;
+
+	while (trie->nodes[it].parent != CBOR_PATH_NONE) {
+		++ depth;
+		it = trie->nodes[it].parent;
+	}
+
+	chain = CborAlloc(sizeof(uint32_t) * (depth + 1));
+	i = depth;
+	it = idx;
+	while (trie->nodes[it].parent != CBOR_PATH_NONE) {
+		chain[-- i] = it;
+		it = trie->nodes[it].parent;
+	}
+
+	if (!(tape ? CborIteratorInitTape(&iter, tape) : CborIteratorInit(&iter, data, size))) {
+		CborFree(chain);
+		return false;
+	}
+
+	CborIteratorNext(&iter);
+	for (it = 0; it < depth && ret; ++ it) {
+		const CborPathTrieNode *node = &trie->nodes[chain[it]];
+		if (iter.token == CborIteratorTokenBeginArray && node->isIndex) {
+			ret = CborIteratorGetIth(&iter, node->index);
+		} else if (iter.token == CborIteratorTokenBeginObject) {
+			ret = CborIteratorGetKey(&iter, (const char *)node->step.ptr, node->step.size);
+		} else {
+			ret = false;
+		}
+	}
+
+	if (ret) {
+		const uint8_t *begin = CborIteratorGetCurrentValuePtr(&iter);
+		if (begin && CborIteratorSkipValue(&iter) && !iter.malformed) {
+			trie->nodes[idx].resolved = true;
+			trie->nodes[idx].value.ptr = begin;
+			trie->nodes[idx].value.size = iter.current.ptr - begin;
+		}
+	}
+
+	CborIteratorFinalize(&iter);
+	CborFree(chain);
+	return true;
+}
+
+bool CborPathTrieResolve(CborPathTrie *trie, const uint8_t *data, size_t size) {
+	CborIteratorContext iter;
+	CborTape tape;
+	bool tapeInit = false;
+	bool tapeValid = false;
+	uint32_t i;
+	bool ret;
+
+	for (i = 0; i < trie->nnodes; ++ i) {
+		trie->nodes[i].resolved = false;
+		trie->nodes[i].deferred = false;
+		trie->nodes[i].epoch = 0;
+		trie->nodes[i].value.ptr = NULL;
+		trie->nodes[i].value.size = 0;
+	}
+	trie->epoch = 0;
+
+	if (!CborIteratorInit(&iter, data, size)) {
+		return false;
+	}
+
+	CborIteratorNext(&iter);
+	ret = CborPathTrieResolveNode(trie, &iter, 0) && !iter.malformed;
+	CborIteratorFinalize(&iter);
+
+	for (i = 0; i < trie->nnodes; ++ i) {
+		uint32_t it = i;
+
+		if (!trie->nodes[i].terminal || trie->nodes[i].resolved) {
+			continue;
+		}
+
+		// deferred flag is set on the topmost skipped node only, so parents are checked too
+		while (it != CBOR_PATH_NONE && !trie->nodes[it].deferred) {
+			it = trie->nodes[it].parent;
+		}
+		if (it == CBOR_PATH_NONE) {
+			continue;
+		}
+
+		// repeated lookups from root use random access with tape, instead of scanning data
+		if (!tapeInit) {
+			tapeInit = true;
+			tapeValid = CborTapeInit(&tape, data, size);
+		}
+		CborPathTrieResolveFallback(trie, tapeValid ? &tape : NULL, data, size, i);
+	}
+
+	if (tapeInit) {
+		CborTapeFinalize(&tape);
+	}
+
+	return ret;
+}
+
+const CborData *CborPathTrieGetValue(const CborPathTrie *trie, uint32_t path) {
+	const CborPathTrieNode *node;
+
+	if (path >= trie->npaths) {
+		return NULL;
+	}
+
+	node = &trie->nodes[trie->paths[path]];
+	return node->resolved ? &node->value : NULL;
+}
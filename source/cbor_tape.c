@@ -0,0 +1,285 @@
+
+#include "cbor_alloc.h"
+#include "cbor_tape.h"
+#include "cbor_typeinfo.h"
+
+#include <string.h>
+
+struct CborTapeFrame {
+	uint32_t entry;
+	uint32_t base; // position of first direct child in scratch list
+	uint32_t remaining; // UINT32_MAX for undefined length container
+};
+
+struct CborTapeBuilder {
+	CborTape *tape;
+	const uint8_t *data;
+
+	uint32_t scratchSize;
+	uint32_t scratchCapacity;
+	uint32_t *scratch;
+
+	uint32_t framesSize;
+	uint32_t framesCapacity;
+	struct CborTapeFrame *frames;
+};
+
+static void *CborTapeGrow(void *ptr, uint32_t *capacity, uint32_t required, size_t elt) {
+	uint32_t cap = *capacity ? *capacity : 8;
+	while (cap < required) {
+		cap *= 2;
+	}
+
+	if (cap != *capacity || !ptr) {
+		ptr = ptr ? CborRealloc(ptr, cap * elt) : CborAlloc(cap * elt);
+		*capacity = cap;
+	}
+	return ptr;
+}
+
+static void CborTapeCloseFrame(struct CborTapeBuilder *b, const uint8_t *ptr) {
+	CborTape *tape = b->tape;
+	struct CborTapeFrame *frame = &b->frames[-- b->framesSize];
+	CborTapeEntry *entry = &tape->entries[frame->entry];
+	uint32_t count = b->scratchSize - frame->base;
+
+	if (tape->childrenSize + count > tape->childrenCapacity) {
+		tape->children = CborTapeGrow(tape->children, &tape->childrenCapacity, tape->childrenSize + count, sizeof(uint32_t));
+	}
+
+	entry->end = ptr - b->data;
+	entry->next = tape->size;
+	entry->children = tape->childrenSize;
+	entry->count = count;
+
+	if (count > 0) {
+		memcpy(tape->children + tape->childrenSize, b->scratch + frame->base, count * sizeof(uint32_t));
+		tape->childrenSize += count;
+	}
+	b->scratchSize = frame->base;
+}
+
+// item was completed, close all definite containers that was completed with it
+static void CborTapeComplete(struct CborTapeBuilder *b, const uint8_t *ptr) {
+	while (b->framesSize > 0) {
+		struct CborTapeFrame *frame = &b->frames[b->framesSize - 1];
+		if (frame->remaining == UINT32_MAX) {
+			return;
+		}
+
+		-- frame->remaining;
+		if (frame->remaining > 0) {
+			return;
+		}
+
+		CborTapeCloseFrame(b, ptr);
+	}
+}
+
+static void CborTapePushFrame(struct CborTapeBuilder *b, uint32_t entry, uint32_t remaining) {
+	struct CborTapeFrame *frame;
+
+	if (b->framesSize == b->framesCapacity) {
+		b->frames = CborTapeGrow(b->frames, &b->framesCapacity, b->framesSize + 1, sizeof(struct CborTapeFrame));
+	}
+
+	frame = &b->frames[b->framesSize ++];
+	frame->entry = entry;
+	frame->base = b->scratchSize;
+	frame->remaining = remaining;
+}
+
+static uint32_t CborTapePushEntry(struct CborTapeBuilder *b, uint32_t offset, uint8_t type, uint8_t info) {
+	CborTape *tape = b->tape;
+	CborTapeEntry *entry;
+	uint32_t idx = tape->size;
+
+	if (tape->size == tape->capacity) {
+		tape->entries = CborTapeGrow(tape->entries, &tape->capacity, tape->size + 1, sizeof(CborTapeEntry));
+	}
+
+	entry = &tape->entries[tape->size ++];
+	entry->offset = offset;
+	entry->end = offset;
+	entry->next = idx + 1;
+	entry->children = 0;
+	entry->count = 0;
+	entry->type = type;
+	entry->info = info;
+
+	if (b->framesSize > 0) {
+		if (b->scratchSize == b->scratchCapacity) {
+			b->scratch = CborTapeGrow(b->scratch, &b->scratchCapacity, b->scratchSize + 1, sizeof(uint32_t));
+		}
+		b->scratch[b->scratchSize ++] = idx;
+	}
+
+	return idx;
+}
+
+static bool CborTapeBuild(struct CborTapeBuilder *b, const uint8_t *ptr, const uint8_t *end) {
+	uint8_t type, info;
+	uint64_t value;
+	uint32_t idx;
+
+	while (ptr < end) {
+		uint32_t offset = ptr - b->data;
+
+		type = *ptr ++;
+		if (type == CborFlagsInterrupt) {
+			if (b->framesSize == 0 || b->frames[b->framesSize - 1].remaining != UINT32_MAX) {
+				return false;
+			}
+			CborTapeCloseFrame(b, ptr);
+			CborTapeComplete(b, ptr);
+			continue;
+		}
+
+		info = type & CborFlagsAdditionalInfoMask;
+		type = (type & CborFlagsMajorTypeMaskEncoded) >> CborFlagsMajorTypeShift;
+
+		if (info < CborFlagsMaxAdditionalNumber) {
+			value = info;
+		} else if (info <= CborFlagsAdditionalNumber64Bit) {
+			uint32_t len = 1 << (info - CborFlagsAdditionalNumber8Bit);
+			CborData data = { len, ptr };
+			if ((size_t)(end - ptr) < len) {
+				return false;
+			}
+			value = CborDataGetUnsignedValue(&data, info);
+			ptr += len;
+		} else if (info == CborFlagsUndefinedLength) {
+			value = UINT32_MAX;
+		} else {
+			return false;
+		}
+
+		idx = CborTapePushEntry(b, offset, type, info);
+
+		switch (type) {
+		case CborMajorTypeByteString:
+		case CborMajorTypeCharString:
+			if (info == CborFlagsUndefinedLength) {
+				CborTapePushFrame(b, idx, UINT32_MAX);
+				continue;
+			}
+			if (value > (uint64_t)(end - ptr)) {
+				return false;
+			}
+			ptr += value;
+			break;
+		case CborMajorTypeArray:
+		case CborMajorTypeMap:
+			if (info != CborFlagsUndefinedLength) {
+				if (type == CborMajorTypeMap) {
+					if (value > (uint64_t)(end - ptr) / 2) {
+						return false;
+					}
+					value *= 2;
+				} else if (value > (uint64_t)(end - ptr)) {
+					return false;
+				}
+			}
+
+			CborTapePushFrame(b, idx, value);
+			if (value == 0) {
+				CborTapeCloseFrame(b, ptr);
+				break;
+			}
+			continue;
+			break;
+		case CborMajorTypeTag:
+			if (info == CborFlagsUndefinedLength) {
+				return false;
+			}
+			CborTapePushFrame(b, idx, 1);
+			continue;
+			break;
+		default:
+			if (info == CborFlagsUndefinedLength) {
+				return false;
+			}
+			break;
+		}
+
+		b->tape->entries[idx].end = ptr - b->data;
+		CborTapeComplete(b, ptr);
+	}
+
+	return b->framesSize == 0;
+}
+
+bool CborTapeInit(CborTape *tape, const uint8_t *data, size_t size) {
+	struct CborTapeBuilder builder;
+	bool ret;
+
+	memset(tape, 0, sizeof(CborTape));
+
+	if (data_is_cbor(data, size)) {
+		data += CborHeaderSize;
+		size -= CborHeaderSize;
+	} else if (size == 0) {
+		return false;
+	}
+
+	tape->data.ptr = data;
+	tape->data.size = size;
+
+	memset(&builder, 0, sizeof(struct CborTapeBuilder));
+	builder.tape = tape;
+	builder.data = data;
+
+	ret = CborTapeBuild(&builder, data, data + size);
+
+	if (builder.scratch) {
+		CborFree(builder.scratch);
+	}
+	if (builder.frames) {
+		CborFree(builder.frames);
+	}
+
+	if (!ret) {
+		CborTapeFinalize(tape);
+	}
+	return ret;
+}
+
+void CborTapeFinalize(CborTape *tape) {
+	if (tape->entries) {
+		CborFree(tape->entries);
+	}
+	if (tape->children) {
+		CborFree(tape->children);
+	}
+	memset(tape, 0, sizeof(CborTape));
+}
+
+uint32_t CborTapeFind(const CborTape *tape, const uint8_t *ptr, uint32_t hint) {
+	uint32_t offset, low, high;
+
+	if (ptr < tape->data.ptr || ptr >= tape->data.ptr + tape->data.size) {
+		return CBOR_TAPE_NOT_FOUND;
+	}
+
+	offset = ptr - tape->data.ptr;
+	if (hint < tape->size && tape->entries[hint].offset == offset) {
+		return hint;
+	}
+
+	// entries are sorted by offset
+	low = 0;
+	high = tape->size;
+	while (low < high) {
+		uint32_t mid = low + (high - low) / 2;
+		if (tape->entries[mid].offset < offset) {
+			low = mid + 1;
+		} else {
+			high = mid;
+		}
+	}
+
+	if (low < tape->size && tape->entries[low].offset == offset) {
+		return low;
+	}
+	return CBOR_TAPE_NOT_FOUND;
+}
@@ -0,0 +1,265 @@
+
+#include "cbor_iter.h"
+#include "cbor_typeinfo.h"
+
+#include <string.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// nesting limit for containers, tags and undefined length strings
+#define CBOR_VALIDATE_MAX_DEPTH 512
+
+// two-byte form is well-formed only for simple values from 32 (RFC 8949, section 3.3)
+#define CBOR_VALIDATE_MIN_SIMPLE8 32
+
+struct CborValidateFrame {
+	uint64_t remaining; // items left in definite container, UINT64_MAX for undefined length
+	uint8_t major; // major type of container, tag or undefined length string
+	bool odd; // undefined length container: odd number of items (key without value for map)
+};
+
+// skip ASCII bytes with vector compare, returns first non-ASCII byte or end
+static inline const uint8_t *CborValidateAscii(const uint8_t *ptr, const uint8_t *end) {
+#if defined(__AVX2__)
+	while (end - ptr >= 32) {
+		__m256i v = _mm256_loadu_si256((const __m256i *)ptr);
+		if (_mm256_movemask_epi8(v) != 0) {
+			break;
+		}
+		ptr += 32;
+	}
+#endif
+#if defined(__SSE2__)
+	while (end - ptr >= 16) {
+		__m128i v = _mm_loadu_si128((const __m128i *)ptr);
+		if (_mm_movemask_epi8(v) != 0) {
+			break;
+		}
+		ptr += 16;
+	}
+#else
+	while (end - ptr >= 8) {
+		uint64_t v;
+		memcpy(&v, ptr, sizeof(uint64_t));
+		if (v & 0x8080808080808080ULL) {
+			break;
+		}
+		ptr += 8;
+	}
+#endif
+	while (ptr < end && *ptr < 0x80) {
+		++ ptr;
+	}
+	return ptr;
+}
+
+// UTF-8 well-formed sequences according to RFC 3629, section 4
+bool CborValidateUtf8(const uint8_t *ptr, const uint8_t *end) {
+	while (ptr < end) {
+		uint8_t c, lo = 0x80, hi = 0xBF;
+		uint32_t len;
+
+		ptr = CborValidateAscii(ptr, end);
+		if (ptr == end) {
+			break;
+		}
+
+		c = *ptr;
+		if (c >= 0xC2 && c <= 0xDF) {
+			len = 1;
+		} else if (c >= 0xE0 && c <= 0xEF) {
+			len = 2;
+			if (c == 0xE0) {
+				lo = 0xA0;
+			} else if (c == 0xED) {
+				hi = 0x9F; // surrogates
+			}
+		} else if (c >= 0xF0 && c <= 0xF4) {
+			len = 3;
+			if (c == 0xF0) {
+				lo = 0x90;
+			} else if (c == 0xF4) {
+				hi = 0x8F;
+			}
+		} else {
+			return false;
+		}
+
+		if ((size_t)(end - ptr) <= len) {
+			return false;
+		}
+
+		if (ptr[1] < lo || ptr[1] > hi) {
+			return false;
+		}
+		if (len > 1 && (ptr[2] & 0xC0) != 0x80) {
+			return false;
+		}
+		if (len > 2 && (ptr[3] & 0xC0) != 0x80) {
+			return false;
+		}
+
+		ptr += len + 1;
+	}
+	return true;
+}
+
+bool CborValidate(const uint8_t *data, size_t size) {
+	return CborValidateWithFlags(data, size, CborValidateStrict);
+}
+
+bool CborValidateWithFlags(const uint8_t *data, size_t size, uint32_t flags) {
+	struct CborValidateFrame stack[CBOR_VALIDATE_MAX_DEPTH];
+	struct CborValidateFrame *top;
+	const uint8_t *ptr, *end;
+	uint32_t depth;
+
+	if (data_is_cbor(data, size)) {
+		data += CborHeaderSize;
+		size -= CborHeaderSize;
+	} else if (size == 0) {
+		return false;
+	}
+
+	ptr = data;
+	end = data + size;
+
+	// root frame expects exactly one item
+	depth = 1;
+	top = &stack[0];
+	top->remaining = 1;
+	top->major = CborMajorTypeArray;
+	top->odd = false;
+
+	while (depth > 0) {
+		const CborInitialByte *desc;
+		uint8_t info;
+		uint64_t value;
+
+		if (top->remaining == 0) {
+			// definite container or tag is complete, it counts as single item within parent
+			-- depth;
+			if (depth == 0) {
+				break;
+			}
+			top = &stack[depth - 1];
+			if (top->remaining != UINT64_MAX) {
+				-- top->remaining;
+			} else {
+				top->odd = !top->odd;
+			}
+			continue;
+		}
+
+		if (ptr == end) {
+			return false;
+		}
+
+		desc = &CborInitialByteTable[*ptr];
+		info = *ptr & CborFlagsAdditionalInfoMask;
+
+		if (desc->flags & CborInitialByteFlagBreak) {
+			if (top->remaining != UINT64_MAX || (top->major == CborMajorTypeMap && top->odd)) {
+				return false;
+			}
+			++ ptr;
+			top->remaining = 0;
+			continue;
+		}
+
+		if (desc->flags & CborInitialByteFlagInvalid) {
+			return false;
+		}
+
+		// chunks of undefined length string should be definite strings of the same type
+		if (top->remaining == UINT64_MAX && (top->major == CborMajorTypeByteString || top->major == CborMajorTypeCharString)) {
+			if (desc->major != top->major || (desc->flags & CborInitialByteFlagIndefinite)) {
+				return false;
+			}
+		}
+
+		if ((size_t)(end - ptr) <= desc->length) {
+			return false;
+		}
+
+		if (desc->length > 0) {
+			CborData arg = { desc->length, ptr + 1 };
+			value = CborDataGetUnsignedValue(&arg, info);
+		} else {
+			value = info;
+		}
+		ptr += 1 + desc->length;
+
+		if (desc->flags & CborInitialByteFlagIndefinite) {
+			if (depth == CBOR_VALIDATE_MAX_DEPTH) {
+				return false;
+			}
+			top = &stack[depth ++];
+			top->remaining = UINT64_MAX;
+			top->major = desc->major;
+			top->odd = false;
+			continue;
+		}
+
+		switch (desc->major) {
+		case CborMajorTypeByteString:
+		case CborMajorTypeCharString:
+			if (value > (uint64_t)(end - ptr)) {
+				return false;
+			}
+			if (desc->major == CborMajorTypeCharString && !CborValidateUtf8(ptr, ptr + value)) {
+				return false;
+			}
+			ptr += value;
+			break;
+		case CborMajorTypeArray:
+		case CborMajorTypeMap:
+		case CborMajorTypeTag:
+			if (desc->major == CborMajorTypeMap) {
+				if (value > (uint64_t)(end - ptr) / 2) {
+					return false;
+				}
+				value *= 2;
+			} else if (desc->major == CborMajorTypeTag) {
+				value = 1;
+			} else if (value > (uint64_t)(end - ptr)) {
+				return false;
+			}
+
+			if (value > 0) {
+				if (depth == CBOR_VALIDATE_MAX_DEPTH) {
+					return false;
+				}
+				top = &stack[depth ++];
+				top->remaining = value;
+				top->major = desc->major;
+				top->odd = false;
+				continue;
+			}
+			break;
+		case CborMajorTypeSimple:
+			// two-byte form for simple values, that fit into initial byte, is never accepted
+			if (info == CborFlagsSimple8Bit && value < CBOR_VALIDATE_MIN_SIMPLE8) {
+				if (value < CborFlagsMaxAdditionalNumber || !(flags & CborValidateLegacySimple)) {
+					return false;
+				}
+			}
+			break;
+		default:
+			break;
+		}
+
+		// single complete item
+		if (top->remaining != UINT64_MAX) {
+			-- top->remaining;
+		} else {
+			top->odd = !top->odd;
+		}
+	}
+
+	return ptr == end;
+}
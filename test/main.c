@@ -7,8 +7,9 @@
 #include <ftw.h>
 #include <dirent.h>
 #include <stdarg.h>
+#include <time.h>
 
-#include "cbor.h"
+#include "test.h"
 
 static void print_hex(const uint8_t *s, size_t size) {
 	while (size > 0) {
@@ -61,15 +62,18 @@ void process_file_data(const char *filename, const uint8_t *data, size_t size) {
 	uint32_t level = 1;
 
 	struct CborWriter writer = {
-		(CborWriterPlain)printString,
-		(CborWriterFormat)printFormat,
-		NULL
+		.plain = (CborWriterPlain)printString,
+		.format = (CborWriterFormat)printFormat,
+		.ctx = NULL,
+		.buffer = NULL,
 	};
 
 	CborIteratorContext iter;
 	printf("File: %s\n", filename);
 	CborToString(&writer, data, size);
 	printf("\n");
+	CborToJson(&writer, data, size);
+	printf("\n");
 
 	if (CborIteratorInit(&iter, data, size)) {
 		const char *path[] = {
@@ -161,6 +165,219 @@ void process_file_data(const char *filename, const uint8_t *data, size_t size) {
 	}*/
 }
 
+static double bench_now() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1000000000.0;
+}
+
+// previous key lookup: decode every token and compare every key with memcmp
+static bool bench_scalar_get_key(CborIteratorContext *ctx, const char *str, uint32_t size) {
+	uint32_t stackSize = ctx->stackSize;
+	while (ctx->token != CborIteratorTokenDone && ctx->stackSize >= stackSize) {
+		CborIteratorToken token = CborIteratorNext(ctx);
+		if (ctx->stackSize == stackSize && token == CborIteratorTokenKey) {
+			if (ctx->type == CborMajorTypeCharString && ctx->objectSize == size && memcmp(str, ctx->current.ptr, size) == 0) {
+				CborIteratorNext(ctx);
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+// wide map with short text keys: { "field_000": 0, "field_001": "value", ... }
+static size_t bench_make_wide_map(uint8_t *buf, uint32_t nkeys) {
+	size_t size = 0;
+	uint32_t i;
+
+	memcpy(buf, CborHeaderData, CborHeaderSize);
+	size += CborHeaderSize;
+	buf[size ++] = CborMajorTypeEncodedMap | CborFlagsAdditionalNumber16Bit;
+	buf[size ++] = nkeys >> 8;
+	buf[size ++] = nkeys & 0xFF;
+
+	for (i = 0; i < nkeys; ++ i) {
+		buf[size ++] = CborMajorTypeEncodedCharString | 9;
+		sprintf((char *)buf + size, "field_%03u", i);
+		size += 9;
+		if (i % 2) {
+			buf[size ++] = CborMajorTypeEncodedCharString | 5;
+			memcpy(buf + size, "value", 5);
+			size += 5;
+		} else {
+			buf[size ++] = CborMajorTypeEncodedUnsigned | CborFlagsAdditionalNumber8Bit;
+			buf[size ++] = i & 0xFF;
+		}
+	}
+	return size;
+}
+
+static int run_key_benchmark() {
+	static uint8_t buf[64 * 1024];
+	const uint32_t nkeys = 500;
+	const uint32_t niter = 20000;
+	size_t size = bench_make_wide_map(buf, nkeys);
+	const char *key = "field_499";
+	uint32_t i, found;
+	double t;
+
+	CborIteratorContext iter;
+
+	found = 0;
+	t = bench_now();
+	for (i = 0; i < niter; ++ i) {
+		CborIteratorInit(&iter, buf, size);
+		CborIteratorNext(&iter);
+		found += bench_scalar_get_key(&iter, key, strlen(key));
+		CborIteratorFinalize(&iter);
+	}
+	t = bench_now() - t;
+	printf("scalar key loop: %u lookups in %u-key map, %.3f us/lookup (found: %u)\n", niter, nkeys, t * 1000000.0 / niter, found);
+
+	found = 0;
+	t = bench_now();
+	for (i = 0; i < niter; ++ i) {
+		CborIteratorInit(&iter, buf, size);
+		CborIteratorNext(&iter);
+		found += CborIteratorGetKey(&iter, key, strlen(key));
+		CborIteratorFinalize(&iter);
+	}
+	t = bench_now() - t;
+	printf("CborIteratorGetKey: %u lookups in %u-key map, %.3f us/lookup (found: %u)\n", niter, nkeys, t * 1000000.0 / niter, found);
+
+	return 0;
+}
+
+static size_t bench_put_header(uint8_t *buf, uint8_t major, uint64_t value) {
+	if (value < CborFlagsMaxAdditionalNumber) {
+		buf[0] = major | value;
+		return 1;
+	} else if (value <= 0xFF) {
+		buf[0] = major | CborFlagsAdditionalNumber8Bit;
+		buf[1] = value;
+		return 2;
+	} else if (value <= 0xFFFF) {
+		buf[0] = major | CborFlagsAdditionalNumber16Bit;
+		buf[1] = value >> 8;
+		buf[2] = value & 0xFF;
+		return 3;
+	} else {
+		buf[0] = major | CborFlagsAdditionalNumber32Bit;
+		buf[1] = (value >> 24) & 0xFF;
+		buf[2] = (value >> 16) & 0xFF;
+		buf[3] = (value >> 8) & 0xFF;
+		buf[4] = value & 0xFF;
+		return 5;
+	}
+}
+
+static size_t bench_put_string(uint8_t *buf, const char *str) {
+	size_t len = strlen(str);
+	size_t size = bench_put_header(buf, CborMajorTypeEncodedCharString, len);
+	memcpy(buf + size, str, len);
+	return size + len;
+}
+
+// array of application records with mixed value types, used when no document is provided
+static size_t bench_make_document(uint8_t *buf, uint32_t napps) {
+	char str[64];
+	size_t size = 0;
+	uint32_t i, j;
+
+	memcpy(buf, CborHeaderData, CborHeaderSize);
+	size += CborHeaderSize;
+	size += bench_put_header(buf + size, CborMajorTypeEncodedArray, napps);
+
+	for (i = 0; i < napps; ++ i) {
+		size += bench_put_header(buf + size, CborMajorTypeEncodedMap, 8);
+
+		size += bench_put_string(buf + size, "id");
+		size += bench_put_header(buf + size, CborMajorTypeEncodedUnsigned, 100000 + i);
+
+		size += bench_put_string(buf + size, "name");
+		sprintf(str, "Application number %u", i);
+		size += bench_put_string(buf + size, str);
+
+		size += bench_put_string(buf + size, "version");
+		sprintf(str, "%u.%u.%u", i % 7, i % 13, i % 101);
+		size += bench_put_string(buf + size, str);
+
+		size += bench_put_string(buf + size, "rating");
+		buf[size ++] = CborMajorTypeEncodedSimple | CborFlagsAdditionalFloat64Bit;
+		memset(buf + size, 0x40, 8);
+		size += 8;
+
+		size += bench_put_string(buf + size, "downloads");
+		size += bench_put_header(buf + size, CborMajorTypeEncodedUnsigned, i * 7919);
+
+		size += bench_put_string(buf + size, "free");
+		buf[size ++] = CborMajorTypeEncodedSimple | ((i % 3) ? CborSimpleValueTrue : CborSimpleValueFalse);
+
+		size += bench_put_string(buf + size, "tags");
+		size += bench_put_header(buf + size, CborMajorTypeEncodedArray, 3);
+		size += bench_put_string(buf + size, "tools");
+		size += bench_put_string(buf + size, "social");
+		size += bench_put_header(buf + size, CborMajorTypeEncodedNegative, i);
+
+		size += bench_put_string(buf + size, "meta");
+		size += bench_put_header(buf + size, CborMajorTypeEncodedMap, 2);
+		size += bench_put_string(buf + size, "size");
+		size += bench_put_header(buf + size, CborMajorTypeEncodedUnsigned, 1024 * i);
+		size += bench_put_string(buf + size, "sha");
+		size += bench_put_header(buf + size, CborMajorTypeEncodedByteString, 20);
+		for (j = 0; j < 20; ++ j) {
+			buf[size ++] = (i * 31 + j) & 0xFF;
+		}
+	}
+	return size;
+}
+
+static int run_token_benchmark(const char *filename) {
+	static uint8_t buf[4 * 1024 * 1024];
+	const uint32_t niter = 200;
+	size_t size = 0;
+	uint64_t ntokens, nvalues;
+	uint32_t i;
+	double t;
+
+	CborIteratorContext iter;
+
+	if (filename) {
+		FILE *fp = fopen(filename, "r");
+		if (!fp) {
+			printf("Fail to open %s\n", filename);
+			return 1;
+		}
+		size = fread(buf, 1, sizeof(buf), fp);
+		fclose(fp);
+	} else {
+		size = bench_make_document(buf, 20000);
+	}
+
+	ntokens = 0;
+	nvalues = 0;
+	t = bench_now();
+	for (i = 0; i < niter; ++ i) {
+		if (CborIteratorInit(&iter, buf, size)) {
+			while (CborIteratorNext(&iter) != CborIteratorTokenDone) {
+				// accessors are called for every token by typical consumers
+				if (CborIteratorGetType(&iter) != CborTypeUnknown) {
+					++ nvalues;
+				}
+				++ ntokens;
+			}
+			CborIteratorFinalize(&iter);
+		}
+	}
+	t = bench_now() - t;
+	printf("CborIteratorNext: %lu bytes, %lu tokens per pass, %.2f Mtokens/s, %.1f MB/s (%lu typed)\n",
+			(unsigned long)size, (unsigned long)(ntokens / niter), ntokens / t / 1000000.0,
+			size * (double)niter / t / (1024.0 * 1024.0), (unsigned long)(nvalues / niter));
+
+	return 0;
+}
+
 void read_file(const char *dirname, const char *filename) {
 	char buf[PATH_MAX + 1] = { 0 };
 
@@ -200,12 +417,43 @@ void print_file(const char *dirname, const char *filename) {
 	}
 }
 
+static int run_tests() {
+	test_iter();
+	test_tape();
+	test_path();
+	test_stream();
+	test_validate();
+	test_encoder();
+	test_json();
+	test_encoding();
+	test_compare();
+	test_canonical();
+	test_contains();
+	test_edit();
+	test_merge();
+
+	printf("%u checks, %u failed\n", test_checks, test_failures);
+	return test_failures > 0 ? 1 : 0;
+}
+
 int main(int argc, char* argv[]) {
 	char buf[PATH_MAX + 1] = { 0 };
 
 	char *cwd = getcwd(buf, PATH_MAX);
 	strcat(cwd, "/test/data");
 
+	if (argc == 1 || strcmp(argv[1], "--test") == 0) {
+		return run_tests();
+	}
+
+	if (argc > 1 && strcmp(argv[1], "--bench-keys") == 0) {
+		return run_key_benchmark();
+	}
+
+	if (argc > 1 && strcmp(argv[1], "--bench-tokens") == 0) {
+		return run_token_benchmark(argc > 2 ? argv[2] : NULL);
+	}
+
 	if (argc > 1) {
 		cwd = realpath(argv[1], buf);
 	}
@@ -0,0 +1,111 @@
+
+#include "test.h"
+
+#include <string.h>
+#include <stdlib.h>
+#include <dirent.h>
+
+uint32_t test_checks = 0;
+uint32_t test_failures = 0;
+
+bool test_check(bool value, const char *expr, const char *file, int line) {
+	++ test_checks;
+	if (!value) {
+		++ test_failures;
+		printf("%s:%d: check failed: %s\n", file, line, expr);
+	}
+	return value;
+}
+
+static int test_hex_digit(char c) {
+	if (c >= '0' && c <= '9') {
+		return c - '0';
+	} else if (c >= 'a' && c <= 'f') {
+		return c - 'a' + 10;
+	} else if (c >= 'A' && c <= 'F') {
+		return c - 'A' + 10;
+	}
+	return -1;
+}
+
+size_t test_hex(uint8_t *buf, const char *hex) {
+	size_t size = 0;
+	int hi, lo;
+
+	while (*hex) {
+		if (*hex == ' ') {
+			++ hex;
+			continue;
+		}
+		hi = test_hex_digit(hex[0]);
+		lo = test_hex_digit(hex[1]);
+		if (hi < 0 || lo < 0) {
+			break;
+		}
+		buf[size ++] = (uint8_t)(hi << 4 | lo);
+		hex += 2;
+	}
+	return size;
+}
+
+bool test_hex_equal(const uint8_t *data, size_t size, const char *hex, const char *file, int line) {
+	uint8_t expected[1024];
+	size_t esize = test_hex(expected, hex);
+	size_t i;
+
+	if (test_check(size == esize && memcmp(data, expected, size) == 0, hex, file, line)) {
+		return true;
+	}
+
+	printf("\tgot: ");
+	for (i = 0; i < size; ++ i) {
+		printf("%02x", data[i]);
+	}
+	printf("\n");
+	return false;
+}
+
+uint32_t test_data_foreach(test_data_callback cb) {
+	char path[1024];
+	struct dirent *dp;
+	uint32_t count = 0;
+	DIR *dir = opendir("test/data");
+
+	if (!dir) {
+		return 0;
+	}
+
+	while ((dp = readdir(dir)) != NULL) {
+		const char *name = dp->d_name;
+		size_t len = strlen(name);
+		uint8_t *data;
+		long int size;
+		FILE *fp;
+
+		if (len <= 5 || memcmp(".cbor", name + len - 5, 5) != 0) {
+			continue;
+		}
+
+		snprintf(path, sizeof(path), "test/data/%s", name);
+		fp = fopen(path, "rb");
+		if (!fp) {
+			continue;
+		}
+
+		fseek(fp, 0, SEEK_END);
+		size = ftell(fp);
+		fseek(fp, 0, SEEK_SET);
+
+		data = malloc(size > 0 ? size : 1);
+		if (size == 0 || fread(data, size, 1, fp) == 1) {
+			cb(name, data, size);
+			++ count;
+		}
+
+		free(data);
+		fclose(fp);
+	}
+
+	closedir(dir);
+	return count;
+}
@@ -0,0 +1,46 @@
+
+#ifndef TEST_TEST_H_
+#define TEST_TEST_H_
+
+#include "cbor.h"
+
+#include <stdio.h>
+
+/* Functional tests: every test file provides test_<feature> function, that checks
+ * results with TEST_CHECK, failures are reported and counted, run continues */
+
+extern uint32_t test_checks;
+extern uint32_t test_failures;
+
+#define TEST_CHECK(cond) test_check((cond), #cond, __FILE__, __LINE__)
+
+bool test_check(bool, const char *expr, const char *file, int line);
+
+/** Decode hex string (spaces are skipped) into buffer, returns size */
+size_t test_hex(uint8_t *buf, const char *hex);
+
+/** Compare bytes with expected hex string, mismatch is printed */
+bool test_hex_equal(const uint8_t *data, size_t size, const char *hex, const char *file, int line);
+
+#define TEST_CHECK_HEX(data, size, hex) test_hex_equal((data), (size), (hex), __FILE__, __LINE__)
+
+typedef void (*test_data_callback)(const char *name, const uint8_t *data, size_t size);
+
+/** Call `cb` for every .cbor file within test/data (relative to working directory), returns number of files */
+uint32_t test_data_foreach(test_data_callback cb);
+
+void test_iter(void);
+void test_tape(void);
+void test_path(void);
+void test_stream(void);
+void test_validate(void);
+void test_encoder(void);
+void test_json(void);
+void test_encoding(void);
+void test_compare(void);
+void test_canonical(void);
+void test_contains(void);
+void test_edit(void);
+void test_merge(void);
+
+#endif /* TEST_TEST_H_ */
@@ -0,0 +1,166 @@
+
+#include "test.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static bool test_canonical_hex(const char *doc, const char *expected) {
+	uint8_t buf[256];
+	size_t size = test_hex(buf, doc);
+	CborEncoder enc;
+	CborData data;
+	bool ret = false;
+
+	CborEncoderInit(&enc, 0, false);
+	if (TEST_CHECK(CborCanonicalize(&enc, buf, size))) {
+		data = CborEncoderGetData(&enc);
+		ret = TEST_CHECK_HEX(data.ptr, data.size, expected);
+		TEST_CHECK(CborIsCanonical(data.ptr, data.size));
+	}
+	CborEncoderFinalize(&enc);
+	return ret;
+}
+
+static uint64_t test_hash_hex(const char *doc, uint64_t seed) {
+	uint8_t buf[256];
+	size_t size = test_hex(buf, doc);
+	uint64_t hash = 0;
+
+	TEST_CHECK(CborHash(buf, size, seed, &hash));
+	return hash;
+}
+
+#define TEST_HASH_DOCS 4096
+#define TEST_HASH_BUCKETS 256
+
+static int test_hash_cmp(const void *a, const void *b) {
+	uint64_t ha = *(const uint64_t *)a, hb = *(const uint64_t *)b;
+	return (ha < hb) ? -1 : ((ha > hb) ? 1 : 0);
+}
+
+// chi-square of bucket counts by hash bits from `shift`, expected value is TEST_HASH_BUCKETS - 1
+static double test_hash_chi2(const uint64_t *hashes, uint32_t count, uint32_t shift) {
+	uint32_t buckets[TEST_HASH_BUCKETS] = { 0 };
+	double expected = (double)count / TEST_HASH_BUCKETS, ret = 0.0;
+	uint32_t i;
+
+	for (i = 0; i < count; ++ i) {
+		++ buckets[(hashes[i] >> shift) % TEST_HASH_BUCKETS];
+	}
+	for (i = 0; i < TEST_HASH_BUCKETS; ++ i) {
+		ret += (buckets[i] - expected) * (buckets[i] - expected) / expected;
+	}
+	return ret;
+}
+
+// small distinct documents (integers, strings, arrays and maps) have distinct and evenly spread hashes
+static void test_hash_spread(void) {
+	uint64_t *hashes = malloc(TEST_HASH_DOCS * sizeof(uint64_t));
+	uint32_t i, collisions = 0;
+	bool ret = true;
+	CborEncoder enc;
+	CborData data;
+	char str[16];
+
+	for (i = 0; i < TEST_HASH_DOCS; ++ i) {
+		uint32_t value = i / 4;
+
+		CborEncoderInit(&enc, 0, false);
+		switch (i % 4) {
+		case 0:
+			CborEncodeUnsigned(&enc, value);
+			break;
+		case 1:
+			CborEncodeString(&enc, str, snprintf(str, sizeof(str), "%u", value));
+			break;
+		case 2:
+			CborEncodeBeginArray(&enc, 2);
+			CborEncodeUnsigned(&enc, value);
+			CborEncodeBool(&enc, true);
+			CborEncodeEnd(&enc);
+			break;
+		default:
+			CborEncodeBeginMap(&enc, 1);
+			CborEncodeString(&enc, "a", 1);
+			CborEncodeUnsigned(&enc, value);
+			CborEncodeEnd(&enc);
+			break;
+		}
+
+		data = CborEncoderGetData(&enc);
+		hashes[i] = 0;
+		ret = CborHash(data.ptr, data.size, 0, &hashes[i]) && ret;
+		CborEncoderFinalize(&enc);
+	}
+	TEST_CHECK(ret);
+
+	TEST_CHECK(test_hash_chi2(hashes, TEST_HASH_DOCS, 0) < 2 * TEST_HASH_BUCKETS);
+	TEST_CHECK(test_hash_chi2(hashes, TEST_HASH_DOCS, 56) < 2 * TEST_HASH_BUCKETS);
+
+	qsort(hashes, TEST_HASH_DOCS, sizeof(uint64_t), test_hash_cmp);
+	for (i = 1; i < TEST_HASH_DOCS; ++ i) {
+		if (hashes[i] == hashes[i - 1]) {
+			++ collisions;
+		}
+	}
+	TEST_CHECK(collisions == 0);
+
+	free(hashes);
+}
+
+static bool test_is_canonical_hex(const char *doc) {
+	uint8_t buf[256];
+	size_t size = test_hex(buf, doc);
+
+	return CborIsCanonical(buf, size);
+}
+
+void test_canonical(void) {
+	uint8_t buf[64];
+	CborEncoder enc;
+	uint64_t hash;
+
+	// shortest arguments and floats, sorted keys, definite lengths
+	test_canonical_hex("1b0000000000000001", "01");
+	test_canonical_hex("fb3ff0000000000000", "f93c00");
+	test_canonical_hex("fb3ff199999999999a", "fb3ff199999999999a");
+	test_canonical_hex("fa7fc00000", "f97e00");
+	test_canonical_hex("a2 6162 01 6161 02", "a2 6161 02 6162 01");
+	test_canonical_hex("a2 0a 01 6161 02", "a2 0a 01 6161 02");
+	test_canonical_hex("9f 01 5f 4101 4102 ff ff", "82 01 42 0102");
+	test_canonical_hex("d9d9f7 c1 1a00000001", "c1 01");
+
+	TEST_CHECK(test_is_canonical_hex("d9d9f7 a2 6161 02 6162 01"));
+	TEST_CHECK(!test_is_canonical_hex("a2 6162 01 6161 02"));
+	TEST_CHECK(!test_is_canonical_hex("1801"));
+	TEST_CHECK(!test_is_canonical_hex("9f ff"));
+	TEST_CHECK(!test_is_canonical_hex("f8 01"));
+	TEST_CHECK(!test_is_canonical_hex("a2 6161 01 6161 02"));
+
+	// duplicate keys are rejected
+	CborEncoderInit(&enc, 0, false);
+	TEST_CHECK(!CborCanonicalize(&enc, buf, test_hex(buf, "a2 6161 01 6161 02")));
+	CborEncoderFinalize(&enc);
+
+	// equal documents have equal hash regardless of encoding, map order and tags
+	TEST_CHECK(test_hash_hex("01", 0) == test_hash_hex("1b0000000000000001", 0));
+	TEST_CHECK(test_hash_hex("a2 6161 01 6162 02", 0) == test_hash_hex("a2 6162 02 6161 01", 0));
+	TEST_CHECK(test_hash_hex("c1 01", 0) == test_hash_hex("01", 0));
+	TEST_CHECK(test_hash_hex("81 c1 01", 0) == test_hash_hex("d9d9f7 81 01", 0));
+	TEST_CHECK(test_hash_hex("a1 c1 01 02", 0) == test_hash_hex("a1 01 02", 0));
+	TEST_CHECK(test_hash_hex("f98000", 0) == test_hash_hex("f90000", 0));
+	TEST_CHECK(test_hash_hex("a1 f98000 01", 0) == test_hash_hex("a1 fb0000000000000000 01", 0));
+	TEST_CHECK(test_hash_hex("7f 6161 6162 ff", 0) == test_hash_hex("626162", 0));
+	TEST_CHECK(test_hash_hex("a2 6161 02 6161 01", 0) == test_hash_hex("a2 6161 01 6161 c1 02", 0));
+
+	// different documents and seeds
+	TEST_CHECK(test_hash_hex("01", 0) != test_hash_hex("02", 0));
+	TEST_CHECK(test_hash_hex("01", 0) != test_hash_hex("01", 1));
+	TEST_CHECK(test_hash_hex("80", 0) != test_hash_hex("a0", 0));
+	TEST_CHECK(test_hash_hex("6161", 0) != test_hash_hex("4161", 0));
+	test_hash_spread();
+
+	// malformed documents
+	TEST_CHECK(!CborHash(buf, test_hex(buf, "82 01"), 0, &hash));
+	TEST_CHECK(!CborHash(buf, test_hex(buf, "d9d9f7"), 0, &hash));
+}
@@ -0,0 +1,126 @@
+
+#include "test.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static int test_compare_hex(const char *a, const char *b) {
+	uint8_t abuf[256], bbuf[256];
+	size_t asize = test_hex(abuf, a);
+	size_t bsize = test_hex(bbuf, b);
+	int ret = CborCompare(abuf, asize, bbuf, bsize);
+
+	// sort key should not contradict full comparison, order should be antisymmetric
+	if (ret < 0 && CborCompareKey(abuf, asize) > CborCompareKey(bbuf, bsize)) {
+		return 2;
+	} else if (ret > 0 && CborCompareKey(abuf, asize) < CborCompareKey(bbuf, bsize)) {
+		return 2;
+	} else if (CborCompare(bbuf, bsize, abuf, asize) != -ret) {
+		return 2;
+	}
+	return ret;
+}
+
+#define TEST_COMPARE(a, b, expected) TEST_CHECK(test_compare_hex(a, b) == (expected))
+
+#define TEST_COMPARE_DOCS_MAX 128
+
+static struct {
+	uint8_t *data;
+	size_t size;
+} test_compare_docs[TEST_COMPARE_DOCS_MAX];
+static uint32_t test_compare_ndocs;
+
+static void test_compare_collect(const char *name, const uint8_t *data, size_t size) {
+	(void)name;
+	if (test_compare_ndocs < TEST_COMPARE_DOCS_MAX && CborValidateWithFlags(data, size, CborValidateLegacySimple)) {
+		test_compare_docs[test_compare_ndocs].data = malloc(size);
+		test_compare_docs[test_compare_ndocs].size = size;
+		memcpy(test_compare_docs[test_compare_ndocs].data, data, size);
+		++ test_compare_ndocs;
+	}
+}
+
+// order over every pair (and triple) of test documents is consistent
+static bool test_compare_order(void) {
+	uint32_t i, j, k;
+
+	for (i = 0; i < test_compare_ndocs; ++ i) {
+		const uint8_t *a = test_compare_docs[i].data;
+		size_t asize = test_compare_docs[i].size;
+
+		if (CborCompare(a, asize, a, asize) != 0) {
+			return false;
+		}
+
+		for (j = 0; j < test_compare_ndocs; ++ j) {
+			const uint8_t *b = test_compare_docs[j].data;
+			size_t bsize = test_compare_docs[j].size;
+			int ab = CborCompare(a, asize, b, bsize);
+
+			if (ab != -CborCompare(b, bsize, a, asize)) {
+				return false;
+			}
+			if (ab < 0 && CborCompareKey(a, asize) > CborCompareKey(b, bsize)) {
+				return false;
+			}
+
+			for (k = 0; k < test_compare_ndocs && ab < 0; ++ k) {
+				const uint8_t *c = test_compare_docs[k].data;
+				size_t csize = test_compare_docs[k].size;
+				if (CborCompare(b, bsize, c, csize) < 0 && CborCompare(a, asize, c, csize) >= 0) {
+					return false;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+void test_compare(void) {
+	uint32_t i;
+
+	// simple values < numbers < byte strings < text strings < arrays < maps
+	TEST_COMPARE("f4", "f5", -1);
+	TEST_COMPARE("f6", "00", -1);
+	TEST_COMPARE("f5", "20", -1);
+	TEST_COMPARE("f93e00", "02", -1);
+	TEST_COMPARE("1bffffffffffffffff", "41 00", -1);
+	TEST_COMPARE("41 00", "60", -1);
+	TEST_COMPARE("80", "60", 1);
+	TEST_COMPARE("a0", "9f ff", 1);
+
+	// numbers by value, integer before equal float, NaN is the largest
+	TEST_COMPARE("20", "00", -1);
+	TEST_COMPARE("3bffffffffffffffff", "20", -1);
+	TEST_COMPARE("01", "1801", 0);
+	TEST_COMPARE("01", "f93c00", -1);
+	TEST_COMPARE("1b7fffffffffffffff", "fb43e0000000000000", -1);
+	TEST_COMPARE("f97e00", "1bffffffffffffffff", 1);
+
+	// strings bytewise, chunked strings by content
+	TEST_COMPARE("41 01", "42 0000", 1);
+	TEST_COMPARE("61 61", "61 62", -1);
+	TEST_COMPARE("62 6161", "61 62", -1);
+	TEST_COMPARE("5f 41 01 ff", "41 01", 0);
+
+	// containers item by item, shorter first
+	TEST_COMPARE("81 01", "82 01 00", -1);
+	TEST_COMPARE("81 01", "82 00 00", 1);
+	TEST_COMPARE("82 01 02", "9f 01 03 ff", -1);
+	TEST_COMPARE("a1 6161 01", "a1 6161 02", -1);
+	TEST_COMPARE("82 82 01 02 81 03", "82 82 01 02 81 04", -1);
+	TEST_COMPARE("82 82 01 02 a1 6161 03", "82 82 01 02 a1 6161 f93c00", 1);
+	TEST_COMPARE("82 9f 01 ff 01", "82 81 01 1801", 0);
+
+	// tags and magic header are ignored
+	TEST_COMPARE("c1 01", "01", 0);
+	TEST_COMPARE("d9d9f7 01", "01", 0);
+
+	test_compare_ndocs = 0;
+	test_data_foreach(test_compare_collect);
+	TEST_CHECK(test_compare_ndocs > 0 && test_compare_order());
+	for (i = 0; i < test_compare_ndocs; ++ i) {
+		free(test_compare_docs[i].data);
+	}
+}
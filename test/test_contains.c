@@ -0,0 +1,73 @@
+
+#include "test.h"
+
+static bool test_contains_hex(const char *data, const char *query) {
+	uint8_t dbuf[256], qbuf[256];
+	size_t dsize = test_hex(dbuf, data);
+	size_t qsize = test_hex(qbuf, query);
+
+	return CborContains(dbuf, dsize, qbuf, qsize);
+}
+
+// array of `count` distinct integers, wide enough for index lookup
+static size_t test_contains_make_array(uint8_t *buf, uint32_t count) {
+	size_t size = 0;
+	uint32_t i;
+
+	buf[size ++] = CborMajorTypeEncodedArray | CborFlagsAdditionalNumber8Bit;
+	buf[size ++] = (uint8_t)count;
+	for (i = 0; i < count; ++ i) {
+		if (i < CborFlagsMaxAdditionalNumber) {
+			buf[size ++] = CborMajorTypeEncodedUnsigned | i;
+		} else {
+			buf[size ++] = CborMajorTypeEncodedUnsigned | CborFlagsAdditionalNumber8Bit;
+			buf[size ++] = (uint8_t)i;
+		}
+	}
+	return size;
+}
+
+void test_contains(void) {
+	uint8_t data[512], query[8];
+	size_t dsize, qsize;
+	uint32_t count;
+
+	// scalars and containers
+	TEST_CHECK(test_contains_hex("01", "01"));
+	TEST_CHECK(!test_contains_hex("01", "02"));
+	TEST_CHECK(test_contains_hex("a2 6161 01 6162 82 02 03", "a1 6162 81 03"));
+	TEST_CHECK(!test_contains_hex("a2 6161 01 6162 82 02 03", "a1 6162 81 04"));
+	TEST_CHECK(test_contains_hex("d9d9f7 83 01 02 03", "d9d9f7 82 03 01"));
+	TEST_CHECK(test_contains_hex("83 01 02 03", "80"));
+	TEST_CHECK(!test_contains_hex("a0", "80"));
+
+	// equal values with different encoding, tags are ignored
+	TEST_CHECK(test_contains_hex("81 1801", "81 01"));
+	TEST_CHECK(test_contains_hex("81 f93c00", "81 fb3ff0000000000000"));
+	TEST_CHECK(test_contains_hex("81 7f 6161 6162 ff", "81 626162"));
+	TEST_CHECK(test_contains_hex("81 c1 01", "81 01"));
+
+	// truncated documents are never contained
+	TEST_CHECK(!test_contains_hex("83 01 02", "81 01"));
+	TEST_CHECK(!test_contains_hex("83 01 02 03", "82 01"));
+
+	// indexed arrays with power of two sizes: missing element should not loop over full table
+	for (count = 16; count <= 128; count *= 2) {
+		dsize = test_contains_make_array(data, count);
+
+		qsize = test_hex(query, "82 18c8 00");
+		TEST_CHECK(!CborContains(data, dsize, query, qsize));
+
+		qsize = test_hex(query, "82 00 01");
+		TEST_CHECK(CborContains(data, dsize, query, qsize));
+
+		query[0] = CborMajorTypeEncodedArray | 2;
+		query[1] = CborMajorTypeEncodedUnsigned | CborFlagsAdditionalNumber8Bit;
+		query[2] = (uint8_t)(count - 1);
+		query[3] = CborMajorTypeEncodedUnsigned | CborFlagsAdditionalNumber8Bit;
+		query[4] = (uint8_t)count;
+		TEST_CHECK(!CborContains(data, dsize, query, 5));
+		query[0] = CborMajorTypeEncodedArray | 1;
+		TEST_CHECK(CborContains(data, dsize, query, 3));
+	}
+}
@@ -0,0 +1,104 @@
+
+#include "test.h"
+#include "cbor_path.h"
+
+#include <string.h>
+
+static CborEditStatus test_edit_path(const char *doc, const char *path, CborEditMode mode, const char *value, CborBuffer *out) {
+	uint8_t dbuf[256], vbuf[256];
+	size_t dsize = test_hex(dbuf, doc);
+	CborData v = { test_hex(vbuf, value), vbuf };
+	CborData steps[8];
+	CborEditStatus status;
+	uint32_t nsteps = 0;
+	CborPath p;
+
+	// path steps are separated with '/'
+	while (*path) {
+		const char *next = strchr(path, '/');
+		size_t len = next ? (size_t)(next - path) : strlen(path);
+
+		steps[nsteps].ptr = (const uint8_t *)path;
+		steps[nsteps].size = len;
+		++ nsteps;
+		path += len + (next ? 1 : 0);
+	}
+
+	CborPathInit(&p, steps, nsteps);
+	CborBufferInit(out, 0, 0);
+	status = CborEditPath(out, dbuf, dsize, &p, mode, &v);
+	CborPathFinalize(&p);
+	return status;
+}
+
+#define TEST_EDIT(doc, path, mode, value, expected) do { \
+		CborBuffer out; \
+		if (TEST_CHECK(test_edit_path(doc, path, mode, value, &out) == CborEditStatusOk)) { \
+			TEST_CHECK_HEX((const uint8_t *)out.data, out.size, expected); \
+		} \
+		CborBufferFinalize(&out); \
+	} while (0)
+
+#define TEST_EDIT_STATUS(doc, path, mode, value, status) do { \
+		CborBuffer out; \
+		TEST_CHECK(test_edit_path(doc, path, mode, value, &out) == status); \
+		CborBufferFinalize(&out); \
+	} while (0)
+
+void test_edit(void) {
+	// {"a": 1, "b": 2}
+	const char *map = "d9d9f7 a2 6161 01 6162 02";
+
+	TEST_EDIT(map, "b", CborEditSet, "03", "a2 6161 01 6162 03");
+	TEST_EDIT(map, "b", CborEditSet, "63616263", "a2 6161 01 6162 63616263");
+	TEST_EDIT(map, "c", CborEditSet, "03", "a3 6161 01 6162 02 6163 03");
+	TEST_EDIT_STATUS(map, "c", CborEditReplace, "03", CborEditStatusNotFound);
+	TEST_EDIT(map, "a", CborEditDelete, "", "a1 6162 02");
+	TEST_EDIT_STATUS(map, "c", CborEditDelete, "", CborEditStatusNotFound);
+	TEST_EDIT_STATUS(map, "a", CborEditInsertBefore, "03", CborEditStatusKeyExists);
+	TEST_EDIT(map, "c", CborEditInsertAfter, "f6", "a3 6161 01 6162 02 6163 f6");
+	TEST_EDIT_STATUS(map, "a/b", CborEditSet, "03", CborEditStatusNotFound);
+	TEST_EDIT_STATUS(map, "", CborEditSet, "03", CborEditStatusNotFound);
+
+	// arrays: negative index counts from the end, out of range positions are clamped for set and insert
+	TEST_EDIT("83 01 02 03", "1", CborEditSet, "1864", "83 01 1864 03");
+	TEST_EDIT("83 01 02 03", "-1", CborEditSet, "00", "83 01 02 00");
+	TEST_EDIT("83 01 02 03", "10", CborEditSet, "00", "84 01 02 03 00");
+	TEST_EDIT("83 01 02 03", "-10", CborEditSet, "00", "84 00 01 02 03");
+	TEST_EDIT("83 01 02 03", "0", CborEditInsertBefore, "00", "84 00 01 02 03");
+	TEST_EDIT("83 01 02 03", "0", CborEditInsertAfter, "00", "84 01 00 02 03");
+	TEST_EDIT("83 01 02 03", "-1", CborEditDelete, "", "82 01 02");
+	TEST_EDIT_STATUS("83 01 02 03", "3", CborEditDelete, "", CborEditStatusNotFound);
+	TEST_EDIT_STATUS("83 01 02 03", "x", CborEditSet, "00", CborEditStatusNotFound);
+
+	// nested containers, only header of edited container is rewritten
+	TEST_EDIT("a1 6161 82 a0 97 00 01 02 03 04 05 06 07 08 09 0a 0b 0c 0d 0e 0f 10 11 12 13 14 15 16", "a/1/0", CborEditDelete, "",
+			"a1 6161 82 a0 96 01 02 03 04 05 06 07 08 09 0a 0b 0c 0d 0e 0f 10 11 12 13 14 15 16");
+	TEST_EDIT("a1 6161 82 a0 97 00 01 02 03 04 05 06 07 08 09 0a 0b 0c 0d 0e 0f 10 11 12 13 14 15 16", "a/-1/30", CborEditSet, "17",
+			"a1 6161 82 a0 98 18 00 01 02 03 04 05 06 07 08 09 0a 0b 0c 0d 0e 0f 10 11 12 13 14 15 16 17");
+
+	// indefinite containers keep their header, chunked keys are matched
+	TEST_EDIT("9f 01 02 ff", "5", CborEditSet, "03", "9f 01 02 03 ff");
+	TEST_EDIT("bf 7f 6161 ff 01 ff", "a", CborEditDelete, "", "bf ff");
+
+	// tagged containers are not traversed
+	TEST_EDIT_STATUS("a1 6161 c1 81 01", "a/0", CborEditSet, "00", CborEditStatusNotFound);
+
+	// value should be exactly one complete item
+	TEST_EDIT_STATUS(map, "b", CborEditSet, "", CborEditStatusMalformed);
+	TEST_EDIT_STATUS(map, "b", CborEditSet, "01 02", CborEditStatusMalformed);
+	TEST_EDIT_STATUS(map, "b", CborEditSet, "5f", CborEditStatusMalformed);
+	TEST_EDIT_STATUS(map, "b", CborEditSet, "18", CborEditStatusMalformed);
+	TEST_EDIT_STATUS(map, "c", CborEditInsertBefore, "82 01", CborEditStatusMalformed);
+
+	// values, that are accepted by SQL functions
+	TEST_CHECK(!CborValidate((const uint8_t *)"\xd9\xd9\xf7", 3));
+	TEST_CHECK(!CborValidate((const uint8_t *)"\xd9\xd9\xf7\x01\x02", 5));
+	TEST_CHECK(!CborValidate((const uint8_t *)"\xd9\xd9\xf7\x5f", 4));
+	TEST_CHECK(!CborValidate((const uint8_t *)"\xd9\xd9\xf7\x18", 4));
+	TEST_CHECK(CborValidate((const uint8_t *)"\xd9\xd9\xf7\x18\x18", 5));
+
+	// truncated documents
+	TEST_EDIT_STATUS("a2 6161 01 6162", "a", CborEditSet, "00", CborEditStatusMalformed);
+	TEST_EDIT_STATUS("83 01 02", "0", CborEditDelete, "", CborEditStatusMalformed);
+}
@@ -0,0 +1,73 @@
+
+#include "test.h"
+
+#define TEST_ENCODER_CHECK(enc, hex) do { \
+		CborData data = CborEncoderGetData(enc); \
+		TEST_CHECK_HEX(data.ptr, data.size, hex); \
+	} while (0)
+
+void test_encoder(void) {
+	CborEncoder enc;
+	int i;
+
+	// shortest headers and floats
+	CborEncoderInit(&enc, 0, true);
+	CborEncodeBeginArray(&enc, CBOR_ENCODER_UNKNOWN_COUNT);
+	CborEncodeInteger(&enc, 23);
+	CborEncodeInteger(&enc, 24);
+	CborEncodeInteger(&enc, -1);
+	CborEncodeInteger(&enc, INT64_MIN);
+	CborEncodeFloat(&enc, 1.5);
+	CborEncodeFloat(&enc, 100000.0);
+	CborEncodeFloat(&enc, 0.1);
+	CborEncodeString(&enc, "a", 1);
+	TEST_CHECK(CborEncodeEnd(&enc));
+	TEST_CHECK(CborEncoderIsComplete(&enc));
+	TEST_ENCODER_CHECK(&enc, "d9d9f7 88 17 1818 20 3b7fffffffffffffff f93e00 fa47c35000 fb3fb999999999999a 6161");
+	CborEncoderFinalize(&enc);
+
+	// unknown count is back-patched with longer header
+	CborEncoderInit(&enc, 0, false);
+	CborEncodeBeginMap(&enc, CBOR_ENCODER_UNKNOWN_COUNT);
+	for (i = 0; i < 24; ++ i) {
+		CborEncodeUnsigned(&enc, i);
+		CborEncodeNull(&enc);
+	}
+	TEST_CHECK(CborEncodeEnd(&enc));
+	TEST_CHECK(CborEncoderGetData(&enc).ptr[0] == 0xb8 && CborEncoderGetData(&enc).ptr[1] == 24);
+	TEST_CHECK(CborValidate(CborEncoderGetData(&enc).ptr, CborEncoderGetData(&enc).size));
+	CborEncoderFinalize(&enc);
+
+	// tag applies to next item, indefinite containers end with break
+	CborEncoderInit(&enc, 0, false);
+	CborEncodeBeginArray(&enc, CBOR_ENCODER_INDEFINITE);
+	CborEncodeTag(&enc, 1);
+	TEST_CHECK(!CborEncodeEnd(&enc));
+	CborEncodeUnsigned(&enc, 0);
+	TEST_CHECK(CborEncodeEnd(&enc));
+	TEST_ENCODER_CHECK(&enc, "9f c1 00 ff");
+	CborEncoderFinalize(&enc);
+
+	// map with key without value is not closed, state is left unchanged
+	CborEncoderInit(&enc, 0, false);
+	CborEncodeBeginMap(&enc, CBOR_ENCODER_UNKNOWN_COUNT);
+	CborEncodeString(&enc, "a", 1);
+	TEST_CHECK(!CborEncodeEnd(&enc));
+	TEST_CHECK(!CborEncoderIsComplete(&enc) && enc.stackSize == 1);
+	CborEncodeBool(&enc, true);
+	TEST_CHECK(CborEncodeEnd(&enc));
+	TEST_ENCODER_CHECK(&enc, "a1 6161 f5");
+	CborEncoderFinalize(&enc);
+
+	// declared count mismatch, state is left unchanged
+	CborEncoderInit(&enc, 0, false);
+	CborEncodeBeginArray(&enc, 2);
+	CborEncodeUnsigned(&enc, 1);
+	TEST_CHECK(!CborEncodeEnd(&enc));
+	TEST_CHECK(enc.stackSize == 1);
+	CborEncodeUnsigned(&enc, 2);
+	TEST_CHECK(CborEncodeEnd(&enc));
+	TEST_CHECK(!CborEncodeEnd(&enc));
+	TEST_ENCODER_CHECK(&enc, "82 01 02");
+	CborEncoderFinalize(&enc);
+}
@@ -0,0 +1,103 @@
+
+#include "test.h"
+
+#include <string.h>
+
+static const char test_encoding_hex[] = "0123456789abcdef";
+static const char test_encoding_base64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+// reference encoders, one byte or group at a time
+static size_t test_encoding_hex_ref(char *out, const uint8_t *data, size_t size) {
+	size_t i;
+	for (i = 0; i < size; ++ i) {
+		out[i * 2] = test_encoding_hex[data[i] >> 4];
+		out[i * 2 + 1] = test_encoding_hex[data[i] & 0xF];
+	}
+	return size * 2;
+}
+
+static size_t test_encoding_base64_ref(char *out, const uint8_t *data, size_t size, bool url) {
+	size_t i, len = 0;
+
+	for (i = 0; i < size; i += 3) {
+		uint32_t v = (uint32_t)data[i] << 16;
+		size_t n = (size - i < 3) ? size - i : 3;
+		size_t j;
+
+		if (n > 1) {
+			v |= (uint32_t)data[i + 1] << 8;
+		}
+		if (n > 2) {
+			v |= data[i + 2];
+		}
+		for (j = 0; j < 4; ++ j) {
+			if (j <= n) {
+				char c = test_encoding_base64[(v >> (18 - j * 6)) & 0x3F];
+				if (url && c == '+') {
+					c = '-';
+				} else if (url && c == '/') {
+					c = '_';
+				}
+				out[len ++] = c;
+			} else if (!url) {
+				out[len ++] = '=';
+			}
+		}
+	}
+	return len;
+}
+
+static bool test_encoding_check(const char *expected, size_t elen, const char *got, size_t glen) {
+	return elen == glen && memcmp(expected, got, elen) == 0;
+}
+
+#define TEST_ENCODING(fn, input, expected) do { \
+		char out[64]; \
+		size_t len = fn(out, (const uint8_t *)input, strlen(input)); \
+		TEST_CHECK(test_encoding_check(expected, strlen(expected), out, len)); \
+	} while (0)
+
+void test_encoding(void) {
+	uint8_t data[300];
+	char expected[700], got[700];
+	uint32_t seed = 1;
+	size_t size, i;
+	bool hex = true, base64 = true, base64url = true;
+
+	// RFC 4648, section 10
+	TEST_ENCODING(CborBase64Encode, "", "");
+	TEST_ENCODING(CborBase64Encode, "f", "Zg==");
+	TEST_ENCODING(CborBase64Encode, "fo", "Zm8=");
+	TEST_ENCODING(CborBase64Encode, "foo", "Zm9v");
+	TEST_ENCODING(CborBase64Encode, "foob", "Zm9vYg==");
+	TEST_ENCODING(CborBase64Encode, "fooba", "Zm9vYmE=");
+	TEST_ENCODING(CborBase64Encode, "foobar", "Zm9vYmFy");
+	TEST_ENCODING(CborBase64UrlEncode, "f", "Zg");
+	TEST_ENCODING(CborBase64UrlEncode, "fo", "Zm8");
+	TEST_ENCODING(CborBase64UrlEncode, "foob", "Zm9vYg");
+	TEST_ENCODING(CborBase64UrlEncode, "\xfb\xff\xbf", "-_-_");
+	TEST_ENCODING(CborBase64Encode, "\xfb\xff\xbf", "+/+/");
+	TEST_ENCODING(CborHexEncode, "foobar", "666f6f626172");
+
+	TEST_CHECK(CborByteEncodingSize(CborByteEncodingHex, 5) >= 10);
+	TEST_CHECK(CborByteEncodingSize(CborByteEncodingBase64, 5) >= 8);
+	TEST_CHECK(CborByteEncodingSize(CborByteEncodingBase64Url, 4) >= 6);
+
+	// vectorized encoders against reference for every length and all byte values
+	for (size = 0; size <= sizeof(data); ++ size) {
+		for (i = 0; i < size; ++ i) {
+			seed = seed * 1103515245 + 12345;
+			data[i] = (uint8_t)(seed >> 16);
+		}
+
+		hex = hex && test_encoding_check(expected, test_encoding_hex_ref(expected, data, size),
+				got, CborByteEncode(CborByteEncodingHex, got, data, size));
+		base64 = base64 && test_encoding_check(expected, test_encoding_base64_ref(expected, data, size, false),
+				got, CborByteEncode(CborByteEncodingBase64, got, data, size));
+		base64url = base64url && test_encoding_check(expected, test_encoding_base64_ref(expected, data, size, true),
+				got, CborByteEncode(CborByteEncodingBase64Url, got, data, size));
+	}
+	TEST_CHECK(hex);
+	TEST_CHECK(base64);
+	TEST_CHECK(base64url);
+}
@@ -0,0 +1,166 @@
+
+#include "test.h"
+
+#include <string.h>
+
+// key lengths cover immediate, one and two byte headers
+#define TEST_ITER_KEY_SIZE(i) ((i) < 40 ? (i) + 1 : 40 + ((i) - 40) * 6)
+
+// returns value of key in root object, or -1 if key is not found; both lookup variants should agree
+static int64_t test_iter_key(const uint8_t *data, size_t size, const char *key, size_t len) {
+	CborIteratorContext iter, probed;
+	CborKeyProbe probe;
+	int64_t ret = -1, pret = -1;
+
+	CborIteratorInit(&iter, data, size);
+	CborIteratorInit(&probed, data, size);
+	CborKeyProbeInit(&probe, key, (uint32_t)len);
+
+	if (CborIteratorNext(&iter) == CborIteratorTokenBeginObject && CborIteratorGetKey(&iter, key, (uint32_t)len)) {
+		ret = CborIteratorGetInteger(&iter);
+	}
+	if (CborIteratorNext(&probed) == CborIteratorTokenBeginObject && CborIteratorGetKeyProbe(&probed, &probe)) {
+		pret = CborIteratorGetInteger(&probed);
+	}
+
+	CborIteratorFinalize(&iter);
+	CborIteratorFinalize(&probed);
+	return ret == pret ? ret : -2;
+}
+
+// header with shortest argument
+static size_t test_iter_put_header(uint8_t *buf, uint8_t major, uint32_t value) {
+	if (value < CborFlagsMaxAdditionalNumber) {
+		buf[0] = major | value;
+		return 1;
+	} else if (value <= 0xFF) {
+		buf[0] = major | CborFlagsAdditionalNumber8Bit;
+		buf[1] = value;
+		return 2;
+	} else if (value <= 0xFFFF) {
+		buf[0] = major | CborFlagsAdditionalNumber16Bit;
+		buf[1] = value >> 8;
+		buf[2] = value & 0xFF;
+		return 3;
+	}
+	buf[0] = major | CborFlagsAdditionalNumber32Bit;
+	buf[1] = value >> 24;
+	buf[2] = (value >> 16) & 0xFF;
+	buf[3] = (value >> 8) & 0xFF;
+	buf[4] = value & 0xFF;
+	return 5;
+}
+
+static int64_t test_iter_key_hex(const char *hex, const char *key) {
+	uint8_t data[256];
+	size_t size = test_hex(data, hex);
+	return test_iter_key(data, size, key, strlen(key));
+}
+
+static bool test_iter_skip(const char *hex, uint32_t count, size_t rest) {
+	uint8_t data[256];
+	CborData item;
+
+	item.ptr = data;
+	item.size = test_hex(data, hex);
+	if (!CborDataSkipItems(&item, count)) {
+		return rest == SIZE_MAX;
+	}
+	return item.size == rest;
+}
+
+// iterate or skip root container, returns true if truncated data was reported
+static bool test_iter_malformed(const char *hex, bool skip) {
+	uint8_t data[256];
+	size_t size = test_hex(data, hex);
+	CborIteratorContext iter;
+	bool ret;
+
+	CborIteratorInit(&iter, data, size);
+	if (skip) {
+		CborIteratorNext(&iter);
+		CborIteratorSkipValue(&iter);
+	} else {
+		while (CborIteratorNext(&iter) != CborIteratorTokenDone) { }
+	}
+
+	ret = iter.malformed;
+	CborIteratorFinalize(&iter);
+	return ret;
+}
+
+void test_iter(void) {
+	static uint8_t doc[32 * 1024];
+	size_t size = 0;
+	char keys[80][300];
+	uint32_t i;
+	bool found = true;
+
+	TEST_CHECK(test_iter_key_hex("a2 61 61 01 61 62 02", "b") == 2);
+	TEST_CHECK(test_iter_key_hex("a2 61 61 01 61 62 02", "c") == -1);
+	TEST_CHECK(test_iter_key_hex("a2 61 61 01 61 62 02", "") == -1);
+	TEST_CHECK(test_iter_key_hex("a2 60 01 61 62 02", "") == 1);
+	TEST_CHECK(test_iter_key_hex("a0", "a") == -1);
+	TEST_CHECK(test_iter_key_hex("82 61 61 01", "a") == -1);
+
+	// undefined length map, non-string keys and key-like values
+	TEST_CHECK(test_iter_key_hex("bf 61 61 01 61 62 02 ff", "b") == 2);
+	TEST_CHECK(test_iter_key_hex("bf 61 61 01 ff", "b") == -1);
+	TEST_CHECK(test_iter_key_hex("a3 01 05 61 31 07 41 32 06", "1") == 7);
+	TEST_CHECK(test_iter_key_hex("a3 01 05 61 31 07 41 32 06", "2") == 6); // byte string keys are matched too
+	TEST_CHECK(test_iter_key_hex("a2 61 61 61 62 61 62 03", "b") == 3);
+
+	// nested containers and tags within skipped values
+	TEST_CHECK(test_iter_key_hex("a2 61 61 82 01 a1 61 62 05 61 62 03", "b") == 3);
+	TEST_CHECK(test_iter_key_hex("a2 61 61 c1 9f 01 bf 61 62 05 ff ff 61 62 03", "b") == 3);
+
+	// chunked keys are decoded before comparison
+	TEST_CHECK(test_iter_key_hex("a2 7f 61 61 61 62 ff 01 61 63 02", "ab") == 1);
+	TEST_CHECK(test_iter_key_hex("a2 7f 61 61 61 62 ff 01 61 63 02", "c") == 2);
+	TEST_CHECK(test_iter_key_hex("a2 7f 61 61 61 62 ff 01 61 63 02", "a") == -1);
+
+	// keys of all header sizes, long keys with the same probe prefix
+	for (i = 0; i < 80; ++ i) {
+		memset(keys[i], 'x', sizeof(keys[i]));
+		keys[i][i % 40] = (char)('a' + i / 40);
+	}
+	size += test_iter_put_header(doc + size, CborMajorTypeEncodedMap, 80);
+	for (i = 0; i < 80; ++ i) {
+		size += test_iter_put_header(doc + size, CborMajorTypeEncodedCharString, TEST_ITER_KEY_SIZE(i));
+		memcpy(doc + size, keys[i], TEST_ITER_KEY_SIZE(i));
+		size += TEST_ITER_KEY_SIZE(i);
+		size += test_iter_put_header(doc + size, CborMajorTypeEncodedUnsigned, i * 1000);
+	}
+
+	for (i = 0; i < 80; ++ i) {
+		found = found && test_iter_key(doc, size, keys[i], TEST_ITER_KEY_SIZE(i)) == i * 1000;
+	}
+	TEST_CHECK(found);
+	TEST_CHECK(test_iter_key(doc, size, keys[79], TEST_ITER_KEY_SIZE(79) - 1) == -1);
+	TEST_CHECK(test_iter_key(doc, size, keys[79], TEST_ITER_KEY_SIZE(79) + 1) == -1);
+	TEST_CHECK(test_iter_key(doc, size, keys[50], 40) == -1);
+
+	// truncated data is reported both by iteration and skip
+	TEST_CHECK(!test_iter_malformed("82 01 9f 02 ff", false));
+	TEST_CHECK(!test_iter_malformed("82 01 9f 02 ff", true));
+	TEST_CHECK(test_iter_malformed("82 01 9f 02", false));
+	TEST_CHECK(test_iter_malformed("82 01 9f 02", true));
+	TEST_CHECK(test_iter_malformed("82 01 43 0102", false));
+	TEST_CHECK(test_iter_malformed("82 01 43 0102", true));
+	TEST_CHECK(test_iter_malformed("a1 61 61", false));
+	TEST_CHECK(test_iter_malformed("c1", true));
+
+	// header arithmetic skip, SIZE_MAX marks failure
+	TEST_CHECK(test_iter_skip("01 02", 1, 1));
+	TEST_CHECK(test_iter_skip("83 01 82 02 03 bf 61 61 5f 41 01 ff ff 04", 1, 1));
+	TEST_CHECK(test_iter_skip("c1 c2 1b 0000000000000001 f6", 2, 0));
+	TEST_CHECK(test_iter_skip("7f 61 61 ff 9f 9f ff ff", 2, 0));
+	TEST_CHECK(test_iter_skip("01", 2, SIZE_MAX));
+	TEST_CHECK(test_iter_skip("82 01", 1, SIZE_MAX));
+	TEST_CHECK(test_iter_skip("9f 01", 1, SIZE_MAX));
+	TEST_CHECK(test_iter_skip("5f 41 01", 1, SIZE_MAX));
+	TEST_CHECK(test_iter_skip("43 01 02", 1, SIZE_MAX));
+	TEST_CHECK(test_iter_skip("c1", 1, SIZE_MAX));
+	TEST_CHECK(test_iter_skip("19 01", 1, SIZE_MAX));
+	TEST_CHECK(test_iter_skip("ff", 1, SIZE_MAX));
+}
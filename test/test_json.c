@@ -0,0 +1,113 @@
+
+#include "test.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static bool test_json_double(double value, const char *expected) {
+	char buf[CBOR_NUMBER_MAX_SIZE + 1];
+	uint32_t len = CborFormatDouble(buf, value);
+
+	buf[len] = 0;
+	if (strcmp(buf, expected) != 0) {
+		printf("  formatted: %s, expected: %s\n", buf, expected);
+		return false;
+	}
+	return true;
+}
+
+// data is copied into buffer of exact size, so reads past the end are visible with sanitizers
+static bool test_json_hex(const char *hex, const char *expected) {
+	uint8_t buf[256];
+	size_t size = test_hex(buf, hex);
+	uint8_t *data = malloc(size);
+	struct CborWriter writer;
+	CborBuffer out;
+	bool ret;
+
+	memcpy(data, buf, size);
+	CborBufferInit(&out, 0, 0);
+	CborWriterInitBuffer(&writer, &out);
+
+	ret = CborToJson(&writer, data, size);
+	if (ret && expected) {
+		ret = (out.size == strlen(expected) && memcmp(out.data, expected, out.size) == 0);
+		if (!ret) {
+			printf("  json: %.*s, expected: %s\n", (int)out.size, out.data, expected);
+		}
+	}
+
+	CborBufferFinalize(&out);
+	free(data);
+	return ret;
+}
+
+static void test_json_file(const char *name, const uint8_t *data, size_t size) {
+	if (CborValidateWithFlags(data, size, CborValidateLegacySimple)) {
+		struct CborWriter writer;
+		CborBuffer out;
+
+		CborBufferInit(&out, 0, 0);
+		CborWriterInitBuffer(&writer, &out);
+		if (!TEST_CHECK(CborToJson(&writer, data, size))) {
+			printf("  file: %s\n", name);
+		}
+		CborBufferFinalize(&out);
+	}
+}
+
+void test_json(void) {
+	// shortest decimal, that is converted back into the same double
+	TEST_CHECK(test_json_double(1.0, "1.0"));
+	TEST_CHECK(test_json_double(-0.0, "-0.0"));
+	TEST_CHECK(test_json_double(0.1, "0.1"));
+	TEST_CHECK(test_json_double(-2.5, "-2.5"));
+	TEST_CHECK(test_json_double(0.1 + 0.2, "0.30000000000000004"));
+	TEST_CHECK(test_json_double(1.0 / 3.0, "0.3333333333333333"));
+	TEST_CHECK(test_json_double(1e300, "1e+300"));
+	TEST_CHECK(test_json_double(5e-324, "5e-324"));
+
+	// RFC 8949, section 6.1
+	TEST_CHECK(test_json_hex("d9d9f7 a2 6161 01 6162 82 02 03", "{\"a\":1,\"b\":[2,3]}"));
+	TEST_CHECK(test_json_hex("3bffffffffffffffff", "-18446744073709551616"));
+	TEST_CHECK(test_json_hex("f97e00", "null"));
+	TEST_CHECK(test_json_hex("f97c00", "null"));
+	TEST_CHECK(test_json_hex("82 f7 f0", "[null,null]"));
+	TEST_CHECK(test_json_hex("62 0a01", "\"\\n\\u0001\""));
+	TEST_CHECK(test_json_hex("7f 6161 6162 ff", "\"ab\""));
+
+	// byte strings as base64url, unless expected conversion tag is set
+	TEST_CHECK(test_json_hex("43 010203", "\"AQID\""));
+	TEST_CHECK(test_json_hex("5f 41 01 41 02 ff", "\"AQI\""));
+	TEST_CHECK(test_json_hex("d6 41 fb", "\"+w==\""));
+	TEST_CHECK(test_json_hex("d7 82 41 01 41 ff", "[\"01\",\"ff\"]"));
+
+	// tags are omitted, non-string keys as their JSON text, container keys are rejected
+	TEST_CHECK(test_json_hex("c1 1a 514b67b0", "1363896240"));
+	TEST_CHECK(test_json_hex("a2 01 02 f5 03", "{\"1\":2,\"true\":3}"));
+	TEST_CHECK(test_json_hex("a1 fb3ff8000000000000 01", "{\"1.5\":1}"));
+	TEST_CHECK(!test_json_hex("a1 81 01 02", NULL));
+
+	// truncated documents: containers closed at the end of data, strings longer than data
+	TEST_CHECK(!test_json_hex("82 01", NULL));
+	TEST_CHECK(!test_json_hex("9f 01", NULL));
+	TEST_CHECK(!test_json_hex("bf 6161 01", NULL));
+	TEST_CHECK(!test_json_hex("81 82 01", NULL));
+	TEST_CHECK(!test_json_hex("a1 6161", NULL));
+	TEST_CHECK(!test_json_hex("62 61", NULL));
+	TEST_CHECK(!test_json_hex("81 62 61", NULL));
+	TEST_CHECK(!test_json_hex("5f 41 01", NULL));
+	TEST_CHECK(!test_json_hex("81 c1", NULL));
+	TEST_CHECK(!test_json_hex("19 01", NULL));
+
+	// text strings, keys and chunks should be valid UTF-8
+	TEST_CHECK(test_json_hex("63 c3a961", "\"\xc3\xa9" "a\""));
+	TEST_CHECK(test_json_hex("7f 62 c3a9 ff", "\"\xc3\xa9\""));
+	TEST_CHECK(!test_json_hex("61 ff", NULL));
+	TEST_CHECK(!test_json_hex("62 c328", NULL));
+	TEST_CHECK(!test_json_hex("63 eda080", NULL));
+	TEST_CHECK(!test_json_hex("a1 61 80 01", NULL));
+	TEST_CHECK(!test_json_hex("7f 61 c3 61 a9 ff", NULL));
+
+	TEST_CHECK(test_data_foreach(test_json_file) > 0);
+}
@@ -0,0 +1,56 @@
+
+#include "test.h"
+
+static bool test_merge_hex(bool patch, const char *a, const char *b, CborBuffer *out) {
+	uint8_t abuf[256], bbuf[256];
+	size_t asize = test_hex(abuf, a);
+	size_t bsize = test_hex(bbuf, b);
+
+	CborBufferInit(out, 0, 0);
+	return patch ? CborMergePatch(out, abuf, asize, bbuf, bsize) : CborConcat(out, abuf, asize, bbuf, bsize);
+}
+
+#define TEST_MERGE(patch, a, b, expected) do { \
+		CborBuffer out; \
+		if (TEST_CHECK(test_merge_hex(patch, a, b, &out))) { \
+			TEST_CHECK_HEX((const uint8_t *)out.data, out.size, expected); \
+		} \
+		CborBufferFinalize(&out); \
+	} while (0)
+
+#define TEST_MERGE_FAIL(patch, a, b) do { \
+		CborBuffer out; \
+		TEST_CHECK(!test_merge_hex(patch, a, b, &out)); \
+		CborBufferFinalize(&out); \
+	} while (0)
+
+void test_merge(void) {
+	// concatenation: arrays are joined, undefined length array keeps its form
+	TEST_MERGE(false, "82 01 02", "81 03", "83 01 02 03");
+	TEST_MERGE(false, "9f 01 ff", "82 02 03", "9f 01 02 03 ff");
+	TEST_MERGE(false, "d9d9f7 81 01", "d9d9f7 81 02", "82 01 02");
+
+	// keys of right map replace values in place, new keys are appended
+	TEST_MERGE(false, "a1 6161 01", "a2 6162 02 6161 03", "a2 6161 03 6162 02");
+
+	// other values are added as array elements
+	TEST_MERGE(false, "01", "02", "82 01 02");
+	TEST_MERGE(false, "82 01 02", "a1 6161 01", "83 01 02 a1 6161 01");
+	TEST_MERGE(false, "a1 6161 01", "82 01 02", "83 a1 6161 01 01 02");
+	TEST_MERGE_FAIL(false, "82 01", "81 02");
+
+	// merge patch (RFC 7396): null removes key, nested maps are merged
+	TEST_MERGE(true, "a2 6161 01 6162 02", "a1 6161 f6", "a1 6162 02");
+	TEST_MERGE(true, "a2 6161 01 6162 02", "a1 6163 03", "a3 6161 01 6162 02 6163 03");
+	TEST_MERGE(true, "a1 6161 a1 6162 01", "a1 6161 a1 6163 02", "a1 6161 a2 6162 01 6163 02");
+	TEST_MERGE(true, "a1 6161 01", "a1 6161 a1 6162 f6", "a1 6161 a0");
+
+	// non-map patch replaces target, non-map target is replaced with map
+	TEST_MERGE(true, "a1 6161 01", "82 01 02", "82 01 02");
+	TEST_MERGE(true, "82 01 02", "a1 6161 01", "a1 6161 01");
+
+	// keys are compared by normalized value, regardless of encoding
+	TEST_MERGE(true, "a1 6161 1801", "a1 6161 01", "a1 6161 01");
+	TEST_MERGE(true, "a1 7f 6161 ff 01", "a1 6161 f6", "a0");
+	TEST_MERGE_FAIL(true, "a2 6161 01", "a1 6161 f6");
+}
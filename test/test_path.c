@@ -0,0 +1,140 @@
+
+#include "test.h"
+#include "cbor_path.h"
+
+#include <string.h>
+
+// paths are separated with ' ', steps with '/', expected values are separated with ' ', '-' for missing value;
+// truncated document is not resolved, but values within it are
+static void test_path_trie(const char *doc, const char *paths, const char *values, bool complete, const char *file, int line) {
+	CborData steps[32];
+	uint32_t nsteps[8];
+	uint8_t dbuf[256];
+	size_t dsize = test_hex(dbuf, doc);
+	uint32_t npaths = 0, total = 0;
+	CborPathTrie trie;
+	uint32_t i, j;
+
+	while (*paths) {
+		nsteps[npaths] = 0;
+		while (*paths && *paths != ' ') {
+			size_t len = strcspn(paths, "/ ");
+			steps[total].ptr = (const uint8_t *)paths;
+			steps[total].size = len;
+			++ total;
+			++ nsteps[npaths];
+			paths += len + (paths[len] == '/' ? 1 : 0);
+		}
+		paths += (*paths == ' ' ? 1 : 0);
+		++ npaths;
+	}
+
+	CborPathTrieInit(&trie);
+	for (i = 0, j = 0; i < npaths; j += nsteps[i ++]) {
+		CborPathTrieAdd(&trie, &steps[j], nsteps[i]);
+	}
+
+	test_check(CborPathTrieResolve(&trie, dbuf, dsize) == complete, "CborPathTrieResolve", file, line);
+
+	for (i = 0; i < npaths; ++ i) {
+		const CborData *value = CborPathTrieGetValue(&trie, i);
+		size_t len = strcspn(values, " ");
+
+		if (len == 1 && *values == '-') {
+			test_check(value == NULL, "missing value", file, line);
+		} else if (test_check(value != NULL, "resolved value", file, line)) {
+			char hex[128];
+			memcpy(hex, values, len);
+			hex[len] = 0;
+			test_hex_equal(value->ptr, value->size, hex, file, line);
+		}
+		values += len + (values[len] == ' ' ? 1 : 0);
+	}
+
+	CborPathTrieFinalize(&trie);
+}
+
+#define TEST_PATH_TRIE(doc, paths, values) test_path_trie((doc), (paths), (values), true, __FILE__, __LINE__)
+#define TEST_PATH_TRIE_PREFIX(doc, paths, values) test_path_trie((doc), (paths), (values), false, __FILE__, __LINE__)
+
+static bool test_path_get(const char *doc, const char *path, const char *expected) {
+	uint8_t dbuf[256], ebuf[256];
+	size_t dsize = test_hex(dbuf, doc);
+	size_t esize = test_hex(ebuf, expected);
+	CborData steps[8];
+	uint32_t nsteps = 0;
+	CborIteratorContext iter;
+	CborPath p;
+	bool ret = false;
+
+	while (*path) {
+		size_t len = strcspn(path, "/");
+		steps[nsteps].ptr = (const uint8_t *)path;
+		steps[nsteps].size = len;
+		++ nsteps;
+		path += len + (path[len] == '/' ? 1 : 0);
+	}
+
+	CborPathInit(&p, steps, nsteps);
+	if (CborIteratorInit(&iter, dbuf, dsize)) {
+		if (CborIteratorGetPath(&iter, &p)) {
+			const uint8_t *begin = CborIteratorGetCurrentValuePtr(&iter);
+			if (begin && CborIteratorSkipValue(&iter)) {
+				ret = (size_t)(iter.current.ptr - begin) == esize && memcmp(begin, ebuf, esize) == 0;
+			}
+		} else {
+			ret = (esize == 0);
+		}
+		CborIteratorFinalize(&iter);
+	}
+	CborPathFinalize(&p);
+	return ret;
+}
+
+void test_path(void) {
+	long int index;
+	CborData step;
+
+	// index parsing
+	step.ptr = (const uint8_t *)"-12";
+	step.size = 3;
+	TEST_CHECK(CborPathParseIndex(&step, &index) && index == -12);
+	step.ptr = (const uint8_t *)"1a";
+	step.size = 2;
+	TEST_CHECK(!CborPathParseIndex(&step, &index));
+	step.ptr = (const uint8_t *)"9999999999";
+	step.size = 10;
+	TEST_CHECK(!CborPathParseIndex(&step, &index));
+
+	// single path
+	TEST_CHECK(test_path_get("a1 6161 83 0a 14 18 1e", "a/1", "14"));
+	TEST_CHECK(test_path_get("a1 6161 83 0a 14 18 1e", "a/-1", "18 1e"));
+	TEST_CHECK(test_path_get("a1 6161 83 0a 14 18 1e", "a/3", ""));
+	TEST_CHECK(test_path_get("a1 6161 83 0a 14 18 1e", "b", ""));
+	TEST_CHECK(test_path_get("d9d9f7 a1 6161 9f 0a 14 ff", "a/1", "14"));
+
+	// multiple paths in single pass
+	TEST_PATH_TRIE("83 0a 14 18 1e", "0 2 3", "0a 181e -");
+	TEST_PATH_TRIE("a2 6161 82 01 02 6162 a1 6163 f5", "a/1 b/c b/d a", "02 f5 - 820102");
+	TEST_PATH_TRIE("a1 7f 61 61 ff 01", "a", "01");
+	TEST_PATH_TRIE("9f 0a 14 ff", "1 -1 5 -3", "14 14 - -");
+	TEST_PATH_TRIE("a1 6161 9f 0a 9f 14 ff ff", "a/-1/-1 a/0 a/-2", "14 0a 0a");
+
+	// same element with negative and positive index
+	TEST_PATH_TRIE("83 0a 14 18 1e", "-1 2", "181e 181e");
+	TEST_PATH_TRIE("83 0a 14 18 1e", "2 -1", "181e 181e");
+	TEST_PATH_TRIE("83 0a 14 18 1e", "-3 0 -2", "0a 0a 14");
+
+	// same element with aliased index text
+	TEST_PATH_TRIE("83 0a 14 18 1e", "1 01", "14 14");
+	TEST_PATH_TRIE("83 0a 14 18 1e", "01 +1 1", "14 14 14");
+
+	// aliased parents, terminals in deferred subtree
+	TEST_PATH_TRIE("82 a1 6161 01 a2 6161 02 6162 03", "1/a 01/b -1/c", "02 03 -");
+	TEST_PATH_TRIE("82 82 01 02 82 03 04", "-1/0 1/1 0/-1", "03 04 02");
+
+	// prefix of document: values are resolved only if they are complete within prefix
+	TEST_PATH_TRIE_PREFIX("a2 6161 83 01 02", "a/0 a a/2 b", "01 - - -");
+	TEST_PATH_TRIE_PREFIX("a2 6161 9f 01 82 02", "a/0 a/1 a", "01 - -");
+	TEST_PATH_TRIE_PREFIX("a2 6161 65 616263", "a b", "- -");
+}
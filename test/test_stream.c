@@ -0,0 +1,194 @@
+
+#include "test.h"
+
+#include <string.h>
+
+/* Token stream is written into log in form, that does not depend on chunk boundaries:
+ * strings are logged with concatenated content, regardless of chunks */
+struct test_stream_log {
+	CborBuffer out;
+	CborBuffer str;
+	uint32_t strings; // nesting of Begin/End*Strings
+};
+
+static void test_stream_log_value(struct test_stream_log *log, const CborIteratorContext *iter, CborIteratorToken token) {
+	CborType type = CborIteratorGetType(iter);
+	uint64_t value = 0;
+	double fvalue;
+
+	if (type == CborTypeByteString || type == CborTypeCharString) {
+		if (log->strings > 0) {
+			CborBufferWrite(&log->str, (const char *)iter->current.ptr, CborIteratorGetObjectSize(iter));
+			return;
+		}
+		// keys, split between chunks, are returned as strings
+		CborBufferWriteChar(&log->out, 'S');
+		CborBufferWriteChar(&log->out, (char)type);
+		value = CborIteratorGetObjectSize(iter);
+		CborBufferWrite(&log->out, (const char *)&value, sizeof(value));
+		CborBufferWrite(&log->out, (const char *)iter->current.ptr, value);
+		return;
+	}
+
+	if (type == CborTypeFloat) {
+		fvalue = CborIteratorGetFloat(iter);
+		memcpy(&value, &fvalue, sizeof(value));
+	} else {
+		value = CborIteratorGetUnsigned(iter);
+	}
+
+	CborBufferWriteChar(&log->out, token == CborIteratorTokenKey ? 'K' : 'V');
+	CborBufferWriteChar(&log->out, (char)type);
+	CborBufferWrite(&log->out, (const char *)&value, sizeof(value));
+}
+
+static void test_stream_log_token(struct test_stream_log *log, const CborIteratorContext *iter, CborIteratorToken token) {
+	uint64_t size;
+
+	switch (token) {
+	case CborIteratorTokenKey:
+	case CborIteratorTokenValue:
+		test_stream_log_value(log, iter, token);
+		break;
+	case CborIteratorTokenBeginByteStrings:
+	case CborIteratorTokenBeginCharStrings:
+		if (log->strings ++ == 0) {
+			log->str.size = 0;
+		}
+		break;
+	case CborIteratorTokenEndByteStrings:
+	case CborIteratorTokenEndCharStrings:
+		if (-- log->strings == 0) {
+			size = log->str.size;
+			CborBufferWriteChar(&log->out, 'S');
+			CborBufferWriteChar(&log->out, (char)(token == CborIteratorTokenEndByteStrings ? CborTypeByteString : CborTypeCharString));
+			CborBufferWrite(&log->out, (const char *)&size, sizeof(size));
+			CborBufferWrite(&log->out, log->str.data, log->str.size);
+		}
+		break;
+	default:
+		CborBufferWriteChar(&log->out, 'T');
+		CborBufferWriteChar(&log->out, (char)token);
+		break;
+	}
+}
+
+static void test_stream_log_init(struct test_stream_log *log) {
+	CborBufferInit(&log->out, 0, 256);
+	CborBufferInit(&log->str, 0, 64);
+	log->strings = 0;
+}
+
+static void test_stream_log_finalize(struct test_stream_log *log) {
+	CborBufferFinalize(&log->out);
+	CborBufferFinalize(&log->str);
+}
+
+static void test_stream_contiguous(struct test_stream_log *log, const uint8_t *data, size_t size) {
+	CborIteratorContext iter;
+	CborIteratorToken token;
+
+	if (!CborIteratorInit(&iter, data, size)) {
+		return;
+	}
+
+	do {
+		token = CborIteratorNext(&iter);
+		test_stream_log_token(log, &iter, token);
+	} while (token != CborIteratorTokenDone);
+
+	CborIteratorFinalize(&iter);
+}
+
+// document is fed in chunks, that end at given offsets (last chunk ends at size)
+static void test_stream_chunked(struct test_stream_log *log, const uint8_t *data, size_t size, const size_t *splits, uint32_t nsplits) {
+	CborIteratorContext iter;
+	CborIteratorToken token;
+	size_t offset = 0;
+	uint32_t chunk = 0;
+
+	CborIteratorInitStream(&iter);
+	while (true) {
+		size_t end = (chunk < nsplits) ? splits[chunk] : size;
+		CborIteratorFeed(&iter, data + offset, end - offset, chunk >= nsplits);
+		offset = end;
+		++ chunk;
+
+		while ((token = CborIteratorNext(&iter)) != CborIteratorTokenNeedData) {
+			test_stream_log_token(log, &iter, token);
+			if (token == CborIteratorTokenDone) {
+				CborIteratorFinalize(&iter);
+				return;
+			}
+		}
+	}
+}
+
+static const char *test_stream_name;
+static uint32_t test_stream_failures;
+
+static void test_stream_compare(const struct test_stream_log *expected, const uint8_t *data, size_t size, const size_t *splits, uint32_t nsplits) {
+	struct test_stream_log log;
+	uint32_t i;
+
+	test_stream_log_init(&log);
+	test_stream_chunked(&log, data, size, splits, nsplits);
+	if (log.out.size != expected->out.size || memcmp(log.out.data, expected->out.data, log.out.size) != 0) {
+		if (test_stream_failures ++ == 0) {
+			printf("  file: %s, chunks end at:", test_stream_name);
+			for (i = 0; i < nsplits; ++ i) {
+				printf(" %zu", splits[i]);
+			}
+			printf("\n");
+		}
+	}
+	test_stream_log_finalize(&log);
+}
+
+static void test_stream_file(const char *name, const uint8_t *data, size_t size) {
+	struct test_stream_log expected;
+	CborData item = { size, data };
+	size_t splits[64];
+	size_t i;
+
+	// stream iterator accepts only whole documents
+	if (data_is_cbor(data, size)) {
+		CborDataOffset(&item, CborHeaderSize);
+	}
+	if (!CborDataSkipItems(&item, 1) || item.size != 0 || size > 64) {
+		return;
+	}
+
+	test_stream_name = name;
+	test_stream_failures = 0;
+
+	test_stream_log_init(&expected);
+	test_stream_contiguous(&expected, data, size);
+
+	// single chunk, split at every offset and byte by byte
+	test_stream_compare(&expected, data, size, splits, 0);
+	for (i = 0; i <= size; ++ i) {
+		splits[0] = i;
+		test_stream_compare(&expected, data, size, splits, 1);
+	}
+	for (i = 0; i < size; ++ i) {
+		splits[i] = i;
+	}
+	test_stream_compare(&expected, data, size, splits, size);
+
+	test_stream_log_finalize(&expected);
+	TEST_CHECK(test_stream_failures == 0);
+}
+
+void test_stream(void) {
+	uint8_t data[64];
+	size_t size;
+
+	// split definite length strings and headers, undefined length containers
+	size = test_hex(data, "a2 63 6b6579 9f 1903e8 fb3ff8000000000000 ff 5f 42 0102 41 03 ff 78 1a 6162636465666768696a6b6c6d6e6f707172737475767778797a");
+	test_stream_file("inline", data, size);
+	size = test_hex(data, "d9d9f7 83 c1 1a 5f5e1000 3b 7fffffffffffffff f6");
+	test_stream_file("tagged", data, size);
+
+	TEST_CHECK(test_data_foreach(test_stream_file) > 0);
+}
@@ -0,0 +1,133 @@
+
+#include "test.h"
+#include "cbor_tape.h"
+
+#include <string.h>
+
+// offsets from tape should match sequential scan of the same data
+static bool test_tape_entry(const CborTape *tape, uint32_t idx) {
+	const CborTapeEntry *entry = &tape->entries[idx];
+	CborData item = { tape->data.size - entry->offset, tape->data.ptr + entry->offset };
+	uint32_t i;
+
+	if (entry->type == CborMajorTypeArray || entry->type == CborMajorTypeMap) {
+		if (entry->count > 0 && tape->entries[CborTapeGetChild(tape, idx, 0)].offset <= entry->offset) {
+			return false;
+		}
+		for (i = 1; i < entry->count; ++ i) {
+			if (tape->entries[CborTapeGetChild(tape, idx, i)].offset != tape->entries[CborTapeGetChild(tape, idx, i - 1)].end) {
+				return false;
+			}
+		}
+		if (CborTapeGetChild(tape, idx, entry->count) != CBOR_TAPE_NOT_FOUND) {
+			return false;
+		}
+	}
+
+	if (entry->type == CborMajorTypeTag) {
+		return true;
+	}
+
+	return CborDataSkipItems(&item, 1) && item.ptr == tape->data.ptr + entry->end
+			&& CborTapeFind(tape, tape->data.ptr + entry->offset, 0) == idx;
+}
+
+// every element of root array is found with tape and with sequential scan at the same offset
+static bool test_tape_lookup(const CborTape *tape, const uint8_t *data, size_t size) {
+	const CborTapeEntry *entry = &tape->entries[0];
+	CborIteratorContext plain, indexed;
+	uint32_t i;
+	bool ret = true;
+
+	if (entry->type != CborMajorTypeArray) {
+		return true;
+	}
+
+	for (i = 0; i < entry->count && ret; ++ i) {
+		ret = CborIteratorInit(&plain, data, size) && CborIteratorInitTape(&indexed, tape);
+		if (ret) {
+			CborIteratorNext(&plain);
+			CborIteratorNext(&indexed);
+			ret = CborIteratorGetIth(&plain, i) && CborIteratorGetIth(&indexed, i)
+					&& CborIteratorGetCurrentValuePtr(&plain) == CborIteratorGetCurrentValuePtr(&indexed)
+					&& CborIteratorSkipValue(&plain) && CborIteratorSkipValue(&indexed)
+					&& plain.current.ptr == indexed.current.ptr;
+			CborIteratorFinalize(&plain);
+			CborIteratorFinalize(&indexed);
+		}
+	}
+
+	return ret;
+}
+
+// container, that iterator is stopped at, should be known without search in tape
+static bool test_tape_head(const CborIteratorContext *iter) {
+	const struct CborIteratorStackValue *head = iter->stackHead;
+	return head && head->tape != CBOR_TAPE_NOT_FOUND
+			&& iter->tape->data.ptr + iter->tape->entries[head->tape].offset == head->ptr;
+}
+
+static void test_tape_file(const char *name, const uint8_t *data, size_t size) {
+	CborData item = { size, data };
+	CborTape tape;
+	uint32_t i;
+	bool ret = true;
+
+	// only documents with single complete item
+	if (data_is_cbor(data, size)) {
+		CborDataOffset(&item, CborHeaderSize);
+	}
+	if (!CborDataSkipItems(&item, 1) || item.size != 0) {
+		return;
+	}
+
+	if (!TEST_CHECK(CborTapeInit(&tape, data, size))) {
+		printf("  file: %s\n", name);
+		return;
+	}
+
+	ret = tape.size > 0 && tape.entries[0].offset == 0 && tape.entries[0].end == tape.data.size;
+	for (i = 0; i < tape.size && ret; ++ i) {
+		ret = test_tape_entry(&tape, i);
+	}
+	if (!TEST_CHECK(ret && test_tape_lookup(&tape, data, size))) {
+		printf("  file: %s, entry: %u\n", name, i - 1);
+	}
+
+	CborTapeFinalize(&tape);
+}
+
+void test_tape(void) {
+	uint8_t data[64];
+	size_t size;
+	CborTape tape;
+
+	size = test_hex(data, "d9d9f7 82 9f 01 c1 02 ff a1 6161 5f 41 00 41 01 ff");
+	if (TEST_CHECK(CborTapeInit(&tape, data, size))) {
+		TEST_CHECK(tape.data.size == size - 3);
+		TEST_CHECK(tape.entries[0].count == 2 && tape.entries[0].end == tape.data.size);
+		TEST_CHECK(tape.entries[CborTapeGetChild(&tape, 0, 0)].count == 2);
+		TEST_CHECK(CborTapeGetChild(&tape, 0, 2) == CBOR_TAPE_NOT_FOUND);
+		CborTapeFinalize(&tape);
+	}
+
+	// {"a": [0, [1, 2, 3]], "b": 1}
+	size = test_hex(data, "a2 6161 82 00 9f 01 02 03 ff 6162 01");
+	if (TEST_CHECK(CborTapeInit(&tape, data, size))) {
+		CborIteratorContext iter;
+		CborIteratorInitTape(&iter, &tape);
+		TEST_CHECK(CborIteratorNext(&iter) == CborIteratorTokenBeginObject && test_tape_head(&iter));
+		TEST_CHECK(CborIteratorGetKey(&iter, "a", 1) && test_tape_head(&iter));
+		TEST_CHECK(CborIteratorGetIth(&iter, 1) && test_tape_head(&iter));
+		TEST_CHECK(CborIteratorGetIth(&iter, -1) && CborIteratorGetUnsigned(&iter) == 3);
+		CborIteratorFinalize(&iter);
+		CborTapeFinalize(&tape);
+	}
+
+	size = test_hex(data, "82 01");
+	TEST_CHECK(!CborTapeInit(&tape, data, size));
+	size = test_hex(data, "9f 01");
+	TEST_CHECK(!CborTapeInit(&tape, data, size));
+
+	TEST_CHECK(test_data_foreach(test_tape_file) > 0);
+}
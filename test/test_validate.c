@@ -0,0 +1,50 @@
+
+#include "test.h"
+
+static bool test_validate_hex(const char *hex, uint32_t flags) {
+	uint8_t buf[256];
+	size_t size = test_hex(buf, hex);
+
+	return CborValidateWithFlags(buf, size, flags);
+}
+
+void test_validate(void) {
+	// well-formed items
+	TEST_CHECK(test_validate_hex("00", CborValidateStrict));
+	TEST_CHECK(test_validate_hex("d9d9f7 a2 6161 01 6162 9f 02 ff", CborValidateStrict));
+	TEST_CHECK(test_validate_hex("7f 6161 62c3a9 ff", CborValidateStrict));
+	TEST_CHECK(test_validate_hex("c1 1a 514b67b0", CborValidateStrict));
+	TEST_CHECK(test_validate_hex("f8 20", CborValidateStrict));
+	TEST_CHECK(test_validate_hex("f8 ff", CborValidateStrict));
+
+	// two-byte simple values below 32 (RFC 8949, section 3.3)
+	TEST_CHECK(!test_validate_hex("f8 00", CborValidateStrict));
+	TEST_CHECK(!test_validate_hex("f8 17", CborValidateStrict));
+	TEST_CHECK(!test_validate_hex("f8 18", CborValidateStrict));
+	TEST_CHECK(!test_validate_hex("f8 1f", CborValidateStrict));
+	TEST_CHECK(!test_validate_hex("81 f8 18", CborValidateStrict));
+	TEST_CHECK(!CborValidate((const uint8_t *)"\xd9\xd9\xf7\xf8\x18", 5));
+
+	// legacy test vectors use simple(24)
+	TEST_CHECK(test_validate_hex("f8 18", CborValidateLegacySimple));
+	TEST_CHECK(test_validate_hex("f8 1f", CborValidateLegacySimple));
+	TEST_CHECK(!test_validate_hex("f8 17", CborValidateLegacySimple));
+
+	// truncated, trailing data, misplaced break, reserved additional info
+	TEST_CHECK(!test_validate_hex("82 01", CborValidateStrict));
+	TEST_CHECK(!test_validate_hex("01 02", CborValidateStrict));
+	TEST_CHECK(!test_validate_hex("ff", CborValidateStrict));
+	TEST_CHECK(!test_validate_hex("bf 01 ff", CborValidateStrict));
+	TEST_CHECK(!test_validate_hex("1c", CborValidateStrict));
+	TEST_CHECK(!test_validate_hex("5a ffffffff 00", CborValidateStrict));
+
+	// chunks of undefined length string should be definite strings of the same type
+	TEST_CHECK(!test_validate_hex("5f 6161 ff", CborValidateStrict));
+	TEST_CHECK(!test_validate_hex("7f 7f ff ff", CborValidateStrict));
+
+	// UTF-8 in text strings: overlong, surrogate, truncated sequence
+	TEST_CHECK(!test_validate_hex("62 c0af", CborValidateStrict));
+	TEST_CHECK(!test_validate_hex("63 eda080", CborValidateStrict));
+	TEST_CHECK(!test_validate_hex("62 e282", CborValidateStrict));
+	TEST_CHECK(test_validate_hex("64 f09f9880", CborValidateStrict));
+}